@@ -0,0 +1,528 @@
+/*****************************************************************************
+
+Copyright (c) 2014, Percona Inc. All Rights Reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Suite 500, Boston, MA 02110-1335 USA
+
+*****************************************************************************/
+
+/**************************************************//**
+@file btr/btr0bulk.cc
+Bottom-up bulk loading of a B-tree from sorted index entries
+*******************************************************/
+
+#include "btr0bulk.h"
+
+#include "btr0btr.h"
+#include "dict0dict.h"
+#include "fsp0fsp.h"
+#include "ibuf0ibuf.h"
+#include "log0log.h"
+#include "mtr0mtr.h"
+#include "page0cur.h"
+#include "page0page.h"
+#include "rem0cmp.h"
+#include "srv0srv.h"
+
+/** A level of the tree being loaded */
+struct btr_bulk_level_t {
+	ulint		page_no;	/*!< page being filled */
+	buf_block_t*	block;		/*!< page being filled, or NULL
+					if it is not latched */
+	mtr_t		mtr;		/*!< mini-transaction holding the
+					latch on block */
+};
+
+/** Bulk loader of an index tree */
+struct btr_bulk_t {
+	dict_index_t*		index;		/*!< index being loaded */
+	trx_id_t		trx_id;		/*!< transaction building the
+						index */
+	ulint			leaf_reserve;	/*!< bytes to leave free on
+						the leaf pages */
+	ulint			node_reserve;	/*!< bytes to leave free on
+						the non-leaf pages */
+	ulint			n_levels;	/*!< number of levels that
+						have a page */
+	mem_heap_t*		heap;		/*!< memory heap for records
+						and node pointers */
+	btr_bulk_level_t	levels[BTR_MAX_LEVELS];
+						/*!< the page being filled
+						on each level */
+};
+
+/*********************************************************************//**
+Create a bulk loader of an empty index tree.
+@return own: bulk loader */
+UNIV_INTERN
+btr_bulk_t*
+btr_bulk_create(
+/*============*/
+	dict_index_t*	index,	/*!< in: empty index */
+	trx_id_t	trx_id)	/*!< in: transaction building the index */
+{
+	btr_bulk_t*	bulk;
+
+	ut_ad(!dict_table_zip_size(index->table));
+	ut_ad(!dict_index_is_ibuf(index));
+	ut_ad(srv_fill_factor >= 10 && srv_fill_factor <= 100);
+
+	bulk = static_cast<btr_bulk_t*>(ut_malloc(sizeof *bulk));
+
+	bulk->index = index;
+	bulk->trx_id = trx_id;
+	bulk->node_reserve = UNIV_PAGE_SIZE * (100 - srv_fill_factor) / 100;
+	bulk->leaf_reserve = bulk->node_reserve;
+	bulk->n_levels = 0;
+	bulk->heap = mem_heap_create(UNIV_PAGE_SIZE / 4);
+
+	/* Leave room for updates on the clustered index leaf pages, like
+	btr_cur_optimistic_insert() does. */
+	if (dict_index_is_clust(index)) {
+		bulk->leaf_reserve = ut_max(bulk->leaf_reserve,
+					    dict_index_get_space_reserve());
+	}
+
+	return(bulk);
+}
+
+/*********************************************************************//**
+Get the page being filled on a level, latching it again if the latches
+have been released.
+@return the page */
+static
+buf_block_t*
+btr_bulk_get_block(
+/*===============*/
+	btr_bulk_t*	bulk,	/*!< in/out: bulk loader */
+	ulint		level)	/*!< in: level of the page */
+{
+	btr_bulk_level_t*	lv = &bulk->levels[level];
+
+	ut_ad(level < bulk->n_levels);
+
+	if (lv->block == NULL) {
+		mtr_start(&lv->mtr);
+		lv->block = btr_block_get(bulk->index->space, 0, lv->page_no,
+					  RW_X_LATCH, bulk->index, &lv->mtr);
+	}
+
+	return(lv->block);
+}
+
+/*********************************************************************//**
+Commit the mini-transactions of all levels, releasing the page latches. */
+static
+void
+btr_bulk_release(
+/*=============*/
+	btr_bulk_t*	bulk)	/*!< in/out: bulk loader */
+{
+	ulint	level;
+
+	for (level = 0; level < bulk->n_levels; level++) {
+		btr_bulk_level_t*	lv = &bulk->levels[level];
+
+		if (lv->block != NULL) {
+			mtr_commit(&lv->mtr);
+			lv->block = NULL;
+		}
+	}
+}
+
+/*********************************************************************//**
+Allocate a page for a level of the tree in a separate mini-transaction, so
+that the tablespace latches are not held while the page is filled.
+@return DB_SUCCESS or DB_OUT_OF_FILE_SPACE */
+static __attribute__((nonnull, warn_unused_result))
+dberr_t
+btr_bulk_page_alloc(
+/*================*/
+	btr_bulk_t*	bulk,		/*!< in/out: bulk loader */
+	ulint		level,		/*!< in: level of the page */
+	ulint		hint_page_no,	/*!< in: hint of a good page */
+	ulint*		page_no)	/*!< out: allocated page */
+{
+	dict_index_t*	index = bulk->index;
+	buf_block_t*	block;
+	ulint		n_reserved;
+	mtr_t		mtr;
+
+	mtr_start(&mtr);
+	mtr_x_lock(dict_index_get_lock(index), &mtr);
+
+	if (!fsp_reserve_free_extents(&n_reserved, index->space, 1,
+				      FSP_NORMAL, &mtr)) {
+		mtr_commit(&mtr);
+		return(DB_OUT_OF_FILE_SPACE);
+	}
+
+	block = btr_page_alloc(index, hint_page_no, FSP_UP, level,
+			       &mtr, &mtr);
+
+	fil_space_release_free_extents(index->space, n_reserved);
+
+	if (block == NULL) {
+		mtr_commit(&mtr);
+		return(DB_OUT_OF_FILE_SPACE);
+	}
+
+	*page_no = buf_block_get_page_no(block);
+
+	mtr_commit(&mtr);
+
+	return(DB_SUCCESS);
+}
+
+/*********************************************************************//**
+Create an allocated page as the last page of a level, and latch it for
+filling. */
+static
+void
+btr_bulk_page_init(
+/*===============*/
+	btr_bulk_t*	bulk,		/*!< in/out: bulk loader */
+	ulint		level,		/*!< in: level of the page */
+	ulint		page_no,	/*!< in: allocated page */
+	ulint		prev_page_no)	/*!< in: previous page on the level,
+					or FIL_NULL */
+{
+	btr_bulk_level_t*	lv = &bulk->levels[level];
+	page_t*			page;
+
+	ut_ad(lv->block == NULL);
+
+	mtr_start(&lv->mtr);
+	lv->page_no = page_no;
+	lv->block = btr_block_get(bulk->index->space, 0, page_no,
+				  RW_X_LATCH, bulk->index, &lv->mtr);
+
+	/* The free bits must not claim the space of an earlier use of
+	the page. */
+	if (level == 0) {
+		ibuf_reset_free_bits(lv->block);
+	}
+
+	btr_page_create(lv->block, NULL, bulk->index, level, &lv->mtr);
+
+	page = buf_block_get_frame(lv->block);
+	btr_page_set_prev(page, NULL, prev_page_no, &lv->mtr);
+	btr_page_set_next(page, NULL, FIL_NULL, &lv->mtr);
+}
+
+/*********************************************************************//**
+Append a record to the page being filled on a level.
+@return DB_SUCCESS or error code */
+static __attribute__((nonnull, warn_unused_result))
+dberr_t
+btr_bulk_insert_low(
+/*================*/
+	btr_bulk_t*	bulk,	/*!< in/out: bulk loader */
+	ulint		level,	/*!< in: level to insert to */
+	const dtuple_t*	tuple);	/*!< in: record or node pointer */
+
+/*********************************************************************//**
+Insert the node pointer to the page being filled on a level to the next
+level up. The node pointer to the leftmost page of a level is marked as the
+minimum record of the leftmost page of the next level.
+@return DB_SUCCESS or error code */
+static __attribute__((nonnull, warn_unused_result))
+dberr_t
+btr_bulk_node_ptr_insert(
+/*=====================*/
+	btr_bulk_t*	bulk,	/*!< in/out: bulk loader */
+	ulint		level)	/*!< in: level of the child page */
+{
+	btr_bulk_level_t*	lv = &bulk->levels[level];
+	const page_t*		page = buf_block_get_frame(lv->block);
+	const rec_t*		first;
+	dtuple_t*		node_ptr;
+
+	first = page_rec_get_next_const(page_get_infimum_rec(page));
+	ut_ad(!page_rec_is_supremum(first));
+
+	node_ptr = dict_index_build_node_ptr(
+		bulk->index, first, lv->page_no, bulk->heap, level);
+
+	if (btr_page_get_prev(page, &lv->mtr) == FIL_NULL) {
+		dtuple_set_info_bits(node_ptr,
+				     dtuple_get_info_bits(node_ptr)
+				     | REC_INFO_MIN_REC_FLAG);
+	}
+
+	return(btr_bulk_insert_low(bulk, level + 1, node_ptr));
+}
+
+/*********************************************************************//**
+Start a new page on a level when the page being filled is full. The node
+pointer to the full page is inserted to the next level up before the full
+page is committed.
+@return DB_SUCCESS or error code */
+static __attribute__((nonnull, warn_unused_result))
+dberr_t
+btr_bulk_page_switch(
+/*=================*/
+	btr_bulk_t*	bulk,	/*!< in/out: bulk loader */
+	ulint		level)	/*!< in: level of the full page */
+{
+	btr_bulk_level_t*	lv = &bulk->levels[level];
+	ulint			page_no = lv->page_no;
+	ulint			new_page_no;
+	dberr_t			err;
+
+	err = btr_bulk_page_alloc(bulk, level, page_no + 1, &new_page_no);
+
+	if (err != DB_SUCCESS) {
+		return(err);
+	}
+
+	btr_page_set_next(buf_block_get_frame(lv->block), NULL,
+			  new_page_no, &lv->mtr);
+
+	err = btr_bulk_node_ptr_insert(bulk, level);
+
+	mtr_commit(&lv->mtr);
+	lv->block = NULL;
+
+	if (err != DB_SUCCESS) {
+		return(err);
+	}
+
+	if (level == 0) {
+		/* Do not hold any page latches while waiting for a
+		log checkpoint.  Once per leaf page is often enough, as
+		no mini-transaction of the loader logs more than about a
+		page worth of records. */
+		btr_bulk_release(bulk);
+		log_free_check();
+	}
+
+	btr_bulk_page_init(bulk, level, new_page_no, page_no);
+
+	return(DB_SUCCESS);
+}
+
+/*********************************************************************//**
+Append a record to the page being filled on a level, starting a new page
+when the record would not leave the reserved free space on the page.
+@return DB_SUCCESS or error code */
+static
+dberr_t
+btr_bulk_insert_low(
+/*================*/
+	btr_bulk_t*	bulk,	/*!< in/out: bulk loader */
+	ulint		level,	/*!< in: level to insert to */
+	const dtuple_t*	tuple)	/*!< in: record or node pointer */
+{
+	btr_bulk_level_t*	lv = &bulk->levels[level];
+	dict_index_t*		index = bulk->index;
+	buf_block_t*		block;
+	page_t*			page;
+	page_cur_t		cur;
+	rec_t*			rec;
+	ulint*			offsets = NULL;
+	ulint			size;
+	ulint			reserve;
+	dberr_t			err;
+
+	ut_a(level < BTR_MAX_LEVELS);
+
+	size = rec_get_converted_size(index, tuple, 0);
+	reserve = level ? bulk->node_reserve : bulk->leaf_reserve;
+
+	if (level == bulk->n_levels) {
+		ulint	page_no;
+
+		/* This is the first page of the level. */
+		err = btr_bulk_page_alloc(bulk, level,
+					  dict_index_get_page(index) + 1,
+					  &page_no);
+
+		if (err != DB_SUCCESS) {
+			return(err);
+		}
+
+		bulk->n_levels++;
+		lv->block = NULL;
+		btr_bulk_page_init(bulk, level, page_no, FIL_NULL);
+	} else {
+		page = buf_block_get_frame(btr_bulk_get_block(bulk, level));
+
+		if (page_get_n_recs(page) > 0
+		    && page_get_max_insert_size(page, 1) < size + reserve) {
+
+			err = btr_bulk_page_switch(bulk, level);
+
+			if (err != DB_SUCCESS) {
+				return(err);
+			}
+		}
+	}
+
+retry:
+	block = lv->block;
+	page = buf_block_get_frame(block);
+
+	page_cur_position(page_rec_get_prev(page_get_supremum_rec(page)),
+			  block, &cur);
+
+#ifdef UNIV_DEBUG
+	/* Check that the records are inserted in order. */
+	if (level == 0 && !page_cur_is_before_first(&cur)) {
+		offsets = rec_get_offsets(page_cur_get_rec(&cur), index,
+					  NULL, ULINT_UNDEFINED, &bulk->heap);
+		ut_ad(cmp_dtuple_rec(tuple, page_cur_get_rec(&cur), offsets)
+		      > 0);
+	}
+#endif /* UNIV_DEBUG */
+
+	rec = page_cur_tuple_insert(&cur, tuple, index, &offsets,
+				    &bulk->heap, 0, &lv->mtr);
+
+	if (rec == NULL) {
+		if (page_get_n_recs(page) == 0) {
+			/* The record does not fit even on an empty
+			page. */
+			return(DB_TOO_BIG_RECORD);
+		}
+
+		/* The estimate above let the record through, but it
+		does not fit on the page. Retry on an empty page. */
+		err = btr_bulk_page_switch(bulk, level);
+
+		if (err != DB_SUCCESS) {
+			return(err);
+		}
+
+		goto retry;
+	}
+
+	if (level == 0 && !dict_index_is_clust(index)
+	    && page_get_n_recs(page) == 1) {
+		page_update_max_trx_id(block, NULL, bulk->trx_id, &lv->mtr);
+	}
+
+	return(DB_SUCCESS);
+}
+
+/*********************************************************************//**
+Append an index entry to the tree being loaded. The entry must be greater
+than the previous one.
+@return DB_SUCCESS or error code */
+UNIV_INTERN
+dberr_t
+btr_bulk_insert(
+/*============*/
+	btr_bulk_t*		bulk,	/*!< in/out: bulk loader */
+	const dtuple_t*		entry)	/*!< in: index entry */
+{
+	ut_ad(dtuple_check_typed(entry));
+
+	mem_heap_empty(bulk->heap);
+
+	return(btr_bulk_insert_low(bulk, 0, entry));
+}
+
+/*********************************************************************//**
+Copy the single page of the top level to the root page, which is the only
+page of the tree that is known to the data dictionary, and free the page. */
+static
+void
+btr_bulk_copy_to_root(
+/*==================*/
+	btr_bulk_t*	bulk)	/*!< in/out: bulk loader */
+{
+	dict_index_t*		index = bulk->index;
+	ulint			level = bulk->n_levels - 1;
+	btr_bulk_level_t*	lv = &bulk->levels[level];
+	buf_block_t*		block = btr_bulk_get_block(bulk, level);
+	buf_block_t*		root_block;
+	page_t*			root;
+
+	ut_ad(btr_page_get_prev(buf_block_get_frame(block), &lv->mtr)
+	      == FIL_NULL);
+	ut_ad(btr_page_get_next(buf_block_get_frame(block), &lv->mtr)
+	      == FIL_NULL);
+
+	root_block = btr_block_get(index->space, 0,
+				   dict_index_get_page(index),
+				   RW_X_LATCH, index, &lv->mtr);
+	root = buf_block_get_frame(root_block);
+
+	ut_ad(page_get_n_recs(root) == 0);
+	ut_ad(btr_page_get_level(root, &lv->mtr) == 0);
+
+	ibuf_reset_free_bits(root_block);
+	btr_page_set_level(root, NULL, level, &lv->mtr);
+
+	page_copy_rec_list_end_no_locks(
+		root_block, block,
+		page_get_infimum_rec(buf_block_get_frame(block)),
+		index, &lv->mtr);
+
+	if (level == 0 && !dict_index_is_clust(index)) {
+		page_update_max_trx_id(root_block, NULL, bulk->trx_id,
+				       &lv->mtr);
+	}
+
+	btr_page_free(index, block, &lv->mtr);
+
+	mtr_commit(&lv->mtr);
+	lv->block = NULL;
+}
+
+/*********************************************************************//**
+Finish loading the tree and free the bulk loader. On error, the pages are
+released but the tree is left incomplete, and the index must be dropped.
+@return DB_SUCCESS or error code */
+UNIV_INTERN
+dberr_t
+btr_bulk_finish(
+/*============*/
+	btr_bulk_t*	bulk,	/*!< in,own: bulk loader */
+	dberr_t		err)	/*!< in: DB_SUCCESS, or the error
+				that stopped the loading */
+{
+	ulint	level;
+
+	if (err == DB_SUCCESS && bulk->n_levels > 0) {
+		/* Insert the node pointers to the last page of each
+		level.  This can add pages and levels above the level. */
+		for (level = 0; level + 1 < bulk->n_levels; level++) {
+			btr_bulk_level_t*	lv = &bulk->levels[level];
+
+			btr_bulk_get_block(bulk, level);
+			mem_heap_empty(bulk->heap);
+
+			err = btr_bulk_node_ptr_insert(bulk, level);
+
+			mtr_commit(&lv->mtr);
+			lv->block = NULL;
+
+			if (err != DB_SUCCESS) {
+				break;
+			}
+		}
+
+		if (err == DB_SUCCESS) {
+			btr_bulk_copy_to_root(bulk);
+		}
+	}
+
+	btr_bulk_release(bulk);
+
+	mem_heap_free(bulk->heap);
+	ut_free(bulk);
+
+	return(err);
+}
@@ -35,6 +35,10 @@ Created 2011/12/19
 #include "srv0srv.h"
 #include "page0zip.h"
 #include "trx0sys.h"
+#include "os0file.h"
+
+#include <map>
+#include <vector>
 
 #ifndef UNIV_HOTBACKUP
 
@@ -49,6 +53,36 @@ UNIV_INTERN buf_dblwr_t*	buf_dblwr = NULL;
 /** Set to TRUE when the doublewrite buffer is being created */
 UNIV_INTERN ibool	buf_dblwr_being_created = FALSE;
 
+/** @name Parallel doublewrite file header, in the first page of the file
+@{ */
+#define BUF_DBLWR_HDR_MAGIC	0	/*!< BUF_DBLWR_MAGIC_N */
+#define BUF_DBLWR_HDR_PAGE_SIZE	4	/*!< UNIV_PAGE_SIZE */
+#define BUF_DBLWR_HDR_N_SEGS	8	/*!< number of segments */
+#define BUF_DBLWR_HDR_SEG_SIZE	12	/*!< number of pages in a segment */
+/* @} */
+
+/** Contents of BUF_DBLWR_HDR_MAGIC */
+#define BUF_DBLWR_MAGIC_N	873301241
+
+/** Name of the file in the data directory that lists the parallel
+doublewrite files */
+#define BUF_DBLWR_FILES_INFO	"ib_parallel_doublewrite"
+
+/** A copy of a page in a doublewrite buffer */
+struct buf_dblwr_copy_t {
+	lsn_t	lsn;		/*!< FIL_PAGE_LSN of the copy */
+	bool	corrupted;	/*!< true if the copy fails the checksum */
+	ulint	file;		/*!< parallel doublewrite file of the
+				copy, or ULINT_UNDEFINED for the
+				system tablespace doublewrite buffer */
+	ulint	slot;		/*!< slot of the copy in the file
+				or buffer */
+};
+
+/** The copy to restore each page from, keyed by (space id, page number) */
+typedef std::map<std::pair<ulint, ulint>, buf_dblwr_copy_t>
+	buf_dblwr_copies_t;
+
 /****************************************************************//**
 Determines if a page number is located inside the doublewrite buffer.
 @return TRUE if the location is inside the two blocks of the
@@ -119,6 +153,362 @@ buf_dblwr_sync_datafiles()
 	fil_flush_file_spaces(FIL_TABLESPACE);
 }
 
+/****************************************************************//**
+Determines if the batch flushes are doublewritten to the parallel
+doublewrite files instead of the system tablespace.
+@return true if the parallel doublewrite files are used */
+static
+bool
+buf_dblwr_use_parallel(void)
+/*========================*/
+{
+	return(srv_parallel_doublewrite_path != NULL
+	       && *srv_parallel_doublewrite_path != '\0'
+	       && !srv_read_only_mode);
+}
+
+/****************************************************************//**
+Builds the name of the parallel doublewrite file of a buffer pool
+instance. */
+static
+void
+buf_dblwr_file_name(
+/*================*/
+	char*		name,	/*!< out: file name, OS_FILE_MAX_PATH bytes */
+	const char*	prefix,	/*!< in: name prefix of the files */
+	ulint		i)	/*!< in: buffer pool instance number */
+{
+	ulint	len;
+
+	len = ut_snprintf(name, OS_FILE_MAX_PATH, "%s_%lu",
+			  prefix, (ulong) i);
+
+	/* The length of innodb_parallel_doublewrite_path is checked at
+	startup */
+	ut_a(len < OS_FILE_MAX_PATH);
+
+	srv_normalize_path_for_win(name);
+}
+
+/****************************************************************//**
+Reads the name prefix and the number of the parallel doublewrite files
+from BUF_DBLWR_FILES_INFO. The files are found through it rather than
+through innodb_parallel_doublewrite_path, which may have been changed or
+cleared since they were written.
+@return true if the parallel doublewrite files have been created */
+static
+bool
+buf_dblwr_read_files_info(
+/*======================*/
+	char*	prefix,		/*!< out: name prefix of the files,
+				OS_FILE_MAX_PATH bytes */
+	ulint*	n_files)	/*!< out: number of files */
+{
+	os_file_t	file;
+	ibool		success;
+	char		buf[OS_FILE_MAX_PATH + 32];
+	os_offset_t	size;
+	char*		end;
+
+	file = os_file_create_simple_no_error_handling(
+		innodb_file_data_key, BUF_DBLWR_FILES_INFO, OS_FILE_OPEN,
+		OS_FILE_READ_ONLY, &success);
+
+	if (!success) {
+		return(false);
+	}
+
+	size = os_file_get_size(file);
+
+	success = size != (os_offset_t) -1 && size > 0 && size < sizeof(buf)
+		&& os_file_read(file, buf, 0, (ulint) size);
+
+	os_file_close(file);
+
+	if (!success) {
+		ib_logf(IB_LOG_LEVEL_FATAL,
+			"Cannot read '%s'", BUF_DBLWR_FILES_INFO);
+	}
+
+	buf[size] = '\0';
+
+	/* The file consists of the number of files and the name prefix,
+	separated by a space and terminated by a newline. */
+	*n_files = strtoul(buf, &end, 10);
+
+	if (*end != ' ' || buf[size - 1] != '\n' || end + 2 > buf + size) {
+		ib_logf(IB_LOG_LEVEL_FATAL,
+			"'%s' is corrupted", BUF_DBLWR_FILES_INFO);
+	}
+
+	buf[size - 1] = '\0';
+	ut_strlcpy(prefix, end + 1, OS_FILE_MAX_PATH);
+
+	return(true);
+}
+
+/****************************************************************//**
+Removes the parallel doublewrite files listed in BUF_DBLWR_FILES_INFO
+that are not going to be used any more, and BUF_DBLWR_FILES_INFO itself
+if the parallel doublewrite files are not used. Their contents are not
+needed once the pages in them have been restored. */
+static
+void
+buf_dblwr_remove_old_files(
+/*=======================*/
+	bool	use_parallel)	/*!< in: whether the parallel doublewrite
+				files are used from now on */
+{
+	char	prefix[OS_FILE_MAX_PATH];
+	char	name[OS_FILE_MAX_PATH];
+	ulint	n_files;
+
+	if (!buf_dblwr_read_files_info(prefix, &n_files)) {
+		return;
+	}
+
+	for (ulint i = 0; i < n_files; i++) {
+		if (use_parallel && i < srv_buf_pool_instances
+		    && !strcmp(prefix, srv_parallel_doublewrite_path)) {
+			/* The file is going to be recreated */
+			continue;
+		}
+
+		buf_dblwr_file_name(name, prefix, i);
+
+		os_file_delete_if_exists(innodb_file_data_key, name);
+	}
+
+	if (!use_parallel) {
+		os_file_delete_if_exists(innodb_file_data_key,
+					 BUF_DBLWR_FILES_INFO);
+	}
+}
+
+/****************************************************************//**
+Writes the name prefix and the number of the parallel doublewrite files
+to BUF_DBLWR_FILES_INFO. */
+static
+void
+buf_dblwr_write_files_info(
+/*=======================*/
+	ulint	n_files)	/*!< in: number of files */
+{
+	os_file_t	file;
+	ibool		success;
+	char		buf[OS_FILE_MAX_PATH + 32];
+	ulint		len;
+
+	len = ut_snprintf(buf, sizeof(buf), "%lu %s\n", (ulong) n_files,
+			  srv_parallel_doublewrite_path);
+
+	os_file_delete_if_exists(innodb_file_data_key, BUF_DBLWR_FILES_INFO);
+
+	file = os_file_create_simple(
+		innodb_file_data_key, BUF_DBLWR_FILES_INFO,
+		OS_FILE_CREATE, OS_FILE_READ_WRITE, &success);
+
+	if (!success
+	    || !os_file_write(BUF_DBLWR_FILES_INFO, file, buf, 0, len)
+	    || !os_file_flush(file)) {
+		ib_logf(IB_LOG_LEVEL_FATAL,
+			"Cannot write '%s'", BUF_DBLWR_FILES_INFO);
+	}
+
+	os_file_close(file);
+}
+
+/****************************************************************//**
+Opens an existing parallel doublewrite file if it has the layout that
+buf_dblwr_create_files() would give it.
+@return true if the file can be reused */
+static
+bool
+buf_dblwr_open_file(
+/*================*/
+	const char*	name,	/*!< in: file name */
+	const byte*	header,	/*!< in: expected header page */
+	byte*		page,	/*!< in: buffer of UNIV_PAGE_SIZE bytes */
+	os_offset_t	size,	/*!< in: expected file size */
+	os_file_t*	file)	/*!< out: the opened file */
+{
+	ibool		exists;
+	ibool		success;
+	os_file_type_t	type;
+
+	if (!os_file_status(name, &exists, &type)
+	    || !exists || type != OS_FILE_TYPE_FILE) {
+		return(false);
+	}
+
+	*file = os_file_create(innodb_file_data_key, name, OS_FILE_OPEN,
+			       OS_FILE_NORMAL, OS_DATA_FILE, &success);
+
+	if (!success) {
+		return(false);
+	}
+
+	if (os_file_get_size(*file) == size
+	    && os_file_read(*file, page, 0, UNIV_PAGE_SIZE)
+	    && !memcmp(page, header, UNIV_PAGE_SIZE)) {
+		return(true);
+	}
+
+	os_file_close(*file);
+
+	return(false);
+}
+
+/****************************************************************//**
+Creates the parallel doublewrite files, one for each buffer pool instance,
+and removes the files left behind by a previous configuration. A file
+consists of a header page followed by BUF_DBLWR_N_FILE_SEGS segments of
+BUF_DBLWR_SEG_SIZE pages. A new file is zero-filled, so that the pages
+which have not been written have a zero FIL_PAGE_LSN. An existing file
+with the same layout is reused as it is: the copies left in it are older
+than any copy written from now on, and a page is only ever restored from
+its newest copy. */
+static
+void
+buf_dblwr_create_files(void)
+/*========================*/
+{
+	byte*		unaligned_header;
+	byte*		header;
+	byte*		page;
+	char		name[OS_FILE_MAX_PATH];
+	os_offset_t	size;
+
+	unaligned_header = static_cast<byte*>(
+		ut_malloc(3 * UNIV_PAGE_SIZE));
+	header = static_cast<byte*>(
+		ut_align(unaligned_header, UNIV_PAGE_SIZE));
+	page = header + UNIV_PAGE_SIZE;
+
+	memset(header, 0, UNIV_PAGE_SIZE);
+	mach_write_to_4(header + BUF_DBLWR_HDR_MAGIC, BUF_DBLWR_MAGIC_N);
+	mach_write_to_4(header + BUF_DBLWR_HDR_PAGE_SIZE, UNIV_PAGE_SIZE);
+	mach_write_to_4(header + BUF_DBLWR_HDR_N_SEGS, BUF_DBLWR_N_FILE_SEGS);
+	mach_write_to_4(header + BUF_DBLWR_HDR_SEG_SIZE, BUF_DBLWR_SEG_SIZE);
+
+	size = (1 + BUF_DBLWR_N_FILE_SEGS * BUF_DBLWR_SEG_SIZE)
+		* (os_offset_t) UNIV_PAGE_SIZE;
+
+	buf_dblwr->n_files = srv_buf_pool_instances;
+
+	buf_dblwr->files = static_cast<os_file_t*>(
+		mem_zalloc(buf_dblwr->n_files * sizeof(os_file_t)));
+	buf_dblwr->file_names = static_cast<char**>(
+		mem_zalloc(buf_dblwr->n_files * sizeof(char*)));
+
+	buf_dblwr_remove_old_files(true);
+
+	for (ulint i = 0; i < buf_dblwr->n_files; i++) {
+		ibool	success;
+
+		buf_dblwr_file_name(name, srv_parallel_doublewrite_path, i);
+
+		buf_dblwr->file_names[i] = mem_strdup(name);
+
+		if (buf_dblwr_open_file(name, header, page, size,
+					&buf_dblwr->files[i])) {
+			continue;
+		}
+
+		buf_dblwr->files[i] = os_file_create(
+			innodb_file_data_key, name, OS_FILE_OVERWRITE,
+			OS_FILE_NORMAL, OS_DATA_FILE, &success);
+
+		if (!success) {
+			ib_logf(IB_LOG_LEVEL_FATAL,
+				"Cannot create the parallel doublewrite "
+				"file '%s'", name);
+		}
+
+		success = os_file_set_size(name, buf_dblwr->files[i], size)
+			&& os_file_write(name, buf_dblwr->files[i], header,
+					 0, UNIV_PAGE_SIZE)
+			&& os_file_flush(buf_dblwr->files[i]);
+
+		if (!success) {
+			ib_logf(IB_LOG_LEVEL_FATAL,
+				"Cannot initialize the parallel doublewrite "
+				"file '%s'", name);
+		}
+	}
+
+	/* The files must be found on a crash recovery even if
+	innodb_parallel_doublewrite_path is changed before the restart */
+	buf_dblwr_write_files_info(buf_dblwr->n_files);
+
+	ut_free(unaligned_header);
+}
+
+/****************************************************************//**
+Initializes a doublewrite segment. */
+static
+void
+buf_dblwr_seg_init(
+/*===============*/
+	buf_dblwr_seg_t*	seg,	/*!< out: segment */
+	ulint			size)	/*!< in: number of pages */
+{
+	mutex_create(buf_dblwr_mutex_key, &seg->mutex, SYNC_DOUBLEWRITE);
+
+	seg->size = size;
+	seg->b_event = os_event_create();
+	seg->first_free = 0;
+	seg->b_reserved = 0;
+	seg->batch_running = false;
+
+	seg->write_buf_unaligned = static_cast<byte*>(
+		ut_malloc((1 + size) * UNIV_PAGE_SIZE));
+
+	seg->write_buf = static_cast<byte*>(
+		ut_align(seg->write_buf_unaligned, UNIV_PAGE_SIZE));
+
+	seg->buf_block_arr = static_cast<buf_page_t**>(
+		mem_zalloc(size * sizeof(void*)));
+}
+
+/****************************************************************//**
+Frees a doublewrite segment. */
+static
+void
+buf_dblwr_seg_free(
+/*===============*/
+	buf_dblwr_seg_t*	seg)	/*!< in/out: segment */
+{
+	ut_ad(seg->b_reserved == 0);
+
+	os_event_free(seg->b_event);
+	ut_free(seg->write_buf_unaligned);
+	mem_free(seg->buf_block_arr);
+	mutex_free(&seg->mutex);
+}
+
+/****************************************************************//**
+Returns the doublewrite segment of a batch flush.
+@return segment */
+static
+buf_dblwr_seg_t*
+buf_dblwr_get_seg(
+/*==============*/
+	const buf_pool_t*	buf_pool,	/*!< in: buffer pool instance */
+	buf_flush_t		flush_type)	/*!< in: BUF_FLUSH_LRU or
+						BUF_FLUSH_LIST */
+{
+	ut_ad(flush_type == BUF_FLUSH_LRU || flush_type == BUF_FLUSH_LIST);
+
+	if (buf_dblwr->n_files == 0) {
+		return(buf_dblwr->segs);
+	}
+
+	return(&buf_dblwr->segs[buf_pool_index(buf_pool)
+				* BUF_DBLWR_N_FILE_SEGS
+				+ (flush_type == BUF_FLUSH_LIST)]);
+}
+
 /****************************************************************//**
 Creates or initialializes the doublewrite buffer at a database start. */
 static
@@ -145,11 +535,8 @@ buf_dblwr_init(
 	mutex_create(buf_dblwr_mutex_key,
 		     &buf_dblwr->mutex, SYNC_DOUBLEWRITE);
 
-	buf_dblwr->b_event = os_event_create();
 	buf_dblwr->s_event = os_event_create();
-	buf_dblwr->first_free = 0;
 	buf_dblwr->s_reserved = 0;
-	buf_dblwr->b_reserved = 0;
 
 	buf_dblwr->block1 = mach_read_from_4(
 		doublewrite + TRX_SYS_DOUBLEWRITE_BLOCK1);
@@ -168,6 +555,51 @@ buf_dblwr_init(
 
 	buf_dblwr->buf_block_arr = static_cast<buf_page_t**>(
 		mem_zalloc(buf_size * sizeof(void*)));
+
+	if (buf_dblwr_use_parallel()) {
+		/* Each flush type of each buffer pool instance gets a
+		segment of its own, so that the batches flushed in
+		parallel never wait for each other. The segments have
+		BUF_DBLWR_SEG_SIZE pages, srv_doublewrite_batch_size
+		only applies to the system tablespace. */
+		buf_dblwr_create_files();
+
+		buf_dblwr->n_segs = BUF_DBLWR_N_FILE_SEGS
+			* buf_dblwr->n_files;
+		buf_dblwr->segs = static_cast<buf_dblwr_seg_t*>(
+			mem_zalloc(buf_dblwr->n_segs
+				   * sizeof(buf_dblwr_seg_t)));
+
+		for (ulint i = 0; i < buf_dblwr->n_segs; i++) {
+			buf_dblwr_seg_t*	seg = &buf_dblwr->segs[i];
+			ulint			file = i / BUF_DBLWR_N_FILE_SEGS;
+
+			buf_dblwr_seg_init(seg, BUF_DBLWR_SEG_SIZE);
+
+			seg->in_sys = false;
+			seg->file = buf_dblwr->files[file];
+			seg->file_name = buf_dblwr->file_names[file];
+			seg->offset = (1 + (i % BUF_DBLWR_N_FILE_SEGS)
+				       * BUF_DBLWR_SEG_SIZE)
+				* (os_offset_t) UNIV_PAGE_SIZE;
+		}
+	} else {
+		if (!srv_read_only_mode) {
+			buf_dblwr_remove_old_files(false);
+		}
+
+		/* The first srv_doublewrite_batch_size slots of the
+		system tablespace doublewrite buffer are shared by all
+		the batch flushes. */
+		buf_dblwr->n_segs = 1;
+		buf_dblwr->segs = static_cast<buf_dblwr_seg_t*>(
+			mem_zalloc(sizeof(buf_dblwr_seg_t)));
+
+		buf_dblwr_seg_init(buf_dblwr->segs,
+				   srv_doublewrite_batch_size);
+
+		buf_dblwr->segs->in_sys = true;
+	}
 }
 
 /****************************************************************//**
@@ -346,6 +778,314 @@ start_again:
 	goto start_again;
 }
 
+/****************************************************************//**
+Restores a page from its copy in the doublewrite buffer if the page in the
+data file is corrupt, i.e. if the write of the page to the data file was
+interrupted by a crash. */
+static
+void
+buf_dblwr_restore_page(
+/*===================*/
+	ulint		space_id,	/*!< in: tablespace id of the page */
+	ulint		page_no,	/*!< in: page number of the page */
+	const byte*	page,		/*!< in: copy of the page in the
+					doublewrite buffer */
+	byte*		read_buf,	/*!< in/out: buffer of
+					UNIV_PAGE_SIZE bytes to read the
+					page from the data file into */
+	ulint		i)		/*!< in: position of the copy in
+					the doublewrite buffer, for
+					messages */
+{
+	ulint	zip_size;
+
+	if (!fil_tablespace_exists_in_mem(space_id)) {
+		/* Maybe we have dropped the single-table tablespace
+		and this page once belonged to it: do nothing */
+		return;
+	}
+
+	if (!fil_check_adress_in_tablespace(space_id, page_no)) {
+		ib_logf(IB_LOG_LEVEL_WARN,
+			"A page in the doublewrite buffer is not "
+			"within space bounds; space id %lu "
+			"page number %lu, page %lu in "
+			"doublewrite buf.",
+			(ulong) space_id, (ulong) page_no, (ulong) i);
+		return;
+	}
+
+	zip_size = fil_space_get_zip_size(space_id);
+
+	/* Read in the actual page from the file */
+	fil_io(OS_FILE_READ, true, space_id, zip_size,
+	       page_no, 0,
+	       zip_size ? zip_size : UNIV_PAGE_SIZE,
+	       read_buf, NULL);
+
+	/* Check if the page is corrupt */
+
+	if (!buf_page_is_corrupted(true, read_buf, zip_size)) {
+		return;
+	}
+
+	fprintf(stderr,
+		"InnoDB: Warning: database page"
+		" corruption or a failed\n"
+		"InnoDB: file read of"
+		" space %lu page %lu.\n"
+		"InnoDB: Trying to recover it from"
+		" the doublewrite buffer.\n",
+		(ulong) space_id, (ulong) page_no);
+
+	if (buf_page_is_corrupted(true, page, zip_size)) {
+		fprintf(stderr,
+			"InnoDB: Dump of the page:\n");
+		buf_page_print(
+			read_buf, zip_size,
+			BUF_PAGE_PRINT_NO_CRASH);
+		fprintf(stderr,
+			"InnoDB: Dump of"
+			" corresponding page"
+			" in doublewrite buffer:\n");
+		buf_page_print(
+			page, zip_size,
+			BUF_PAGE_PRINT_NO_CRASH);
+
+		fprintf(stderr,
+			"InnoDB: Also the page in the"
+			" doublewrite buffer"
+			" is corrupt.\n"
+			"InnoDB: Cannot continue"
+			" operation.\n"
+			"InnoDB: You can try to"
+			" recover the database"
+			" with the my.cnf\n"
+			"InnoDB: option:\n"
+			"InnoDB:"
+			" innodb_force_recovery=6\n");
+		ut_error;
+	}
+
+	/* Write the good page from the
+	doublewrite buffer to the intended
+	position */
+
+	fil_io(OS_FILE_WRITE, true, space_id,
+	       zip_size, page_no, 0,
+	       zip_size ? zip_size : UNIV_PAGE_SIZE,
+	       (void*) page, NULL);
+
+	ib_logf(IB_LOG_LEVEL_INFO,
+		"Recovered the page from"
+		" the doublewrite buffer.");
+}
+
+/****************************************************************//**
+Adds a copy of a page in a doublewrite buffer to the candidates to restore
+the page from. Every slot keeps the last page written to it, so there may
+be older copies of a page besides the newest one. The copy with the highest
+FIL_PAGE_LSN among those that pass the checksum is chosen. */
+static
+void
+buf_dblwr_add_copy(
+/*===============*/
+	buf_dblwr_copies_t*	copies,	/*!< in/out: copies to restore */
+	const byte*		page,	/*!< in: copy of the page */
+	ulint			file,	/*!< in: parallel doublewrite file,
+					or ULINT_UNDEFINED */
+	ulint			slot)	/*!< in: slot of the copy */
+{
+	buf_dblwr_copy_t	copy;
+	ulint			space_id;
+	ulint			page_no;
+
+	space_id = mach_read_from_4(page + FIL_PAGE_ARCH_LOG_NO_OR_SPACE_ID);
+	page_no = mach_read_from_4(page + FIL_PAGE_OFFSET);
+
+	if (!fil_tablespace_exists_in_mem(space_id)) {
+		/* Maybe we have dropped the single-table tablespace
+		and this page once belonged to it: do nothing */
+		return;
+	}
+
+	copy.lsn = mach_read_from_8(page + FIL_PAGE_LSN);
+	copy.corrupted = buf_page_is_corrupted(
+		true, page, fil_space_get_zip_size(space_id));
+	copy.file = file;
+	copy.slot = slot;
+
+	std::pair<buf_dblwr_copies_t::iterator, bool>	ins
+		= copies->insert(std::make_pair(
+			std::make_pair(space_id, page_no), copy));
+
+	buf_dblwr_copy_t&	best = ins.first->second;
+
+	if (!ins.second && !copy.corrupted
+	    && (best.corrupted || copy.lsn > best.lsn)) {
+		best = copy;
+	}
+}
+
+/****************************************************************//**
+Opens the parallel doublewrite files listed in BUF_DBLWR_FILES_INFO and
+adds the pages in them to the candidates to restore. The files are read
+according to their own headers, so the number of buffer pool instances
+may have changed since the crash. */
+static
+void
+buf_dblwr_add_parallel_copies(
+/*==========================*/
+	buf_dblwr_copies_t*	copies,	/*!< in/out: copies to restore */
+	std::vector<os_file_t>*	files,	/*!< out: the opened files, indexed
+					by buf_dblwr_copy_t::file */
+	byte*			page)	/*!< in: buffer of UNIV_PAGE_SIZE
+					bytes */
+{
+	char	prefix[OS_FILE_MAX_PATH];
+	char	name[OS_FILE_MAX_PATH];
+	ulint	n_files;
+
+	if (!buf_dblwr_read_files_info(prefix, &n_files)) {
+		return;
+	}
+
+	for (ulint i = 0; i < n_files; i++) {
+		os_file_t	file;
+		ibool		success;
+		ulint		n_pages;
+
+		buf_dblwr_file_name(name, prefix, i);
+
+		file = os_file_create_simple_no_error_handling(
+			innodb_file_data_key, name, OS_FILE_OPEN,
+			OS_FILE_READ_ONLY, &success);
+
+		if (!success) {
+			ib_logf(IB_LOG_LEVEL_WARN,
+				"Cannot open the parallel doublewrite "
+				"file '%s', its pages are not restored",
+				name);
+			continue;
+		}
+
+		if (!os_file_read(file, page, 0, UNIV_PAGE_SIZE)
+		    || mach_read_from_4(page + BUF_DBLWR_HDR_MAGIC)
+		    != BUF_DBLWR_MAGIC_N
+		    || mach_read_from_4(page + BUF_DBLWR_HDR_PAGE_SIZE)
+		    != UNIV_PAGE_SIZE) {
+
+			ib_logf(IB_LOG_LEVEL_WARN,
+				"The parallel doublewrite file '%s' has "
+				"an invalid header, its pages are not "
+				"restored", name);
+
+			os_file_close(file);
+			continue;
+		}
+
+		files->push_back(file);
+
+		n_pages = mach_read_from_4(page + BUF_DBLWR_HDR_N_SEGS)
+			* mach_read_from_4(page + BUF_DBLWR_HDR_SEG_SIZE);
+
+		for (ulint j = 0; j < n_pages; j++) {
+			if (!os_file_read(file, page,
+					  (1 + j) * (os_offset_t) UNIV_PAGE_SIZE,
+					  UNIV_PAGE_SIZE)) {
+				break;
+			}
+
+			if (mach_read_from_8(page + FIL_PAGE_LSN) == 0) {
+				/* The slot has never been written to */
+				continue;
+			}
+
+			buf_dblwr_add_copy(copies, page, files->size() - 1, j);
+		}
+	}
+}
+
+/****************************************************************//**
+Restores the pages whose writes were interrupted by a crash. All the
+copies in the system tablespace doublewrite buffer and in the parallel
+doublewrite files are considered, and each page is restored from its
+newest copy that passes the checksum. */
+static
+void
+buf_dblwr_restore_pages(
+/*====================*/
+	const byte*	buf,	/*!< in: the pages of the system
+				tablespace doublewrite buffer */
+	ulint		block1,	/*!< in: first page of block 1 */
+	ulint		block2)	/*!< in: first page of block 2 */
+{
+	buf_dblwr_copies_t	copies;
+	std::vector<os_file_t>	files;
+	byte*			unaligned_buf;
+	byte*			page;
+	byte*			read_buf;
+
+	unaligned_buf = static_cast<byte*>(ut_malloc(3 * UNIV_PAGE_SIZE));
+
+	page = static_cast<byte*>(ut_align(unaligned_buf, UNIV_PAGE_SIZE));
+	read_buf = page + UNIV_PAGE_SIZE;
+
+	for (ulint i = 0; i < TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * 2; i++) {
+		const byte*	copy = buf + i * UNIV_PAGE_SIZE;
+		ulint		space_id;
+		ulint		page_no;
+
+		space_id = mach_read_from_4(
+			copy + FIL_PAGE_ARCH_LOG_NO_OR_SPACE_ID);
+		page_no = mach_read_from_4(copy + FIL_PAGE_OFFSET);
+
+		if (space_id == TRX_SYS_SPACE
+		    && ((page_no >= block1
+			 && page_no < block1 + TRX_SYS_DOUBLEWRITE_BLOCK_SIZE)
+			|| (page_no >= block2
+			    && page_no
+			    < block2 + TRX_SYS_DOUBLEWRITE_BLOCK_SIZE))) {
+
+			/* It is an unwritten doublewrite buffer page:
+			do nothing */
+			continue;
+		}
+
+		buf_dblwr_add_copy(&copies, copy, ULINT_UNDEFINED, i);
+	}
+
+	buf_dblwr_add_parallel_copies(&copies, &files, page);
+
+	for (buf_dblwr_copies_t::const_iterator it = copies.begin();
+	     it != copies.end(); ++it) {
+		const buf_dblwr_copy_t&	copy = it->second;
+		const byte*		copy_page;
+
+		if (copy.file == ULINT_UNDEFINED) {
+			copy_page = buf + copy.slot * UNIV_PAGE_SIZE;
+		} else if (os_file_read(files[copy.file], page,
+					(1 + copy.slot)
+					* (os_offset_t) UNIV_PAGE_SIZE,
+					UNIV_PAGE_SIZE)) {
+			copy_page = page;
+		} else {
+			continue;
+		}
+
+		buf_dblwr_restore_page(it->first.first, it->first.second,
+				       copy_page, read_buf, copy.slot);
+	}
+
+	for (ulint i = 0; i < files.size(); i++) {
+		os_file_close(files[i]);
+	}
+
+	fil_flush_file_spaces(FIL_TABLESPACE);
+
+	ut_free(unaligned_buf);
+}
+
 /****************************************************************//**
 At a database startup initializes the doublewrite buffer memory structure if
 we already have a doublewrite buffer created in the data files. If we are
@@ -360,6 +1100,7 @@ buf_dblwr_init_or_restore_pages(
 	ibool	restore_corrupt_pages)	/*!< in: TRUE=restore pages */
 {
 	byte*	buf;
+	byte*	unaligned_buf;
 	byte*	read_buf;
 	byte*	unaligned_read_buf;
 	ulint	block1;
@@ -367,8 +1108,6 @@ buf_dblwr_init_or_restore_pages(
 	byte*	page;
 	ibool	reset_space_ids = FALSE;
 	byte*	doublewrite;
-	ulint	space_id;
-	ulint	page_no;
 	ulint	i;
 
 	/* We do the file i/o past the buffer pool */
@@ -386,19 +1125,15 @@ buf_dblwr_init_or_restore_pages(
 	doublewrite = read_buf + TRX_SYS_DOUBLEWRITE;
 
 	if (mach_read_from_4(doublewrite + TRX_SYS_DOUBLEWRITE_MAGIC)
-	    == TRX_SYS_DOUBLEWRITE_MAGIC_N) {
-		/* The doublewrite buffer has been created */
-
-		buf_dblwr_init(doublewrite);
-
-		block1 = buf_dblwr->block1;
-		block2 = buf_dblwr->block2;
-
-		buf = buf_dblwr->write_buf;
-	} else {
+	    != TRX_SYS_DOUBLEWRITE_MAGIC_N) {
 		goto leave_func;
 	}
 
+	/* The doublewrite buffer has been created */
+
+	block1 = mach_read_from_4(doublewrite + TRX_SYS_DOUBLEWRITE_BLOCK1);
+	block2 = mach_read_from_4(doublewrite + TRX_SYS_DOUBLEWRITE_BLOCK2);
+
 	if (mach_read_from_4(doublewrite + TRX_SYS_DOUBLEWRITE_SPACE_ID_STORED)
 	    != TRX_SYS_DOUBLEWRITE_SPACE_ID_STORED_N) {
 
@@ -416,6 +1151,12 @@ buf_dblwr_init_or_restore_pages(
 
 	/* Read the pages from the doublewrite buffer to memory */
 
+	unaligned_buf = static_cast<byte*>(
+		ut_malloc((1 + 2 * TRX_SYS_DOUBLEWRITE_BLOCK_SIZE)
+			  * UNIV_PAGE_SIZE));
+
+	buf = static_cast<byte*>(ut_align(unaligned_buf, UNIV_PAGE_SIZE));
+
 	fil_io(OS_FILE_READ, true, TRX_SYS_SPACE, 0, block1, 0,
 	       TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE,
 	       buf, NULL);
@@ -423,19 +1164,13 @@ buf_dblwr_init_or_restore_pages(
 	       TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE,
 	       buf + TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE,
 	       NULL);
-	/* Check if any of these pages is half-written in data files, in the
-	intended position */
 
-	page = buf;
+	if (reset_space_ids) {
+		page = buf;
 
-	for (i = 0; i < TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * 2; i++) {
+		for (i = 0; i < TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * 2; i++) {
+			ulint	source_page_no;
 
-		ulint source_page_no;
-		page_no = mach_read_from_4(page + FIL_PAGE_OFFSET);
-
-		if (reset_space_ids) {
-
-			space_id = 0;
 			mach_write_to_4(page
 					+ FIL_PAGE_ARCH_LOG_NO_OR_SPACE_ID, 0);
 			/* We do not need to calculate new checksums for the
@@ -451,111 +1186,25 @@ buf_dblwr_init_or_restore_pages(
 
 			fil_io(OS_FILE_WRITE, true, 0, 0, source_page_no, 0,
 			       UNIV_PAGE_SIZE, page, NULL);
-		} else {
 
-			space_id = mach_read_from_4(
-				page + FIL_PAGE_ARCH_LOG_NO_OR_SPACE_ID);
+			page += UNIV_PAGE_SIZE;
 		}
 
-		if (!restore_corrupt_pages) {
-			/* The database was shut down gracefully: no need to
-			restore pages */
-
-		} else if (!fil_tablespace_exists_in_mem(space_id)) {
-			/* Maybe we have dropped the single-table tablespace
-			and this page once belonged to it: do nothing */
-
-		} else if (!fil_check_adress_in_tablespace(space_id,
-							   page_no)) {
-			ib_logf(IB_LOG_LEVEL_WARN,
-				"A page in the doublewrite buffer is not "
-				"within space bounds; space id %lu "
-				"page number %lu, page %lu in "
-				"doublewrite buf.",
-				(ulong) space_id, (ulong) page_no, (ulong) i);
-
-		} else if (space_id == TRX_SYS_SPACE
-			   && ((page_no >= block1
-				&& page_no
-				< block1 + TRX_SYS_DOUBLEWRITE_BLOCK_SIZE)
-			       || (page_no >= block2
-				   && page_no
-				   < (block2
-				      + TRX_SYS_DOUBLEWRITE_BLOCK_SIZE)))) {
-
-			/* It is an unwritten doublewrite buffer page:
-			do nothing */
-		} else {
-			ulint	zip_size = fil_space_get_zip_size(space_id);
-
-			/* Read in the actual page from the file */
-			fil_io(OS_FILE_READ, true, space_id, zip_size,
-			       page_no, 0,
-			       zip_size ? zip_size : UNIV_PAGE_SIZE,
-			       read_buf, NULL);
-
-			/* Check if the page is corrupt */
-
-			if (buf_page_is_corrupted(true, read_buf, zip_size)) {
-
-				fprintf(stderr,
-					"InnoDB: Warning: database page"
-					" corruption or a failed\n"
-					"InnoDB: file read of"
-					" space %lu page %lu.\n"
-					"InnoDB: Trying to recover it from"
-					" the doublewrite buffer.\n",
-					(ulong) space_id, (ulong) page_no);
-
-				if (buf_page_is_corrupted(true,
-							  page, zip_size)) {
-					fprintf(stderr,
-						"InnoDB: Dump of the page:\n");
-					buf_page_print(
-						read_buf, zip_size,
-						BUF_PAGE_PRINT_NO_CRASH);
-					fprintf(stderr,
-						"InnoDB: Dump of"
-						" corresponding page"
-						" in doublewrite buffer:\n");
-					buf_page_print(
-						page, zip_size,
-						BUF_PAGE_PRINT_NO_CRASH);
-
-					fprintf(stderr,
-						"InnoDB: Also the page in the"
-						" doublewrite buffer"
-						" is corrupt.\n"
-						"InnoDB: Cannot continue"
-						" operation.\n"
-						"InnoDB: You can try to"
-						" recover the database"
-						" with the my.cnf\n"
-						"InnoDB: option:\n"
-						"InnoDB:"
-						" innodb_force_recovery=6\n");
-					ut_error;
-				}
-
-				/* Write the good page from the
-				doublewrite buffer to the intended
-				position */
-
-				fil_io(OS_FILE_WRITE, true, space_id,
-				       zip_size, page_no, 0,
-				       zip_size ? zip_size : UNIV_PAGE_SIZE,
-				       page, NULL);
-
-				ib_logf(IB_LOG_LEVEL_INFO,
-					"Recovered the page from"
-					" the doublewrite buffer.");
-			}
-		}
+		fil_flush_file_spaces(FIL_TABLESPACE);
+	}
 
-		page += UNIV_PAGE_SIZE;
+	if (restore_corrupt_pages) {
+		/* Check if any of the pages is half-written in data files,
+		in the intended position. If the database was shut down
+		gracefully, there is no need to restore pages. This must be
+		done before buf_dblwr_init() recreates the parallel
+		doublewrite files. */
+		buf_dblwr_restore_pages(buf, block1, block2);
 	}
 
-	fil_flush_file_spaces(FIL_TABLESPACE);
+	ut_free(unaligned_buf);
+
+	buf_dblwr_init(doublewrite);
 
 leave_func:
 	ut_free(unaligned_read_buf);
@@ -571,9 +1220,24 @@ buf_dblwr_free(void)
 	/* Free the double write data structures. */
 	ut_a(buf_dblwr != NULL);
 	ut_ad(buf_dblwr->s_reserved == 0);
-	ut_ad(buf_dblwr->b_reserved == 0);
 
-	os_event_free(buf_dblwr->b_event);
+	for (ulint i = 0; i < buf_dblwr->n_segs; i++) {
+		buf_dblwr_seg_free(&buf_dblwr->segs[i]);
+	}
+
+	mem_free(buf_dblwr->segs);
+	buf_dblwr->segs = NULL;
+
+	for (ulint i = 0; i < buf_dblwr->n_files; i++) {
+		os_file_close(buf_dblwr->files[i]);
+		mem_free(buf_dblwr->file_names[i]);
+	}
+
+	if (buf_dblwr->n_files > 0) {
+		mem_free(buf_dblwr->files);
+		mem_free(buf_dblwr->file_names);
+	}
+
 	os_event_free(buf_dblwr->s_event);
 	ut_free(buf_dblwr->write_buf_unaligned);
 	buf_dblwr->write_buf_unaligned = NULL;
@@ -603,30 +1267,34 @@ buf_dblwr_update(
 	}
 
 	switch (flush_type) {
+		buf_dblwr_seg_t*	seg;
 	case BUF_FLUSH_LIST:
 	case BUF_FLUSH_LRU:
-		mutex_enter(&buf_dblwr->mutex);
+		seg = buf_dblwr_get_seg(buf_pool_from_bpage(bpage),
+					flush_type);
+
+		mutex_enter(&seg->mutex);
 
-		ut_ad(buf_dblwr->batch_running);
-		ut_ad(buf_dblwr->b_reserved > 0);
-		ut_ad(buf_dblwr->b_reserved <= buf_dblwr->first_free);
+		ut_ad(seg->batch_running);
+		ut_ad(seg->b_reserved > 0);
+		ut_ad(seg->b_reserved <= seg->first_free);
 
-		buf_dblwr->b_reserved--;
+		seg->b_reserved--;
 
-		if (buf_dblwr->b_reserved == 0) {
-			mutex_exit(&buf_dblwr->mutex);
+		if (seg->b_reserved == 0) {
+			mutex_exit(&seg->mutex);
 			/* This will finish the batch. Sync data files
 			to the disk. */
 			fil_flush_file_spaces(FIL_TABLESPACE);
-			mutex_enter(&buf_dblwr->mutex);
+			mutex_enter(&seg->mutex);
 
 			/* We can now reuse the doublewrite memory buffer: */
-			buf_dblwr->first_free = 0;
-			buf_dblwr->batch_running = false;
-			os_event_set(buf_dblwr->b_event);
+			seg->first_free = 0;
+			seg->batch_running = false;
+			os_event_set(seg->b_event);
 		}
 
-		mutex_exit(&buf_dblwr->mutex);
+		mutex_exit(&seg->mutex);
 		break;
 	case BUF_FLUSH_SINGLE_PAGE:
 		{
@@ -778,6 +1446,57 @@ buf_dblwr_write_block_to_datafile(
 	       (void*) block->frame, (void*) block);
 }
 
+/********************************************************************//**
+Writes the pages buffered in a doublewrite segment to the segment on disk
+and syncs it. */
+static
+void
+buf_dblwr_seg_write(
+/*================*/
+	buf_dblwr_seg_t*	seg,		/*!< in: segment */
+	ulint			first_free)	/*!< in: number of buffered
+						pages */
+{
+	ulint	len;
+
+	if (!seg->in_sys) {
+		if (!os_file_write(seg->file_name, seg->file, seg->write_buf,
+				   seg->offset, first_free * UNIV_PAGE_SIZE)
+		    || !os_file_flush(seg->file)) {
+
+			ib_logf(IB_LOG_LEVEL_FATAL,
+				"Cannot write to the parallel doublewrite "
+				"file '%s'", seg->file_name);
+		}
+
+		return;
+	}
+
+	/* Write out the first block of the doublewrite buffer */
+	len = ut_min(TRX_SYS_DOUBLEWRITE_BLOCK_SIZE,
+		     first_free) * UNIV_PAGE_SIZE;
+
+	fil_io(OS_FILE_WRITE, true, TRX_SYS_SPACE, 0,
+	       buf_dblwr->block1, 0, len,
+	       (void*) seg->write_buf, NULL);
+
+	if (first_free > TRX_SYS_DOUBLEWRITE_BLOCK_SIZE) {
+		/* Write out the second block of the doublewrite
+		buffer. */
+		len = (first_free - TRX_SYS_DOUBLEWRITE_BLOCK_SIZE)
+		       * UNIV_PAGE_SIZE;
+
+		fil_io(OS_FILE_WRITE, true, TRX_SYS_SPACE, 0,
+		       buf_dblwr->block2, 0, len,
+		       (void*) (seg->write_buf
+				+ TRX_SYS_DOUBLEWRITE_BLOCK_SIZE
+				* UNIV_PAGE_SIZE), NULL);
+	}
+
+	/* Now flush the doublewrite buffer data to disk */
+	fil_flush(TRX_SYS_SPACE);
+}
+
 /********************************************************************//**
 Flushes possible buffered writes from the doublewrite memory buffer to disk,
 and also wakes up the aio thread if simulated aio is used. It is very
@@ -786,12 +1505,16 @@ and also when we may have to wait for a page latch! Otherwise a deadlock
 of threads can occur. */
 UNIV_INTERN
 void
-buf_dblwr_flush_buffered_writes(void)
-/*=================================*/
+buf_dblwr_flush_buffered_writes(
+/*============================*/
+	buf_pool_t*	buf_pool,	/*!< in: buffer pool instance of the
+					batch */
+	buf_flush_t	flush_type)	/*!< in: BUF_FLUSH_LRU or
+					BUF_FLUSH_LIST */
 {
-	byte*		write_buf;
-	ulint		first_free;
-	ulint		len;
+	buf_dblwr_seg_t*	seg;
+	byte*			write_buf;
+	ulint			first_free;
 
 	if (!srv_use_doublewrite_buf || buf_dblwr == NULL) {
 		/* Sync the writes to the disk. */
@@ -799,53 +1522,55 @@ buf_dblwr_flush_buffered_writes(void)
 		return;
 	}
 
+	seg = buf_dblwr_get_seg(buf_pool, flush_type);
+
 try_again:
-	mutex_enter(&buf_dblwr->mutex);
+	mutex_enter(&seg->mutex);
 
 	/* Write first to doublewrite buffer blocks. We use synchronous
 	aio and thus know that file write has been completed when the
 	control returns. */
 
-	if (buf_dblwr->first_free == 0) {
+	if (seg->first_free == 0) {
 
-		mutex_exit(&buf_dblwr->mutex);
+		mutex_exit(&seg->mutex);
 
 		return;
 	}
 
-	if (buf_dblwr->batch_running) {
+	if (seg->batch_running) {
 		/* Another thread is running the batch right now. Wait
 		for it to finish. */
-		ib_int64_t	sig_count = os_event_reset(buf_dblwr->b_event);
-		mutex_exit(&buf_dblwr->mutex);
+		ib_int64_t	sig_count = os_event_reset(seg->b_event);
+		mutex_exit(&seg->mutex);
 
-		os_event_wait_low(buf_dblwr->b_event, sig_count);
+		os_event_wait_low(seg->b_event, sig_count);
 		goto try_again;
 	}
 
-	ut_a(!buf_dblwr->batch_running);
-	ut_ad(buf_dblwr->first_free == buf_dblwr->b_reserved);
+	ut_a(!seg->batch_running);
+	ut_ad(seg->first_free == seg->b_reserved);
 
-	/* Disallow anyone else to post to doublewrite buffer or to
-	start another batch of flushing. */
-	buf_dblwr->batch_running = true;
-	first_free = buf_dblwr->first_free;
+	/* Disallow anyone else to post to the segment or to start
+	another batch of flushing from it. */
+	seg->batch_running = true;
+	first_free = seg->first_free;
 
 	/* Now safe to release the mutex. Note that though no other
 	thread is allowed to post to the doublewrite batch flushing
-	but any threads working on single page flushes are allowed
-	to proceed. */
-	mutex_exit(&buf_dblwr->mutex);
+	but any threads working on single page flushes or on the
+	other segments are allowed to proceed. */
+	mutex_exit(&seg->mutex);
 
-	write_buf = buf_dblwr->write_buf;
+	write_buf = seg->write_buf;
 
 	for (ulint len2 = 0, i = 0;
-	     i < buf_dblwr->first_free;
+	     i < first_free;
 	     len2 += UNIV_PAGE_SIZE, i++) {
 
 		const buf_block_t*	block;
 
-		block = (buf_block_t*) buf_dblwr->buf_block_arr[i];
+		block = (buf_block_t*) seg->buf_block_arr[i];
 
 		if (buf_block_get_state(block) != BUF_BLOCK_FILE_PAGE
 		    || block->page.zip.data) {
@@ -863,57 +1588,31 @@ try_again:
 		buf_dblwr_check_page_lsn(write_buf + len2);
 	}
 
-	/* Write out the first block of the doublewrite buffer */
-	len = ut_min(TRX_SYS_DOUBLEWRITE_BLOCK_SIZE,
-		     buf_dblwr->first_free) * UNIV_PAGE_SIZE;
-
-	fil_io(OS_FILE_WRITE, true, TRX_SYS_SPACE, 0,
-	       buf_dblwr->block1, 0, len,
-	       (void*) write_buf, NULL);
-
-	if (buf_dblwr->first_free <= TRX_SYS_DOUBLEWRITE_BLOCK_SIZE) {
-		/* No unwritten pages in the second block. */
-		goto flush;
-	}
+	buf_dblwr_seg_write(seg, first_free);
 
-	/* Write out the second block of the doublewrite buffer. */
-	len = (buf_dblwr->first_free - TRX_SYS_DOUBLEWRITE_BLOCK_SIZE)
-	       * UNIV_PAGE_SIZE;
-
-	write_buf = buf_dblwr->write_buf
-		    + TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE;
-
-	fil_io(OS_FILE_WRITE, true, TRX_SYS_SPACE, 0,
-	       buf_dblwr->block2, 0, len,
-	       (void*) write_buf, NULL);
-
-flush:
 	/* increment the doublewrite flushed pages counter */
-	srv_stats.dblwr_pages_written.add(buf_dblwr->first_free);
+	srv_stats.dblwr_pages_written.add(first_free);
 	srv_stats.dblwr_writes.inc();
 
-	/* Now flush the doublewrite buffer data to disk */
-	fil_flush(TRX_SYS_SPACE);
-
 	/* We know that the writes have been flushed to disk now
 	and in recovery we will find them in the doublewrite buffer
 	blocks. Next do the writes to the intended positions. */
 
-	/* Up to this point first_free and buf_dblwr->first_free are
-	same because we have set the buf_dblwr->batch_running flag
+	/* Up to this point first_free and seg->first_free are
+	same because we have set the seg->batch_running flag
 	disallowing any other thread to post any request but we
-	can't safely access buf_dblwr->first_free in the loop below.
+	can't safely access seg->first_free in the loop below.
 	This is so because it is possible that after we are done with
 	the last iteration and before we terminate the loop, the batch
 	gets finished in the IO helper thread and another thread posts
-	a new batch setting buf_dblwr->first_free to a higher value.
-	If this happens and we are using buf_dblwr->first_free in the
+	a new batch setting seg->first_free to a higher value.
+	If this happens and we are using seg->first_free in the
 	loop termination condition then we'll end up dispatching
 	the same block twice from two different threads. */
-	ut_ad(first_free == buf_dblwr->first_free);
+	ut_ad(first_free == seg->first_free);
 	for (ulint i = 0; i < first_free; i++) {
 		buf_dblwr_write_block_to_datafile(
-			buf_dblwr->buf_block_arr[i], false);
+			seg->buf_block_arr[i], false);
 	}
 
 	/* Wake possible simulated aio thread to actually post the
@@ -933,34 +1632,37 @@ buf_dblwr_add_to_batch(
 /*====================*/
 	buf_page_t*	bpage)	/*!< in: buffer block to write */
 {
-	ulint	zip_size;
+	buf_pool_t*		buf_pool = buf_pool_from_bpage(bpage);
+	buf_flush_t		flush_type = buf_page_get_flush_type(bpage);
+	buf_dblwr_seg_t*	seg = buf_dblwr_get_seg(buf_pool, flush_type);
+	ulint			zip_size;
 
 	ut_a(buf_page_in_file(bpage));
 
 try_again:
-	mutex_enter(&buf_dblwr->mutex);
+	mutex_enter(&seg->mutex);
 
-	ut_a(buf_dblwr->first_free <= srv_doublewrite_batch_size);
+	ut_a(seg->first_free <= seg->size);
 
-	if (buf_dblwr->batch_running) {
+	if (seg->batch_running) {
 
-		/* This not nearly as bad as it looks. There is only
-		page_cleaner thread which does background flushing
-		in batches therefore it is unlikely to be a contention
-		point. The only exception is when a user thread is
-		forced to do a flush batch because of a sync
-		checkpoint. */
-		ib_int64_t	sig_count = os_event_reset(buf_dblwr->b_event);
-		mutex_exit(&buf_dblwr->mutex);
+		/* This not nearly as bad as it looks. Only one batch
+		of a flush type can run in a buffer pool instance and
+		with the parallel doublewrite each of them has a
+		segment of its own. Without it the page_cleaner
+		threads and the user threads forced to do a flush
+		batch because of a sync checkpoint share the segment. */
+		ib_int64_t	sig_count = os_event_reset(seg->b_event);
+		mutex_exit(&seg->mutex);
 
-		os_event_wait_low(buf_dblwr->b_event, sig_count);
+		os_event_wait_low(seg->b_event, sig_count);
 		goto try_again;
 	}
 
-	if (buf_dblwr->first_free == srv_doublewrite_batch_size) {
-		mutex_exit(&(buf_dblwr->mutex));
+	if (seg->first_free == seg->size) {
+		mutex_exit(&seg->mutex);
 
-		buf_dblwr_flush_buffered_writes();
+		buf_dblwr_flush_buffered_writes(buf_pool, flush_type);
 
 		goto try_again;
 	}
@@ -970,40 +1672,40 @@ try_again:
 	if (zip_size) {
 		UNIV_MEM_ASSERT_RW(bpage->zip.data, zip_size);
 		/* Copy the compressed page and clear the rest. */
-		memcpy(buf_dblwr->write_buf
-		       + UNIV_PAGE_SIZE * buf_dblwr->first_free,
+		memcpy(seg->write_buf
+		       + UNIV_PAGE_SIZE * seg->first_free,
 		       bpage->zip.data, zip_size);
-		memset(buf_dblwr->write_buf
-		       + UNIV_PAGE_SIZE * buf_dblwr->first_free
+		memset(seg->write_buf
+		       + UNIV_PAGE_SIZE * seg->first_free
 		       + zip_size, 0, UNIV_PAGE_SIZE - zip_size);
 	} else {
 		ut_a(buf_page_get_state(bpage) == BUF_BLOCK_FILE_PAGE);
 		UNIV_MEM_ASSERT_RW(((buf_block_t*) bpage)->frame,
 				   UNIV_PAGE_SIZE);
 
-		memcpy(buf_dblwr->write_buf
-		       + UNIV_PAGE_SIZE * buf_dblwr->first_free,
+		memcpy(seg->write_buf
+		       + UNIV_PAGE_SIZE * seg->first_free,
 		       ((buf_block_t*) bpage)->frame, UNIV_PAGE_SIZE);
 	}
 
-	buf_dblwr->buf_block_arr[buf_dblwr->first_free] = bpage;
+	seg->buf_block_arr[seg->first_free] = bpage;
 
-	buf_dblwr->first_free++;
-	buf_dblwr->b_reserved++;
+	seg->first_free++;
+	seg->b_reserved++;
 
-	ut_ad(!buf_dblwr->batch_running);
-	ut_ad(buf_dblwr->first_free == buf_dblwr->b_reserved);
-	ut_ad(buf_dblwr->b_reserved <= srv_doublewrite_batch_size);
+	ut_ad(!seg->batch_running);
+	ut_ad(seg->first_free == seg->b_reserved);
+	ut_ad(seg->b_reserved <= seg->size);
 
-	if (buf_dblwr->first_free == srv_doublewrite_batch_size) {
-		mutex_exit(&(buf_dblwr->mutex));
+	if (seg->first_free == seg->size) {
+		mutex_exit(&seg->mutex);
 
-		buf_dblwr_flush_buffered_writes();
+		buf_dblwr_flush_buffered_writes(buf_pool, flush_type);
 
 		return;
 	}
 
-	mutex_exit(&(buf_dblwr->mutex));
+	mutex_exit(&seg->mutex);
 }
 
 /********************************************************************//**
@@ -30,6 +30,7 @@ Created April 08, 2011 Vasil Dimov
 
 #include "buf0buf.h" /* buf_pool_mutex_enter(), srv_buf_pool_instances */
 #include "buf0dump.h"
+#include "buf0rea.h" /* buf_read_load_pages() */
 #include "db0err.h"
 #include "dict0dict.h" /* dict_operation_lock */
 #include "os0file.h" /* OS_FILE_MAX_PATH */
@@ -68,6 +69,12 @@ typedef ib_uint64_t	buf_dump_t;
 #define BUF_DUMP_SPACE(a)		((ulint) ((a) >> 32))
 #define BUF_DUMP_PAGE(a)		((ulint) ((a) & 0xFFFFFFFFUL))
 
+/* Maximum number of adjacent pages of a dump that buf_load() reads in one
+go, the same as the merge limit of simulated aio. The aio segment of a
+request is chosen by the offset divided by this many pages, so a run that
+does not cross a multiple of it is served by one i/o-handler thread. */
+#define BUF_LOAD_MAX_RUN		64
+
 /*****************************************************************//**
 Wakes up the buffer pool dump/load thread and instructs it to start
 a dump. This function is called by MySQL code via buffer_pool_dump_now()
@@ -360,6 +367,37 @@ buf_dump_sort(
 			      buf_dump_cmp);
 }
 
+/*****************************************************************//**
+Throttles a buffer pool load to innodb_io_capacity read requests per
+second if innodb_buffer_pool_load_throttle is set. */
+static
+void
+buf_load_throttle_if_needed(
+/*========================*/
+	ulint*	last_check_time,	/*!< in/out: when the current second
+					of reads started, in milliseconds */
+	ulint*	n_io,			/*!< in/out: read requests issued in
+					the current second */
+	ulint	count)			/*!< in: read requests just issued */
+{
+	ulint	elapsed;
+
+	*n_io += count;
+
+	if (!srv_buffer_pool_load_throttle || *n_io < srv_io_capacity) {
+		return;
+	}
+
+	elapsed = ut_time_ms() - *last_check_time;
+
+	if (elapsed < 1000) {
+		os_thread_sleep((1000 - elapsed) * 1000);
+	}
+
+	*last_check_time = ut_time_ms();
+	*n_io = 0;
+}
+
 /*****************************************************************//**
 Perform a buffer pool load from the file specified by
 innodb_buffer_pool_filename. If any errors occur then the value of
@@ -379,8 +417,14 @@ buf_load()
 	ulint		dump_n;
 	ulint		total_buffer_pools_pages;
 	ulint		i;
+	ulint		n;
 	ulint		space_id;
 	ulint		page_no;
+	ulint		count;
+	ulint		n_read;
+	ulint		n_io;
+	ulint		last_check_time;
+	ulint		last_status;
 	int		fscanf_ret;
 
 	/* Ignore any leftovers from before */
@@ -521,19 +565,39 @@ buf_load()
 
 	ut_free(dump_tmp);
 
-	for (i = 0; i < dump_n && !SHUTTING_DOWN(); i++) {
+	n_read = 0;
+	n_io = 0;
+	last_check_time = ut_time_ms();
+	last_status = 0;
+
+	/* Read the runs of adjacent pages of the sorted dump
+	asynchronously. The read i/o-handler threads complete them in
+	parallel while this thread queues the following runs. */
+	for (i = 0; i < dump_n && !SHUTTING_DOWN(); i += n) {
+
+		space_id = BUF_DUMP_SPACE(dump[i]);
+		page_no = BUF_DUMP_PAGE(dump[i]);
+
+		/* End the run at a multiple of BUF_LOAD_MAX_RUN pages,
+		so that all its requests go to the same aio segment and
+		can be merged. */
+		for (n = 1;
+		     (page_no + n) % BUF_LOAD_MAX_RUN != 0 && i + n < dump_n
+		     && BUF_DUMP_SPACE(dump[i + n]) == space_id
+		     && BUF_DUMP_PAGE(dump[i + n]) == page_no + n;
+		     n++) {
+		}
 
-		buf_read_page_async(BUF_DUMP_SPACE(dump[i]),
-				    BUF_DUMP_PAGE(dump[i]));
+		count = buf_read_load_pages(space_id, page_no, n);
+		n_read += count;
 
-		if (i % 64 == 63) {
-			os_aio_simulated_wake_handler_threads();
-		}
+		buf_load_throttle_if_needed(&last_check_time, &n_io, count);
 
-		if (i % 128 == 0) {
+		if (i + n - last_status >= 128 || i == 0) {
+			last_status = i + n;
 			buf_load_status(STATUS_INFO,
 					"Loaded " ULINTPF "/" ULINTPF " pages",
-					i + 1, dump_n);
+					i + n, dump_n);
 		}
 
 		if (buf_load_abort_flag) {
@@ -548,6 +612,26 @@ buf_load()
 
 	ut_free(dump);
 
+	/* Wait for the reads to complete, so that the pages are in the
+	buffer pool when the load is reported completed. */
+	while (buf_get_n_pending_read_ios() > 0 && !SHUTTING_DOWN()) {
+
+		if (buf_load_abort_flag) {
+			buf_load_abort_flag = FALSE;
+			buf_load_status(
+				STATUS_NOTICE,
+				"Buffer pool(s) load aborted on request");
+			return;
+		}
+
+		os_aio_simulated_wake_handler_threads();
+		os_thread_sleep(10000);
+	}
+
+	ib_logf(IB_LOG_LEVEL_INFO,
+		"Buffer pool load read " ULINTPF " of " ULINTPF " pages",
+		n_read, dump_n);
+
 	ut_sprintf_timestamp(now);
 
 	buf_load_status(STATUS_NOTICE,
@@ -65,8 +65,13 @@ reduce the wait time for the threads waiting for a clean block */
 
 #ifdef UNIV_PFS_THREAD
 UNIV_INTERN mysql_pfs_key_t buf_page_cleaner_thread_key;
+UNIV_INTERN mysql_pfs_key_t buf_page_cleaner_worker_thread_key;
 #endif /* UNIV_PFS_THREAD */
 
+#ifdef UNIV_PFS_MUTEX
+UNIV_INTERN mysql_pfs_key_t page_cleaner_mutex_key;
+#endif /* UNIV_PFS_MUTEX */
+
 /** If LRU list of a buf_pool is less than this size then LRU eviction
 should not happen. This is because when we do LRU flushing we also put
 the blocks on free list. If LRU list is very small then we can end up
@@ -1053,7 +1058,7 @@ buf_flush_page(
 		flush_list or LRU_list. */
 
 		if (!is_s_latched) {
-			buf_dblwr_flush_buffered_writes();
+			buf_dblwr_flush_buffered_writes(buf_pool, flush_type);
 
 			if (is_uncompressed) {
 				rw_lock_s_lock_gen(&((buf_block_t*) bpage)
@@ -1738,10 +1743,11 @@ static
 void
 buf_flush_common(
 /*=============*/
+	buf_pool_t*	buf_pool,	/*!< in: buffer pool instance */
 	buf_flush_t	flush_type,	/*!< in: type of flush */
 	ulint		page_count)	/*!< in: number of pages flushed */
 {
-	buf_dblwr_flush_buffered_writes();
+	buf_dblwr_flush_buffered_writes(buf_pool, flush_type);
 
 	ut_a(flush_type == BUF_FLUSH_LRU || flush_type == BUF_FLUSH_LIST);
 
@@ -1876,7 +1882,7 @@ buf_flush_LRU(
 
 	buf_flush_end(buf_pool, BUF_FLUSH_LRU);
 
-	buf_flush_common(BUF_FLUSH_LRU, page_count);
+	buf_flush_common(buf_pool, BUF_FLUSH_LRU, page_count);
 
 	if (n_processed) {
 		*n_processed = page_count;
@@ -1885,6 +1891,55 @@ buf_flush_LRU(
 	return(true);
 }
 
+/*******************************************************************//**
+This utility flushes dirty blocks from the end of the flush list of
+a buffer pool instance.
+NOTE: The calling thread is not allowed to own any latches on pages!
+@return true if a batch was queued successfully. false if another batch
+of same type was already running. */
+static
+bool
+buf_flush_list_instance(
+/*====================*/
+	buf_pool_t*	buf_pool,	/*!< in/out: buffer pool instance */
+	ulint		min_n,		/*!< in: wished minimum mumber of blocks
+					flushed (it is not guaranteed that the
+					actual number is that big, though) */
+	lsn_t		lsn_limit,	/*!< in: all blocks whose
+					oldest_modification is smaller than
+					this should be flushed (if their
+					number does not exceed min_n) */
+	ulint*		n_processed)	/*!< out: the number of pages
+					which were processed */
+{
+	ulint		page_count;
+
+	*n_processed = 0;
+
+	if (!buf_flush_start(buf_pool, BUF_FLUSH_LIST)) {
+		return(false);
+	}
+
+	page_count = buf_flush_batch(
+		buf_pool, BUF_FLUSH_LIST, min_n, lsn_limit);
+
+	buf_flush_end(buf_pool, BUF_FLUSH_LIST);
+
+	buf_flush_common(buf_pool, BUF_FLUSH_LIST, page_count);
+
+	if (page_count) {
+		MONITOR_INC_VALUE_CUMULATIVE(
+			MONITOR_FLUSH_BATCH_TOTAL_PAGE,
+			MONITOR_FLUSH_BATCH_COUNT,
+			MONITOR_FLUSH_BATCH_PAGES,
+			page_count);
+	}
+
+	*n_processed = page_count;
+
+	return(true);
+}
+
 /*******************************************************************//**
 This utility flushes dirty blocks from the end of the flush list of
 all buffer pool instances.
@@ -1927,12 +1982,10 @@ buf_flush_list(
 
 	/* Flush to lsn_limit in all buffer pool instances */
 	for (i = 0; i < srv_buf_pool_instances; i++) {
-		buf_pool_t*	buf_pool;
-		ulint		page_count = 0;
-
-		buf_pool = buf_pool_from_array(i);
+		ulint		page_count;
 
-		if (!buf_flush_start(buf_pool, BUF_FLUSH_LIST)) {
+		if (!buf_flush_list_instance(buf_pool_from_array(i),
+					     min_n, lsn_limit, &page_count)) {
 			/* We have two choices here. If lsn_limit was
 			specified then skipping an instance of buffer
 			pool means we cannot guarantee that all pages
@@ -1948,24 +2001,9 @@ buf_flush_list(
 			continue;
 		}
 
-		page_count = buf_flush_batch(
-			buf_pool, BUF_FLUSH_LIST, min_n, lsn_limit);
-
-		buf_flush_end(buf_pool, BUF_FLUSH_LIST);
-
-		buf_flush_common(BUF_FLUSH_LIST, page_count);
-
 		if (n_processed) {
 			*n_processed += page_count;
 		}
-
-		if (page_count) {
-			MONITOR_INC_VALUE_CUMULATIVE(
-				MONITOR_FLUSH_BATCH_TOTAL_PAGE,
-				MONITOR_FLUSH_BATCH_COUNT,
-				MONITOR_FLUSH_BATCH_PAGES,
-				page_count);
-		}
 	}
 
 	return(success);
@@ -2063,6 +2101,64 @@ buf_flush_single_page_from_LRU(
 	return(freed);
 }
 
+/*********************************************************************//**
+Clears up tail of the LRU list of a buffer pool instance:
+* Put replaceable pages at the tail of LRU to the free list
+* Flush dirty pages at the tail of LRU to the disk
+The depth to which we scan the buffer pool is controlled by dynamic
+config parameter innodb_LRU_scan_depth.
+@return number of pages flushed */
+static
+ulint
+buf_flush_LRU_tail_instance(
+/*========================*/
+	buf_pool_t*	buf_pool)	/*!< in/out: buffer pool instance */
+{
+	ulint	total_flushed = 0;
+	ulint	scan_depth;
+
+	/* srv_LRU_scan_depth can be arbitrarily large value.
+	We cap it with current LRU size. */
+	buf_pool_mutex_enter(buf_pool);
+	scan_depth = UT_LIST_GET_LEN(buf_pool->LRU);
+	buf_pool_mutex_exit(buf_pool);
+
+	scan_depth = ut_min(srv_LRU_scan_depth, scan_depth);
+
+	/* We divide LRU flush into smaller chunks because
+	there may be user threads waiting for the flush to
+	end in buf_LRU_get_free_block(). */
+	for (ulint j = 0;
+	     j < scan_depth;
+	     j += PAGE_CLEANER_LRU_BATCH_CHUNK_SIZE) {
+
+		ulint	n_flushed = 0;
+
+		/* Currently page_cleaner is the only thread
+		that can trigger an LRU flush. It is possible
+		that a batch triggered during last iteration is
+		still running, */
+		if (buf_flush_LRU(buf_pool,
+				  PAGE_CLEANER_LRU_BATCH_CHUNK_SIZE,
+				  &n_flushed)) {
+
+			/* Allowed only one batch per
+			buffer pool instance. */
+			buf_flush_wait_batch_end(
+				buf_pool, BUF_FLUSH_LRU);
+		}
+
+		if (n_flushed) {
+			total_flushed += n_flushed;
+		} else {
+			/* Nothing to flush */
+			break;
+		}
+	}
+
+	return(total_flushed);
+}
+
 /*********************************************************************//**
 Clears up tail of the LRU lists:
 * Put replaceable pages at the tail of LRU to the free list
@@ -2079,47 +2175,8 @@ buf_flush_LRU_tail(void)
 
 	for (ulint i = 0; i < srv_buf_pool_instances; i++) {
 
-		buf_pool_t*	buf_pool = buf_pool_from_array(i);
-		ulint		scan_depth;
-
-		/* srv_LRU_scan_depth can be arbitrarily large value.
-		We cap it with current LRU size. */
-		buf_pool_mutex_enter(buf_pool);
-		scan_depth = UT_LIST_GET_LEN(buf_pool->LRU);
-		buf_pool_mutex_exit(buf_pool);
-
-		scan_depth = ut_min(srv_LRU_scan_depth, scan_depth);
-
-		/* We divide LRU flush into smaller chunks because
-		there may be user threads waiting for the flush to
-		end in buf_LRU_get_free_block(). */
-		for (ulint j = 0;
-		     j < scan_depth;
-		     j += PAGE_CLEANER_LRU_BATCH_CHUNK_SIZE) {
-
-			ulint	n_flushed = 0;
-
-			/* Currently page_cleaner is the only thread
-			that can trigger an LRU flush. It is possible
-			that a batch triggered during last iteration is
-			still running, */
-			if (buf_flush_LRU(buf_pool,
-					  PAGE_CLEANER_LRU_BATCH_CHUNK_SIZE,
-					  &n_flushed)) {
-
-				/* Allowed only one batch per
-				buffer pool instance. */
-				buf_flush_wait_batch_end(
-					buf_pool, BUF_FLUSH_LRU);
-			}
-
-			if (n_flushed) {
-				total_flushed += n_flushed;
-			} else {
-				/* Nothing to flush */
-				break;
-			}
-		}
+		total_flushed += buf_flush_LRU_tail_instance(
+			buf_pool_from_array(i));
 	}
 
 	if (total_flushed) {
@@ -2158,22 +2215,328 @@ buf_flush_wait_LRU_batch_end(void)
 	}
 }
 
+/** State of a page_cleaner slot */
+enum page_cleaner_state_t {
+	PAGE_CLEANER_STATE_NONE = 0,	/*!< no flush requested */
+	PAGE_CLEANER_STATE_REQUESTED,	/*!< flush requested, the slot
+					has not been picked up yet */
+	PAGE_CLEANER_STATE_FLUSHING,	/*!< a thread is flushing */
+	PAGE_CLEANER_STATE_FINISHED	/*!< flushing has finished */
+};
+
+/** Flush batch state of one buffer pool instance */
+struct page_cleaner_slot_t {
+	page_cleaner_state_t	state;		/*!< state of the slot */
+	ulint			n_flushed_lru;	/*!< number of pages flushed
+						from the tail of the LRU */
+	ulint			n_flushed_list;	/*!< number of pages flushed
+						from the flush_list */
+	bool			success_list;	/*!< false if another
+						flush_list batch was running
+						in the instance */
+};
+
+/** Page cleaner coordination. The page_cleaner coordinator thread
+requests a flush batch of all the buffer pool instances and then the
+worker threads and the coordinator itself pick up the instances one at
+a time, so that the instances are flushed in parallel. */
+struct page_cleaner_t {
+	ib_mutex_t		mutex;		/*!< protects all the fields
+						below and the slots */
+	os_event_t		is_requested;	/*!< set when there are slots
+						waiting to be flushed */
+	os_event_t		is_finished;	/*!< set when all the slots of
+						a batch have been flushed */
+	ulint			n_workers;	/*!< number of running worker
+						threads */
+	bool			is_running;	/*!< false if the worker
+						threads must exit */
+	bool			flush_lru;	/*!< true if the tails of the
+						LRU lists must be cleared */
+	ulint			min_n;		/*!< number of pages to flush
+						from each flush_list */
+	lsn_t			lsn_limit;	/*!< flush_list batch upper
+						LSN limit */
+	ulint			n_slots;	/*!< number of slots, equal to
+						srv_buf_pool_instances */
+	ulint			n_slots_requested;
+						/*!< number of slots in
+						PAGE_CLEANER_STATE_REQUESTED */
+	ulint			n_slots_finished;
+						/*!< number of slots in
+						PAGE_CLEANER_STATE_FINISHED */
+	page_cleaner_slot_t*	slots;		/*!< one slot for each buffer
+						pool instance */
+};
+
+/** The page_cleaner coordination, created and freed by the coordinator
+thread */
+static page_cleaner_t*	page_cleaner = NULL;
+
 /*********************************************************************//**
-Flush a batch of dirty pages from the flush list
-@return number of pages flushed, 0 if no page is flushed or if another
-flush_list type batch is running */
+Creates the page_cleaner coordination. */
+static
+void
+page_cleaner_create(void)
+/*=====================*/
+{
+	ut_a(page_cleaner == NULL);
+
+	page_cleaner = static_cast<page_cleaner_t*>(
+		mem_zalloc(sizeof(*page_cleaner)));
+
+	mutex_create(page_cleaner_mutex_key, &page_cleaner->mutex,
+		     SYNC_NO_ORDER_CHECK);
+
+	page_cleaner->is_requested = os_event_create();
+	page_cleaner->is_finished = os_event_create();
+
+	page_cleaner->is_running = true;
+	page_cleaner->n_slots = srv_buf_pool_instances;
+	page_cleaner->slots = static_cast<page_cleaner_slot_t*>(
+		mem_zalloc(page_cleaner->n_slots
+			   * sizeof(*page_cleaner->slots)));
+}
+
+/*********************************************************************//**
+Stops the page_cleaner worker threads and frees the page_cleaner
+coordination. */
+static
+void
+page_cleaner_free(void)
+/*===================*/
+{
+	mutex_enter(&page_cleaner->mutex);
+	page_cleaner->is_running = false;
+	os_event_set(page_cleaner->is_requested);
+	mutex_exit(&page_cleaner->mutex);
+
+	for (;;) {
+		ulint	n_workers;
+
+		mutex_enter(&page_cleaner->mutex);
+		n_workers = page_cleaner->n_workers;
+		mutex_exit(&page_cleaner->mutex);
+
+		if (n_workers == 0) {
+			break;
+		}
+
+		os_thread_sleep(10000);
+	}
+
+	mutex_free(&page_cleaner->mutex);
+	os_event_free(page_cleaner->is_requested);
+	os_event_free(page_cleaner->is_finished);
+
+	mem_free(page_cleaner->slots);
+	mem_free(page_cleaner);
+	page_cleaner = NULL;
+}
+
+/*********************************************************************//**
+Requests a flush batch of all the buffer pool instances. The batch is
+carried out by page_cleaner_flush_slot(). */
+static
+void
+page_cleaner_request(
+/*=================*/
+	ulint		min_n,		/*!< in: number of pages to flush
+					from the flush_lists, 0 if the
+					flush_lists must not be flushed */
+	lsn_t		lsn_limit,	/*!< in: flush_list batch upper
+					LSN limit */
+	bool		flush_lru)	/*!< in: true if the tails of the
+					LRU lists must be cleared */
+{
+	mutex_enter(&page_cleaner->mutex);
+
+	ut_ad(page_cleaner->n_slots_requested == 0);
+	ut_ad(page_cleaner->n_slots_finished == 0);
+
+	if (min_n != ULINT_MAX) {
+		/* Ensure that flushing is spread evenly amongst the
+		buffer pool instances, as buf_flush_list() does. */
+		min_n = (min_n + page_cleaner->n_slots - 1)
+			/ page_cleaner->n_slots;
+	}
+
+	page_cleaner->min_n = min_n;
+	page_cleaner->lsn_limit = lsn_limit;
+	page_cleaner->flush_lru = flush_lru;
+
+	for (ulint i = 0; i < page_cleaner->n_slots; i++) {
+		ut_ad(page_cleaner->slots[i].state
+		      == PAGE_CLEANER_STATE_NONE);
+
+		page_cleaner->slots[i].state = PAGE_CLEANER_STATE_REQUESTED;
+	}
+
+	page_cleaner->n_slots_requested = page_cleaner->n_slots;
+
+	os_event_reset(page_cleaner->is_finished);
+	os_event_set(page_cleaner->is_requested);
+
+	mutex_exit(&page_cleaner->mutex);
+}
+
+/*********************************************************************//**
+Picks up a requested slot, if any, and flushes its buffer pool instance.
+@return true if a slot was flushed, false if there was none left */
+static
+bool
+page_cleaner_flush_slot(void)
+/*=========================*/
+{
+	page_cleaner_slot_t*	slot = NULL;
+	buf_pool_t*		buf_pool = NULL;
+	ulint			min_n;
+	lsn_t			lsn_limit;
+	bool			flush_lru;
+
+	mutex_enter(&page_cleaner->mutex);
+
+	if (page_cleaner->n_slots_requested == 0) {
+		mutex_exit(&page_cleaner->mutex);
+		return(false);
+	}
+
+	for (ulint i = 0; i < page_cleaner->n_slots; i++) {
+		if (page_cleaner->slots[i].state
+		    == PAGE_CLEANER_STATE_REQUESTED) {
+
+			slot = &page_cleaner->slots[i];
+			buf_pool = buf_pool_from_array(i);
+			break;
+		}
+	}
+
+	ut_a(slot != NULL);
+
+	slot->state = PAGE_CLEANER_STATE_FLUSHING;
+
+	if (--page_cleaner->n_slots_requested == 0) {
+		os_event_reset(page_cleaner->is_requested);
+	}
+
+	min_n = page_cleaner->min_n;
+	lsn_limit = page_cleaner->lsn_limit;
+	flush_lru = page_cleaner->flush_lru;
+
+	mutex_exit(&page_cleaner->mutex);
+
+	/* Flush pages from end of LRU if required */
+	slot->n_flushed_lru = flush_lru
+		? buf_flush_LRU_tail_instance(buf_pool) : 0;
+
+	/* Flush pages from flush_list if required */
+	slot->n_flushed_list = 0;
+	slot->success_list = min_n == 0
+		|| buf_flush_list_instance(buf_pool, min_n, lsn_limit,
+					   &slot->n_flushed_list);
+
+	mutex_enter(&page_cleaner->mutex);
+
+	slot->state = PAGE_CLEANER_STATE_FINISHED;
+
+	if (++page_cleaner->n_slots_finished == page_cleaner->n_slots) {
+		os_event_set(page_cleaner->is_finished);
+	}
+
+	mutex_exit(&page_cleaner->mutex);
+
+	return(true);
+}
+
+/*********************************************************************//**
+Waits until all the slots of the requested flush batch have been flushed
+and collects the results.
+@return false if another flush_list batch was running in at least one of
+the buffer pool instances */
+static
+bool
+page_cleaner_wait_finished(
+/*=======================*/
+	ulint*	n_flushed_lru,	/*!< out: pages flushed from the LRU
+				lists */
+	ulint*	n_flushed_list)	/*!< out: pages flushed from the
+				flush_lists */
+{
+	bool	success = true;
+
+	os_event_wait(page_cleaner->is_finished);
+
+	*n_flushed_lru = 0;
+	*n_flushed_list = 0;
+
+	mutex_enter(&page_cleaner->mutex);
+
+	ut_ad(page_cleaner->n_slots_requested == 0);
+	ut_ad(page_cleaner->n_slots_finished == page_cleaner->n_slots);
+
+	for (ulint i = 0; i < page_cleaner->n_slots; i++) {
+		page_cleaner_slot_t*	slot = &page_cleaner->slots[i];
+
+		ut_ad(slot->state == PAGE_CLEANER_STATE_FINISHED);
+
+		*n_flushed_lru += slot->n_flushed_lru;
+		*n_flushed_list += slot->n_flushed_list;
+		success = success && slot->success_list;
+
+		slot->state = PAGE_CLEANER_STATE_NONE;
+	}
+
+	page_cleaner->n_slots_finished = 0;
+
+	mutex_exit(&page_cleaner->mutex);
+
+	return(success);
+}
+
+/*********************************************************************//**
+Flush a batch of dirty pages from the flush list and, optionally, from
+the tail of the LRU list of every buffer pool instance. The instances are
+flushed in parallel by the page_cleaner worker threads and the calling
+coordinator thread.
+@return number of pages flushed from the flush list, 0 if no page is
+flushed or if another flush_list type batch is running */
 static
 ulint
 page_cleaner_do_flush_batch(
 /*========================*/
 	ulint		n_to_flush,	/*!< in: number of pages that
 					we should attempt to flush. */
-	lsn_t		lsn_limit)	/*!< in: LSN up to which flushing
+	lsn_t		lsn_limit,	/*!< in: LSN up to which flushing
 					must happen */
+	bool		flush_lru,	/*!< in: true if the tails of the
+					LRU lists must be cleared */
+	ulint*		n_flushed_lru)	/*!< out: number of pages flushed
+					from the LRU lists. Ignored if
+					NULL */
 {
-	ulint n_flushed;
+	ulint	n_lru;
+	ulint	n_flushed;
+
+	page_cleaner_request(n_to_flush, lsn_limit, flush_lru);
+
+	/* Take part in the batch instead of idling until the workers
+	are done. */
+	while (page_cleaner_flush_slot()) {
+	}
 
-	buf_flush_list(n_to_flush, lsn_limit, &n_flushed);
+	page_cleaner_wait_finished(&n_lru, &n_flushed);
+
+	if (n_lru) {
+		MONITOR_INC_VALUE_CUMULATIVE(
+			MONITOR_LRU_BATCH_TOTAL_PAGE,
+			MONITOR_LRU_BATCH_COUNT,
+			MONITOR_LRU_BATCH_PAGES,
+			n_lru);
+	}
+
+	if (n_flushed_lru) {
+		*n_flushed_lru = n_lru;
+	}
 
 	return(n_flushed);
 }
@@ -2254,12 +2617,15 @@ af_get_pct_for_lsn(
 This function is called approximately once every second by the
 page_cleaner thread. Based on various factors it decides if there is a
 need to do flushing. If flushing is needed it is performed and the
-number of pages flushed is returned.
-@return number of pages flushed */
+number of pages flushed is returned. The tails of the LRU lists are
+cleared up in the same batch.
+@return number of pages flushed from the flush list */
 static
 ulint
-page_cleaner_flush_pages_if_needed(void)
-/*====================================*/
+page_cleaner_flush_pages_if_needed(
+/*===============================*/
+	ulint*	n_flushed_lru)	/*!< out: number of pages flushed from
+				the LRU lists */
 {
 	static	lsn_t		lsn_avg_rate = 0;
 	static	lsn_t		prev_lsn = 0;
@@ -2284,10 +2650,11 @@ page_cleaner_flush_pages_if_needed(void)
 	if (prev_lsn == 0) {
 		/* First time around. */
 		prev_lsn = cur_lsn;
-		return(0);
 	}
 
 	if (prev_lsn == cur_lsn) {
+		/* Only the tails of the LRU lists need cleaning. */
+		page_cleaner_do_flush_batch(0, 0, true, n_flushed_lru);
 		return(0);
 	}
 
@@ -2337,7 +2704,8 @@ page_cleaner_flush_pages_if_needed(void)
 
 	prev_pages = n_pages;
 	n_pages = page_cleaner_do_flush_batch(
-		n_pages, oldest_lsn + lsn_avg_rate * (age_factor + 1));
+		n_pages, oldest_lsn + lsn_avg_rate * (age_factor + 1),
+		true, n_flushed_lru);
 
 	last_lsn= cur_lsn;
 	last_pages= n_pages + 1;
@@ -2383,8 +2751,62 @@ page_cleaner_sleep_if_needed(
 }
 
 /******************************************************************//**
-page_cleaner thread tasked with flushing dirty pages from the buffer
-pools. As of now we'll have only one instance of this thread.
+page_cleaner worker thread. Flushes the buffer pool instances of the
+batches requested by the page_cleaner coordinator thread, one instance
+at a time, until the coordinator stops it.
+@return a dummy parameter */
+extern "C" UNIV_INTERN
+os_thread_ret_t
+DECLARE_THREAD(buf_flush_page_cleaner_worker)(
+/*==========================================*/
+	void*	arg __attribute__((unused)))
+			/*!< in: a dummy parameter required by
+			os_thread_create */
+{
+	ut_ad(!srv_read_only_mode);
+
+#ifdef UNIV_PFS_THREAD
+	pfs_register_thread(buf_page_cleaner_worker_thread_key);
+#endif /* UNIV_PFS_THREAD */
+
+#ifdef UNIV_DEBUG_THREAD_CREATION
+	fprintf(stderr, "InnoDB: page_cleaner worker running, id %lu\n",
+		os_thread_pf(os_thread_get_curr_id()));
+#endif /* UNIV_DEBUG_THREAD_CREATION */
+
+	for (;;) {
+		bool	is_running;
+
+		os_event_wait(page_cleaner->is_requested);
+
+		mutex_enter(&page_cleaner->mutex);
+		is_running = page_cleaner->is_running;
+		mutex_exit(&page_cleaner->mutex);
+
+		if (!is_running) {
+			break;
+		}
+
+		page_cleaner_flush_slot();
+	}
+
+	mutex_enter(&page_cleaner->mutex);
+	ut_a(page_cleaner->n_workers > 0);
+	page_cleaner->n_workers--;
+	mutex_exit(&page_cleaner->mutex);
+
+	/* We count the number of threads in os_thread_exit(). A created
+	thread should always use that to exit and not use return() to exit. */
+	os_thread_exit(NULL);
+
+	OS_THREAD_DUMMY_RETURN;
+}
+
+/******************************************************************//**
+page_cleaner coordinator thread tasked with flushing dirty pages from
+the buffer pools. It decides how much to flush and spawns
+innodb_page_cleaners - 1 worker threads which flush the buffer pool
+instances in parallel with it.
 @return a dummy parameter */
 extern "C" UNIV_INTERN
 os_thread_ret_t
@@ -2409,6 +2831,18 @@ DECLARE_THREAD(buf_flush_page_cleaner_thread)(
 		os_thread_pf(os_thread_get_curr_id()));
 #endif /* UNIV_DEBUG_THREAD_CREATION */
 
+	page_cleaner_create();
+
+	ut_a(srv_n_page_cleaners >= 1);
+
+	for (ulint i = 1; i < srv_n_page_cleaners; i++) {
+		mutex_enter(&page_cleaner->mutex);
+		page_cleaner->n_workers++;
+		mutex_exit(&page_cleaner->mutex);
+
+		os_thread_create(buf_flush_page_cleaner_worker, NULL, NULL);
+	}
+
 	buf_page_cleaner_is_active = TRUE;
 
 	while (srv_shutdown_state == SRV_SHUTDOWN_NONE) {
@@ -2425,17 +2859,20 @@ DECLARE_THREAD(buf_flush_page_cleaner_thread)(
 		next_loop_time = ut_time_ms() + 1000;
 
 		if (srv_check_activity(last_activity)) {
-			last_activity = srv_get_activity_count();
+			ulint	n_flushed_lru;
 
-			/* Flush pages from end of LRU if required */
-			n_flushed = buf_flush_LRU_tail();
+			last_activity = srv_get_activity_count();
 
-			/* Flush pages from flush_list if required */
-			n_flushed += page_cleaner_flush_pages_if_needed();
+			/* Flush pages from end of LRU and from flush_list
+			if required */
+			n_flushed = page_cleaner_flush_pages_if_needed(
+				&n_flushed_lru);
+			n_flushed += n_flushed_lru;
 		} else {
 			n_flushed = page_cleaner_do_flush_batch(
 							PCT_IO(100),
-							LSN_MAX);
+							LSN_MAX,
+							false, NULL);
 
 			if (n_flushed) {
 				MONITOR_INC_VALUE_CUMULATIVE(
@@ -2467,7 +2904,8 @@ DECLARE_THREAD(buf_flush_page_cleaner_thread)(
 	dirtied until we enter SRV_SHUTDOWN_FLUSH_PHASE phase. */
 
 	do {
-		n_flushed = page_cleaner_do_flush_batch(PCT_IO(100), LSN_MAX);
+		n_flushed = page_cleaner_do_flush_batch(
+			PCT_IO(100), LSN_MAX, false, NULL);
 
 		/* We sleep only if there are no pages to flush */
 		if (n_flushed == 0) {
@@ -2510,6 +2948,10 @@ DECLARE_THREAD(buf_flush_page_cleaner_thread)(
 	/* We have lived our life. Time to die. */
 
 thread_exit:
+	/* The worker threads must be gone before we report that the
+	page_cleaner is not active. */
+	page_cleaner_free();
+
 	buf_page_cleaner_is_active = FALSE;
 
 	/* We count the number of threads in os_thread_exit(). A created
@@ -427,36 +427,59 @@ buf_read_page(
 }
 
 /********************************************************************//**
-High-level function which reads a page asynchronously from a file to the
-buffer buf_pool if it is not already there. Sets the io_fix flag and sets
-an exclusive lock on the buffer frame. The flag is cleared and the x-lock
-released by the i/o-handler thread.
-@return TRUE if page has been read in, FALSE in case of failure */
+Issues asynchronous read requests for a run of adjacent pages of a buffer
+pool dump, for the pages that are not already in buf_pool. The aio
+segment of a request is chosen by its offset in units of 64 pages, so the
+requests of a run that does not cross a multiple of 64 pages are served by
+the same i/o-handler thread, which merges them into one read with simulated
+aio. Waits while the pending reads occupy half of a buffer pool instance.
+@return number of page read requests issued */
 UNIV_INTERN
-ibool
-buf_read_page_async(
+ulint
+buf_read_load_pages(
 /*================*/
 	ulint	space,	/*!< in: space id */
-	ulint	offset)	/*!< in: page number */
+	ulint	offset,	/*!< in: number of the first page */
+	ulint	n_pages)/*!< in: number of pages */
 {
 	ulint		zip_size;
 	ib_int64_t	tablespace_version;
-	ulint		count;
+	ulint		count = 0;
 	dberr_t		err;
+	ulint		i;
 
 	zip_size = fil_space_get_zip_size(space);
 
 	if (zip_size == ULINT_UNDEFINED) {
-		return(FALSE);
+		return(0);
 	}
 
 	tablespace_version = fil_space_get_version(space);
 
-	count = buf_read_page_low(&err, true, BUF_READ_ANY_PAGE
-				  | OS_AIO_SIMULATED_WAKE_LATER
-				  | BUF_READ_IGNORE_NONEXISTENT_PAGES,
-				  space, zip_size, FALSE,
-				  tablespace_version, offset);
+	for (i = offset; i < offset + n_pages; i++) {
+		buf_pool_t*	buf_pool = buf_pool_get(space, i);
+
+		while (buf_pool->n_pend_reads
+		       > buf_pool->curr_size / BUF_READ_AHEAD_PEND_LIMIT) {
+			os_aio_simulated_wake_handler_threads();
+			os_thread_sleep(10000);
+		}
+
+		count += buf_read_page_low(
+			&err, false, BUF_READ_ANY_PAGE
+			| OS_AIO_SIMULATED_WAKE_LATER
+			| BUF_READ_IGNORE_NONEXISTENT_PAGES,
+			space, zip_size, FALSE, tablespace_version, i);
+
+		if (err == DB_TABLESPACE_DELETED) {
+			break;
+		}
+	}
+
+	/* In simulated aio we wake the aio handler threads only after
+	queuing all the requests of the run, so that they are merged */
+	os_aio_simulated_wake_handler_threads();
+
 	srv_stats.buf_pool_reads.add(count);
 
 	/* We do not increment number of I/O operations used for LRU policy
@@ -466,7 +489,7 @@ buf_read_page_async(
 	these IOs are deliberate and are not part of normal workload we can
 	ignore these in our heuristics. */
 
-	return(count > 0);
+	return(count);
 }
 
 /********************************************************************//**
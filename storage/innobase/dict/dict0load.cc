@@ -34,6 +34,7 @@ Created 4/24/1996 Heikki Tuuri
 #include "btr0pcur.h"
 #include "btr0btr.h"
 #include "page0page.h"
+#include "page0zip.h"
 #include "mach0data.h"
 #include "dict0dict.h"
 #include "dict0boot.h"
@@ -767,6 +768,12 @@ dict_sys_tables_get_flags(
 		return(ULINT_UNDEFINED);
 	}
 
+	/* Refuse the tables whose pages this build cannot decompress,
+	like an older engine that does not know the ZIP_CODEC field. */
+	if (!page_zip_codec_available(DICT_TF_GET_ZIP_CODEC(type))) {
+		return(ULINT_UNDEFINED);
+	}
+
 	return(dict_sys_tables_type_to_tf(type, n_cols));
 }
 
@@ -1088,6 +1095,12 @@ loop:
 			goto next_tablespace;
 		}
 
+		if (fil_tablespace_is_filtered(name)) {
+			/* XtraBackup: the tablespace is excluded from
+			recovery, do not complain about it. */
+			goto next_tablespace;
+		}
+
 		switch (dict_check) {
 		case DICT_CHECK_ALL_LOADED:
 			/* All tablespaces should have been found in
@@ -2344,6 +2357,10 @@ err_exit:
 
 		table->ibd_file_missing = TRUE;
 
+	} else if (fil_tablespace_is_filtered(name)) {
+		/* XtraBackup: the tablespace is excluded from recovery */
+		table->ibd_file_missing = TRUE;
+
 	} else if (!fil_space_for_table_exists_in_mem(
 			table->space, name, FALSE, FALSE, true, heap,
 			table->id)) {
@@ -129,6 +129,10 @@ UNIV_INTERN ulint	fil_n_pending_tablespace_flushes	= 0;
 /** Number of files currently open */
 UNIV_INTERN ulint	fil_n_file_opened			= 0;
 
+/** XtraBackup: filter for tablespaces to recover, see fil0fil.h */
+UNIV_INTERN ibool	(*fil_tablespace_filter)(const char* db,
+						 const char* table) = NULL;
+
 /** The null file address */
 UNIV_INTERN fil_addr_t	fil_addr_null = {FIL_NULL, 0};
 
@@ -3538,6 +3542,10 @@ fil_open_single_table_tablespace(
 		return(DB_CORRUPTION);
 	}
 
+	if (fil_tablespace_is_filtered(tablename)) {
+		return(DB_TABLESPACE_NOT_FOUND);
+	}
+
 	/* If the tablespace was relocated, we do not
 	compare the DATA_DIR flag */
 	ulint mod_flags = flags & ~FSP_FLAGS_MASK_DATA_DIR;
@@ -4362,6 +4370,36 @@ fil_file_readdir_next_file(
 	return(-1);
 }
 
+/*******************************************************************//**
+XtraBackup: checks if the tablespace of a table is excluded from recovery by
+fil_tablespace_filter.
+@return true if the tablespace must not be opened */
+UNIV_INTERN
+bool
+fil_tablespace_is_filtered(
+/*=======================*/
+	const char*	name)	/*!< in: table name in the
+				databasename/tablename format */
+{
+	char		db[OS_FILE_MAX_PATH];
+	const char*	sep;
+
+	if (fil_tablespace_filter == NULL) {
+		return(false);
+	}
+
+	sep = strchr(name, '/');
+
+	if (sep == NULL || (ulint) (sep - name) >= sizeof(db)) {
+		return(false);
+	}
+
+	memcpy(db, name, sep - name);
+	db[sep - name] = '\0';
+
+	return(!fil_tablespace_filter(db, sep + 1));
+}
+
 /********************************************************************//**
 At the server startup, if we need crash recovery, scans the database
 directories under the MySQL datadir, looking for .ibd files. Those files are
@@ -4395,6 +4433,10 @@ fil_load_single_table_tablespaces(ibool (*pred)(const char*, const char*))
 
 	dbpath = static_cast<char*>(mem_alloc(dbpath_len));
 
+	if (pred == NULL) {
+		pred = fil_tablespace_filter;
+	}
+
 	/* Scan all directories under the datadir. They are the database
 	directories of MySQL. */
 
@@ -231,6 +231,24 @@ TYPELIB innodb_checksum_algorithm_typelib = {
 	NULL
 };
 
+/** Possible values of system variable "innodb_compression_algorithm",
+in the order of page_zip_codec_t. */
+static const char* innodb_compression_algorithm_names[] = {
+	"zlib",
+	"lz4",
+	"zstd",
+	NullS
+};
+
+/** Used to define an enumerate type of the system variable
+innodb_compression_algorithm. */
+static TYPELIB innodb_compression_algorithm_typelib = {
+	array_elements(innodb_compression_algorithm_names) - 1,
+	"innodb_compression_algorithm_typelib",
+	innodb_compression_algorithm_names,
+	NULL
+};
+
 /* The following counter is used to convey information to InnoDB
 about server activity: in selects it is not sensible to call
 srv_active_wake_master_thread after each fetch or search, we only do
@@ -297,6 +315,7 @@ static PSI_mutex_info all_innodb_mutexes[] = {
 	{&file_format_max_mutex_key, "file_format_max_mutex", 0},
 	{&fil_system_mutex_key, "fil_system_mutex", 0},
 	{&flush_list_mutex_key, "flush_list_mutex", 0},
+	{&page_cleaner_mutex_key, "page_cleaner_mutex", 0},
 	{&fts_bg_threads_mutex_key, "fts_bg_threads_mutex", 0},
 	{&fts_delete_mutex_key, "fts_delete_mutex", 0},
 	{&fts_optimize_mutex_key, "fts_optimize_mutex", 0},
@@ -336,7 +355,8 @@ static PSI_mutex_info all_innodb_mutexes[] = {
 	{&buf_dblwr_mutex_key, "buf_dblwr_mutex", 0},
 	{&trx_undo_mutex_key, "trx_undo_mutex", 0},
 	{&srv_sys_mutex_key, "srv_sys_mutex", 0},
-	{&lock_sys_mutex_key, "lock_mutex", 0},
+	{&lock_sys_rec_mutex_key, "lock_rec_mutex", 0},
+	{&lock_sys_table_mutex_key, "lock_table_mutex", 0},
 	{&lock_sys_wait_mutex_key, "lock_wait_mutex", 0},
 	{&trx_mutex_key, "trx_mutex", 0},
 	{&srv_sys_tasks_mutex_key, "srv_threads_mutex", 0},
@@ -377,6 +397,7 @@ static PSI_rwlock_info all_innodb_rwlocks[] = {
 	{&checkpoint_lock_key, "checkpoint_lock", 0},
 	{&fts_cache_rw_lock_key, "fts_cache_rw_lock", 0},
 	{&fts_cache_init_rw_lock_key, "fts_cache_init_rw_lock", 0},
+	{&lock_sys_latch_key, "lock_sys_latch", 0},
 	{&trx_i_s_cache_lock_key, "trx_i_s_cache_lock", 0},
 	{&trx_purge_latch_key, "trx_purge_latch", 0},
 	{&index_tree_rw_lock_key, "index_tree_rw_lock", 0},
@@ -399,6 +420,7 @@ static PSI_thread_info	all_innodb_threads[] = {
 	{&srv_master_thread_key, "srv_master_thread", 0},
 	{&srv_purge_thread_key, "srv_purge_thread", 0},
 	{&buf_page_cleaner_thread_key, "page_cleaner_thread", 0},
+	{&buf_page_cleaner_worker_thread_key, "page_cleaner_worker_thread", 0},
 	{&recv_writer_thread_key, "recv_writer_thread", 0}
 };
 # endif /* UNIV_PFS_THREAD */
@@ -1172,7 +1194,8 @@ innobase_srv_conc_exit_innodb(
 	trx_t*	trx)	/*!< in: transaction handle */
 {
 #ifdef UNIV_SYNC_DEBUG
-	ut_ad(!sync_thread_levels_nonempty_trx(trx->has_search_latch));
+	ut_ad(!sync_thread_levels_nonempty_trx(
+		trx->has_search_latch != NULL));
 #endif /* UNIV_SYNC_DEBUG */
 
 	/* This is to avoid making an unnecessary function call. */
@@ -1192,7 +1215,8 @@ innobase_srv_conc_force_exit_innodb(
 	trx_t*	trx)	/*!< in: transaction handle */
 {
 #ifdef UNIV_SYNC_DEBUG
-	ut_ad(!sync_thread_levels_nonempty_trx(trx->has_search_latch));
+	ut_ad(!sync_thread_levels_nonempty_trx(
+		trx->has_search_latch != NULL));
 #endif /* UNIV_SYNC_DEBUG */
 
 	/* This is to avoid making an unnecessary function call. */
@@ -3172,6 +3196,25 @@ innobase_change_buffering_inited_ok:
 
 	srv_use_doublewrite_buf = (ibool) innobase_use_doublewrite;
 
+	if (srv_parallel_doublewrite_path != NULL) {
+		ulint	digits = 1;
+
+		/* The parallel doublewrite file names consist of the
+		prefix, "_" and the number of the buffer pool instance */
+		for (ulint n = MAX_BUFFER_POOLS - 1; n >= 10; n /= 10) {
+			digits++;
+		}
+
+		if (strlen(srv_parallel_doublewrite_path) + digits + 2
+		    > OS_FILE_MAX_PATH) {
+			sql_print_error("InnoDB: innodb_parallel_doublewrite_"
+					"path is longer than %lu characters",
+					(ulong) (OS_FILE_MAX_PATH
+						 - digits - 2));
+			goto mem_free_and_error;
+		}
+	}
+
 	if (!innobase_use_checksums) {
 		ut_print_timestamp(stderr);
 		fprintf(stderr,
@@ -4684,7 +4727,7 @@ ha_innobase::open(
 	thd = ha_thd();
 
 	/* Under some cases MySQL seems to call this function while
-	holding btr_search_latch. This breaks the latching order as
+	holding an adaptive hash index latch. This breaks the latching order as
 	we acquire dict_sys->mutex below and leads to a deadlock. */
 	if (thd != NULL) {
 		innobase_release_temporary_latches(ht, thd);
@@ -9422,7 +9465,12 @@ index_bad:
 		       && ((create_info->data_file_name != NULL)
 		       && !(create_info->options & HA_LEX_CREATE_TMP_TABLE));
 
-	dict_tf_set(flags, innodb_row_format, zip_ssize, use_data_dir);
+	/* The pages of a compressed table are compressed with the
+	algorithm that innodb_compression_algorithm names when the
+	table is created or rebuilt. */
+	dict_tf_set(flags, innodb_row_format, zip_ssize,
+		    zip_ssize ? page_zip_codec : PAGE_ZIP_CODEC_ZLIB,
+		    use_data_dir);
 
 	if (create_info->options & HA_LEX_CREATE_TMP_TABLE) {
 		*flags2 |= DICT_TF2_TEMPORARY;
@@ -14444,6 +14492,75 @@ innodb_change_buffering_validate(
 	return(1);
 }
 
+/*************************************************************//**
+Check if it is a valid value of innodb_compression_algorithm, that is,
+the name or number of a compression algorithm that is available in this
+build. This function is registered as a callback with MySQL.
+@return	0 for valid innodb_compression_algorithm */
+static
+int
+innodb_compression_algorithm_validate(
+/*==================================*/
+	THD*				thd,	/*!< in: thread handle */
+	struct st_mysql_sys_var*	var,	/*!< in: pointer to system
+						variable */
+	void*				save,	/*!< out: immediate result
+						for update function */
+	struct st_mysql_value*		value)	/*!< in: incoming string
+						or integer */
+{
+	ulint		codec;
+	char		buff[STRING_BUFFER_USUAL_SIZE];
+	int		len = sizeof(buff);
+
+	ut_a(save != NULL);
+	ut_a(value != NULL);
+
+	if (value->value_type(value) == MYSQL_VALUE_TYPE_STRING) {
+		const char*	algorithm_input;
+
+		algorithm_input = value->val_str(value, buff, &len);
+
+		if (algorithm_input == NULL) {
+			return(1);
+		}
+
+		for (codec = 0; codec <= PAGE_ZIP_CODEC_MAX; codec++) {
+			const char*	name
+				= innodb_compression_algorithm_names[codec];
+
+			if (!innobase_strcasecmp(algorithm_input, name)) {
+				break;
+			}
+		}
+	} else {
+		long long	intbuf;
+
+		value->val_int(value, &intbuf);
+
+		codec = (intbuf < 0 || intbuf > PAGE_ZIP_CODEC_MAX)
+			? PAGE_ZIP_CODEC_MAX + 1
+			: (ulint) intbuf;
+	}
+
+	if (codec > PAGE_ZIP_CODEC_MAX) {
+		return(1);
+	}
+
+	if (!page_zip_codec_available(codec)) {
+		push_warning_printf(thd, Sql_condition::WARN_LEVEL_WARN,
+				    ER_WRONG_ARGUMENTS,
+				    "InnoDB: compression algorithm %s"
+				    " is not available in this build.",
+				    innodb_compression_algorithm_names[codec]);
+		return(1);
+	}
+
+	*static_cast<ulong*>(save) = codec;
+
+	return(0);
+}
+
 /****************************************************************//**
 Update the system variable innodb_change_buffering using the "saved"
 value. This function is registered as a callback with MySQL. */
@@ -15632,6 +15749,15 @@ static MYSQL_SYSVAR_ULONG(purge_threads, srv_n_purge_threads,
   1,			/* Minimum value */
   32, 0);		/* Maximum value */
 
+static MYSQL_SYSVAR_ULONG(page_cleaners, srv_n_page_cleaners,
+  PLUGIN_VAR_OPCMDARG | PLUGIN_VAR_READONLY,
+  "Page cleaner threads can be from 1 to 64, capped by the number of "
+  "buffer pool instances. Default is 1.",
+  NULL, NULL,
+  1,			/* Default setting */
+  1,			/* Minimum value */
+  64, 0);		/* Maximum value */
+
 static MYSQL_SYSVAR_ULONG(sync_array_size, srv_sync_array_size,
   PLUGIN_VAR_OPCMDARG | PLUGIN_VAR_READONLY,
   "Size of the mutex/lock wait array.",
@@ -15828,6 +15954,15 @@ static MYSQL_SYSVAR_BOOL(adaptive_hash_index, btr_search_enabled,
   "Disable with --skip-innodb-adaptive-hash-index.",
   NULL, innodb_adaptive_hash_index_update, TRUE);
 
+static MYSQL_SYSVAR_ULONG(adaptive_hash_index_parts, btr_ahi_parts,
+  PLUGIN_VAR_OPCMDARG | PLUGIN_VAR_READONLY,
+  "Number of InnoDB adaptive hash index partitions, each protected by its "
+  "own latch. Indexes are assigned to partitions by index id. Default is 8.",
+  NULL, NULL,
+  8,			/* Default setting */
+  1,			/* Minimum value */
+  512, 0);		/* Maximum value */
+
 static MYSQL_SYSVAR_ULONG(replication_delay, srv_replication_delay,
   PLUGIN_VAR_RQCMDARG,
   "Replication thread delay (ms) on the slave server if "
@@ -15840,6 +15975,17 @@ static MYSQL_SYSVAR_UINT(compression_level, page_zip_level,
   ", 1 is fastest, 9 is best compression and default is 6.",
   NULL, NULL, DEFAULT_COMPRESSION_LEVEL, 0, 9, 0);
 
+static MYSQL_SYSVAR_ENUM(compression_algorithm, page_zip_codec,
+  PLUGIN_VAR_RQCMDARG,
+  "Compression algorithm of the tables that are created or rebuilt with "
+  "ROW_FORMAT=COMPRESSED. Possible values are "
+  "ZLIB (the default, readable by all versions), "
+  "LZ4 (fastest) and ZSTD (fast, with better compression than zlib); "
+  "LZ4 and ZSTD are available if InnoDB was built with the libraries. "
+  "Tables using LZ4 or ZSTD are not readable by older versions.",
+  innodb_compression_algorithm_validate, NULL, PAGE_ZIP_CODEC_ZLIB,
+  &innodb_compression_algorithm_typelib);
+
 static MYSQL_SYSVAR_BOOL(log_compressed_pages, page_zip_log_pages,
        PLUGIN_VAR_OPCMDARG,
   "Enables/disables the logging of entire compressed page images."
@@ -15875,7 +16021,8 @@ static MYSQL_SYSVAR_ULONG(page_hash_locks, srv_n_page_hash_locks,
 
 static MYSQL_SYSVAR_ULONG(doublewrite_batch_size, srv_doublewrite_batch_size,
   PLUGIN_VAR_OPCMDARG | PLUGIN_VAR_READONLY,
-  "Number of pages reserved in doublewrite buffer for batch flushing",
+  "Number of pages reserved in doublewrite buffer for batch flushing. Has "
+  "no effect if innodb_parallel_doublewrite_path is set.",
   NULL, NULL, 120, 1, 127, 0);
 #endif /* defined UNIV_DEBUG || defined UNIV_PERF_DEBUG */
 
@@ -15922,6 +16069,14 @@ static MYSQL_SYSVAR_BOOL(buffer_pool_load_at_startup, srv_buffer_pool_load_at_st
   "Load the buffer pool from a file named @@innodb_buffer_pool_filename",
   NULL, NULL, FALSE);
 
+static MYSQL_SYSVAR_BOOL(buffer_pool_load_throttle,
+  srv_buffer_pool_load_throttle,
+  PLUGIN_VAR_RQCMDARG,
+  "Load the buffer pool at most innodb_io_capacity pages per second, to "
+  "leave i/o capacity to the workload. By default the load reads the "
+  "pages as fast as possible.",
+  NULL, NULL, FALSE);
+
 static MYSQL_SYSVAR_ULONG(lru_scan_depth, srv_LRU_scan_depth,
   PLUGIN_VAR_RQCMDARG,
   "How deep to scan LRU to keep it clean",
@@ -16007,6 +16162,23 @@ static MYSQL_SYSVAR_ULONG(sort_buffer_size, srv_sort_buf_size,
   "Memory buffer size for index creation",
   NULL, NULL, 1048576, 65536, 64<<20, 0);
 
+static MYSQL_SYSVAR_ULONG(merge_sort_threads, srv_merge_sort_threads,
+  PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
+  "Number of threads merging the sorted index entries of an index in "
+  "index creation. When several indexes are created without allowing "
+  "concurrent DML (LOCK=SHARED or LOCK=EXCLUSIVE) and none of them is "
+  "FULLTEXT, the threads also build the indexes concurrently; online "
+  "index creation builds the indexes one at a time. Each thread "
+  "allocates 3 times innodb_sort_buffer_size. Default is 1.",
+  NULL, NULL, 1, 1, 64, 0);
+
+static MYSQL_SYSVAR_ULONG(fill_factor, srv_fill_factor,
+  PLUGIN_VAR_RQCMDARG,
+  "Percentage of each B-tree page filled with records when the sorted "
+  "entries of a new index are loaded. The rest is left free for later "
+  "growth. Default is 100.",
+  NULL, NULL, 100, 10, 100, 0);
+
 static MYSQL_SYSVAR_ULONGLONG(online_alter_log_max_size, srv_online_max_size,
   PLUGIN_VAR_RQCMDARG,
   "Maximum modification log file size for online index creation",
@@ -16124,6 +16296,16 @@ static MYSQL_SYSVAR_STR(data_file_path, innobase_data_file_path,
   "Path to individual files and their sizes.",
   NULL, NULL, NULL);
 
+static MYSQL_SYSVAR_STR(parallel_doublewrite_path,
+  srv_parallel_doublewrite_path,
+  PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
+  "Name prefix of the files the batch flushes of each buffer pool instance "
+  "are doublewritten to, relative to the data directory, e.g. "
+  "xb_doublewrite. Not set by default, which uses the doublewrite buffer in "
+  "the system tablespace for all flushes. Each of the files holds 128 pages "
+  "for each flush type regardless of innodb_doublewrite_batch_size.",
+  NULL, NULL, NULL);
+
 static MYSQL_SYSVAR_STR(undo_directory, srv_undo_dir,
   PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
   "Directory where undo tablespace files live, this path can be absolute.",
@@ -16347,6 +16529,7 @@ static struct st_mysql_sys_var* innobase_system_variables[]= {
   MYSQL_SYSVAR(buffer_pool_load_now),
   MYSQL_SYSVAR(buffer_pool_load_abort),
   MYSQL_SYSVAR(buffer_pool_load_at_startup),
+  MYSQL_SYSVAR(buffer_pool_load_throttle),
   MYSQL_SYSVAR(lru_scan_depth),
   MYSQL_SYSVAR(flush_neighbors),
   MYSQL_SYSVAR(checksum_algorithm),
@@ -16356,9 +16539,11 @@ static struct st_mysql_sys_var* innobase_system_variables[]= {
   MYSQL_SYSVAR(commit_concurrency),
   MYSQL_SYSVAR(concurrency_tickets),
   MYSQL_SYSVAR(compression_level),
+  MYSQL_SYSVAR(compression_algorithm),
   MYSQL_SYSVAR(data_file_path),
   MYSQL_SYSVAR(data_home_dir),
   MYSQL_SYSVAR(doublewrite),
+  MYSQL_SYSVAR(parallel_doublewrite_path),
   MYSQL_SYSVAR(api_enable_binlog),
   MYSQL_SYSVAR(api_enable_mdl),
   MYSQL_SYSVAR(api_disable_rowlock),
@@ -16424,12 +16609,15 @@ static struct st_mysql_sys_var* innobase_system_variables[]= {
   MYSQL_SYSVAR(stats_persistent_sample_pages),
   MYSQL_SYSVAR(stats_auto_recalc),
   MYSQL_SYSVAR(adaptive_hash_index),
+  MYSQL_SYSVAR(adaptive_hash_index_parts),
   MYSQL_SYSVAR(stats_method),
   MYSQL_SYSVAR(replication_delay),
   MYSQL_SYSVAR(status_file),
   MYSQL_SYSVAR(strict_mode),
   MYSQL_SYSVAR(support_xa),
   MYSQL_SYSVAR(sort_buffer_size),
+  MYSQL_SYSVAR(merge_sort_threads),
+  MYSQL_SYSVAR(fill_factor),
   MYSQL_SYSVAR(online_alter_log_max_size),
   MYSQL_SYSVAR(sync_spin_loops),
   MYSQL_SYSVAR(spin_wait_delay),
@@ -16459,6 +16647,7 @@ static struct st_mysql_sys_var* innobase_system_variables[]= {
   MYSQL_SYSVAR(monitor_reset),
   MYSQL_SYSVAR(monitor_reset_all),
   MYSQL_SYSVAR(purge_threads),
+  MYSQL_SYSVAR(page_cleaners),
   MYSQL_SYSVAR(purge_batch_size),
 #ifdef UNIV_DEBUG
   MYSQL_SYSVAR(purge_run_now),
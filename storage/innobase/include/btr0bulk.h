@@ -0,0 +1,78 @@
+/*****************************************************************************
+
+Copyright (c) 2014, Percona Inc. All Rights Reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Suite 500, Boston, MA 02110-1335 USA
+
+*****************************************************************************/
+
+/********************************************************************//**
+@file include/btr0bulk.h
+Bottom-up bulk loading of a B-tree from sorted index entries
+
+The leaf pages are filled from left to right, leaving innodb_fill_factor
+percent of each page free, and the node pointer to a page is inserted to the
+page of the next level up when the page is full. When all the entries have
+been inserted, the single page of the top level is copied to the root page.
+
+The index must be empty, uncompressed, and not accessed by other threads,
+and the entries must be in ascending order with no externally stored
+columns, as when building a new index in row_merge_insert_index_tuples().
+*************************************************************************/
+
+#ifndef btr0bulk_h
+#define btr0bulk_h
+
+#include "univ.i"
+#include "data0types.h"
+#include "dict0types.h"
+#include "trx0types.h"
+
+/** Bulk loader of an index tree */
+struct btr_bulk_t;
+
+/*********************************************************************//**
+Create a bulk loader of an empty index tree.
+@return own: bulk loader */
+UNIV_INTERN
+btr_bulk_t*
+btr_bulk_create(
+/*============*/
+	dict_index_t*	index,	/*!< in: empty index */
+	trx_id_t	trx_id)	/*!< in: transaction building the index */
+	__attribute__((nonnull, warn_unused_result));
+/*********************************************************************//**
+Append an index entry to the tree being loaded. The entry must be greater
+than the previous one.
+@return DB_SUCCESS or error code */
+UNIV_INTERN
+dberr_t
+btr_bulk_insert(
+/*============*/
+	btr_bulk_t*		bulk,	/*!< in/out: bulk loader */
+	const dtuple_t*		entry)	/*!< in: index entry */
+	__attribute__((nonnull, warn_unused_result));
+/*********************************************************************//**
+Finish loading the tree and free the bulk loader. On error, the pages are
+released but the tree is left incomplete, and the index must be dropped.
+@return DB_SUCCESS or error code */
+UNIV_INTERN
+dberr_t
+btr_bulk_finish(
+/*============*/
+	btr_bulk_t*	bulk,	/*!< in,own: bulk loader */
+	dberr_t		err)	/*!< in: DB_SUCCESS, or the error
+				that stopped the loading */
+	__attribute__((nonnull, warn_unused_result));
+
+#endif /* btr0bulk_h */
@@ -79,14 +79,78 @@ btr_search_info_create(
 /*===================*/
 	mem_heap_t*	heap);	/*!< in: heap where created */
 /*****************************************************************//**
-Returns the value of ref_count. The value is protected by
-btr_search_latch.
+Returns the value of ref_count. The value is protected by the
+adaptive hash index partition latch of the index.
 @return	ref_count value. */
 UNIV_INTERN
 ulint
 btr_search_info_get_ref_count(
 /*==========================*/
-	btr_search_t*   info);	/*!< in: search info. */
+	btr_search_t*		info,	/*!< in: search info. */
+	const dict_index_t*	index);	/*!< in: index */
+/********************************************************************//**
+Returns the latch of the adaptive hash index partition of an index.
+@return	partition latch */
+UNIV_INLINE
+rw_lock_t*
+btr_search_get_latch(
+/*=================*/
+	const dict_index_t*	index)	/*!< in: index */
+	__attribute__((nonnull, pure, warn_unused_result));
+/********************************************************************//**
+Returns the hash table of the adaptive hash index partition of an index.
+@return	partition hash table */
+UNIV_INLINE
+hash_table_t*
+btr_search_get_hash_table(
+/*======================*/
+	const dict_index_t*	index)	/*!< in: index */
+	__attribute__((nonnull, pure, warn_unused_result));
+/********************************************************************//**
+X-latches the latches of all the adaptive hash index partitions. */
+UNIV_INLINE
+void
+btr_search_x_lock_all(void);
+/*========================*/
+/********************************************************************//**
+Releases the X-latches of all the adaptive hash index partitions. */
+UNIV_INLINE
+void
+btr_search_x_unlock_all(void);
+/*==========================*/
+#ifdef UNIV_SYNC_DEBUG
+/********************************************************************//**
+Checks if the thread owns the latch of any adaptive hash index partition.
+@return	TRUE if owns */
+UNIV_INLINE
+ibool
+btr_search_own_any(
+/*===============*/
+	ulint	lock_type)	/*!< in: RW_LOCK_SHARED or RW_LOCK_EX */
+	__attribute__((warn_unused_result));
+/********************************************************************//**
+Checks if the thread owns the latches of all adaptive hash index
+partitions.
+@return	TRUE if owns */
+UNIV_INLINE
+ibool
+btr_search_own_all(
+/*===============*/
+	ulint	lock_type)	/*!< in: RW_LOCK_SHARED or RW_LOCK_EX */
+	__attribute__((warn_unused_result));
+/********************************************************************//**
+Checks if the thread owns the latch of the adaptive hash index partition
+that a hash table belongs to.
+@return	TRUE if owns */
+UNIV_INLINE
+ibool
+btr_search_own_hash_table(
+/*======================*/
+	const hash_table_t*	table,		/*!< in: partition hash table */
+	ulint			lock_type)	/*!< in: RW_LOCK_SHARED or
+						RW_LOCK_EX */
+	__attribute__((nonnull, warn_unused_result));
+#endif /* UNIV_SYNC_DEBUG */
 /*********************************************************************//**
 Updates the search info. */
 UNIV_INLINE
@@ -112,7 +176,8 @@ btr_search_guess_on_hash(
 	ulint		latch_mode,	/*!< in: BTR_SEARCH_LEAF, ... */
 	btr_cur_t*	cursor,		/*!< out: tree cursor */
 	ulint		has_search_latch,/*!< in: latch mode the caller
-					currently has on btr_search_latch:
+					currently has on the adaptive hash
+					index partition latch of the index:
 					RW_S_LATCH, RW_X_LATCH, or 0 */
 	mtr_t*		mtr);		/*!< in: mtr */
 /********************************************************************//**
@@ -198,7 +263,7 @@ struct btr_search_t{
 	ulint	ref_count;	/*!< Number of blocks in this index tree
 				that have search index built
 				i.e. block->index points to this index.
-				Protected by btr_search_latch except
+				Protected by the partition latch except
 				when during initialization in
 				btr_search_info_create(). */
 
@@ -250,8 +315,9 @@ struct btr_search_t{
 
 /** The hash index system */
 struct btr_search_sys_t{
-	hash_table_t*	hash_index;	/*!< the adaptive hash index,
-					mapping dtuple_fold values
+	hash_table_t**	hash_tables;	/*!< the adaptive hash index
+					partitions, btr_ahi_parts hash
+					tables mapping dtuple_fold values
 					to rec_t pointers on index pages */
 };
 
@@ -96,8 +96,12 @@ and also when we may have to wait for a page latch! Otherwise a deadlock
 of threads can occur. */
 UNIV_INTERN
 void
-buf_dblwr_flush_buffered_writes(void);
-/*=================================*/
+buf_dblwr_flush_buffered_writes(
+/*============================*/
+	buf_pool_t*	buf_pool,	/*!< in: buffer pool instance of the
+					batch */
+	buf_flush_t	flush_type);	/*!< in: BUF_FLUSH_LRU or
+					BUF_FLUSH_LIST */
 /********************************************************************//**
 Writes a page to the doublewrite buffer on disk, sync it, then write
 the page to the datafile and sync the datafile. This function is used
@@ -113,19 +117,64 @@ buf_dblwr_write_single_page(
 	buf_page_t*	bpage,	/*!< in: buffer block to write */
 	bool		sync);	/*!< in: true if sync IO requested */
 
-/** Doublewrite control struct */
-struct buf_dblwr_t{
+/** Number of segments in a parallel doublewrite file: one for the LRU
+batches and one for the flush_list batches of a buffer pool instance */
+#define BUF_DBLWR_N_FILE_SEGS		2
+
+/** Number of pages in a segment of a parallel doublewrite file */
+#define BUF_DBLWR_SEG_SIZE		(2 * TRX_SYS_DOUBLEWRITE_BLOCK_SIZE)
+
+/** Doublewrite segment. Buffers the batch flushes of one flush type of
+one buffer pool instance in a parallel doublewrite file, or the batch
+flushes of all the instances in the system tablespace if the parallel
+doublewrite is not used. */
+struct buf_dblwr_seg_t{
 	ib_mutex_t	mutex;	/*!< mutex protecting the first_free
 				field and write_buf */
-	ulint		block1;	/*!< the page number of the first
-				doublewrite block (64 pages) */
-	ulint		block2;	/*!< page number of the second block */
+	ulint		size;	/*!< number of pages in the segment */
+	bool		in_sys;	/*!< true if the segment is the batch
+				part of the doublewrite buffer in the
+				system tablespace */
+	const char*	file_name;/*!< parallel doublewrite file name */
+	os_file_t	file;	/*!< parallel doublewrite file */
+	os_offset_t	offset;	/*!< byte offset of the segment in
+				file */
 	ulint		first_free;/*!< first free position in write_buf
 				measured in units of UNIV_PAGE_SIZE */
 	ulint		b_reserved;/*!< number of slots currently reserved
 				for batch flush. */
 	os_event_t	b_event;/*!< event where threads wait for a
 				batch flush to end. */
+	bool		batch_running;/*!< set to TRUE if currently a batch
+				is being written from the segment. */
+	byte*		write_buf;/*!< write buffer used in writing to the
+				segment, aligned to an address divisible
+				by UNIV_PAGE_SIZE (which is required by
+				Windows aio) */
+	byte*		write_buf_unaligned;/*!< pointer to write_buf,
+				but unaligned */
+	buf_page_t**	buf_block_arr;/*!< array to store pointers to
+				the buffer blocks which have been
+				cached to write_buf */
+};
+
+/** Doublewrite control struct */
+struct buf_dblwr_t{
+	ib_mutex_t	mutex;	/*!< mutex protecting the single page
+				flush fields and write_buf */
+	ulint		block1;	/*!< the page number of the first
+				doublewrite block (64 pages) */
+	ulint		block2;	/*!< page number of the second block */
+	ulint		n_segs;	/*!< number of batch flush segments */
+	buf_dblwr_seg_t*segs;	/*!< batch flush segments, one for each
+				flush type of each buffer pool
+				instance with the parallel
+				doublewrite, else a single one */
+	ulint		n_files;/*!< number of parallel doublewrite
+				files, 0 if not used */
+	os_file_t*	files;	/*!< parallel doublewrite files, one
+				for each buffer pool instance */
+	char**		file_names;/*!< parallel doublewrite file names */
 	ulint		s_reserved;/*!< number of slots currently
 				reserved for single page flushes. */
 	os_event_t	s_event;/*!< event where threads wait for a
@@ -133,9 +182,6 @@ struct buf_dblwr_t{
 	bool*		in_use;	/*!< flag used to indicate if a slot is
 				in use. Only used for single page
 				flushes. */
-	bool		batch_running;/*!< set to TRUE if currently a batch
-				is being written from the doublewrite
-				buffer. */
 	byte*		write_buf;/*!< write buffer used in writing to the
 				doublewrite buffer, aligned to an
 				address divisible by UNIV_PAGE_SIZE
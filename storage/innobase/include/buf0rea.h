@@ -43,17 +43,20 @@ buf_read_page(
 	ulint	zip_size,/*!< in: compressed page size in bytes, or 0 */
 	ulint	offset);/*!< in: page number */
 /********************************************************************//**
-High-level function which reads a page asynchronously from a file to the
-buffer buf_pool if it is not already there. Sets the io_fix flag and sets
-an exclusive lock on the buffer frame. The flag is cleared and the x-lock
-released by the i/o-handler thread.
-@return TRUE if page has been read in, FALSE in case of failure */
+Issues asynchronous read requests for a run of adjacent pages of a buffer
+pool dump, for the pages that are not already in buf_pool. The aio
+segment of a request is chosen by its offset in units of 64 pages, so the
+requests of a run that does not cross a multiple of 64 pages are served by
+the same i/o-handler thread, which merges them into one read with simulated
+aio. Waits while the pending reads occupy half of a buffer pool instance.
+@return number of page read requests issued */
 UNIV_INTERN
-ibool
-buf_read_page_async(
+ulint
+buf_read_load_pages(
 /*================*/
 	ulint	space,	/*!< in: space id */
-	ulint	offset);/*!< in: page number */
+	ulint	offset,	/*!< in: number of the first page */
+	ulint	n_pages);/*!< in: number of pages */
 /********************************************************************//**
 Applies a random read-ahead in buf_pool if there are at least a threshold
 value of accessed pages from the random read-ahead area. Does not read any
@@ -119,12 +119,24 @@ innodb-file-per-table, an older engine will not be able to find that table.
 This flag prevents older engines from attempting to open the table and
 allows InnoDB to update_create_info() accordingly. */
 #define DICT_TF_WIDTH_DATA_DIR		1
+/** Width of the RESERVED bits.  MySQL 5.7 and later use the bit that
+follows DATA_DIR for the SHARED_SPACE flag, and other forks of InnoDB use
+the bits up to 23.  They are kept zero, for the same reason as the
+RESERVED bits of the tablespace flags. */
+#define DICT_TF_WIDTH_RESERVED		17
+/** Width of the ZIP_CODEC field, the page_zip_codec_t that the pages of
+a ROW_FORMAT=COMPRESSED table are compressed with.  It is 0 for zlib, so
+that tables created before the field was introduced keep using zlib, and
+an older engine will not open a table that uses another algorithm. */
+#define DICT_TF_WIDTH_ZIP_CODEC		2
 
 /** Width of all the currently known table flags */
 #define DICT_TF_BITS	(DICT_TF_WIDTH_COMPACT		\
 			+ DICT_TF_WIDTH_ZIP_SSIZE	\
 			+ DICT_TF_WIDTH_ATOMIC_BLOBS	\
-			+ DICT_TF_WIDTH_DATA_DIR)
+			+ DICT_TF_WIDTH_DATA_DIR	\
+			+ DICT_TF_WIDTH_RESERVED	\
+			+ DICT_TF_WIDTH_ZIP_CODEC)
 
 /** A mask of all the known/used bits in table flags */
 #define DICT_TF_BIT_MASK	(~(~0 << DICT_TF_BITS))
@@ -140,9 +152,15 @@ allows InnoDB to update_create_info() accordingly. */
 /** Zero relative shift position of the DATA_DIR field */
 #define DICT_TF_POS_DATA_DIR		(DICT_TF_POS_ATOMIC_BLOBS	\
 					+ DICT_TF_WIDTH_ATOMIC_BLOBS)
-/** Zero relative shift position of the start of the UNUSED bits */
-#define DICT_TF_POS_UNUSED		(DICT_TF_POS_DATA_DIR		\
+/** Zero relative shift position of the RESERVED bits */
+#define DICT_TF_POS_RESERVED		(DICT_TF_POS_DATA_DIR		\
 					+ DICT_TF_WIDTH_DATA_DIR)
+/** Zero relative shift position of the ZIP_CODEC field */
+#define DICT_TF_POS_ZIP_CODEC		(DICT_TF_POS_RESERVED		\
+					+ DICT_TF_WIDTH_RESERVED)
+/** Zero relative shift position of the start of the UNUSED bits */
+#define DICT_TF_POS_UNUSED		(DICT_TF_POS_ZIP_CODEC		\
+					+ DICT_TF_WIDTH_ZIP_CODEC)
 
 /** Bit mask of the COMPACT field */
 #define DICT_TF_MASK_COMPACT				\
@@ -160,6 +178,14 @@ allows InnoDB to update_create_info() accordingly. */
 #define DICT_TF_MASK_DATA_DIR				\
 		((~(~0 << DICT_TF_WIDTH_DATA_DIR))	\
 		<< DICT_TF_POS_DATA_DIR)
+/** Bit mask of the RESERVED bits */
+#define DICT_TF_MASK_RESERVED				\
+		((~(~0 << DICT_TF_WIDTH_RESERVED))	\
+		<< DICT_TF_POS_RESERVED)
+/** Bit mask of the ZIP_CODEC field */
+#define DICT_TF_MASK_ZIP_CODEC				\
+		((~(~0 << DICT_TF_WIDTH_ZIP_CODEC))	\
+		<< DICT_TF_POS_ZIP_CODEC)
 
 /** Return the value of the COMPACT field */
 #define DICT_TF_GET_COMPACT(flags)			\
@@ -177,6 +203,14 @@ allows InnoDB to update_create_info() accordingly. */
 #define DICT_TF_HAS_DATA_DIR(flags)			\
 		((flags & DICT_TF_MASK_DATA_DIR)	\
 		>> DICT_TF_POS_DATA_DIR)
+/** Return the contents of the RESERVED bits */
+#define DICT_TF_GET_RESERVED(flags)			\
+		((flags & DICT_TF_MASK_RESERVED)	\
+		>> DICT_TF_POS_RESERVED)
+/** Return the value of the ZIP_CODEC field */
+#define DICT_TF_GET_ZIP_CODEC(flags)			\
+		((flags & DICT_TF_MASK_ZIP_CODEC)	\
+		>> DICT_TF_POS_ZIP_CODEC)
 /** Return the contents of the UNUSED bits */
 #define DICT_TF_GET_UNUSED(flags)			\
 		(flags >> DICT_TF_POS_UNUSED)
@@ -961,7 +995,7 @@ struct dict_table_t{
 	const trx_t*	autoinc_trx;
 				/*!< The transaction that currently holds the
 				the AUTOINC lock on this table.
-				Protected by lock_sys->mutex. */
+				Protected by lock_sys->latch. */
 	fts_t*		fts;	/* FTS specific state variables */
 				/* @} */
 	/*----------------------*/
@@ -977,7 +1011,9 @@ struct dict_table_t{
 				/*!< Count of the number of record locks on
 				this table. We use this to determine whether
 				we can evict the table from the dictionary
-				cache. It is protected by lock_sys->mutex. */
+				cache. It is updated atomically, or under
+				the X-latch on lock_sys->latch without
+				atomic builtins. */
 	ulint		n_ref_count;
 				/*!< count of how many handles are opened
 				to this table; dropping of the table is
@@ -986,7 +1022,8 @@ struct dict_table_t{
 				open handles at drop */
 	UT_LIST_BASE_NODE_T(lock_t)
 			locks;	/*!< list of locks on the table; protected
-				by lock_sys->mutex */
+				by the X-latch on lock_sys->latch, or by
+				the S-latch and lock_sys->table_mutex */
 #endif /* !UNIV_HOTBACKUP */
 
 #ifdef UNIV_DEBUG
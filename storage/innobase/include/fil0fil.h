@@ -355,6 +355,12 @@ extern ulint	fil_n_pending_tablespace_flushes;
 /** Number of files currently open */
 extern ulint	fil_n_file_opened;
 
+/** XtraBackup: if not NULL, only tablespaces of the tables for which this
+returns TRUE are loaded for crash recovery and opened from the data
+dictionary. Redo log records for the other tablespaces are discarded. The
+arguments are the database name and the table or file name. */
+extern ibool	(*fil_tablespace_filter)(const char* db, const char* table);
+
 #ifndef UNIV_HOTBACKUP
 /*******************************************************************//**
 Returns the version number of a tablespace, -1 if not found.
@@ -789,6 +795,16 @@ dberr_t
 fil_load_single_table_tablespaces(ibool (*pred)(const char*, const char*));
 /*===================================*/
 /*******************************************************************//**
+XtraBackup: checks if the tablespace of a table is excluded from recovery by
+fil_tablespace_filter.
+@return true if the tablespace must not be opened */
+UNIV_INTERN
+bool
+fil_tablespace_is_filtered(
+/*=======================*/
+	const char*	name);	/*!< in: table name in the
+				databasename/tablename format */
+/*******************************************************************//**
 Returns TRUE if a single-table tablespace does not exist in the memory cache,
 or is being deleted there.
 @return	TRUE if does not exist or is being deleted */
@@ -53,12 +53,23 @@ to the two Barracuda row formats COMPRESSED and DYNAMIC. */
 /** Width of the DATA_DIR flag.  This flag indicates that the tablespace
 is found in a remote location, not the default data directory. */
 #define FSP_FLAGS_WIDTH_DATA_DIR	1
+/** Width of the RESERVED bits.  MySQL 5.7 and later use the bits that
+follow DATA_DIR for the SHARED, TEMPORARY, ENCRYPTION and SDI flags, and
+other forks of InnoDB use the bits up to 23.  They are kept zero, so that
+the ZIP_CODEC field does not give a meaning to a tablespace created by
+them, nor they to a tablespace that uses the field. */
+#define FSP_FLAGS_WIDTH_RESERVED	13
+/** Width of the ZIP_CODEC field.  This field is the page_zip_codec_t
+that the compressed pages of the tablespace are written with. */
+#define FSP_FLAGS_WIDTH_ZIP_CODEC	2
 /** Width of all the currently known tablespace flags */
 #define FSP_FLAGS_WIDTH		(FSP_FLAGS_WIDTH_POST_ANTELOPE	\
 				+ FSP_FLAGS_WIDTH_ZIP_SSIZE	\
 				+ FSP_FLAGS_WIDTH_ATOMIC_BLOBS	\
 				+ FSP_FLAGS_WIDTH_PAGE_SSIZE	\
-				+ FSP_FLAGS_WIDTH_DATA_DIR)
+				+ FSP_FLAGS_WIDTH_DATA_DIR	\
+				+ FSP_FLAGS_WIDTH_RESERVED	\
+				+ FSP_FLAGS_WIDTH_ZIP_CODEC)
 
 /** A mask of all the known/used bits in tablespace flags */
 #define FSP_FLAGS_MASK		(~(~0 << FSP_FLAGS_WIDTH))
@@ -77,9 +88,15 @@ is found in a remote location, not the default data directory. */
 /** Zero relative shift position of the start of the UNUSED bits */
 #define FSP_FLAGS_POS_DATA_DIR		(FSP_FLAGS_POS_PAGE_SSIZE	\
 					+ FSP_FLAGS_WIDTH_PAGE_SSIZE)
-/** Zero relative shift position of the start of the UNUSED bits */
-#define FSP_FLAGS_POS_UNUSED		(FSP_FLAGS_POS_DATA_DIR	\
+/** Zero relative shift position of the RESERVED bits */
+#define FSP_FLAGS_POS_RESERVED		(FSP_FLAGS_POS_DATA_DIR	\
 					+ FSP_FLAGS_WIDTH_DATA_DIR)
+/** Zero relative shift position of the ZIP_CODEC field */
+#define FSP_FLAGS_POS_ZIP_CODEC		(FSP_FLAGS_POS_RESERVED	\
+					+ FSP_FLAGS_WIDTH_RESERVED)
+/** Zero relative shift position of the start of the UNUSED bits */
+#define FSP_FLAGS_POS_UNUSED		(FSP_FLAGS_POS_ZIP_CODEC	\
+					+ FSP_FLAGS_WIDTH_ZIP_CODEC)
 
 /** Bit mask of the POST_ANTELOPE field */
 #define FSP_FLAGS_MASK_POST_ANTELOPE				\
@@ -101,6 +118,14 @@ is found in a remote location, not the default data directory. */
 #define FSP_FLAGS_MASK_DATA_DIR					\
 		((~(~0 << FSP_FLAGS_WIDTH_DATA_DIR))		\
 		<< FSP_FLAGS_POS_DATA_DIR)
+/** Bit mask of the RESERVED bits */
+#define FSP_FLAGS_MASK_RESERVED					\
+		((~(~0 << FSP_FLAGS_WIDTH_RESERVED))		\
+		<< FSP_FLAGS_POS_RESERVED)
+/** Bit mask of the ZIP_CODEC field */
+#define FSP_FLAGS_MASK_ZIP_CODEC				\
+		((~(~0 << FSP_FLAGS_WIDTH_ZIP_CODEC))		\
+		<< FSP_FLAGS_POS_ZIP_CODEC)
 
 /** Return the value of the POST_ANTELOPE field */
 #define FSP_FLAGS_GET_POST_ANTELOPE(flags)			\
@@ -122,6 +147,14 @@ is found in a remote location, not the default data directory. */
 #define FSP_FLAGS_HAS_DATA_DIR(flags)				\
 		((flags & FSP_FLAGS_MASK_DATA_DIR)		\
 		>> FSP_FLAGS_POS_DATA_DIR)
+/** Return the contents of the RESERVED bits */
+#define FSP_FLAGS_GET_RESERVED(flags)				\
+		((flags & FSP_FLAGS_MASK_RESERVED)		\
+		>> FSP_FLAGS_POS_RESERVED)
+/** Return the value of the ZIP_CODEC field */
+#define FSP_FLAGS_GET_ZIP_CODEC(flags)				\
+		((flags & FSP_FLAGS_MASK_ZIP_CODEC)		\
+		>> FSP_FLAGS_POS_ZIP_CODEC)
 /** Return the contents of the UNUSED bits */
 #define FSP_FLAGS_GET_UNUSED(flags)				\
 		(flags >> FSP_FLAGS_POS_UNUSED)
@@ -635,7 +635,7 @@ lock_print_info_all_transactions(
 Return approximate number or record locks (bits set in the bitmap) for
 this transaction. Since delete-marked records may be removed, the
 record count will not be precise.
-The caller must be holding lock_sys->mutex. */
+The caller must be holding the X-latch on lock_sys->latch. */
 UNIV_INTERN
 ulint
 lock_number_of_rows_locked(
@@ -916,8 +916,25 @@ struct lock_op_t{
 
 /** The lock system struct */
 struct lock_sys_t{
-	ib_mutex_t	mutex;			/*!< Mutex protecting the
-						locks */
+	rw_lock_t	latch;			/*!< Latch protecting the
+						locks. The X-latch protects
+						all of them. The S-latch
+						together with a mutex of
+						rec_mutexes protects the
+						record locks on the pages of
+						that partition of rec_hash,
+						and together with table_mutex
+						the table lock queues. */
+#ifdef UNIV_DEBUG
+	os_thread_id_t	latch_owner;		/*!< Thread holding latch in
+						X mode, or ULINT_UNDEFINED */
+#endif /* UNIV_DEBUG */
+	ib_mutex_t*	rec_mutexes;		/*!< Mutexes of the
+						LOCK_REC_N_PARTITIONS
+						partitions of rec_hash */
+	ib_mutex_t	table_mutex;		/*!< Mutex protecting the
+						table lock queues while latch
+						is S-latched */
 	hash_table_t*	rec_hash;		/*!< hash table of the record
 						locks */
 	ib_mutex_t	wait_mutex;		/*!< Mutex protecting the
@@ -934,7 +951,7 @@ struct lock_sys_t{
 						/*!< TRUE if rollback of all
 						recovered transactions is
 						complete. Protected by
-						lock_sys->mutex */
+						lock_sys->latch */
 
 	ulint		n_lock_max_wait_time;	/*!< Max wait time */
 
@@ -950,21 +967,72 @@ struct lock_sys_t{
 /** The lock system */
 extern lock_sys_t*	lock_sys;
 
-/** Test if lock_sys->mutex can be acquired without waiting. */
-#define lock_mutex_enter_nowait() mutex_enter_nowait(&lock_sys->mutex)
+/** Number of partitions of lock_sys->rec_hash. The hash cells of a
+partition are those whose number is congruent modulo this. */
+#define LOCK_REC_N_PARTITIONS	64
+
+/** Acquire lock_sys->latch in X mode. This protects all the locks. */
+#define lock_mutex_enter() do {					\
+	rw_lock_x_lock(&lock_sys->latch);			\
+	ut_d(lock_sys->latch_owner = os_thread_get_curr_id());	\
+} while (0)
+
+/** Release the X-latch on lock_sys->latch. */
+#define lock_mutex_exit() do {						\
+	ut_d(lock_sys->latch_owner = (os_thread_id_t) ULINT_UNDEFINED);	\
+	rw_lock_x_unlock(&lock_sys->latch);				\
+} while (0)
+
+/** Test if lock_sys->latch is X-latched by this thread. */
+#define lock_mutex_own()					\
+	os_thread_eq(lock_sys->latch_owner, os_thread_get_curr_id())
 
-/** Test if lock_sys->mutex is owned. */
-#define lock_mutex_own() mutex_own(&lock_sys->mutex)
+/** Gets the mutex of a partition of lock_sys->rec_hash.
+@param hash	lock_rec_hash() of a page, or buf_block_get_lock_hash_val() */
+#define lock_rec_get_mutex(hash)				\
+	(&lock_sys->rec_mutexes[(hash) % LOCK_REC_N_PARTITIONS])
 
-/** Acquire the lock_sys->mutex. */
-#define lock_mutex_enter() do {			\
-	mutex_enter(&lock_sys->mutex);		\
+#ifdef HAVE_ATOMIC_BUILTINS
+/** S-latch lock_sys->latch and acquire the mutex of the partition of
+lock_sys->rec_hash holding the record locks of a page. */
+# define lock_rec_mutex_enter(hash) do {			\
+	rw_lock_s_lock(&lock_sys->latch);			\
+	mutex_enter(lock_rec_get_mutex(hash));			\
 } while (0)
 
-/** Release the lock_sys->mutex. */
-#define lock_mutex_exit() do {			\
-	mutex_exit(&lock_sys->mutex);		\
+/** Release the latches acquired by lock_rec_mutex_enter(). */
+# define lock_rec_mutex_exit(hash) do {				\
+	mutex_exit(lock_rec_get_mutex(hash));			\
+	rw_lock_s_unlock(&lock_sys->latch);			\
 } while (0)
+#else /* HAVE_ATOMIC_BUILTINS */
+/* dict_table_t::n_rec_locks cannot be updated from several partitions at
+once without atomic operations: protect all the record locks. */
+# define lock_rec_mutex_enter(hash)	lock_mutex_enter()
+# define lock_rec_mutex_exit(hash)	lock_mutex_exit()
+#endif /* HAVE_ATOMIC_BUILTINS */
+
+/** Test if the record locks of a page are protected: either by the
+X-latch or by the mutex of the partition of lock_sys->rec_hash. */
+#define lock_rec_mutex_own(hash)				\
+	(lock_mutex_own() || mutex_own(lock_rec_get_mutex(hash)))
+
+/** S-latch lock_sys->latch and acquire lock_sys->table_mutex. */
+#define lock_table_mutex_enter() do {				\
+	rw_lock_s_lock(&lock_sys->latch);			\
+	mutex_enter(&lock_sys->table_mutex);			\
+} while (0)
+
+/** Release the latches acquired by lock_table_mutex_enter(). */
+#define lock_table_mutex_exit() do {				\
+	mutex_exit(&lock_sys->table_mutex);			\
+	rw_lock_s_unlock(&lock_sys->latch);			\
+} while (0)
+
+/** Test if the table lock queues are protected: either by the X-latch
+or by lock_sys->table_mutex. */
+#define lock_table_mutex_own()					\
+	(lock_mutex_own() || mutex_own(&lock_sys->table_mutex))
 
 /** Test if lock_sys->wait_mutex is owned. */
 #define lock_wait_mutex_own() mutex_own(&lock_sys->wait_mutex)
@@ -979,6 +1047,14 @@ extern lock_sys_t*	lock_sys;
 	mutex_exit(&lock_sys->wait_mutex);	\
 } while (0)
 
+/*********************************************************************//**
+Tries to X-latch lock_sys->latch without waiting.
+@return	TRUE if the latch was acquired */
+UNIV_INLINE
+ibool
+lock_mutex_enter_nowait(void);
+/*=========================*/
+
 #ifndef UNIV_NONINL
 #include "lock0lock.ic"
 #endif
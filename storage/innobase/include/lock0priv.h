@@ -58,7 +58,9 @@ struct lock_rec_t {
 					lock struct */
 };
 
-/** Lock struct; protected by lock_sys->mutex */
+/** Lock struct; protected by the X-latch on lock_sys->latch, or by the
+S-latch together with the mutex of its rec_hash partition (record locks)
+or lock_sys->table_mutex (table locks) */
 struct lock_t {
 	trx_t*		trx;		/*!< transaction owning the
 					lock */
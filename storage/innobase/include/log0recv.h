@@ -206,6 +206,28 @@ recv_scan_log_recs(
 					to this lsn */
 	lsn_t*		group_scanned_lsn);/*!< out: scanning succeeded up to
 					this lsn */
+/*******************************************************//**
+Calculates the new value for lsn when more data is added to the log. */
+UNIV_INTERN
+lsn_t
+recv_calc_lsn_on_data_add(
+/*======================*/
+	lsn_t		lsn,	/*!< in: old lsn */
+	ib_uint64_t	len);	/*!< in: this many bytes of data is
+				added, log block headers not included */
+/*******************************************************//**
+Tries to parse a single log record and returns its length.
+@return	length of the record, or 0 if the record was not complete */
+UNIV_INTERN
+ulint
+recv_parse_log_rec(
+/*===============*/
+	byte*	ptr,	/*!< in: pointer to a buffer */
+	byte*	end_ptr,/*!< in: pointer to the buffer end */
+	byte*	type,	/*!< out: type */
+	ulint*	space,	/*!< out: space id */
+	ulint*	page_no,/*!< out: page number */
+	byte**	body);	/*!< out: log record body start */
 /******************************************************//**
 Resets the logs. The contents of log files will be lost! */
 UNIV_INTERN
@@ -478,6 +500,21 @@ use these free frames to read in pages when we start applying the
 log records to the database. */
 extern ulint	recv_n_pool_free_frames;
 
+/** Recovery progress counters. They are updated without latching and are
+only meant to be sampled by monitoring code running in other threads. */
+/* @{ */
+/** The checkpoint lsn recovery has started from */
+extern lsn_t	recv_progress_start_lsn;
+/** The lsn the log scan has reached */
+extern lsn_t	recv_progress_scanned_lsn;
+/** Number of recv_apply_hashed_log_recs() batches started */
+extern ulint	recv_progress_apply_batches;
+/** Percentage of the hash cells processed by the current apply batch */
+extern ulint	recv_progress_apply_percent;
+/** Number of pages left to be recovered in the current apply batch */
+extern ulint	recv_progress_pending_pages;
+/* @} */
+
 /***********************************************************************//**
 Checks the consistency of the checkpoint info
 @return	TRUE if ok */
@@ -61,6 +61,20 @@ ssize, which is the number of shifts from 512. */
 # error "PAGE_ZIP_SSIZE_MAX >= (1 << PAGE_ZIP_SSIZE_BITS)"
 #endif
 
+/** Compression algorithms of ROW_FORMAT=COMPRESSED pages. The algorithm
+that a table compresses its pages with is stored in the ZIP_CODEC field
+of the table and tablespace flags. Each compressed page also identifies
+the algorithm of its own stream, so that the pages can be decompressed
+without knowing the flags. */
+enum page_zip_codec_t {
+	PAGE_ZIP_CODEC_ZLIB = 0,	/*!< zlib deflate */
+	PAGE_ZIP_CODEC_LZ4,		/*!< LZ4 */
+	PAGE_ZIP_CODEC_ZSTD		/*!< Zstandard */
+};
+
+/** Maximum compression algorithm identifier */
+#define PAGE_ZIP_CODEC_MAX	PAGE_ZIP_CODEC_ZSTD
+
 /** Compressed page descriptor */
 struct page_zip_des_t
 {
@@ -46,6 +46,10 @@ extern uint	page_zip_level;
 /* Default compression level. */
 #define DEFAULT_COMPRESSION_LEVEL	6
 
+/* Compression algorithm (page_zip_codec_t) of the tables that are
+created with ROW_FORMAT=COMPRESSED. Settable by user. */
+extern ulong	page_zip_codec;
+
 /* Whether or not to log compressed page images to avoid possible
 compression algorithm changes in zlib. */
 extern my_bool	page_zip_log_pages;
@@ -113,6 +117,16 @@ page_zip_set_alloc(
 	void*		stream,		/*!< in/out: zlib stream */
 	mem_heap_t*	heap);		/*!< in: memory heap to use */
 
+/**********************************************************************//**
+Determine if a compression algorithm is available in this build.
+@return	true if pages can be compressed and decompressed with codec */
+UNIV_INTERN
+bool
+page_zip_codec_available(
+/*=====================*/
+	ulint		codec)		/*!< in: page_zip_codec_t */
+	__attribute__((const));
+
 /**********************************************************************//**
 Compress a page.
 @return TRUE on success, FALSE on failure; page_zip will be left
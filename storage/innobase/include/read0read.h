@@ -149,8 +149,8 @@ struct read_view_t{
 				not see: typically, these are the read-write
 				active transactions at the time when the read
 				is serialized, except the reading transaction
-				itself; the trx ids in this array are in a
-				descending order. These trx_ids should be
+				itself; the trx ids in this array are in an
+				ascending order. These trx_ids should be
 				between the "low" and "high" water marks,
 				that is, up_limit_id and low_limit_id. */
 	trx_id_t	creator_trx_id;
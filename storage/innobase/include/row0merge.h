@@ -116,7 +116,8 @@ struct row_merge_dup_t {
 					in table to the rebuilt table
 					(index->table), or NULL if not
 					rebuilding table */
-	ulint			n_dup;	/*!< number of duplicates */
+	ulint			n_dup;	/*!< number of duplicates,
+					incremented atomically */
 };
 
 /*************************************************************//**
@@ -370,7 +371,9 @@ row_merge_sort(
 	merge_file_t*		file,	/*!< in/out: file containing
 					index entries */
 	row_merge_block_t*	block,	/*!< in/out: 3 buffers */
-	int*			tmpfd)	/*!< in/out: temporary file handle */
+	int*			tmpfd,	/*!< in/out: temporary file handle */
+	ulint			n_threads)/*!< in: number of threads to
+					merge the runs of a pass in */
 	__attribute__((nonnull));
 /*********************************************************************//**
 Allocate a sort buffer.
@@ -150,6 +150,10 @@ and/or load it during startup. */
 extern char		srv_buffer_pool_dump_at_shutdown;
 extern char		srv_buffer_pool_load_at_startup;
 
+/** Whether the buffer pool load reads at most innodb_io_capacity pages
+per second rather than as fast as possible */
+extern char		srv_buffer_pool_load_throttle;
+
 /* Whether to disable file system cache if it is defined */
 extern char		srv_disable_sort_file_cache;
 
@@ -209,6 +213,12 @@ extern ibool	srv_locks_unsafe_for_binlog;
 
 /** Sort buffer size in index creation */
 extern ulong	srv_sort_buf_size;
+/** Number of threads merging the sorted runs of an index, and building
+the indexes concurrently, in index creation */
+extern ulong	srv_merge_sort_threads;
+/** Percentage of each page filled with records when loading a new index
+in index creation */
+extern ulong	srv_fill_factor;
 /** Maximum modification log file size for online index creation */
 extern unsigned long long	srv_online_max_size;
 
@@ -346,6 +356,7 @@ extern my_bool			srv_stats_auto_recalc;
 
 extern ibool	srv_use_doublewrite_buf;
 extern ulong	srv_doublewrite_batch_size;
+extern char*	srv_parallel_doublewrite_path;
 extern ulong	srv_checksum_algorithm;
 
 extern ibool	srv_fast_checksum;
@@ -439,6 +450,9 @@ extern ulong srv_n_purge_threads;
 /* the number of pages to purge in one batch */
 extern ulong srv_purge_batch_size;
 
+/* the number of page_cleaner threads, including the coordinator */
+extern ulong srv_n_page_cleaners;
+
 /* the number of sync wait arrays */
 extern ulong srv_sync_array_size;
 
@@ -456,6 +470,7 @@ extern srv_stats_t	srv_stats;
 # ifdef UNIV_PFS_THREAD
 /* Keys to register InnoDB threads with performance schema */
 extern mysql_pfs_key_t	buf_page_cleaner_thread_key;
+extern mysql_pfs_key_t	buf_page_cleaner_worker_thread_key;
 extern mysql_pfs_key_t	trx_rollback_clean_thread_key;
 extern mysql_pfs_key_t	io_handler_thread_key;
 extern mysql_pfs_key_t	srv_lock_timeout_thread_key;
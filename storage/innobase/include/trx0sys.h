@@ -213,7 +213,7 @@ trx_read_trx_id(
 Looks for the trx instance with the given id in the rw trx_list.
 The caller must be holding trx_sys->mutex.
 @return	the trx handle or NULL if not found;
-the pointer must not be dereferenced unless lock_sys->mutex was
+the pointer must not be dereferenced unless lock_sys->latch was
 acquired before calling this function and is still being held */
 UNIV_INLINE
 trx_t*
@@ -233,9 +233,9 @@ trx_rw_min_trx_id(void);
 /****************************************************************//**
 Checks if a rw transaction with the given id is active. Caller must hold
 trx_sys->mutex in shared mode. If the caller is not holding
-lock_sys->mutex, the transaction may already have been committed.
+lock_sys->latch, the transaction may already have been committed.
 @return	transaction instance if active, or NULL;
-the pointer must not be dereferenced unless lock_sys->mutex was
+the pointer must not be dereferenced unless lock_sys->latch was
 acquired before calling this function and is still being held */
 UNIV_INLINE
 trx_t*
@@ -246,10 +246,10 @@ trx_rw_is_active_low(
 					that will be set if corrupt */
 /****************************************************************//**
 Checks if a rw transaction with the given id is active. If the caller is
-not holding lock_sys->mutex, the transaction may already have been
+not holding lock_sys->latch, the transaction may already have been
 committed.
 @return	transaction instance if active, or NULL;
-the pointer must not be dereferenced unless lock_sys->mutex was
+the pointer must not be dereferenced unless lock_sys->latch was
 acquired before calling this function and is still being held */
 UNIV_INLINE
 trx_t*
@@ -628,6 +628,21 @@ struct trx_sys_t{
 					memory read-write transactions, sorted
 					on trx id, biggest first. Recovered
 					transactions are always on this list. */
+	trx_id_t*	descriptors;	/*!< Ids of the transactions on
+					rw_trx_list that are visible as
+					active to a new read view, sorted
+					in ascending order. A read view
+					copies this array instead of
+					walking rw_trx_list. */
+	ulint		descr_n_max;	/*!< Number of cells allocated in
+					descriptors */
+	ulint		descr_n_used;	/*!< Number of cells used in
+					descriptors */
+	trx_list_t	serialisation_list;
+					/*!< Active and prepared read-write
+					transactions that have been assigned
+					a trx->no, sorted on trx->no, smallest
+					first */
 	trx_list_t	ro_trx_list;	/*!< List of active and committed in
 					memory read-only transactions, sorted
 					on trx id, biggest first. NOTE:
@@ -663,6 +678,9 @@ struct trx_sys_t{
 					on trx no, biggest first */
 };
 
+/** Initial number of cells in trx_sys_t::descriptors */
+#define TRX_DESCR_ARRAY_INITIAL_SIZE	1000
+
 /** When a trx id which is zero modulo this number (which must be a power of
 two) is assigned, the field TRX_SYS_TRX_ID_STORE on the transaction system
 page is updated */
@@ -42,6 +42,23 @@ innobase_start_or_create_for_mysql(). */
 void
 xb_compact_rebuild_indexes(void);
 
+/******************************************************************************
+Reserve up to 'n' index rebuild threads that have run out of tables, so that
+row_merge_build_indexes() can use them to build the indexes of a single table
+in parallel.
+@return number of reserved threads */
+ulint
+xb_rebuild_threads_reserve(
+/*=======================*/
+	ulint	n);	/*!< in: number of threads wanted */
+
+/******************************************************************************
+Return threads reserved with xb_rebuild_threads_reserve(). */
+void
+xb_rebuild_threads_release(
+/*=======================*/
+	ulint	n);	/*!< in: number of threads to return */
+
 #ifdef __cplusplus
 }
 #endif
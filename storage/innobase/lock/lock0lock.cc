@@ -375,15 +375,22 @@ struct lock_stack_t {
 
 /** Stack to use during DFS search. Currently only a single stack is required
 because there is no parallel deadlock check. This stack is protected by
-the lock_sys_t::mutex. */
+the X-latch on lock_sys_t::latch. */
 static lock_stack_t*	lock_stack;
 
 /** The count of the types of locks. */
 static const ulint	lock_types = UT_ARR_SIZE(lock_compatibility_matrix);
 
+#ifdef UNIV_PFS_RWLOCK
+/* Key to register rw-lock with performance schema */
+UNIV_INTERN mysql_pfs_key_t	lock_sys_latch_key;
+#endif /* UNIV_PFS_RWLOCK */
+
 #ifdef UNIV_PFS_MUTEX
 /* Key to register mutex with performance schema */
-UNIV_INTERN mysql_pfs_key_t	lock_sys_mutex_key;
+UNIV_INTERN mysql_pfs_key_t	lock_sys_rec_mutex_key;
+/* Key to register mutex with performance schema */
+UNIV_INTERN mysql_pfs_key_t	lock_sys_table_mutex_key;
 /* Key to register mutex with performance schema */
 UNIV_INTERN mysql_pfs_key_t	lock_sys_wait_mutex_key;
 #endif /* UNIV_PFS_MUTEX */
@@ -606,7 +613,20 @@ lock_sys_create(
 
 	lock_sys->last_slot = lock_sys->waiting_threads;
 
-	mutex_create(lock_sys_mutex_key, &lock_sys->mutex, SYNC_LOCK_SYS);
+	rw_lock_create(lock_sys_latch_key, &lock_sys->latch, SYNC_LOCK_SYS);
+
+	ut_d(lock_sys->latch_owner = (os_thread_id_t) ULINT_UNDEFINED);
+
+	lock_sys->rec_mutexes = static_cast<ib_mutex_t*>(
+		mem_zalloc(LOCK_REC_N_PARTITIONS * sizeof(ib_mutex_t)));
+
+	for (ulint i = 0; i < LOCK_REC_N_PARTITIONS; i++) {
+		mutex_create(lock_sys_rec_mutex_key,
+			     &lock_sys->rec_mutexes[i], SYNC_LOCK_SYS_PART);
+	}
+
+	mutex_create(lock_sys_table_mutex_key,
+		     &lock_sys->table_mutex, SYNC_LOCK_SYS_PART);
 
 	mutex_create(lock_sys_wait_mutex_key,
 		     &lock_sys->wait_mutex, SYNC_LOCK_WAIT_SYS);
@@ -635,7 +655,15 @@ lock_sys_close(void)
 
 	hash_table_free(lock_sys->rec_hash);
 
-	mutex_free(&lock_sys->mutex);
+	rw_lock_free(&lock_sys->latch);
+
+	for (ulint i = 0; i < LOCK_REC_N_PARTITIONS; i++) {
+		mutex_free(&lock_sys->rec_mutexes[i]);
+	}
+
+	mem_free(lock_sys->rec_mutexes);
+
+	mutex_free(&lock_sys->table_mutex);
 	mutex_free(&lock_sys->wait_mutex);
 
 	mem_free(lock_stack);
@@ -711,8 +739,8 @@ lock_get_src_table(
 	Other transactions could want to convert one of our implicit
 	record locks to an explicit one. For that, they would need our
 	trx mutex. Waiting locks can be removed while only holding
-	lock_sys->mutex, but this is a running transaction and cannot
-	thus be holding any waiting locks. */
+	the X-latch on lock_sys->latch, but this is a running transaction
+	and cannot thus be holding any waiting locks. */
 	trx_mutex_enter(trx);
 
 	for (lock = UT_LIST_GET_FIRST(trx->lock.trx_locks);
@@ -1157,12 +1185,13 @@ lock_rec_get_next_on_page_const(
 	ulint	space;
 	ulint	page_no;
 
-	ut_ad(lock_mutex_own());
 	ut_ad(lock_get_type_low(lock) == LOCK_REC);
 
 	space = lock->un_member.rec_lock.space;
 	page_no = lock->un_member.rec_lock.page_no;
 
+	ut_ad(lock_rec_mutex_own(lock_rec_hash(space, page_no)));
+
 	for (;;) {
 		lock = static_cast<const lock_t*>(HASH_GET_NEXT(hash, lock));
 
@@ -1258,10 +1287,10 @@ lock_rec_get_first_on_page(
 	ulint	space	= buf_block_get_space(block);
 	ulint	page_no	= buf_block_get_page_no(block);
 
-	ut_ad(lock_mutex_own());
-
 	hash = buf_block_get_lock_hash_val(block);
 
+	ut_ad(lock_rec_mutex_own(hash));
+
 	for (lock = static_cast<lock_t*>(
 			HASH_GET_FIRST( lock_sys->rec_hash, hash));
 	     lock != NULL;
@@ -1322,7 +1351,7 @@ lock_rec_get_first(
 {
 	lock_t*	lock;
 
-	ut_ad(lock_mutex_own());
+	ut_ad(lock_rec_mutex_own(buf_block_get_lock_hash_val(block)));
 
 	for (lock = lock_rec_get_first_on_page(block); lock;
 	     lock = lock_rec_get_next_on_page(lock)) {
@@ -1692,7 +1721,7 @@ lock_sec_rec_some_has_impl(
 Return approximate number or record locks (bits set in the bitmap) for
 this transaction. Since delete-marked records may be removed, the
 record count will not be precise.
-The caller must be holding lock_sys->mutex. */
+The caller must be holding the X-latch on lock_sys->latch. */
 UNIV_INTERN
 ulint
 lock_number_of_rows_locked(
@@ -1752,7 +1781,7 @@ lock_rec_create(
 	ulint		n_bytes;
 	const page_t*	page;
 
-	ut_ad(lock_mutex_own());
+	ut_ad(lock_rec_mutex_own(buf_block_get_lock_hash_val(block)));
 	ut_ad(caller_owns_trx_mutex == trx_mutex_own(trx));
 	ut_ad(dict_index_is_clust(index) || !dict_index_is_online_ddl(index));
 
@@ -1800,7 +1829,13 @@ lock_rec_create(
 	/* Set the bit corresponding to rec */
 	lock_rec_set_nth_bit(lock, heap_no);
 
+#ifdef HAVE_ATOMIC_BUILTINS
+	/* Record locks are created under the mutexes of different
+	partitions of lock_sys->rec_hash at the same time. */
+	os_atomic_increment_ulint(&index->table->n_rec_locks, 1);
+#else /* HAVE_ATOMIC_BUILTINS */
 	index->table->n_rec_locks++;
+#endif /* HAVE_ATOMIC_BUILTINS */
 
 	ut_ad(index->table->n_ref_count > 0 || !index->table->can_be_evicted);
 
@@ -2103,7 +2138,7 @@ lock_rec_lock_fast(
 	trx_t*			trx;
 	enum lock_rec_req_status status = LOCK_REC_SUCCESS;
 
-	ut_ad(lock_mutex_own());
+	ut_ad(lock_rec_mutex_own(buf_block_get_lock_hash_val(block)));
 	ut_ad((LOCK_MODE_MASK & mode) != LOCK_S
 	      || lock_table_has(thr_get_trx(thr), index->table, LOCK_IS));
 	ut_ad((LOCK_MODE_MASK & mode) != LOCK_X
@@ -2257,7 +2292,10 @@ Tries to lock the specified record in the mode requested. If not immediately
 possible, enqueues a waiting lock request. This is a low-level function
 which does NOT look at implicit locks! Checks lock compatibility within
 explicit locks. This function sets a normal next-key lock, or in the case
-of a page supremum record, a gap type lock.
+of a page supremum record, a gap type lock. The common cases are handled
+under the mutex of the partition of lock_sys->rec_hash holding the page;
+the X-latch on lock_sys->latch is only acquired when the request may have
+to wait, as the deadlock check looks at the locks on all pages.
 @return	DB_SUCCESS, DB_SUCCESS_LOCKED_REC, DB_LOCK_WAIT, DB_DEADLOCK,
 or DB_QUE_THR_SUSPENDED */
 static
@@ -2277,7 +2315,11 @@ lock_rec_lock(
 	dict_index_t*		index,	/*!< in: index of record */
 	que_thr_t*		thr)	/*!< in: query thread */
 {
-	ut_ad(lock_mutex_own());
+	ulint			hash;
+	enum lock_rec_req_status status;
+	dberr_t			err;
+
+	ut_ad(!lock_mutex_own());
 	ut_ad((LOCK_MODE_MASK & mode) != LOCK_S
 	      || lock_table_has(thr_get_trx(thr), index->table, LOCK_IS));
 	ut_ad((LOCK_MODE_MASK & mode) != LOCK_X
@@ -2289,16 +2331,33 @@ lock_rec_lock(
 	      || mode - (LOCK_MODE_MASK & mode) == 0);
 	ut_ad(dict_index_is_clust(index) || !dict_index_is_online_ddl(index));
 
+	hash = buf_block_get_lock_hash_val(block);
+
 	/* We try a simplified and faster subroutine for the most
 	common cases */
-	switch (lock_rec_lock_fast(impl, mode, block, heap_no, index, thr)) {
+	lock_rec_mutex_enter(hash);
+
+	status = lock_rec_lock_fast(impl, mode, block, heap_no, index, thr);
+
+	lock_rec_mutex_exit(hash);
+
+	switch (status) {
 	case LOCK_REC_SUCCESS:
 		return(DB_SUCCESS);
 	case LOCK_REC_SUCCESS_CREATED:
 		return(DB_SUCCESS_LOCKED_REC);
 	case LOCK_REC_FAIL:
-		return(lock_rec_lock_slow(impl, mode, block,
-					  heap_no, index, thr));
+		/* The lock queue may have changed after the partition
+		mutex was released: lock_rec_lock_slow() checks it again
+		from the beginning. */
+		lock_mutex_enter();
+
+		err = lock_rec_lock_slow(impl, mode, block,
+					 heap_no, index, thr);
+
+		lock_mutex_exit();
+
+		return(err);
 	}
 
 	ut_error;
@@ -2351,7 +2410,8 @@ lock_rec_has_to_wait_in_queue(
 
 /*************************************************************//**
 Grants a lock to a waiting lock request and releases the waiting transaction.
-The caller must hold lock_sys->mutex but not lock->trx->mutex. */
+The caller must hold the X-latch on lock_sys->latch but not
+lock->trx->mutex. */
 static
 void
 lock_grant(
@@ -3573,7 +3633,8 @@ lock_deadlock_lock_print(
 	}
 }
 
-/** Used in deadlock tracking. Protected by lock_sys->mutex. */
+/** Used in deadlock tracking. Protected by the X-latch on
+lock_sys->latch. */
 static ib_uint64_t	lock_mark_counter = 0;
 
 /** Check if the search is too deep. */
@@ -4048,7 +4109,8 @@ lock_table_create(
 	lock_t*	lock;
 
 	ut_ad(table && trx);
-	ut_ad(lock_mutex_own());
+	ut_ad(lock_table_mutex_own());
+	ut_ad(lock_mutex_own() || (type_mode & LOCK_MODE_MASK) != LOCK_AUTO_INC);
 	ut_ad(trx_mutex_own(trx));
 	ut_ad(!(type_mode & LOCK_CONV_BY_OTHER));
 
@@ -4346,7 +4408,7 @@ lock_table_other_has_incompatible(
 {
 	const lock_t*	lock;
 
-	ut_ad(lock_mutex_own());
+	ut_ad(lock_table_mutex_own());
 
 	for (lock = UT_LIST_GET_LAST(table->locks);
 	     lock != NULL;
@@ -4403,6 +4465,33 @@ lock_table(
 		return(DB_SUCCESS);
 	}
 
+	/* A lock that can be granted at once is created under
+	lock_sys->table_mutex. AUTO_INC locks also change the
+	table->autoinc_trx that is read under the X-latch only. */
+
+	if (mode != LOCK_AUTO_INC) {
+
+		lock_table_mutex_enter();
+
+		wait_for = lock_table_other_has_incompatible(
+			trx, LOCK_WAIT, table, mode);
+
+		if (wait_for == NULL) {
+
+			trx_mutex_enter(trx);
+
+			lock_table_create(table, mode | flags, trx);
+
+			trx_mutex_exit(trx);
+
+			lock_table_mutex_exit();
+
+			return(DB_SUCCESS);
+		}
+
+		lock_table_mutex_exit();
+	}
+
 	lock_mutex_enter();
 
 	/* We have to check if the new lock is compatible with any locks
@@ -4841,7 +4930,7 @@ lock_remove_recovered_trx_record_locks(
 			continue;
 		}
 
-		/* Because we are holding the lock_sys->mutex,
+		/* Because we are holding the X-latch on lock_sys->latch,
 		implicit locks cannot be converted to explicit ones
 		while we are scanning the explicit locks. */
 
@@ -5144,7 +5233,7 @@ lock_print_info_summary(
 	mutex. */
 	if (!nowait) {
 		lock_mutex_enter();
-	} else if (lock_mutex_enter_nowait()) {
+	} else if (!lock_mutex_enter_nowait()) {
 		fputs("FAIL TO OBTAIN LOCK MUTEX, "
 		      "SKIP LOCK INFO PRINTING\n", file);
 		return(FALSE);
@@ -5260,7 +5349,7 @@ lock_print_info_all_transactions(
 	}
 
 loop:
-	/* Since we temporarily release lock_sys->mutex and
+	/* Since we temporarily release lock_sys->latch and
 	trx_sys->mutex when reading a database page in below,
 	variable trx may be obsolete now and we must loop
 	through the trx list to get probably the same trx,
@@ -5476,7 +5565,8 @@ lock_table_queue_validate(
 		/* lock->trx->state cannot change from or to NOT_STARTED
 		while we are holding the trx_sys->mutex. It may change
 		from ACTIVE to PREPARED, but it may not change to
-		COMMITTED, because we are holding the lock_sys->mutex. */
+		COMMITTED, because we are holding the X-latch on
+		lock_sys->latch. */
 		ut_ad(trx_assert_started(lock->trx));
 
 		if (!lock_get_wait(lock)) {
@@ -5562,7 +5652,7 @@ lock_rec_queue_validate(
 
 		ut_ad(lock_mutex_own());
 		/* impl_trx cannot be committed until lock_mutex_exit()
-		because lock_trx_release_locks() acquires lock_sys->mutex */
+		because lock_trx_release_locks() X-latches lock_sys->latch */
 
 		if (impl_trx != NULL
 		    && lock_rec_other_has_expl_req(LOCK_S, 0, LOCK_WAIT,
@@ -5912,7 +6002,6 @@ lock_rec_insert_check_and_lock(
 	next_rec = page_rec_get_next_const(rec);
 	next_rec_heap_no = page_rec_get_heap_no(next_rec);
 
-	lock_mutex_enter();
 	/* Because this code is invoked for a running transaction by
 	the thread that is serving the transaction, it is not necessary
 	to hold trx->mutex here. */
@@ -5922,13 +6011,18 @@ lock_rec_insert_check_and_lock(
 	BTR_NO_LOCKING_FLAG and skip the locking altogether. */
 	ut_ad(lock_table_has(trx, index->table, LOCK_IX));
 
+	/* No lock can be created on the successor while we hold the
+	page latch in X mode, but a lock on it may be released. */
+
+	lock_rec_mutex_enter(buf_block_get_lock_hash_val(block));
+
 	lock = lock_rec_get_first(block, next_rec_heap_no);
 
+	lock_rec_mutex_exit(buf_block_get_lock_hash_val(block));
+
 	if (UNIV_LIKELY(lock == NULL)) {
 		/* We optimize CPU time usage in the simplest case */
 
-		lock_mutex_exit();
-
 		if (!dict_index_is_clust(index)) {
 			/* Update the page max trx id field */
 			page_update_max_trx_id(block,
@@ -5953,6 +6047,8 @@ lock_rec_insert_check_and_lock(
 	had to wait for their insert. Both had waiting gap type lock requests
 	on the successor, which produced an unnecessary deadlock. */
 
+	lock_mutex_enter();
+
 	if (lock_rec_other_has_conflicting(
 		    static_cast<enum lock_mode>(
 			    LOCK_X | LOCK_GAP | LOCK_INSERT_INTENTION),
@@ -6055,7 +6151,7 @@ lock_rec_convert_impl_to_expl(
 		impl_trx = trx_rw_is_active(trx_id, NULL);
 
 		/* impl_trx cannot be committed until lock_mutex_exit()
-		because lock_trx_release_locks() acquires lock_sys->mutex */
+		because lock_trx_release_locks() X-latches lock_sys->latch */
 
 		if (impl_trx != NULL
 		    && !lock_rec_has_expl(LOCK_X | LOCK_REC_NOT_GAP, block,
@@ -6128,8 +6224,6 @@ lock_clust_rec_modify_check_and_lock(
 
 	lock_rec_convert_impl_to_expl(block, rec, index, offsets);
 
-	lock_mutex_enter();
-
 	ut_ad(lock_table_has(thr_get_trx(thr), index->table, LOCK_IX));
 
 	err = lock_rec_lock(TRUE, LOCK_X | LOCK_REC_NOT_GAP,
@@ -6137,8 +6231,6 @@ lock_clust_rec_modify_check_and_lock(
 
 	MONITOR_INC(MONITOR_NUM_RECLOCK_REQ);
 
-	lock_mutex_exit();
-
 	ut_ad(lock_rec_queue_validate(FALSE, block, rec, index, offsets));
 
 	if (UNIV_UNLIKELY(err == DB_SUCCESS_LOCKED_REC)) {
@@ -6188,8 +6280,6 @@ lock_sec_rec_modify_check_and_lock(
 	index record, and this would not have been possible if another active
 	transaction had modified this secondary index record. */
 
-	lock_mutex_enter();
-
 	ut_ad(lock_table_has(thr_get_trx(thr), index->table, LOCK_IX));
 
 	err = lock_rec_lock(TRUE, LOCK_X | LOCK_REC_NOT_GAP,
@@ -6197,8 +6287,6 @@ lock_sec_rec_modify_check_and_lock(
 
 	MONITOR_INC(MONITOR_NUM_RECLOCK_REQ);
 
-	lock_mutex_exit();
-
 #ifdef UNIV_DEBUG
 	{
 		mem_heap_t*	heap		= NULL;
@@ -6287,8 +6375,6 @@ lock_sec_rec_read_check_and_lock(
 		lock_rec_convert_impl_to_expl(block, rec, index, offsets);
 	}
 
-	lock_mutex_enter();
-
 	ut_ad(mode != LOCK_X
 	      || lock_table_has(thr_get_trx(thr), index->table, LOCK_IX));
 	ut_ad(mode != LOCK_S
@@ -6299,8 +6385,6 @@ lock_sec_rec_read_check_and_lock(
 
 	MONITOR_INC(MONITOR_NUM_RECLOCK_REQ);
 
-	lock_mutex_exit();
-
 	ut_ad(lock_rec_queue_validate(FALSE, block, rec, index, offsets));
 
 	return(err);
@@ -6359,8 +6443,6 @@ lock_clust_rec_read_check_and_lock(
 		lock_rec_convert_impl_to_expl(block, rec, index, offsets);
 	}
 
-	lock_mutex_enter();
-
 	ut_ad(mode != LOCK_X
 	      || lock_table_has(thr_get_trx(thr), index->table, LOCK_IX));
 	ut_ad(mode != LOCK_S
@@ -6371,8 +6453,6 @@ lock_clust_rec_read_check_and_lock(
 
 	MONITOR_INC(MONITOR_NUM_RECLOCK_REQ);
 
-	lock_mutex_exit();
-
 	ut_ad(lock_rec_queue_validate(FALSE, block, rec, index, offsets));
 
 	return(err);
@@ -6814,8 +6894,12 @@ lock_trx_release_locks(
 	}
 
 	/* The transition of trx->state to TRX_STATE_COMMITTED_IN_MEMORY
-	is protected by both the lock_sys->mutex and the trx->mutex. */
+	is protected by both the X-latch on lock_sys->latch and the
+	trx->mutex. We also hold trx_sys->mutex, because the transition
+	must be atomic with removing the transaction from
+	trx_sys->descriptors. */
 	lock_mutex_enter();
+	mutex_enter(&trx_sys->mutex);
 	trx_mutex_enter(trx);
 
 	/* The following assignment makes the transaction committed in memory
@@ -6851,6 +6935,17 @@ lock_trx_release_locks(
 
 	trx_mutex_exit(trx);
 
+	/* Read views created from now on must see the changes of this
+	transaction. Remove it before lock_release() grants the locks
+	that other transactions wait for, so that a transaction whose
+	locking read returned the changes of this one cannot create a
+	read view that still treats this one as active. */
+	if (!trx->read_only) {
+		trx_release_descriptor(trx);
+	}
+
+	mutex_exit(&trx_sys->mutex);
+
 	lock_release(trx);
 
 	lock_mutex_exit();
@@ -50,6 +50,7 @@ Created 9/20/1997 Heikki Tuuri
 #include "row0merge.h"
 #include "sync0sync.h"
 #include "xb0xb.h"
+#include "ut0sort.h"
 
 /** The size of archived log file */
 extern ib_uint64_t xtrabackup_arch_file_size;
@@ -67,8 +68,9 @@ UNIV_INTERN ibool	recv_replay_file_ops	= TRUE;
 this must be less than UNIV_PAGE_SIZE as it is stored in the buffer pool */
 #define RECV_DATA_BLOCK_SIZE	(MEM_MAX_ALLOC_IN_BUF - sizeof(recv_data_t))
 
-/** Read-ahead area in applying log records to file pages */
-#define RECV_READ_AHEAD_AREA	32
+/** Maximum number of pages read in one batch, in ascending page number
+order, in applying log records to file pages */
+#define RECV_READ_AHEAD_AREA	64
 
 /** The recovery system */
 UNIV_INTERN recv_sys_t*	recv_sys = NULL;
@@ -154,6 +156,15 @@ is bigger than the lsn we are able to scan up to, that is an indication that
 the recovery failed and the database may be corrupt. */
 UNIV_INTERN lsn_t	recv_max_page_lsn;
 
+/** Recovery progress counters, see log0recv.h */
+/* @{ */
+UNIV_INTERN lsn_t	recv_progress_start_lsn		= 0;
+UNIV_INTERN lsn_t	recv_progress_scanned_lsn	= 0;
+UNIV_INTERN ulint	recv_progress_apply_batches	= 0;
+UNIV_INTERN ulint	recv_progress_apply_percent	= 0;
+UNIV_INTERN ulint	recv_progress_pending_pages	= 0;
+/* @} */
+
 #ifdef UNIV_PFS_THREAD
 UNIV_INTERN mysql_pfs_key_t	trx_rollback_clean_thread_key;
 #endif /* UNIV_PFS_THREAD */
@@ -1839,38 +1850,120 @@ recv_recover_page_func(
 
 #ifndef UNIV_HOTBACKUP
 /*******************************************************************//**
-Reads in pages which have hashed log records, from an area around a given
-page number.
-@return	number of pages found */
+Compares two hashed log record addresses by space id and page number.
+@return -1/0/1 if a1 is smaller/equal/bigger than a2 */
+static
+lint
+recv_addr_cmp(
+/*==========*/
+	const recv_addr_t*	a1,	/*!< in: address 1 */
+	const recv_addr_t*	a2)	/*!< in: address 2 */
+{
+	if (a1->space != a2->space) {
+		return(a1->space < a2->space ? -1 : 1);
+	}
+
+	if (a1->page_no != a2->page_no) {
+		return(a1->page_no < a2->page_no ? -1 : 1);
+	}
+
+	return(0);
+}
+
+/*******************************************************************//**
+Sorts hashed log record addresses on space id, page number. */
+static
+void
+recv_addr_sort(
+/*===========*/
+	recv_addr_t**	addrs,	/*!< in/out: addresses to sort */
+	recv_addr_t**	tmp,	/*!< in/out: temp storage */
+	ulint		low,	/*!< in: lowest index (inclusive) */
+	ulint		high)	/*!< in: highest index (non-inclusive) */
+{
+	UT_SORT_FUNCTION_BODY(recv_addr_sort, addrs, tmp, low, high,
+			      recv_addr_cmp);
+}
+
+/*******************************************************************//**
+Collects the addresses of the hashed log records not processed yet and sorts
+them on space id, page number, so that the pages can be read in ascending
+order.
+@return	array of n_addrs addresses, to be freed with ut_free() */
+static
+recv_addr_t**
+recv_get_sorted_addrs(
+/*==================*/
+	ulint*	n_addrs)	/*!< out: number of addresses */
+{
+	recv_addr_t**	addrs;
+	recv_addr_t**	tmp;
+	recv_addr_t*	recv_addr;
+	ulint		n = 0;
+
+	ut_ad(mutex_own(&recv_sys->mutex));
+
+	addrs = static_cast<recv_addr_t**>(
+		ut_malloc((recv_sys->n_addrs + 1) * sizeof(*addrs)));
+
+	for (ulint i = 0; i < hash_get_n_cells(recv_sys->addr_hash); i++) {
+		for (recv_addr = static_cast<recv_addr_t*>(
+				HASH_GET_FIRST(recv_sys->addr_hash, i));
+		     recv_addr != 0;
+		     recv_addr = static_cast<recv_addr_t*>(
+				HASH_GET_NEXT(addr_hash, recv_addr))) {
+
+			if (recv_addr->state == RECV_NOT_PROCESSED) {
+				ut_a(n < recv_sys->n_addrs);
+				addrs[n++] = recv_addr;
+			}
+		}
+	}
+
+	if (n > 1) {
+		tmp = static_cast<recv_addr_t**>(
+			ut_malloc(n * sizeof(*tmp)));
+		recv_addr_sort(addrs, tmp, 0, n);
+		ut_free(tmp);
+	}
+
+	*n_addrs = n;
+
+	return(addrs);
+}
+
+/*******************************************************************//**
+Reads in pages which have hashed log records, starting from a given position
+in the sorted address array. Up to RECV_READ_AHEAD_AREA pages of the same
+tablespace that are not in the buffer pool are read in ascending page number
+order, which lets the I/O requests for adjacent pages be merged.
+@return	number of pages read */
 static
 ulint
 recv_read_in_area(
 /*==============*/
-	ulint	space,	/*!< in: space */
-	ulint	zip_size,/*!< in: compressed page size in bytes, or 0 */
-	ulint	page_no)/*!< in: page number */
+	recv_addr_t**	addrs,	/*!< in: sorted addresses */
+	ulint		n_addrs,/*!< in: number of addresses */
+	ulint		i,	/*!< in: position of the first page to read */
+	ulint		zip_size)/*!< in: compressed page size in bytes, or 0 */
 {
-	recv_addr_t* recv_addr;
 	ulint	page_nos[RECV_READ_AHEAD_AREA];
-	ulint	low_limit;
-	ulint	n;
+	ulint	space = addrs[i]->space;
+	ulint	n = 0;
 
-	low_limit = page_no - (page_no % RECV_READ_AHEAD_AREA);
+	for (; i < n_addrs && n < RECV_READ_AHEAD_AREA
+	     && addrs[i]->space == space; i++) {
 
-	n = 0;
+		recv_addr_t*	recv_addr = addrs[i];
 
-	for (page_no = low_limit; page_no < low_limit + RECV_READ_AHEAD_AREA;
-	     page_no++) {
-		recv_addr = recv_get_fil_addr_struct(space, page_no);
-
-		if (recv_addr && !buf_page_peek(space, page_no)) {
+		if (!buf_page_peek(space, recv_addr->page_no)) {
 
 			mutex_enter(&(recv_sys->mutex));
 
 			if (recv_addr->state == RECV_NOT_PROCESSED) {
 				recv_addr->state = RECV_BEING_READ;
 
-				page_nos[n] = page_no;
+				page_nos[n] = recv_addr->page_no;
 
 				n++;
 			}
@@ -1903,10 +1996,11 @@ recv_apply_hashed_log_recs(
 				the caller must in this case own the log
 				mutex */
 {
-	recv_addr_t* recv_addr;
-	ulint	i;
-	ibool	has_printed	= FALSE;
-	mtr_t	mtr;
+	recv_addr_t**	addrs;
+	ulint		n_addrs;
+	ulint		i;
+	ibool		has_printed	= FALSE;
+	mtr_t		mtr;
 loop:
 	mutex_enter(&(recv_sys->mutex));
 
@@ -1928,77 +2022,81 @@ loop:
 	recv_sys->apply_log_recs = TRUE;
 	recv_sys->apply_batch_on = TRUE;
 
-	for (i = 0; i < hash_get_n_cells(recv_sys->addr_hash); i++) {
+	recv_progress_apply_batches++;
+	recv_progress_apply_percent = 0;
+	recv_progress_pending_pages = recv_sys->n_addrs;
 
-		for (recv_addr = static_cast<recv_addr_t*>(
-				HASH_GET_FIRST(recv_sys->addr_hash, i));
-		     recv_addr != 0;
-		     recv_addr = static_cast<recv_addr_t*>(
-				HASH_GET_NEXT(addr_hash, recv_addr))) {
+	/* Visit the pages in the order they are stored in the tablespaces
+	rather than in the hash table order, so that they are read in mostly
+	sequentially */
+	addrs = recv_get_sorted_addrs(&n_addrs);
 
-			ulint	space = recv_addr->space;
-			ulint	zip_size = fil_space_get_zip_size(space);
-			ulint	page_no = recv_addr->page_no;
+	for (i = 0; i < n_addrs; i++) {
 
-			/* By now we have replayed all DDL log records from the
-			current batch. Check if the space ID is still valid in
-			the entry being processed, and ignore it if it is not.*/
-			if (fil_tablespace_deleted_or_being_deleted_in_mem(
-				    space, -1)) {
+		recv_addr_t*	recv_addr = addrs[i];
+		ulint		space = recv_addr->space;
+		ulint		zip_size = fil_space_get_zip_size(space);
+		ulint		page_no = recv_addr->page_no;
 
-				ut_a(recv_sys->n_addrs);
+		/* By now we have replayed all DDL log records from the
+		current batch. Check if the space ID is still valid in
+		the entry being processed, and ignore it if it is not.*/
+		if (fil_tablespace_deleted_or_being_deleted_in_mem(
+			    space, -1)) {
 
-				recv_addr->state = RECV_PROCESSED;
-				recv_sys->n_addrs--;
+			ut_a(recv_sys->n_addrs);
 
-				continue;
-			}
-			if (recv_addr->state == RECV_NOT_PROCESSED) {
-				if (!has_printed) {
-					ib_logf(IB_LOG_LEVEL_INFO,
-						"Starting an apply batch"
-						" of log records"
-						" to the database...");
-					fputs("InnoDB: Progress in percent: ",
-					      stderr);
-					has_printed = TRUE;
-				}
+			recv_addr->state = RECV_PROCESSED;
+			recv_sys->n_addrs--;
 
-				mutex_exit(&(recv_sys->mutex));
+			continue;
+		}
+		if (recv_addr->state == RECV_NOT_PROCESSED) {
+			if (!has_printed) {
+				ib_logf(IB_LOG_LEVEL_INFO,
+					"Starting an apply batch"
+					" of log records"
+					" to the database...");
+				fputs("InnoDB: Progress in percent: ",
+				      stderr);
+				has_printed = TRUE;
+			}
 
-				if (buf_page_peek(space, page_no)) {
-					buf_block_t*	block;
+			mutex_exit(&(recv_sys->mutex));
 
-					mtr_start(&mtr);
+			if (buf_page_peek(space, page_no)) {
+				buf_block_t*	block;
 
-					block = buf_page_get(
-						space, zip_size, page_no,
-						RW_X_LATCH, &mtr);
-					buf_block_dbg_add_level(
-						block, SYNC_NO_ORDER_CHECK);
+				mtr_start(&mtr);
 
-					recv_recover_page(FALSE, block);
-					mtr_commit(&mtr);
-				} else {
-					recv_read_in_area(space, zip_size,
-							  page_no);
-				}
+				block = buf_page_get(
+					space, zip_size, page_no,
+					RW_X_LATCH, &mtr);
+				buf_block_dbg_add_level(
+					block, SYNC_NO_ORDER_CHECK);
 
-				mutex_enter(&(recv_sys->mutex));
+				recv_recover_page(FALSE, block);
+				mtr_commit(&mtr);
+			} else {
+				recv_read_in_area(addrs, n_addrs, i,
+						  zip_size);
 			}
+
+			mutex_enter(&(recv_sys->mutex));
 		}
 
+		recv_progress_apply_percent = ((i + 1) * 100) / n_addrs;
+		recv_progress_pending_pages = recv_sys->n_addrs;
+
 		if (has_printed
-		    && (i * 100) / hash_get_n_cells(recv_sys->addr_hash)
-		    != ((i + 1) * 100)
-		    / hash_get_n_cells(recv_sys->addr_hash)) {
+		    && (i * 100) / n_addrs != ((i + 1) * 100) / n_addrs) {
 
-			fprintf(stderr, "%lu ", (ulong)
-				((i * 100)
-				 / hash_get_n_cells(recv_sys->addr_hash)));
+			fprintf(stderr, "%lu ", (ulong) ((i * 100) / n_addrs));
 		}
 	}
 
+	ut_free(addrs);
+
 	/* Wait until all the pages have been processed */
 
 	while (recv_sys->n_addrs != 0) {
@@ -2214,7 +2312,7 @@ skip_this_recv_addr:
 /*******************************************************************//**
 Tries to parse a single log record and returns its length.
 @return	length of the record, or 0 if the record was not complete */
-static
+UNIV_INTERN
 ulint
 recv_parse_log_rec(
 /*===============*/
@@ -2285,7 +2383,7 @@ recv_parse_log_rec(
 
 /*******************************************************//**
 Calculates the new value for lsn when more data is added to the log. */
-static
+UNIV_INTERN
 lsn_t
 recv_calc_lsn_on_data_add(
 /*======================*/
@@ -2624,7 +2722,9 @@ loop:
 #ifdef UNIV_LOG_LSN_DEBUG
 			    && type != MLOG_LSN
 #endif /* UNIV_LOG_LSN_DEBUG */
-			    ) {
+			    /* xtrabackup --log-filter replaces records
+			    within an mtr with dummy records */
+			    && type != MLOG_DUMMY_RECORD) {
 				recv_add_to_hash_table(type, space, page_no,
 						       body, ptr + len,
 						       old_lsn,
@@ -2933,6 +3033,7 @@ recv_scan_log_recs(
 	} while (log_block < buf + len && !finished);
 
 	*group_scanned_lsn = scanned_lsn;
+	recv_progress_scanned_lsn = scanned_lsn;
 
 	if (recv_needed_recovery
 	    || (recv_is_from_backup && !recv_is_making_a_backup)) {
@@ -3240,6 +3341,9 @@ recv_recovery_from_checkpoint_start_func(
 		recv_sys->scanned_checkpoint_no = 0;
 		recv_sys->recovered_lsn = checkpoint_lsn;
 
+		recv_progress_start_lsn = checkpoint_lsn;
+		recv_progress_scanned_lsn = checkpoint_lsn;
+
 		srv_start_lsn = checkpoint_lsn;
 	}
 
@@ -38,9 +38,17 @@ using namespace std;
 #include "ut0sort.h"
 #include "dict0dict.h"
 #include "btr0cur.h"
+#include "fil0fil.h"
+#include "fsp0fsp.h"
 #include "page0types.h"
 #include "log0recv.h"
 #include "zlib.h"
+#ifdef HAVE_LZ4
+# include <lz4.h>
+#endif /* HAVE_LZ4 */
+#ifdef HAVE_ZSTD
+# include <zstd.h>
+#endif /* HAVE_ZSTD */
 #ifndef UNIV_HOTBACKUP
 # include "buf0buf.h"
 # include "buf0lru.h"
@@ -71,6 +79,10 @@ UNIV_INTERN mysql_pfs_key_t		page_zip_stat_per_index_mutex_key;
 /* Compression level to be used by zlib. Settable by user. */
 UNIV_INTERN uint	page_zip_level = DEFAULT_COMPRESSION_LEVEL;
 
+/* Compression algorithm (page_zip_codec_t) of the tables that are
+created with ROW_FORMAT=COMPRESSED. Settable by user. */
+UNIV_INTERN ulong	page_zip_codec = PAGE_ZIP_CODEC_ZLIB;
+
 /* Whether or not to log compressed page images to avoid possible
 compression algorithm changes in zlib. */
 UNIV_INTERN my_bool	page_zip_log_pages = true;
@@ -758,6 +770,451 @@ page_zip_set_alloc(
 	strm->opaque = heap;
 }
 
+/* The compressed payload of a page is a zlib stream, unless the table
+uses another compression algorithm.  The other algorithms compress blocks
+rather than streams, so page_zip_deflate() collects everything that
+page_zip_compress() passes to it and compresses it in one block on
+Z_FINISH, and page_zip_inflate() decompresses the whole block on the
+first call and returns it piecewise, with the same next_in, next_out
+and return values as deflate() and inflate() would have.
+
+The block is preceded by a header of PAGE_ZIP_BLOCK_HEADER bytes:
+the method byte, the length of the index field information, which is
+flushed with Z_FULL_FLUSH and read with Z_BLOCK in a zlib stream, and
+the length of the compressed block.  The low nibble of the first byte
+of a zlib stream is the compression method 8 (deflate).  The method
+byte of a block has the value 15, which is reserved by RFC 1950, in the
+low nibble and the page_zip_codec_t in the high nibble, so that the
+pages identify their algorithm, and zlib refuses to inflate them. */
+
+/** Compression method of a block in the method byte */
+#define PAGE_ZIP_BLOCK_METHOD	15
+/** Size of the header of a block, in bytes */
+#define PAGE_ZIP_BLOCK_HEADER	5
+/** Size of the buffer that holds the uncompressed block: the index
+field information and the compressed part of the page */
+#define PAGE_ZIP_BLOCK_BUF_SIZE	(2 * UNIV_PAGE_SIZE)
+
+/** Compressed page stream */
+struct page_zip_stream_t : public z_stream {
+	ulint		codec;	/*!< compression algorithm,
+				page_zip_codec_t */
+	ulint		level;	/*!< compression level */
+	byte*		buf;	/*!< uncompressed block, or NULL
+				if it has not been decompressed */
+	ulint		len;	/*!< length of the uncompressed block */
+	ulint		pos;	/*!< number of bytes of buf that have
+				been returned by page_zip_inflate() */
+	ulint		fields_len;/*!< length of the index field
+				information at the start of buf */
+	ulint		zip_len;/*!< length of the block, including
+				the header */
+};
+
+/**********************************************************************//**
+Determine if a compression algorithm is available in this build.
+@return	true if pages can be compressed and decompressed with codec */
+UNIV_INTERN
+bool
+page_zip_codec_available(
+/*=====================*/
+	ulint		codec)		/*!< in: page_zip_codec_t */
+{
+	switch (codec) {
+	case PAGE_ZIP_CODEC_ZLIB:
+		return(true);
+#ifdef HAVE_LZ4
+	case PAGE_ZIP_CODEC_LZ4:
+		return(true);
+#endif /* HAVE_LZ4 */
+#ifdef HAVE_ZSTD
+	case PAGE_ZIP_CODEC_ZSTD:
+		return(true);
+#endif /* HAVE_ZSTD */
+	}
+
+	return(false);
+}
+
+/**********************************************************************//**
+Determine the compression algorithm of the compressed payload of a page.
+@return	page_zip_codec_t, or ULINT_UNDEFINED if the method is unknown */
+static
+ulint
+page_zip_get_codec(
+/*===============*/
+	const byte*	payload)	/*!< in: compressed payload */
+{
+	switch (*payload & 15) {
+	case Z_DEFLATED:
+		return(PAGE_ZIP_CODEC_ZLIB);
+	case PAGE_ZIP_BLOCK_METHOD:
+		if ((ulint) (*payload >> 4) != PAGE_ZIP_CODEC_ZLIB
+		    && (ulint) (*payload >> 4) <= PAGE_ZIP_CODEC_MAX) {
+			return(*payload >> 4);
+		}
+	}
+
+	return(ULINT_UNDEFINED);
+}
+
+/**********************************************************************//**
+Compress a block with a compression algorithm other than zlib.
+@return	length of the compressed block, or 0 if it does not fit */
+static
+ulint
+page_zip_block_compress(
+/*====================*/
+	ulint		codec,	/*!< in: page_zip_codec_t */
+	ulint		level,	/*!< in: compression level */
+	const byte*	src,	/*!< in: uncompressed block */
+	ulint		src_len,/*!< in: length of src */
+	byte*		dst,	/*!< out: compressed block */
+	ulint		dst_len)/*!< in: size of dst */
+{
+	switch (codec) {
+#ifdef HAVE_LZ4
+	case PAGE_ZIP_CODEC_LZ4:
+		{
+			/* LZ4 has a single compression level. */
+			int	zip_len = LZ4_compress_default(
+				(const char*) src, (char*) dst,
+				(int) src_len, (int) dst_len);
+
+			return(zip_len > 0 ? (ulint) zip_len : 0);
+		}
+#endif /* HAVE_LZ4 */
+#ifdef HAVE_ZSTD
+	case PAGE_ZIP_CODEC_ZSTD:
+		{
+			/* Level 0 means no compression for zlib,
+			but the default level for zstd. */
+			size_t	zip_len = ZSTD_compress(
+				dst, dst_len, src, src_len,
+				level ? (int) level : 1);
+
+			return(ZSTD_isError(zip_len) ? 0 : zip_len);
+		}
+#endif /* HAVE_ZSTD */
+	}
+
+	ut_error;
+	return(0);
+}
+
+/**********************************************************************//**
+Decompress a block that was compressed with page_zip_block_compress().
+@return	length of the uncompressed block, or ULINT_UNDEFINED on error */
+static
+ulint
+page_zip_block_decompress(
+/*======================*/
+	ulint		codec,	/*!< in: page_zip_codec_t */
+	const byte*	src,	/*!< in: compressed block */
+	ulint		src_len,/*!< in: length of src */
+	byte*		dst,	/*!< out: uncompressed block */
+	ulint		dst_len)/*!< in: size of dst */
+{
+	switch (codec) {
+#ifdef HAVE_LZ4
+	case PAGE_ZIP_CODEC_LZ4:
+		{
+			int	len = LZ4_decompress_safe(
+				(const char*) src, (char*) dst,
+				(int) src_len, (int) dst_len);
+
+			return(len < 0 ? ULINT_UNDEFINED : (ulint) len);
+		}
+#endif /* HAVE_LZ4 */
+#ifdef HAVE_ZSTD
+	case PAGE_ZIP_CODEC_ZSTD:
+		{
+			size_t	len = ZSTD_decompress(
+				dst, dst_len, src, src_len);
+
+			return(ZSTD_isError(len) ? ULINT_UNDEFINED : len);
+		}
+#endif /* HAVE_ZSTD */
+	}
+
+	return(ULINT_UNDEFINED);
+}
+
+/**********************************************************************//**
+Initialize a compressed page stream for page_zip_deflate(). */
+static
+void
+page_zip_deflate_init(
+/*==================*/
+	page_zip_stream_t*	strm,	/*!< out: compressed page stream */
+	ulint			codec,	/*!< in: page_zip_codec_t */
+	ulint			level,	/*!< in: compression level */
+	mem_heap_t*		heap)	/*!< in: memory heap to use */
+{
+	strm->codec = codec;
+	strm->level = level;
+
+	if (codec == PAGE_ZIP_CODEC_ZLIB) {
+		int	err;
+
+		page_zip_set_alloc(strm, heap);
+
+		err = deflateInit2(strm, (int) level,
+				   Z_DEFLATED, UNIV_PAGE_SIZE_SHIFT,
+				   MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+		ut_a(err == Z_OK);
+		return;
+	}
+
+	ut_ad(page_zip_codec_available(codec));
+
+	strm->total_in = strm->total_out = 0;
+	strm->msg = NULL;
+	strm->buf = static_cast<byte*>(
+		mem_heap_alloc(heap, PAGE_ZIP_BLOCK_BUF_SIZE));
+	strm->len = 0;
+	strm->fields_len = ULINT_UNDEFINED;
+}
+
+/**********************************************************************//**
+Compress data like deflate() does.
+@return	deflate() status: Z_OK, Z_STREAM_END, Z_BUF_ERROR, ... */
+static
+int
+page_zip_deflate(
+/*=============*/
+	page_zip_stream_t*	strm,	/*!< in/out: compressed page stream */
+	int			flush)	/*!< in: deflate() flushing method */
+{
+	ulint	zip_len;
+
+	if (strm->codec == PAGE_ZIP_CODEC_ZLIB) {
+		return(deflate(strm, flush));
+	}
+
+	if (UNIV_UNLIKELY(strm->avail_in
+			  > PAGE_ZIP_BLOCK_BUF_SIZE - strm->len)) {
+		ut_ad(0);
+		return(Z_BUF_ERROR);
+	}
+
+	memcpy(strm->buf + strm->len, strm->next_in, strm->avail_in);
+	strm->len += strm->avail_in;
+	strm->next_in += strm->avail_in;
+	strm->total_in += strm->avail_in;
+	strm->avail_in = 0;
+
+	switch (flush) {
+	case Z_FULL_FLUSH:
+		/* This ends the index field information. */
+		ut_ad(strm->fields_len == ULINT_UNDEFINED);
+		strm->fields_len = strm->len;
+		return(Z_OK);
+	case Z_FINISH:
+		break;
+	default:
+		return(Z_OK);
+	}
+
+	ut_ad(strm->fields_len < 1 << 16);
+
+	if (strm->avail_out <= PAGE_ZIP_BLOCK_HEADER) {
+		return(Z_BUF_ERROR);
+	}
+
+	zip_len = page_zip_block_compress(
+		strm->codec, strm->level, strm->buf, strm->len,
+		strm->next_out + PAGE_ZIP_BLOCK_HEADER,
+		strm->avail_out - PAGE_ZIP_BLOCK_HEADER);
+
+	if (!zip_len) {
+		return(Z_BUF_ERROR);
+	}
+
+	ut_ad(zip_len < 1 << 16);
+
+	mach_write_to_1(strm->next_out,
+			strm->codec << 4 | PAGE_ZIP_BLOCK_METHOD);
+	mach_write_to_2(strm->next_out + 1, strm->fields_len);
+	mach_write_to_2(strm->next_out + 3, zip_len);
+
+	zip_len += PAGE_ZIP_BLOCK_HEADER;
+	strm->next_out += zip_len;
+	strm->avail_out -= zip_len;
+	strm->total_out += zip_len;
+
+	return(Z_STREAM_END);
+}
+
+/**********************************************************************//**
+Free a compressed page stream that was initialized with
+page_zip_deflate_init().
+@return	deflateEnd() status: Z_OK, ... */
+static
+int
+page_zip_deflate_end(
+/*=================*/
+	page_zip_stream_t*	strm)	/*!< in/out: compressed page stream */
+{
+	if (strm->codec == PAGE_ZIP_CODEC_ZLIB) {
+		return(deflateEnd(strm));
+	}
+
+	/* The buffer is freed with the memory heap. */
+	return(Z_OK);
+}
+
+/**********************************************************************//**
+Initialize a compressed page stream for page_zip_inflate().  The
+compressed payload must have been assigned to next_in and avail_in.
+@return	Z_OK, or Z_DATA_ERROR if the compression algorithm is not known
+or not available */
+static
+int
+page_zip_inflate_init(
+/*==================*/
+	page_zip_stream_t*	strm,	/*!< in/out: compressed page stream */
+	mem_heap_t*		heap)	/*!< in: memory heap to use */
+{
+	strm->codec = page_zip_get_codec(strm->next_in);
+
+	if (strm->codec == PAGE_ZIP_CODEC_ZLIB) {
+		page_zip_set_alloc(strm, heap);
+
+		if (UNIV_UNLIKELY(inflateInit2(strm, UNIV_PAGE_SIZE_SHIFT)
+				  != Z_OK)) {
+			ut_error;
+		}
+
+		return(Z_OK);
+	}
+
+	strm->total_in = strm->total_out = 0;
+	strm->msg = NULL;
+
+	if (strm->codec == ULINT_UNDEFINED
+	    || !page_zip_codec_available(strm->codec)) {
+		strm->msg = (char*) "unknown compression method";
+		return(Z_DATA_ERROR);
+	}
+
+	strm->buf = static_cast<byte*>(
+		mem_heap_alloc(heap, PAGE_ZIP_BLOCK_BUF_SIZE));
+	strm->len = 0;
+	strm->pos = 0;
+	strm->zip_len = 0;
+
+	return(Z_OK);
+}
+
+/**********************************************************************//**
+Decompress data like inflate() does.
+@return	inflate() status: Z_OK, Z_STREAM_END, Z_BUF_ERROR, ... */
+static
+int
+page_zip_inflate(
+/*=============*/
+	page_zip_stream_t*	strm,	/*!< in/out: compressed page stream */
+	int			flush)	/*!< in: inflate() flushing method */
+{
+	ulint	n;
+
+	if (strm->codec == PAGE_ZIP_CODEC_ZLIB) {
+		return(inflate(strm, flush));
+	}
+
+	if (!strm->zip_len) {
+		/* Decompress the whole block on the first call. */
+		ulint	zip_len;
+
+		if (strm->avail_in <= PAGE_ZIP_BLOCK_HEADER) {
+			strm->msg = (char*) "block header truncated";
+			return(Z_DATA_ERROR);
+		}
+
+		strm->fields_len = mach_read_from_2(strm->next_in + 1);
+		zip_len = mach_read_from_2(strm->next_in + 3);
+
+		if (zip_len > strm->avail_in - PAGE_ZIP_BLOCK_HEADER) {
+			strm->msg = (char*) "block too long";
+			return(Z_DATA_ERROR);
+		}
+
+		strm->len = page_zip_block_decompress(
+			strm->codec, strm->next_in + PAGE_ZIP_BLOCK_HEADER,
+			zip_len, strm->buf, PAGE_ZIP_BLOCK_BUF_SIZE);
+
+		if (strm->len == ULINT_UNDEFINED
+		    || strm->fields_len > strm->len) {
+			strm->msg = (char*) "invalid block";
+			return(Z_DATA_ERROR);
+		}
+
+		strm->zip_len = zip_len + PAGE_ZIP_BLOCK_HEADER;
+	} else if (strm->total_in) {
+		/* The end of the block has been reached. */
+		return(Z_STREAM_END);
+	}
+
+	if (flush == Z_BLOCK) {
+		/* Stop at the end of the index field information,
+		like inflate() stops at the end of the deflate block
+		that deflate(Z_FULL_FLUSH) ended. */
+		n = strm->pos < strm->fields_len
+			? strm->fields_len - strm->pos : 0;
+	} else {
+		n = strm->len - strm->pos;
+	}
+
+	if (n > strm->avail_out) {
+		n = strm->avail_out;
+	}
+
+	memcpy(strm->next_out, strm->buf + strm->pos, n);
+	strm->pos += n;
+	strm->next_out += n;
+	strm->avail_out -= n;
+	strm->total_out += n;
+
+	if (flush == Z_BLOCK) {
+		return(Z_OK);
+	} else if (strm->pos < strm->len) {
+		return(n ? Z_OK : Z_BUF_ERROR);
+	}
+
+	/* Consume the block at the end of the stream, after the
+	callers have excluded the space that is reserved for the
+	uncompressed data from avail_in. */
+	if (strm->zip_len > strm->avail_in) {
+		strm->msg = (char*) "block too long";
+		return(Z_DATA_ERROR);
+	}
+
+	strm->next_in += strm->zip_len;
+	strm->avail_in -= strm->zip_len;
+	strm->total_in = strm->zip_len;
+
+	return(Z_STREAM_END);
+}
+
+/**********************************************************************//**
+Free a compressed page stream that was initialized with
+page_zip_inflate_init().
+@return	inflateEnd() status: Z_OK, ... */
+static
+int
+page_zip_inflate_end(
+/*=================*/
+	page_zip_stream_t*	strm)	/*!< in/out: compressed page stream */
+{
+	if (strm->codec == PAGE_ZIP_CODEC_ZLIB) {
+		return(inflateEnd(strm));
+	}
+
+	/* The buffer is freed with the memory heap. */
+	return(Z_OK);
+}
+
 #if 0 || defined UNIV_DEBUG || defined UNIV_ZIP_DEBUG
 /** Symbol for enabling compression and decompression diagnostics */
 # define PAGE_ZIP_COMPRESS_DBG
@@ -774,15 +1231,16 @@ as a log file name generator. */
 UNIV_INTERN unsigned	page_zip_compress_log;
 
 /**********************************************************************//**
-Wrapper for deflate().  Log the operation if page_zip_compress_dbg is set.
+Wrapper for page_zip_deflate().  Log the operation if
+page_zip_compress_dbg is set.
 @return	deflate() status: Z_OK, Z_BUF_ERROR, ... */
 static
 int
 page_zip_compress_deflate(
 /*======================*/
-	FILE*		logfile,/*!< in: log file, or NULL */
-	z_streamp	strm,	/*!< in/out: compressed stream for deflate() */
-	int		flush)	/*!< in: deflate() flushing method */
+	FILE*			logfile,/*!< in: log file, or NULL */
+	page_zip_stream_t*	strm,	/*!< in/out: compressed page stream */
+	int			flush)	/*!< in: deflate() flushing method */
 {
 	int	status;
 	if (UNIV_UNLIKELY(page_zip_compress_dbg)) {
@@ -791,21 +1249,21 @@ page_zip_compress_deflate(
 	if (UNIV_LIKELY_NULL(logfile)) {
 		fwrite(strm->next_in, 1, strm->avail_in, logfile);
 	}
-	status = deflate(strm, flush);
+	status = page_zip_deflate(strm, flush);
 	if (UNIV_UNLIKELY(page_zip_compress_dbg)) {
 		fprintf(stderr, " -> %d\n", status);
 	}
 	return(status);
 }
 
-/* Redefine deflate(). */
-# undef deflate
-/** Debug wrapper for the zlib compression routine deflate().
+/* Redefine page_zip_deflate(). */
+/** Debug wrapper for the compression routine page_zip_deflate().
 Log the operation if page_zip_compress_dbg is set.
-@param strm	in/out: compressed stream
+@param strm	in/out: compressed page stream
 @param flush	in: flushing method
 @return		deflate() status: Z_OK, Z_BUF_ERROR, ... */
-# define deflate(strm, flush) page_zip_compress_deflate(logfile, strm, flush)
+# define page_zip_deflate(strm, flush)				\
+	page_zip_compress_deflate(logfile, strm, flush)
 /** Declaration of the logfile parameter */
 # define FILE_LOGFILE FILE* logfile,
 /** The logfile parameter */
@@ -825,7 +1283,7 @@ int
 page_zip_compress_node_ptrs(
 /*========================*/
 	FILE_LOGFILE
-	z_stream*	c_stream,	/*!< in/out: compressed page stream */
+	page_zip_stream_t*	c_stream,/*!< in/out: compressed page stream */
 	const rec_t**	recs,		/*!< in: dense page directory
 					sorted by address */
 	ulint		n_dense,	/*!< in: size of recs[] */
@@ -853,7 +1311,7 @@ page_zip_compress_node_ptrs(
 			- c_stream->next_in;
 
 		if (c_stream->avail_in) {
-			err = deflate(c_stream, Z_NO_FLUSH);
+			err = page_zip_deflate(c_stream, Z_NO_FLUSH);
 			if (UNIV_UNLIKELY(err != Z_OK)) {
 				break;
 			}
@@ -866,7 +1324,7 @@ page_zip_compress_node_ptrs(
 			- REC_NODE_PTR_SIZE;
 
 		if (c_stream->avail_in) {
-			err = deflate(c_stream, Z_NO_FLUSH);
+			err = page_zip_deflate(c_stream, Z_NO_FLUSH);
 			if (UNIV_UNLIKELY(err != Z_OK)) {
 				break;
 			}
@@ -891,7 +1349,7 @@ int
 page_zip_compress_sec(
 /*==================*/
 	FILE_LOGFILE
-	z_stream*	c_stream,	/*!< in/out: compressed page stream */
+	page_zip_stream_t*	c_stream,/*!< in/out: compressed page stream */
 	const rec_t**	recs,		/*!< in: dense page directory
 					sorted by address */
 	ulint		n_dense)	/*!< in: size of recs[] */
@@ -910,7 +1368,7 @@ page_zip_compress_sec(
 		if (UNIV_LIKELY(c_stream->avail_in)) {
 			UNIV_MEM_ASSERT_RW(c_stream->next_in,
 					   c_stream->avail_in);
-			err = deflate(c_stream, Z_NO_FLUSH);
+			err = page_zip_deflate(c_stream, Z_NO_FLUSH);
 			if (UNIV_UNLIKELY(err != Z_OK)) {
 				break;
 			}
@@ -936,7 +1394,7 @@ int
 page_zip_compress_clust_ext(
 /*========================*/
 	FILE_LOGFILE
-	z_stream*	c_stream,	/*!< in/out: compressed page stream */
+	page_zip_stream_t*	c_stream,/*!< in/out: compressed page stream */
 	const rec_t*	rec,		/*!< in: record */
 	const ulint*	offsets,	/*!< in: rec_get_offsets(rec) */
 	ulint		trx_id_col,	/*!< in: position of of DB_TRX_ID */
@@ -974,7 +1432,7 @@ page_zip_compress_clust_ext(
 				= src - c_stream->next_in;
 
 			if (c_stream->avail_in) {
-				err = deflate(c_stream, Z_NO_FLUSH);
+				err = page_zip_deflate(c_stream, Z_NO_FLUSH);
 				if (UNIV_UNLIKELY(err != Z_OK)) {
 
 					return(err);
@@ -1003,7 +1461,7 @@ page_zip_compress_clust_ext(
 			c_stream->avail_in = src
 				- c_stream->next_in;
 			if (UNIV_LIKELY(c_stream->avail_in)) {
-				err = deflate(c_stream, Z_NO_FLUSH);
+				err = page_zip_deflate(c_stream, Z_NO_FLUSH);
 				if (UNIV_UNLIKELY(err != Z_OK)) {
 
 					return(err);
@@ -1063,7 +1521,7 @@ int
 page_zip_compress_clust(
 /*====================*/
 	FILE_LOGFILE
-	z_stream*	c_stream,	/*!< in/out: compressed page stream */
+	page_zip_stream_t*	c_stream,/*!< in/out: compressed page stream */
 	const rec_t**	recs,		/*!< in: dense page directory
 					sorted by address */
 	ulint		n_dense,	/*!< in: size of recs[] */
@@ -1100,7 +1558,7 @@ page_zip_compress_clust(
 			- c_stream->next_in;
 
 		if (c_stream->avail_in) {
-			err = deflate(c_stream, Z_NO_FLUSH);
+			err = page_zip_deflate(c_stream, Z_NO_FLUSH);
 			if (UNIV_UNLIKELY(err != Z_OK)) {
 
 				goto func_exit;
@@ -1147,7 +1605,7 @@ page_zip_compress_clust(
 			c_stream->avail_in = src - c_stream->next_in;
 
 			if (c_stream->avail_in) {
-				err = deflate(c_stream, Z_NO_FLUSH);
+				err = page_zip_deflate(c_stream, Z_NO_FLUSH);
 				if (UNIV_UNLIKELY(err != Z_OK)) {
 
 					return(err);
@@ -1175,7 +1633,7 @@ page_zip_compress_clust(
 			- c_stream->next_in;
 
 		if (c_stream->avail_in) {
-			err = deflate(c_stream, Z_NO_FLUSH);
+			err = page_zip_deflate(c_stream, Z_NO_FLUSH);
 			if (UNIV_UNLIKELY(err != Z_OK)) {
 
 				goto func_exit;
@@ -1203,7 +1661,8 @@ page_zip_compress(
 	ulint		level,	/*!< in: compression level */
 	mtr_t*		mtr)	/*!< in: mini-transaction, or NULL */
 {
-	z_stream	c_stream;
+	page_zip_stream_t	c_stream;
+	ulint		codec;	/*!< compression algorithm */
 	int		err;
 	ulint		n_fields;/* number of index fields needed */
 	byte*		fields;	/*!< index field information */
@@ -1321,13 +1780,26 @@ page_zip_compress(
 
 	buf_end = buf + page_zip_get_size(page_zip) - PAGE_DATA;
 
-	/* Compress the data payload. */
-	page_zip_set_alloc(&c_stream, heap);
+	/* Compress the data payload with the algorithm of the table.
+	In crash recovery, the index is a dummy that does not know the
+	algorithm, and it is taken from the flags of the tablespace,
+	which are what the table was created with. */
+	if (!recv_recovery_is_on()) {
+		codec = DICT_TF_GET_ZIP_CODEC(index->table->flags);
+	} else {
+		ulint	flags = fil_space_get_flags(page_get_space_id(page));
 
-	err = deflateInit2(&c_stream, level,
-			   Z_DEFLATED, UNIV_PAGE_SIZE_SHIFT,
-			   MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY);
-	ut_a(err == Z_OK);
+		codec = flags == ULINT_UNDEFINED
+			? ULINT_UNDEFINED
+			: FSP_FLAGS_GET_ZIP_CODEC(flags);
+	}
+
+	if (UNIV_UNLIKELY(codec == ULINT_UNDEFINED
+			  || !page_zip_codec_available(codec))) {
+		codec = PAGE_ZIP_CODEC_ZLIB;
+	}
+
+	page_zip_deflate_init(&c_stream, codec, level, heap);
 
 	c_stream.next_out = buf;
 	/* Subtract the space reserved for uncompressed data. */
@@ -1370,7 +1842,7 @@ page_zip_compress(
 	}
 
 	UNIV_MEM_ASSERT_RW(c_stream.next_in, c_stream.avail_in);
-	err = deflate(&c_stream, Z_FULL_FLUSH);
+	err = page_zip_deflate(&c_stream, Z_FULL_FLUSH);
 	if (err != Z_OK) {
 		goto zlib_error;
 	}
@@ -1424,11 +1896,11 @@ page_zip_compress(
 	ut_a(c_stream.avail_in <= UNIV_PAGE_SIZE - PAGE_ZIP_START - PAGE_DIR);
 
 	UNIV_MEM_ASSERT_RW(c_stream.next_in, c_stream.avail_in);
-	err = deflate(&c_stream, Z_FINISH);
+	err = page_zip_deflate(&c_stream, Z_FINISH);
 
 	if (UNIV_UNLIKELY(err != Z_STREAM_END)) {
 zlib_error:
-		deflateEnd(&c_stream);
+		page_zip_deflate_end(&c_stream);
 		mem_heap_free(heap);
 err_exit:
 #ifdef PAGE_ZIP_COMPRESS_DBG
@@ -1454,7 +1926,7 @@ err_exit:
 		return(FALSE);
 	}
 
-	err = deflateEnd(&c_stream);
+	err = page_zip_deflate_end(&c_stream);
 	ut_a(err == Z_OK);
 
 	ut_ad(buf + c_stream.total_out == c_stream.next_out);
@@ -2207,7 +2679,7 @@ ibool
 page_zip_decompress_node_ptrs(
 /*==========================*/
 	page_zip_des_t*	page_zip,	/*!< in/out: compressed page */
-	z_stream*	d_stream,	/*!< in/out: compressed page stream */
+	page_zip_stream_t*	d_stream,/*!< in/out: compressed page stream */
 	rec_t**		recs,		/*!< in: dense page directory
 					sorted by address */
 	ulint		n_dense,	/*!< in: size of recs[] */
@@ -2233,7 +2705,7 @@ page_zip_decompress_node_ptrs(
 
 		ut_ad(d_stream->avail_out < UNIV_PAGE_SIZE
 		      - PAGE_ZIP_START - PAGE_DIR);
-		switch (inflate(d_stream, Z_SYNC_FLUSH)) {
+		switch (page_zip_inflate(d_stream, Z_SYNC_FLUSH)) {
 		case Z_STREAM_END:
 			page_zip_decompress_heap_no(
 				d_stream, rec, heap_status);
@@ -2268,7 +2740,7 @@ page_zip_decompress_node_ptrs(
 		d_stream->avail_out = rec_offs_data_size(offsets)
 			- REC_NODE_PTR_SIZE;
 
-		switch (inflate(d_stream, Z_SYNC_FLUSH)) {
+		switch (page_zip_inflate(d_stream, Z_SYNC_FLUSH)) {
 		case Z_STREAM_END:
 			goto zlib_done;
 		case Z_OK:
@@ -2307,12 +2779,13 @@ page_zip_decompress_node_ptrs(
 		goto zlib_error;
 	}
 
-	if (UNIV_UNLIKELY(inflate(d_stream, Z_FINISH) != Z_STREAM_END)) {
+	if (UNIV_UNLIKELY(page_zip_inflate(d_stream, Z_FINISH)
+			  != Z_STREAM_END)) {
 		page_zip_fail(("page_zip_decompress_node_ptrs:"
 			       " inflate(Z_FINISH)=%s\n",
 			       d_stream->msg));
 zlib_error:
-		inflateEnd(d_stream);
+		page_zip_inflate_end(d_stream);
 		return(FALSE);
 	}
 
@@ -2320,7 +2793,7 @@ zlib_error:
 	if the modification log is nonempty. */
 
 zlib_done:
-	if (UNIV_UNLIKELY(inflateEnd(d_stream) != Z_OK)) {
+	if (UNIV_UNLIKELY(page_zip_inflate_end(d_stream) != Z_OK)) {
 		ut_error;
 	}
 
@@ -2396,7 +2869,7 @@ ibool
 page_zip_decompress_sec(
 /*====================*/
 	page_zip_des_t*	page_zip,	/*!< in/out: compressed page */
-	z_stream*	d_stream,	/*!< in/out: compressed page stream */
+	page_zip_stream_t*	d_stream,/*!< in/out: compressed page stream */
 	rec_t**		recs,		/*!< in: dense page directory
 					sorted by address */
 	ulint		n_dense,	/*!< in: size of recs[] */
@@ -2420,7 +2893,7 @@ page_zip_decompress_sec(
 			- d_stream->next_out;
 
 		if (UNIV_LIKELY(d_stream->avail_out)) {
-			switch (inflate(d_stream, Z_SYNC_FLUSH)) {
+			switch (page_zip_inflate(d_stream, Z_SYNC_FLUSH)) {
 			case Z_STREAM_END:
 				page_zip_decompress_heap_no(
 					d_stream, rec, heap_status);
@@ -2460,12 +2933,13 @@ page_zip_decompress_sec(
 		goto zlib_error;
 	}
 
-	if (UNIV_UNLIKELY(inflate(d_stream, Z_FINISH) != Z_STREAM_END)) {
+	if (UNIV_UNLIKELY(page_zip_inflate(d_stream, Z_FINISH)
+			  != Z_STREAM_END)) {
 		page_zip_fail(("page_zip_decompress_sec:"
 			       " inflate(Z_FINISH)=%s\n",
 			       d_stream->msg));
 zlib_error:
-		inflateEnd(d_stream);
+		page_zip_inflate_end(d_stream);
 		return(FALSE);
 	}
 
@@ -2473,7 +2947,7 @@ zlib_error:
 	if the modification log is nonempty. */
 
 zlib_done:
-	if (UNIV_UNLIKELY(inflateEnd(d_stream) != Z_OK)) {
+	if (UNIV_UNLIKELY(page_zip_inflate_end(d_stream) != Z_OK)) {
 		ut_error;
 	}
 
@@ -2532,7 +3006,7 @@ static
 ibool
 page_zip_decompress_clust_ext(
 /*==========================*/
-	z_stream*	d_stream,	/*!< in/out: compressed page stream */
+	page_zip_stream_t*	d_stream,/*!< in/out: compressed page stream */
 	rec_t*		rec,		/*!< in/out: record */
 	const ulint*	offsets,	/*!< in: rec_get_offsets(rec) */
 	ulint		trx_id_col)	/*!< in: position of of DB_TRX_ID */
@@ -2565,7 +3039,7 @@ page_zip_decompress_clust_ext(
 
 			d_stream->avail_out = dst - d_stream->next_out;
 
-			switch (inflate(d_stream, Z_SYNC_FLUSH)) {
+			switch (page_zip_inflate(d_stream, Z_SYNC_FLUSH)) {
 			case Z_STREAM_END:
 			case Z_OK:
 			case Z_BUF_ERROR:
@@ -2595,7 +3069,7 @@ page_zip_decompress_clust_ext(
 			dst += len - BTR_EXTERN_FIELD_REF_SIZE;
 
 			d_stream->avail_out = dst - d_stream->next_out;
-			switch (inflate(d_stream, Z_SYNC_FLUSH)) {
+			switch (page_zip_inflate(d_stream, Z_SYNC_FLUSH)) {
 			case Z_STREAM_END:
 			case Z_OK:
 			case Z_BUF_ERROR:
@@ -2641,7 +3115,7 @@ ibool
 page_zip_decompress_clust(
 /*======================*/
 	page_zip_des_t*	page_zip,	/*!< in/out: compressed page */
-	z_stream*	d_stream,	/*!< in/out: compressed page stream */
+	page_zip_stream_t*	d_stream,/*!< in/out: compressed page stream */
 	rec_t**		recs,		/*!< in: dense page directory
 					sorted by address */
 	ulint		n_dense,	/*!< in: size of recs[] */
@@ -2673,7 +3147,7 @@ page_zip_decompress_clust(
 
 		ut_ad(d_stream->avail_out < UNIV_PAGE_SIZE
 		      - PAGE_ZIP_START - PAGE_DIR);
-		err = inflate(d_stream, Z_SYNC_FLUSH);
+		err = page_zip_inflate(d_stream, Z_SYNC_FLUSH);
 		switch (err) {
 		case Z_STREAM_END:
 			page_zip_decompress_heap_no(
@@ -2729,7 +3203,7 @@ page_zip_decompress_clust(
 
 			d_stream->avail_out = dst - d_stream->next_out;
 
-			switch (inflate(d_stream, Z_SYNC_FLUSH)) {
+			switch (page_zip_inflate(d_stream, Z_SYNC_FLUSH)) {
 			case Z_STREAM_END:
 			case Z_OK:
 			case Z_BUF_ERROR:
@@ -2759,7 +3233,7 @@ page_zip_decompress_clust(
 		d_stream->avail_out = rec_get_end(rec, offsets)
 			- d_stream->next_out;
 
-		switch (inflate(d_stream, Z_SYNC_FLUSH)) {
+		switch (page_zip_inflate(d_stream, Z_SYNC_FLUSH)) {
 		case Z_STREAM_END:
 		case Z_OK:
 		case Z_BUF_ERROR:
@@ -2789,12 +3263,13 @@ page_zip_decompress_clust(
 		goto zlib_error;
 	}
 
-	if (UNIV_UNLIKELY(inflate(d_stream, Z_FINISH) != Z_STREAM_END)) {
+	if (UNIV_UNLIKELY(page_zip_inflate(d_stream, Z_FINISH)
+			  != Z_STREAM_END)) {
 		page_zip_fail(("page_zip_decompress_clust:"
 			       " inflate(Z_FINISH)=%s\n",
 			       d_stream->msg));
 zlib_error:
-		inflateEnd(d_stream);
+		page_zip_inflate_end(d_stream);
 		return(FALSE);
 	}
 
@@ -2802,7 +3277,7 @@ zlib_error:
 	if the modification log is nonempty. */
 
 zlib_done:
-	if (UNIV_UNLIKELY(inflateEnd(d_stream) != Z_OK)) {
+	if (UNIV_UNLIKELY(page_zip_inflate_end(d_stream) != Z_OK)) {
 		ut_error;
 	}
 
@@ -2946,7 +3421,7 @@ page_zip_decompress(
 				page header fields that should not change
 				after page creation */
 {
-	z_stream	d_stream;
+	page_zip_stream_t	d_stream;
 	dict_index_t*	index	= NULL;
 	rec_t**		recs;	/*!< dense page directory, sorted by address */
 	ulint		n_dense;/* number of user records on the page */
@@ -3030,8 +3505,6 @@ zlib_error:
 	memcpy(page + (PAGE_NEW_SUPREMUM - REC_N_NEW_EXTRA_BYTES + 1),
 	       supremum_extra_data, sizeof supremum_extra_data);
 
-	page_zip_set_alloc(&d_stream, heap);
-
 	d_stream.next_in = page_zip->data + PAGE_DATA;
 	/* Subtract the space reserved for
 	the page header and the end marker of the modification log. */
@@ -3039,20 +3512,22 @@ zlib_error:
 	d_stream.next_out = page + PAGE_ZIP_START;
 	d_stream.avail_out = UNIV_PAGE_SIZE - PAGE_ZIP_START;
 
-	if (UNIV_UNLIKELY(inflateInit2(&d_stream, UNIV_PAGE_SIZE_SHIFT)
-			  != Z_OK)) {
-		ut_error;
+	if (UNIV_UNLIKELY(page_zip_inflate_init(&d_stream, heap) != Z_OK)) {
+
+		page_zip_fail(("page_zip_decompress:"
+			       " inflate_init=%s\n", d_stream.msg));
+		goto zlib_error;
 	}
 
 	/* Decode the zlib header and the index information. */
-	if (UNIV_UNLIKELY(inflate(&d_stream, Z_BLOCK) != Z_OK)) {
+	if (UNIV_UNLIKELY(page_zip_inflate(&d_stream, Z_BLOCK) != Z_OK)) {
 
 		page_zip_fail(("page_zip_decompress:"
 			       " 1 inflate(Z_BLOCK)=%s\n", d_stream.msg));
 		goto zlib_error;
 	}
 
-	if (UNIV_UNLIKELY(inflate(&d_stream, Z_BLOCK) != Z_OK)) {
+	if (UNIV_UNLIKELY(page_zip_inflate(&d_stream, Z_BLOCK) != Z_OK)) {
 
 		page_zip_fail(("page_zip_decompress:"
 			       " 2 inflate(Z_BLOCK)=%s\n", d_stream.msg));
@@ -273,52 +273,66 @@ read_view_add(
 	ut_ad(read_view_list_validate());
 }
 
-/** Functor to create thew view trx_ids array. */
-struct	CreateView {
-
-	CreateView(read_view_t*	view)
-		: m_view(view)
-	{
-		  m_n_trx = m_view->n_trx_ids;
-		  m_view->n_trx_ids = 0;
-	}
+/*********************************************************************//**
+Fills the trx_ids array and low_limit_no of a read view from the active
+read-write transactions: the ids are copied from trx_sys->descriptors, except
+for the id of the creating transaction, and the smallest trx->no assigned to
+a transaction still in the middle of its commit caps low_limit_no. */
+static
+void
+read_view_copy_trx_ids(
+/*===================*/
+	read_view_t*	view)	/*!< in/out: read view, with at least
+				trx_sys->descr_n_used cells in trx_ids,
+				and low_limit_no set */
+{
+	const trx_t*	trx;
+	ulint		n;
+	ulint		lower;
+	ulint		upper;
 
-	void	operator()(const trx_t* trx)
-	{
-		ut_ad(mutex_own(&trx_sys->mutex));
-		ut_ad(trx->in_rw_trx_list);
+	ut_ad(mutex_own(&trx_sys->mutex));
+	ut_ad(view->n_trx_ids >= trx_sys->descr_n_used);
 
-		/* trx->state cannot change from or to NOT_STARTED
-		while we are holding the trx_sys->mutex. It may change
-		from ACTIVE to PREPARED or COMMITTED. */
+	n = trx_sys->descr_n_used;
 
-		if (trx->id != m_view->creator_trx_id
-		    && !trx_state_eq(trx, TRX_STATE_COMMITTED_IN_MEMORY)) {
+	memcpy(view->trx_ids, trx_sys->descriptors,
+	       n * sizeof(*view->trx_ids));
 
-			ut_ad(m_n_trx > m_view->n_trx_ids);
+	/* Remove the creating transaction, if it is read-write. */
 
-			m_view->trx_ids[m_view->n_trx_ids++] = trx->id;
+	lower = 0;
+	upper = n;
 
-			/* NOTE that a transaction whose trx number is <
-			trx_sys->max_trx_id can still be active, if it is
-			in the middle of its commit! Note that when a
-			transaction starts, we initialize trx->no to
-			TRX_ID_MAX. */
+	while (lower < upper) {
+		ulint	mid = (lower + upper) >> 1;
 
-			/* trx->no is protected by trx_sys->mutex, which
-			we are holding. It is assigned by trx_commit()
-			before lock_trx_release_locks() assigns
-			trx->state = TRX_STATE_COMMITTED_IN_MEMORY. */
+		if (view->trx_ids[mid] == view->creator_trx_id) {
 
-			if (m_view->low_limit_no > trx->no) {
-				m_view->low_limit_no = trx->no;
-			}
+			memmove(view->trx_ids + mid, view->trx_ids + mid + 1,
+				(n - mid - 1) * sizeof(*view->trx_ids));
+			--n;
+			break;
+		} else if (view->trx_ids[mid] < view->creator_trx_id) {
+			lower = mid + 1;
+		} else {
+			upper = mid;
 		}
 	}
 
-	read_view_t*	m_view;
-	ulint		m_n_trx;
-};
+	view->n_trx_ids = n;
+
+	/* NOTE that a transaction whose trx number is <
+	trx_sys->max_trx_id can still be active, if it is in the middle
+	of its commit! Such transactions are on the serialisation list,
+	which is sorted on trx->no. */
+
+	trx = UT_LIST_GET_FIRST(trx_sys->serialisation_list);
+
+	if (trx != NULL && trx->no < view->low_limit_no) {
+		view->low_limit_no = trx->no;
+	}
+}
 
 /*********************************************************************//**
 Opens a read view where exactly the transactions serialized before this
@@ -334,11 +348,10 @@ read_view_open_now_low(
 					allocated */
 {
 	read_view_t*	view;
-	ulint		n_trx = UT_LIST_GET_LEN(trx_sys->rw_trx_list);
 
 	ut_ad(mutex_own(&trx_sys->mutex));
 
-	view = read_view_create_low(n_trx, heap);
+	view = read_view_create_low(trx_sys->descr_n_used, heap);
 
 	view->undo_no = 0;
 	view->type = VIEW_NORMAL;
@@ -351,11 +364,11 @@ read_view_open_now_low(
 
 	/* No active transaction should be visible, except cr_trx */
 
-	ut_list_map(trx_sys->rw_trx_list, &trx_t::trx_list, CreateView(view));
+	read_view_copy_trx_ids(view);
 
 	if (view->n_trx_ids > 0) {
-		/* The last active transaction has the smallest id: */
-		view->up_limit_id = view->trx_ids[view->n_trx_ids - 1];
+		/* The first active transaction has the smallest id: */
+		view->up_limit_id = view->trx_ids[0];
 	} else {
 		view->up_limit_id = view->low_limit_id;
 	}
@@ -445,7 +458,7 @@ read_view_purge_open(
 
 		id = oldest_view->trx_ids[i - insert_done];
 
-		if (insert_done == 0 && creator_trx_id > id) {
+		if (insert_done == 0 && creator_trx_id < id) {
 			id = creator_trx_id;
 			insert_done = 1;
 		}
@@ -466,9 +479,9 @@ read_view_purge_open(
 	view->low_limit_id = oldest_view->low_limit_id;
 
 	if (view->n_trx_ids > 0) {
-		/* The last active transaction has the smallest id: */
+		/* The first active transaction has the smallest id: */
 
-		view->up_limit_id = view->trx_ids[view->n_trx_ids - 1];
+		view->up_limit_id = view->trx_ids[0];
 	} else {
 		view->up_limit_id = oldest_view->up_limit_id;
 	}
@@ -546,7 +559,6 @@ read_cursor_view_create_for_mysql(
 {
 	read_view_t*	view;
 	mem_heap_t*	heap;
-	ulint		n_trx;
 	cursor_view_t*	curview;
 
 	/* Use larger heap than in trx_create when creating a read_view
@@ -567,9 +579,8 @@ read_cursor_view_create_for_mysql(
 
 	mutex_enter(&trx_sys->mutex);
 
-	n_trx = UT_LIST_GET_LEN(trx_sys->rw_trx_list);
-
-	curview->read_view = read_view_create_low(n_trx, curview->heap);
+	curview->read_view = read_view_create_low(
+		trx_sys->descr_n_used, curview->heap);
 
 	view = curview->read_view;
 	view->undo_no = cr_trx->undo_no;
@@ -583,14 +594,14 @@ read_cursor_view_create_for_mysql(
 
 	/* No active transaction should be visible */
 
-	ut_list_map(trx_sys->rw_trx_list, &trx_t::trx_list, CreateView(view));
+	read_view_copy_trx_ids(view);
 
 	view->creator_trx_id = cr_trx->id;
 
 	if (view->n_trx_ids > 0) {
-		/* The last active transaction has the smallest id: */
+		/* The first active transaction has the smallest id: */
 
-		view->up_limit_id = view->trx_ids[view->n_trx_ids - 1];
+		view->up_limit_id = view->trx_ids[0];
 	} else {
 		view->up_limit_id = view->low_limit_id;
 	}
@@ -829,7 +829,7 @@ exit:
 
 		row_merge_sort(psort_info->psort_common->trx,
 			       psort_info->psort_common->dup,
-			       merge_file[i], block[i], &tmpfd[i]);
+			       merge_file[i], block[i], &tmpfd[i], 1);
 		total_rec += merge_file[i]->n_rec;
 		close(tmpfd[i]);
 	}
@@ -36,8 +36,10 @@ Completed by Sunny Bains and Marko Makela
 #include "ut0sort.h"
 #include "row0ftsort.h"
 #include "row0import.h"
+#include "btr0bulk.h"
 #include "handler0alter.h"
 #include "ha_prototypes.h"
+#include "xb0xb.h"
 
 /* Ignore posix_fadvise() on those platforms where it does not exist */
 #if defined __WIN__
@@ -515,7 +517,16 @@ row_merge_dup_report(
 	row_merge_dup_t*	dup,	/*!< in/out: for reporting duplicates */
 	const dfield_t*		entry)	/*!< in: duplicate index entry */
 {
-	if (!dup->n_dup++) {
+	ulint	n_dup;
+
+#ifdef HAVE_ATOMIC_BUILTINS
+	/* The descriptor may be shared by threads sorting in parallel */
+	n_dup = os_atomic_increment_ulint(&dup->n_dup, 1) - 1;
+#else /* HAVE_ATOMIC_BUILTINS */
+	n_dup = dup->n_dup++;
+#endif /* HAVE_ATOMIC_BUILTINS */
+
+	if (!n_dup) {
 		/* Only report the first duplicate record,
 		but count all duplicate records. */
 		innobase_fields_to_mysql(dup->table, dup->index, entry);
@@ -1967,6 +1978,264 @@ done0:
 	       != NULL);
 }
 
+/*************************************************************//**
+Merge a run of the first half of the input file with the run at the same
+position in the second half, or copy a run of the second half that has no
+counterpart in the first half, to the output file.
+@return	DB_SUCCESS or error code */
+static __attribute__((nonnull, warn_unused_result))
+dberr_t
+row_merge_run(
+/*==========*/
+	const row_merge_dup_t*	dup,	/*!< in: descriptor of
+					index being created */
+	const merge_file_t*	file,	/*!< in: file containing
+					index entries */
+	row_merge_block_t*	block,	/*!< in/out: 3 buffers */
+	const ulint*		run_offset,/*!< in: first offset number of
+					each run in the input file */
+	ulint			n_half,	/*!< in: number of runs in the
+					first half of the input file */
+	ulint			n,	/*!< in: number of the output run */
+	merge_file_t*		of)	/*!< in/out: output file */
+{
+	ulint	foffs0;
+	ulint	foffs1;
+
+	if (n < n_half) {
+		foffs0 = run_offset[n];
+		foffs1 = run_offset[n_half + n];
+
+		return(row_merge_blocks(dup, file, block,
+					&foffs0, &foffs1, of));
+	}
+
+	foffs1 = run_offset[n_half + n];
+
+	if (!row_merge_blocks_copy(dup->index, file, block, &foffs1, of)) {
+		return(DB_CORRUPTION);
+	}
+
+	return(DB_SUCCESS);
+}
+
+/** Shared state of the threads merging the runs of one pass of row_merge()
+in parallel. Each thread takes the next output run and writes it at a
+precomputed offset of the output file, which leaves room for all the input
+blocks of the runs preceding it. */
+struct row_merge_pass_t {
+	trx_t*			trx;		/*!< transaction */
+	const row_merge_dup_t*	dup;		/*!< descriptor of index
+						being created */
+	const merge_file_t*	file;		/*!< input file */
+	const ulint*		run_offset;	/*!< first offset number of
+						each input run */
+	ulint			n_half;		/*!< number of runs in the
+						first half of the input */
+	int			fd;		/*!< output file handle */
+	const ulint*		out_offset;	/*!< first offset number of
+						each output run */
+	ulint			n_out;		/*!< number of output runs */
+	ulint			next;		/*!< next output run */
+	ib_uint64_t		n_rec;		/*!< number of records
+						written */
+	ulint			end;		/*!< end of the last output
+						run */
+	dberr_t			error;		/*!< first error, or
+						DB_SUCCESS */
+	ulint			n_running;	/*!< number of running
+						helper threads */
+	os_fast_mutex_t		mutex;		/*!< protects the fields
+						from next to n_running */
+	os_event_t		done;		/*!< set when the last
+						helper thread exits */
+};
+
+/*************************************************************//**
+Write output runs taken from a parallel merge pass until there are none
+left or one of the threads has failed. */
+static
+void
+row_merge_pass_runs(
+/*================*/
+	row_merge_pass_t*	ctx,	/*!< in/out: parallel merge pass */
+	row_merge_block_t*	block)	/*!< in/out: 3 buffers */
+{
+	for (;;) {
+		ulint		n;
+		merge_file_t	of;
+		dberr_t		error;
+
+		os_fast_mutex_lock(&ctx->mutex);
+		n = ctx->next++;
+		error = ctx->error;
+		os_fast_mutex_unlock(&ctx->mutex);
+
+		if (n >= ctx->n_out || error != DB_SUCCESS) {
+			break;
+		}
+
+		of.fd = ctx->fd;
+		of.offset = ctx->out_offset[n];
+		of.n_rec = 0;
+
+		if (trx_is_interrupted(ctx->trx)) {
+			error = DB_INTERRUPTED;
+		} else {
+			error = row_merge_run(ctx->dup, ctx->file, block,
+					      ctx->run_offset, ctx->n_half,
+					      n, &of);
+		}
+
+		ut_ad(error != DB_SUCCESS
+		      || n + 1 == ctx->n_out
+		      || of.offset <= ctx->out_offset[n + 1]);
+
+		os_fast_mutex_lock(&ctx->mutex);
+		if (error != DB_SUCCESS) {
+			if (ctx->error == DB_SUCCESS) {
+				ctx->error = error;
+			}
+		} else {
+			ctx->n_rec += of.n_rec;
+
+			if (n + 1 == ctx->n_out) {
+				ctx->end = of.offset;
+			}
+		}
+		os_fast_mutex_unlock(&ctx->mutex);
+	}
+}
+
+/*********************************************************************//**
+Helper thread of a parallel merge pass of row_merge().
+@return OS_THREAD_DUMMY_RETURN */
+extern "C" UNIV_INTERN
+os_thread_ret_t
+DECLARE_THREAD(row_merge_pass_thread)(
+/*==================================*/
+	void*	arg)	/*!< in: parallel merge pass */
+{
+	row_merge_pass_t*	ctx = static_cast<row_merge_pass_t*>(arg);
+	row_merge_block_t*	block;
+	ulint			block_size;
+
+	block_size = 3 * srv_sort_buf_size;
+	block = static_cast<row_merge_block_t*>(
+		os_mem_alloc_large(&block_size));
+
+	/* Leave the work to the other threads if we cannot get the
+	buffers */
+	if (block != NULL) {
+		row_merge_pass_runs(ctx, block);
+		os_mem_free_large(block, block_size);
+	}
+
+	os_fast_mutex_lock(&ctx->mutex);
+	if (--ctx->n_running == 0) {
+		os_event_set(ctx->done);
+	}
+	os_fast_mutex_unlock(&ctx->mutex);
+
+	os_thread_exit(NULL);
+
+	OS_THREAD_DUMMY_RETURN;
+}
+
+/*************************************************************//**
+Write the output runs of a merge pass in the calling thread and
+'n_threads' helper threads. The output of a run never takes more blocks
+than its input runs, so the output runs are written at the offsets of
+their input in the concatenated halves of the input file, and the output
+file may have holes between the runs.
+@return	DB_SUCCESS or error code */
+static __attribute__((nonnull))
+dberr_t
+row_merge_par(
+/*==========*/
+	trx_t*			trx,	/*!< in: transaction */
+	const row_merge_dup_t*	dup,	/*!< in: descriptor of
+					index being created */
+	const merge_file_t*	file,	/*!< in: file containing
+					index entries */
+	row_merge_block_t*	block,	/*!< in/out: 3 buffers */
+	ulint			num_run,/*!< in: number of input runs */
+	ulint*			run_offset,/*!< in/out: first offset
+					number of each input run on entry,
+					of each output run on exit */
+	merge_file_t*		of,	/*!< in/out: output file */
+	ulint			n_threads)/*!< in: number of helper
+					threads */
+{
+	row_merge_pass_t	ctx;
+	ulint*			out_offset;
+	os_thread_id_t		thd_id;
+	dberr_t			error;
+	ulint			offset;
+	ulint			n;
+
+	ctx.trx = trx;
+	ctx.dup = dup;
+	ctx.file = file;
+	ctx.run_offset = run_offset;
+	ctx.n_half = num_run / 2;
+	ctx.fd = of->fd;
+	ctx.n_out = num_run - ctx.n_half;
+	ctx.next = 0;
+	ctx.n_rec = 0;
+	ctx.end = 0;
+	ctx.error = DB_SUCCESS;
+	ctx.n_running = n_threads;
+
+	out_offset = static_cast<ulint*>(
+		mem_alloc(ctx.n_out * sizeof *out_offset));
+
+	for (n = 0, offset = 0; n < ctx.n_out; n++) {
+		ulint	run = ctx.n_half + n;
+
+		out_offset[n] = offset;
+
+		offset += (run + 1 < num_run
+			   ? run_offset[run + 1] : file->offset)
+			- run_offset[run];
+
+		if (n < ctx.n_half) {
+			offset += run_offset[n + 1] - run_offset[n];
+		}
+	}
+
+	ut_ad(offset <= file->offset);
+	ut_ad(n_threads > 0);
+
+	ctx.out_offset = out_offset;
+
+	os_fast_mutex_init(PFS_NOT_INSTRUMENTED, &ctx.mutex);
+	ctx.done = os_event_create();
+
+	for (n = 0; n < n_threads; n++) {
+		os_thread_create(row_merge_pass_thread, &ctx, &thd_id);
+	}
+
+	row_merge_pass_runs(&ctx, block);
+
+	os_event_wait(ctx.done);
+
+	os_event_free(ctx.done);
+	os_fast_mutex_free(&ctx.mutex);
+
+	error = ctx.error;
+
+	if (error == DB_SUCCESS) {
+		memcpy(run_offset, out_offset, ctx.n_out * sizeof *out_offset);
+		of->offset = ctx.end;
+		of->n_rec = ctx.n_rec;
+	}
+
+	mem_free(out_offset);
+
+	return(error);
+}
+
 /*************************************************************//**
 Merge disk files.
 @return	DB_SUCCESS or error code */
@@ -1983,100 +2252,85 @@ row_merge(
 	int*			tmpfd,	/*!< in/out: temporary file handle */
 	ulint*			num_run,/*!< in/out: Number of runs remain
 					to be merged */
-	ulint*			run_offset) /*!< in/out: Array contains the
+	ulint*			run_offset, /*!< in/out: Array contains the
 					first offset number for each merge
 					run */
+	ulint			n_threads) /*!< in: number of threads
+					to merge the runs in */
 {
-	ulint		foffs0;	/*!< first input offset */
-	ulint		foffs1;	/*!< second input offset */
 	dberr_t		error;	/*!< error code */
 	merge_file_t	of;	/*!< output file */
-	const ulint	ihalf	= run_offset[*num_run / 2];
-				/*!< half the input file */
-	ulint		n_run	= 0;
+	const ulint	n_half	= *num_run / 2;
+				/*!< runs in the first half of the input */
+	const ulint	n_out	= *num_run - n_half;
 				/*!< num of runs generated from this merge */
+	ulint		n;
 
 	UNIV_MEM_ASSERT_W(&block[0], 3 * srv_sort_buf_size);
 
-	ut_ad(ihalf < file->offset);
+	ut_ad(run_offset[n_half] < file->offset);
 
 	of.fd = *tmpfd;
 	of.offset = 0;
 	of.n_rec = 0;
 
-#ifdef POSIX_FADV_SEQUENTIAL
-	/* The input file will be read sequentially, starting from the
-	beginning and the middle.  In Linux, the POSIX_FADV_SEQUENTIAL
-	affects the entire file.  Each block will be read exactly once. */
-	posix_fadvise(file->fd, 0, 0,
-		      POSIX_FADV_SEQUENTIAL | POSIX_FADV_NOREUSE);
-#endif /* POSIX_FADV_SEQUENTIAL */
-
-	/* Merge blocks to the output file. */
-	foffs0 = 0;
-	foffs1 = ihalf;
+	/* The runs of the second half are merged with the runs at the
+	same position in the first half.  The second half has at most
+	one extra run, which is copied to the output file.  Reporting a
+	duplicate key writes to the shared MySQL table, so only one
+	thread may merge the runs of a unique index in that case. */
 
-	UNIV_MEM_INVALID(run_offset, *num_run * sizeof *run_offset);
+	if (n_threads > 1 && n_out > 1
+	    && (!dup->table || !dict_index_is_unique(dup->index))) {
 
-	for (; foffs0 < ihalf && foffs1 < file->offset; foffs0++, foffs1++) {
-
-		if (trx_is_interrupted(trx)) {
-			return(DB_INTERRUPTED);
-		}
-
-		/* Remember the offset number for this run */
-		run_offset[n_run++] = of.offset;
-
-		error = row_merge_blocks(dup, file, block,
-					 &foffs0, &foffs1, &of);
+		error = row_merge_par(trx, dup, file, block, *num_run,
+				      run_offset, &of,
+				      ut_min(n_threads, n_out) - 1);
 
 		if (error != DB_SUCCESS) {
 			return(error);
 		}
+	} else {
+#ifdef POSIX_FADV_SEQUENTIAL
+		/* The input file will be read sequentially, starting from
+		the beginning and the middle.  In Linux, the
+		POSIX_FADV_SEQUENTIAL affects the entire file.  Each block
+		will be read exactly once. */
+		posix_fadvise(file->fd, 0, 0,
+			      POSIX_FADV_SEQUENTIAL | POSIX_FADV_NOREUSE);
+#endif /* POSIX_FADV_SEQUENTIAL */
 
-	}
-
-	/* Copy the last blocks, if there are any. */
-
-	while (foffs0 < ihalf) {
-		if (UNIV_UNLIKELY(trx_is_interrupted(trx))) {
-			return(DB_INTERRUPTED);
-		}
+		/* Merge blocks to the output file.  Output run n reads
+		the input runs n and n_half + n, which are never before
+		the output run numbers that have already been
+		overwritten in run_offset[]. */
 
-		/* Remember the offset number for this run */
-		run_offset[n_run++] = of.offset;
+		for (n = 0; n < n_out; n++) {
+			ulint	offset = of.offset;
 
-		if (!row_merge_blocks_copy(dup->index, file, block,
-					   &foffs0, &of)) {
-			return(DB_CORRUPTION);
-		}
-	}
-
-	ut_ad(foffs0 == ihalf);
+			if (trx_is_interrupted(trx)) {
+				return(DB_INTERRUPTED);
+			}
 
-	while (foffs1 < file->offset) {
-		if (trx_is_interrupted(trx)) {
-			return(DB_INTERRUPTED);
-		}
+			error = row_merge_run(dup, file, block, run_offset,
+					      n_half, n, &of);
 
-		/* Remember the offset number for this run */
-		run_offset[n_run++] = of.offset;
+			if (error != DB_SUCCESS) {
+				return(error);
+			}
 
-		if (!row_merge_blocks_copy(dup->index, file, block,
-					   &foffs1, &of)) {
-			return(DB_CORRUPTION);
+			/* Remember the offset number for this run */
+			run_offset[n] = offset;
 		}
 	}
 
-	ut_ad(foffs1 == file->offset);
-
 	if (UNIV_UNLIKELY(of.n_rec != file->n_rec)) {
 		return(DB_CORRUPTION);
 	}
 
-	ut_ad(n_run <= *num_run);
+	ut_ad(n_out <= *num_run);
 
-	*num_run = n_run;
+	*num_run = n_out;
 
 	/* Each run can contain one or more offsets. As merge goes on,
 	the number of runs (to merge) will reduce until we have one
@@ -2110,11 +2364,13 @@ row_merge_sort(
 	merge_file_t*		file,	/*!< in/out: file containing
 					index entries */
 	row_merge_block_t*	block,	/*!< in/out: 3 buffers */
-	int*			tmpfd)	/*!< in/out: temporary file handle */
+	int*			tmpfd,	/*!< in/out: temporary file handle */
+	ulint			n_threads)/*!< in: number of threads to
+					merge the runs of a pass in */
 {
-	const ulint	half	= file->offset / 2;
 	ulint		num_runs;
 	ulint*		run_offset;
+	ulint		i;
 	dberr_t		error	= DB_SUCCESS;
 	DBUG_ENTER("row_merge_sort");
 
@@ -2129,9 +2385,11 @@ row_merge_sort(
 	/* "run_offset" records each run's first offset number */
 	run_offset = (ulint*) mem_alloc(file->offset * sizeof(ulint));
 
-	/* This tells row_merge() where to start for the first round
-	of merge. */
-	run_offset[half] = half;
+	/* Each block written by row_merge_read_clustered_index() is a
+	run of its own for the first round of merge. */
+	for (i = 0; i < num_runs; i++) {
+		run_offset[i] = i;
+	}
 
 	/* The file should always contain at least one byte (the end
 	of file marker).  Thus, it must be at least one block. */
@@ -2140,7 +2398,7 @@ row_merge_sort(
 	/* Merge the runs until we have one big run */
 	do {
 		error = row_merge(trx, dup, file, block, tmpfd,
-				  &num_runs, run_offset);
+				  &num_runs, run_offset, n_threads);
 
 		if (error != DB_SUCCESS) {
 			break;
@@ -2219,6 +2477,7 @@ row_merge_insert_index_tuples(
 	ulint			foffs = 0;
 	ulint*			offsets;
 	mrec_buf_t*		buf;
+	btr_bulk_t*		bulk	= NULL;
 	DBUG_ENTER("row_merge_insert_index_tuples");
 
 	ut_ad(!srv_read_only_mode);
@@ -2227,6 +2486,12 @@ row_merge_insert_index_tuples(
 
 	tuple_heap = mem_heap_create(1000);
 
+	/* Build the tree bottom-up from the sorted entries, unless the
+	pages are compressed. */
+	if (!dict_table_zip_size(index->table)) {
+		bulk = btr_bulk_create(index, trx_id);
+	}
+
 	{
 		ulint i	= 1 + REC_OFFS_HEADER_SIZE
 			+ dict_index_get_n_fields(index);
@@ -2309,6 +2574,35 @@ row_merge_insert_index_tuples(
 			}
 
 			ut_ad(dtuple_validate(dtuple));
+
+			if (bulk == NULL) {
+				/* Insert through the B-tree cursor. */
+			} else if (!n_ext && !page_zip_rec_needs_ext(
+					   rec_get_converted_size(
+						   index, dtuple, 0),
+					   dict_table_is_comp(index->table),
+					   dtuple_get_n_fields(dtuple), 0)) {
+
+				error = btr_bulk_insert(bulk, dtuple);
+
+				if (error != DB_SUCCESS) {
+					goto err_exit;
+				}
+
+				mem_heap_empty(tuple_heap);
+				continue;
+			} else {
+				/* The bulk loader does not store columns
+				off-page.  Complete the tree and insert
+				the rest of the entries one at a time. */
+				error = btr_bulk_finish(bulk, DB_SUCCESS);
+				bulk = NULL;
+
+				if (error != DB_SUCCESS) {
+					goto err_exit;
+				}
+			}
+
 			log_free_check();
 
 			mtr_start(&mtr);
@@ -2399,6 +2693,14 @@ row_merge_insert_index_tuples(
 	}
 
 err_exit:
+	if (bulk != NULL) {
+		dberr_t	err = btr_bulk_finish(bulk, error);
+
+		if (error == DB_SUCCESS) {
+			error = err;
+		}
+	}
+
 	mem_heap_free(tuple_heap);
 	mem_heap_free(ins_heap);
 	mem_heap_free(heap);
@@ -3344,6 +3646,202 @@ row_merge_drop_table(
 	return(row_drop_table_for_mysql(table->name, trx, false, false));
 }
 
+/** Shared state of threads sorting and inserting the indexes of a table in
+parallel, see row_merge_par_build(). Each thread takes the next unprocessed
+index until all of them are built. */
+struct row_merge_par_build_t {
+	trx_t*			trx;		/*!< transaction */
+	dict_table_t*		table;		/*!< table */
+	struct TABLE*		mysql_table;	/*!< MySQL table for
+						error reporting */
+	const ulint*		col_map;	/*!< column mapping, or NULL */
+	dict_index_t**		indexes;	/*!< indexes to build */
+	merge_file_t*		merge_files;	/*!< index entries of the
+						indexes */
+	ulint			n_indexes;	/*!< size of indexes[] */
+	dberr_t*		errors;		/*!< error per index */
+	ibool*			started;	/*!< TRUE for the indexes
+						taken by a thread */
+	ulint			n_running;	/*!< number of running
+						helper threads */
+	os_fast_mutex_t		mutex;		/*!< protects started and
+						n_running */
+	os_event_t		done;		/*!< set when the last
+						helper thread exits */
+};
+
+/*********************************************************************//**
+Sort and insert index entries for indexes taken from a parallel build
+context until there are none left. Reporting a duplicate key writes to the
+MySQL table, so the unique indexes are left to the calling thread of
+row_merge_par_build() when there is a table to report to. */
+static
+void
+row_merge_par_build_indexes(
+/*========================*/
+	row_merge_par_build_t*	ctx,	/*!< in/out: parallel build context */
+	row_merge_block_t*	block,	/*!< in/out: 3 buffers */
+	int*			tmpfd,	/*!< in/out: temporary file handle */
+	ibool			helper)	/*!< in: TRUE in helper threads */
+{
+	for (;;) {
+		ulint	i;
+		dberr_t	error;
+
+		os_fast_mutex_lock(&ctx->mutex);
+		for (i = 0; i < ctx->n_indexes; i++) {
+			if (!ctx->started[i]
+			    && (!helper || !ctx->mysql_table
+				|| !dict_index_is_unique(ctx->indexes[i]))) {
+
+				ctx->started[i] = TRUE;
+				break;
+			}
+		}
+		os_fast_mutex_unlock(&ctx->mutex);
+
+		if (i >= ctx->n_indexes) {
+			break;
+		}
+
+		row_merge_dup_t	dup = {
+			ctx->indexes[i], ctx->mysql_table, ctx->col_map, 0};
+
+		error = row_merge_sort(ctx->trx, &dup, &ctx->merge_files[i],
+				       block, tmpfd, 1);
+
+		if (error == DB_SUCCESS) {
+			error = row_merge_insert_index_tuples(
+				ctx->trx->id, ctx->indexes[i], ctx->table,
+				ctx->merge_files[i].fd, block);
+		}
+
+		/* Close the temporary file to free up space. */
+		row_merge_file_destroy(&ctx->merge_files[i]);
+
+		ctx->errors[i] = error;
+	}
+}
+
+/*********************************************************************//**
+Helper thread of row_merge_par_build().
+@return OS_THREAD_DUMMY_RETURN */
+extern "C" UNIV_INTERN
+os_thread_ret_t
+DECLARE_THREAD(row_merge_par_build_thread)(
+/*=======================================*/
+	void*	arg)	/*!< in: parallel build context */
+{
+	row_merge_par_build_t*	ctx = static_cast<row_merge_par_build_t*>(arg);
+	row_merge_block_t*	block;
+	ulint			block_size;
+	int			tmpfd;
+
+	block_size = 3 * srv_sort_buf_size;
+	block = static_cast<row_merge_block_t*>(
+		os_mem_alloc_large(&block_size));
+	tmpfd = row_merge_file_create_low();
+
+	/* Leave the work to the other threads if we cannot get the
+	buffers */
+	if (block != NULL && tmpfd >= 0) {
+		row_merge_par_build_indexes(ctx, block, &tmpfd, TRUE);
+	}
+
+	if (tmpfd >= 0) {
+		row_merge_file_destroy_low(tmpfd);
+	}
+	if (block != NULL) {
+		os_mem_free_large(block, block_size);
+	}
+
+	os_fast_mutex_lock(&ctx->mutex);
+	if (--ctx->n_running == 0) {
+		os_event_set(ctx->done);
+	}
+	os_fast_mutex_unlock(&ctx->mutex);
+
+	os_thread_exit(NULL);
+
+	OS_THREAD_DUMMY_RETURN;
+}
+
+/*********************************************************************//**
+Sort and insert the entries of indexes in the calling thread and 'n_threads'
+helper threads, each building whole indexes. Used when the indexes are built
+offline and there are no full-text indexes, as when XtraBackup rebuilds the
+indexes of compact backups.
+@return	DB_SUCCESS or error code */
+static
+dberr_t
+row_merge_par_build(
+/*================*/
+	trx_t*			trx,		/*!< in: transaction */
+	dict_table_t*		table,		/*!< in: table */
+	dict_index_t**		indexes,	/*!< in: indexes to build */
+	const ulint*		key_numbers,	/*!< in: MySQL key numbers */
+	ulint			n_indexes,	/*!< in: size of indexes[] */
+	merge_file_t*		merge_files,	/*!< in/out: index entries */
+	struct TABLE*		mysql_table,	/*!< in/out: MySQL table, for
+						reporting erroneous key
+						value if applicable */
+	const ulint*		col_map,	/*!< in: column mapping, or
+						NULL */
+	row_merge_block_t*	block,		/*!< in/out: 3 buffers */
+	int*			tmpfd,		/*!< in/out: temporary file
+						handle */
+	ulint			n_threads)	/*!< in: number of helper
+						threads */
+{
+	row_merge_par_build_t	ctx;
+	os_thread_id_t		thd_id;
+	dberr_t			error = DB_SUCCESS;
+	ulint			i;
+
+	ctx.trx = trx;
+	ctx.table = table;
+	ctx.mysql_table = mysql_table;
+	ctx.col_map = col_map;
+	ctx.indexes = indexes;
+	ctx.merge_files = merge_files;
+	ctx.n_indexes = n_indexes;
+	ctx.errors = static_cast<dberr_t*>(
+		mem_alloc(n_indexes * sizeof *ctx.errors));
+	ctx.started = static_cast<ibool*>(
+		mem_alloc(n_indexes * sizeof *ctx.started));
+	ctx.n_running = n_threads;
+	os_fast_mutex_init(PFS_NOT_INSTRUMENTED, &ctx.mutex);
+	ctx.done = os_event_create();
+
+	for (i = 0; i < n_indexes; i++) {
+		ctx.errors[i] = DB_SUCCESS;
+		ctx.started[i] = FALSE;
+	}
+
+	for (i = 0; i < n_threads; i++) {
+		os_thread_create(row_merge_par_build_thread, &ctx, &thd_id);
+	}
+
+	row_merge_par_build_indexes(&ctx, block, tmpfd, FALSE);
+
+	os_event_wait(ctx.done);
+
+	for (i = 0; i < n_indexes; i++) {
+		if (ctx.errors[i] != DB_SUCCESS) {
+			error = ctx.errors[i];
+			trx->error_key_num = key_numbers[i];
+			break;
+		}
+	}
+
+	os_event_free(ctx.done);
+	os_fast_mutex_free(&ctx.mutex);
+	mem_free(ctx.started);
+	mem_free(ctx.errors);
+
+	return(error);
+}
+
 /*********************************************************************//**
 Build indexes on a table by reading a clustered index,
 creating a temporary file containing index entries, merge sorting
@@ -3475,6 +3973,39 @@ row_merge_build_indexes(
 
 	DEBUG_SYNC_C("row_merge_after_scan");
 
+	/* Sort and insert the indexes of an offline build in parallel.
+	XtraBackup uses the index rebuild threads that have run out of
+	tables when rebuilding indexes of a compact backup.  The indexes
+	of an online build are built one at a time, because the online
+	log of each index is applied right after it has been built. */
+	if (!online && n_indexes > 1 && !fts_sort_idx) {
+		ulint	n_threads;
+
+		if (!srv_rebuild_indexes) {
+			n_threads = ut_min(srv_merge_sort_threads,
+					   n_indexes) - 1;
+		} else if ((n_threads = xb_rebuild_threads_reserve(
+				    n_indexes - 1)) > 0) {
+			ib_logf(IB_LOG_LEVEL_INFO,
+				"Building %lu indexes of table %s in %lu"
+				" threads", n_indexes, old_table->name,
+				n_threads + 1);
+		}
+
+		if (n_threads > 0) {
+			error = row_merge_par_build(
+				trx, old_table, indexes, key_numbers,
+				n_indexes, merge_files, table, col_map, block,
+				&tmpfd, n_threads);
+
+			if (srv_rebuild_indexes) {
+				xb_rebuild_threads_release(n_threads);
+			}
+
+			goto func_exit;
+		}
+	}
+
 	/* Now we have files containing index entries ready for
 	sorting and inserting. */
 
@@ -3553,7 +4084,7 @@ wait_again:
 
 			error = row_merge_sort(
 				trx, &dup, &merge_files[i],
-				block, &tmpfd);
+				block, &tmpfd, srv_merge_sort_threads);
 
 			if (error == DB_SUCCESS) {
 				error = row_merge_insert_index_tuples(
@@ -52,7 +52,7 @@ index record.
 @return 0 if committed, else the active transaction id;
 NOTE that this function can return false positives but never false
 negatives. The caller must confirm all positive results by calling
-trx_is_active() while holding lock_sys->mutex. */
+trx_is_active() while holding lock_sys->latch. */
 UNIV_INLINE
 trx_id_t
 row_vers_impl_x_locked_low(
@@ -187,7 +187,7 @@ row_vers_impl_x_locked_low(
 		if (!trx_rw_is_active(trx_id, &corrupt)) {
 			/* Transaction no longer active: no implicit
 			x-lock. This situation should only be possible
-			because we are not holding lock_sys->mutex. */
+			because we are not holding lock_sys->latch. */
 			ut_ad(!lock_mutex_own());
 			if (corrupt) {
 				lock_report_trx_id_insanity(
@@ -247,7 +247,7 @@ index record.
 @return 0 if committed, else the active transaction id;
 NOTE that this function can return false positives but never false
 negatives. The caller must confirm all positive results by calling
-trx_is_active() while holding lock_sys->mutex. */
+trx_is_active() while holding lock_sys->latch. */
 UNIV_INTERN
 trx_id_t
 row_vers_impl_x_locked(
@@ -136,6 +136,12 @@ on duplicate key checking and foreign key checking */
 UNIV_INTERN ibool	srv_locks_unsafe_for_binlog = FALSE;
 /** Sort buffer size in index creation */
 UNIV_INTERN ulong	srv_sort_buf_size = 1048576;
+/** Number of threads merging the sorted runs of an index, and building
+the indexes concurrently, in index creation */
+UNIV_INTERN ulong	srv_merge_sort_threads = 1;
+/** Percentage of each page filled with records when loading a new index
+in index creation */
+UNIV_INTERN ulong	srv_fill_factor = 100;
 /** Maximum modification log file size for online index creation */
 UNIV_INTERN unsigned long long	srv_online_max_size;
 
@@ -295,6 +301,10 @@ UNIV_INTERN ulong	srv_n_purge_threads = 1;
 /* the number of pages to purge in one batch */
 UNIV_INTERN ulong	srv_purge_batch_size = 20;
 
+/* The number of page_cleaner threads to use, including the coordinator.
+It is capped by the number of buffer pool instances at startup. */
+UNIV_INTERN ulong	srv_n_page_cleaners = 1;
+
 /* Internal setting for "innodb_stats_method". Decides how InnoDB treats
 NULL value when collecting statistics. By default, it is set to
 SRV_STATS_NULLS_EQUAL(0), ie. all NULL value are treated equal */
@@ -353,6 +363,11 @@ batch flushing i.e.: LRU flushing and flush_list flushing. The rest
 of the pages are used for single page flushing. */
 UNIV_INTERN ulong	srv_doublewrite_batch_size	= 120;
 
+/** Name prefix of the parallel doublewrite files. The batch flushes of each
+buffer pool instance are doublewritten to a file of their own instead of
+the doublewrite buffer in the system tablespace. NULL or empty to disable. */
+UNIV_INTERN char*	srv_parallel_doublewrite_path	= NULL;
+
 UNIV_INTERN ulong	srv_replication_delay		= 0;
 
 UNIV_INTERN ibool	srv_apply_log_only	= FALSE;
@@ -611,6 +626,10 @@ and/or load it during startup. */
 UNIV_INTERN char	srv_buffer_pool_dump_at_shutdown = FALSE;
 UNIV_INTERN char	srv_buffer_pool_load_at_startup = FALSE;
 
+/** Whether the buffer pool load reads at most innodb_io_capacity pages
+per second rather than as fast as possible */
+UNIV_INTERN char	srv_buffer_pool_load_throttle = FALSE;
+
 /** Slot index in the srv_sys->sys_threads array for the purge thread. */
 static const ulint	SRV_PURGE_SLOT	= 1;
 
@@ -1132,6 +1151,7 @@ srv_printf_innodb_monitor(
 	time_t	current_time;
 	ulint	n_reserved;
 	ibool	ret;
+	ulint	i;
 
 	mutex_enter(&srv_innodb_monitor_mutex);
 
@@ -1223,7 +1243,9 @@ srv_printf_innodb_monitor(
 	      "-------------------------------------\n", file);
 	ibuf_print(file);
 
-	ha_print_info(file, btr_search_sys->hash_index);
+	for (i = 0; i < btr_ahi_parts; i++) {
+		ha_print_info(file, btr_search_sys->hash_tables[i]);
+	}
 
 	fprintf(file,
 		"%.2f hash searches/s, %.2f non-hash searches/s\n",
@@ -1554,7 +1576,7 @@ loop:
 		if (srv_print_innodb_monitor) {
 			/* Reset mutex_skipped counter everytime
 			srv_print_innodb_monitor changes. This is to
-			ensure we will not be blocked by lock_sys->mutex
+			ensure we will not be blocked by lock_sys->latch
 			for short duration information printing,
 			such as requested by sync_array_print_long_waits() */
 			if (!last_srv_print_monitor) {
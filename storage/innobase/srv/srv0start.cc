@@ -1766,8 +1766,12 @@ innobase_start_or_create_for_mysql(void)
 	srv_boot();
 
 	ib_logf(IB_LOG_LEVEL_INFO,
-		"%s CPU crc32 instructions",
-		ut_crc32_sse2_enabled ? "Using" : "Not using");
+		"%s CPU crc32 instructions%s",
+		ut_crc32_sse2_enabled ? "Using" : "Not using",
+		ut_crc32_vpclmul_enabled
+		? " with AVX-512 VPCLMULQDQ folding"
+		: ut_crc32_pclmul_enabled
+		? " with PCLMULQDQ folding" : "");
 
 	if (!srv_read_only_mode) {
 
@@ -2664,6 +2668,12 @@ files_checked:
 	}
 
 	if (!srv_read_only_mode) {
+		/* Each page_cleaner thread flushes one buffer pool instance
+		at a time, more threads would have nothing to do. */
+		if (srv_n_page_cleaners > srv_buf_pool_instances) {
+			srv_n_page_cleaners = srv_buf_pool_instances;
+		}
+
 		os_thread_create(buf_flush_page_cleaner_thread, NULL, NULL);
 	}
 
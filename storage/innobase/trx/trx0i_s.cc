@@ -174,7 +174,7 @@ struct trx_i_s_cache_t {
 	ha_storage_t*	storage;	/*!< storage for external volatile
 					data that may become unavailable
 					when we release
-					lock_sys->mutex or trx_sys->mutex */
+					lock_sys->latch or trx_sys->mutex */
 	ulint		mem_allocd;	/*!< the amount of memory
 					allocated with mem_alloc*() */
 	ibool		is_truncated;	/*!< this is TRUE if the memory
@@ -556,9 +556,9 @@ thd_done:
 
 	row->trx_tables_locked = trx->mysql_n_tables_locked;
 
-	/* These are protected by both trx->mutex or lock_sys->mutex,
-	or just lock_sys->mutex. For reading, it suffices to hold
-	lock_sys->mutex. */
+	/* These are protected by both trx->mutex or lock_sys->latch,
+	or just lock_sys->latch. For reading, it suffices to hold
+	lock_sys->latch. */
 
 	row->trx_lock_structs = UT_LIST_GET_LEN(trx->lock.trx_locks);
 
@@ -608,7 +608,7 @@ thd_done:
 		row->trx_foreign_key_error = NULL;
 	}
 
-	row->trx_has_search_latch = (ibool) trx->has_search_latch;
+	row->trx_has_search_latch = trx->has_search_latch != NULL;
 
 	row->trx_search_latch_timeout = trx->search_latch_timeout;
 
@@ -592,6 +592,10 @@ trx_sys_create(void)
 	trx_sys = static_cast<trx_sys_t*>(mem_zalloc(sizeof(*trx_sys)));
 
 	mutex_create(trx_sys_mutex_key, &trx_sys->mutex, SYNC_TRX_SYS);
+
+	trx_sys->descr_n_max = TRX_DESCR_ARRAY_INITIAL_SIZE;
+	trx_sys->descriptors = static_cast<trx_id_t*>(
+		ut_malloc(trx_sys->descr_n_max * sizeof(trx_id_t)));
 }
 
 /*****************************************************************//**
@@ -1239,6 +1243,8 @@ trx_sys_close(void)
 
 	mutex_free(&trx_sys->mutex);
 
+	ut_free(trx_sys->descriptors);
+
 	mem_free(trx_sys);
 
 	trx_sys = NULL;
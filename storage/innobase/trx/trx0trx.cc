@@ -289,6 +289,91 @@ trx_free_for_background(
 	trx_free(trx);
 }
 
+/********************************************************************//**
+Adds the id of a read-write transaction to trx_sys->descriptors, so that
+read views created from now on treat it as active. Transaction ids are
+assigned in ascending order, so outside of startup the id is appended. */
+static
+void
+trx_reserve_descriptor(
+/*===================*/
+	const trx_t*	trx)	/*!< in: read-write transaction */
+{
+	ulint		i;
+	trx_id_t*	descr;
+
+	ut_ad(mutex_own(&trx_sys->mutex));
+	ut_ad(!trx->read_only);
+
+	if (trx_sys->descr_n_used == trx_sys->descr_n_max) {
+
+		trx_sys->descr_n_max *= 2;
+
+		trx_sys->descriptors = static_cast<trx_id_t*>(
+			ut_realloc(trx_sys->descriptors,
+				   trx_sys->descr_n_max * sizeof(trx_id_t)));
+	}
+
+	descr = trx_sys->descriptors;
+
+	for (i = trx_sys->descr_n_used; i > 0 && descr[i - 1] > trx->id; --i) {
+		/* No op */
+	}
+
+	ut_ad(i == 0 || descr[i - 1] < trx->id);
+
+	memmove(descr + i + 1, descr + i,
+		(trx_sys->descr_n_used - i) * sizeof(*descr));
+
+	descr[i] = trx->id;
+
+	++trx_sys->descr_n_used;
+}
+
+/********************************************************************//**
+Removes a read-write transaction from trx_sys->descriptors and from
+trx_sys->serialisation_list. The transaction need not be on either. */
+UNIV_INTERN
+void
+trx_release_descriptor(
+/*===================*/
+	trx_t*	trx)	/*!< in: read-write transaction */
+{
+	ulint		lower;
+	ulint		upper;
+	trx_id_t*	descr;
+
+	ut_ad(mutex_own(&trx_sys->mutex));
+
+	if (trx->in_serialisation_list) {
+		UT_LIST_REMOVE(no_list, trx_sys->serialisation_list, trx);
+		trx->in_serialisation_list = FALSE;
+	}
+
+	descr = trx_sys->descriptors;
+	lower = 0;
+	upper = trx_sys->descr_n_used;
+
+	while (lower < upper) {
+		ulint	mid = (lower + upper) >> 1;
+
+		if (descr[mid] == trx->id) {
+
+			memmove(descr + mid, descr + mid + 1,
+				(trx_sys->descr_n_used - mid - 1)
+				* sizeof(*descr));
+
+			--trx_sys->descr_n_used;
+
+			return;
+		} else if (descr[mid] < trx->id) {
+			lower = mid + 1;
+		} else {
+			upper = mid;
+		}
+	}
+}
+
 /********************************************************************//**
 At shutdown, frees a transaction object that is in the PREPARED state. */
 UNIV_INTERN
@@ -311,6 +396,8 @@ trx_free_prepared(
 	UT_LIST_REMOVE(trx_list, trx_sys->rw_trx_list, trx);
 	ut_d(trx->in_rw_trx_list = FALSE);
 
+	trx_release_descriptor(trx);
+
 	/* Undo trx_resurrect_table_locks(). */
 	UT_LIST_INIT(trx->lock.trx_locks);
 
@@ -720,6 +807,32 @@ trx_lists_init_at_db_start(void)
 			trx_resurrect_table_locks(trx, undo);
 		}
 	}
+
+	/* Now that the state of every resurrected transaction is known,
+	build the array of active transaction ids for read views, and the
+	list of prepared transactions, whose dummy trx->no equals their id,
+	for the purge view. rw_trx_list is sorted on id, biggest first. */
+
+	mutex_enter(&trx_sys->mutex);
+
+	for (trx_t* trx = UT_LIST_GET_LAST(trx_sys->rw_trx_list);
+	     trx != NULL;
+	     trx = UT_LIST_GET_PREV(trx_list, trx)) {
+
+		if (trx_state_eq(trx, TRX_STATE_COMMITTED_IN_MEMORY)) {
+			continue;
+		}
+
+		trx_reserve_descriptor(trx);
+
+		if (trx->no != TRX_ID_MAX) {
+			UT_LIST_ADD_LAST(
+				no_list, trx_sys->serialisation_list, trx);
+			trx->in_serialisation_list = TRUE;
+		}
+	}
+
+	mutex_exit(&trx_sys->mutex);
 }
 
 /******************************************************************//**
@@ -865,6 +978,8 @@ trx_start_low(
 		UT_LIST_ADD_FIRST(trx_list, trx_sys->rw_trx_list, trx);
 		ut_d(trx->in_rw_trx_list = TRUE);
 		ut_d(trx_sys->rw_max_trx_id = trx->id);
+
+		trx_reserve_descriptor(trx);
 	}
 
 	ut_ad(trx_sys_validate_trx_list());
@@ -894,6 +1009,16 @@ trx_serialisation_number_get(
 
 	trx->no = trx_sys_get_new_trx_id();
 
+	/* The new number is the biggest one assigned so far. A recovered
+	prepared transaction is already on the list with its dummy number. */
+
+	if (trx->in_serialisation_list) {
+		UT_LIST_REMOVE(no_list, trx_sys->serialisation_list, trx);
+	}
+
+	UT_LIST_ADD_LAST(no_list, trx_sys->serialisation_list, trx);
+	trx->in_serialisation_list = TRUE;
+
 	/* If the rollack segment is not empty then the
 	new trx_t::no can't be less than any trx_t::no
 	already in the rollback segment. User threads only
@@ -1155,8 +1280,12 @@ trx_commit_in_memory(
 	} else {
 		lock_trx_release_locks(trx);
 
+		DEBUG_SYNC_C("trx_commit_in_memory_after_release_locks");
+
 		/* Remove the transaction from the list of active
-		transactions now that it no longer holds any user locks. */
+		transactions now that it no longer holds any user locks.
+		lock_trx_release_locks() has already removed it from
+		trx_sys->descriptors. */
 
 		ut_ad(trx_state_eq(trx, TRX_STATE_COMMITTED_IN_MEMORY));
 
@@ -1408,6 +1537,8 @@ trx_cleanup_at_db_startup(
 	assert_trx_in_rw_list(trx);
 	ut_d(trx->in_rw_trx_list = FALSE);
 
+	trx_release_descriptor(trx);
+
 	mutex_exit(&trx_sys->mutex);
 
 	/* Change the transaction state without mutex protection, now
@@ -1782,7 +1913,7 @@ state_ok:
 
 /**********************************************************************//**
 Prints info about a transaction.
-The caller must hold lock_sys->mutex and trx_sys->mutex.
+The caller must hold lock_sys->latch and trx_sys->mutex.
 When possible, use trx_print() instead. */
 UNIV_INTERN
 void
@@ -1804,7 +1935,7 @@ trx_print_latched(
 
 /**********************************************************************//**
 Prints info about a transaction.
-Acquires and releases lock_sys->mutex and trx_sys->mutex. */
+Acquires and releases lock_sys->latch and trx_sys->mutex. */
 UNIV_INTERN
 void
 trx_print(
@@ -1850,7 +1981,7 @@ trx_assert_started(
 	/* trx->state can change from or to NOT_STARTED while we are holding
 	trx_sys->mutex for non-locking autocommit selects but not for other
 	types of transactions. It may change from ACTIVE to PREPARED. Unless
-	we are holding lock_sys->mutex, it may also change to COMMITTED. */
+	we are holding lock_sys->latch, it may also change to COMMITTED. */
 
 	switch (trx->state) {
 	case TRX_STATE_PREPARED:
@@ -2096,7 +2227,7 @@ This function is used to find one X/Open XA distributed transaction
 which is in the prepared state
 @return	trx on match, the trx->xid will be invalidated;
 note that the trx may have been committed, unless the caller is
-holding lock_sys->mutex */
+holding lock_sys->latch */
 static __attribute__((nonnull, warn_unused_result))
 trx_t*
 trx_get_trx_by_xid_low(
@@ -2142,7 +2273,7 @@ This function is used to find one X/Open XA distributed transaction
 which is in the prepared state
 @return	trx or NULL; on match, the trx->xid will be invalidated;
 note that the trx may have been committed, unless the caller is
-holding lock_sys->mutex */
+holding lock_sys->latch */
 UNIV_INTERN
 trx_t*
 trx_get_trx_by_xid(
@@ -0,0 +1,192 @@
+/*****************************************************************************
+
+Copyright (c) 2014, Percona Inc. All Rights Reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Suite 500, Boston, MA 02110-1335 USA
+
+*****************************************************************************/
+
+/********************************************************************//**
+@file unittest/ut0crc32-t.cc
+Checks that all the implementations of ut_crc32() that the CPU supports
+compute the same CRC32 as the slice-by-8 implementation, and reports their
+throughput. Set MYTAP_CONFIG=big for a meaningful benchmark.
+*************************************************************************/
+
+#include "../ut/ut0crc32.cc"
+
+#include <my_sys.h>
+#include <my_rdtsc.h>
+#include <tap.h>
+
+#include <stdlib.h>
+
+/** Length of the buffer to check, in bytes */
+#define BUF_LEN		(64 * 1024)
+
+/** Length of the buffer to benchmark, in bytes */
+#define BENCH_LEN	UNIV_PAGE_SIZE_DEF
+
+/* The implementations are compiled in with ut0crc32.cc, which calls
+ut_dbg_assertion_failed() on failed assertions. */
+UNIV_INTERN
+void
+ut_dbg_assertion_failed(
+/*====================*/
+	const char*	expr,	/*!< in: the failed assertion */
+	const char*	file,	/*!< in: source file containing the assertion */
+	ulint		line)	/*!< in: line number of the assertion */
+{
+	diag("Assertion failure in file %s line %lu: %s",
+	     file, line, expr ? expr : "");
+	abort();
+}
+
+/** An implementation of ut_crc32() */
+struct crc32_impl_t {
+	const char*	name;	/*!< name of the implementation */
+	ib_ut_crc32_t	func;	/*!< the implementation */
+	bool		enabled;/*!< whether the CPU supports it */
+};
+
+/********************************************************************//**
+Checks an implementation against ut_crc32_slice8() for all the lengths up
+to a few chunks and a few longer lengths, at all the alignments.
+@return true if all the CRC32 are equal */
+static
+bool
+check_impl(
+/*=======*/
+	const crc32_impl_t*	impl,	/*!< in: implementation */
+	const byte*		buf)	/*!< in: random data */
+{
+	static const ulint	long_lens[] = {
+		4096, 8192, 3 * 8192 + 5, 16384, 16384 + 255, BUF_LEN - 8
+	};
+
+	for (ulint offset = 0; offset < 8; offset++) {
+		for (ulint len = 0; len <= 4 * 3 * UT_CRC32_LONG; len++) {
+			if (impl->func(buf + offset, len)
+			    != ut_crc32_slice8(buf + offset, len)) {
+				diag("%s: offset %lu length %lu",
+				     impl->name, offset, len);
+				return(false);
+			}
+		}
+
+		for (ulint i = 0; i < UT_ARR_SIZE(long_lens); i++) {
+			ulint	len = long_lens[i];
+
+			if (impl->func(buf + offset, len)
+			    != ut_crc32_slice8(buf + offset, len)) {
+				diag("%s: offset %lu length %lu",
+				     impl->name, offset, len);
+				return(false);
+			}
+		}
+	}
+
+	return(true);
+}
+
+/********************************************************************//**
+Reports the throughput of an implementation. */
+static
+void
+bench_impl(
+/*=======*/
+	const crc32_impl_t*	impl,	/*!< in: implementation */
+	const byte*		buf,	/*!< in: random data */
+	ulint			n)	/*!< in: number of iterations */
+{
+	ulonglong	start;
+	ulonglong	ns;
+	ib_uint32_t	crc = 0;
+
+	start = my_timer_nanoseconds();
+
+	for (ulint i = 0; i < n; i++) {
+		crc += impl->func(buf, BENCH_LEN);
+	}
+
+	ns = my_timer_nanoseconds() - start;
+
+	diag("%-8s %8.2f GB/s (%lu x %lu bytes, %08x)",
+	     impl->name, ns ? (double) n * BENCH_LEN / ns : 0.0,
+	     n, (ulint) BENCH_LEN, (unsigned) crc);
+}
+
+int main(int, char**)
+{
+	byte*		buf;
+	crc32_impl_t	impls[] = {
+		{"slice8", ut_crc32_slice8, true},
+		{"sse42", ut_crc32_sse42, false},
+#ifdef UT_CRC32_PCLMUL
+		{"pclmul", ut_crc32_pclmul, false},
+# ifdef UT_CRC32_VPCLMUL
+		{"vpclmul", ut_crc32_vpclmul, false},
+# endif /* UT_CRC32_VPCLMUL */
+#endif /* UT_CRC32_PCLMUL */
+		{"ut_crc32", NULL, true}
+	};
+	const ulint	n_impls = UT_ARR_SIZE(impls);
+
+	MY_INIT("ut0crc32-t");
+	plan(n_impls + 1);
+
+	ut_crc32_init();
+	ut_crc32_slice8_table_init();
+
+	impls[1].enabled = ut_crc32_sse2_enabled;
+#ifdef UT_CRC32_PCLMUL
+	impls[2].enabled = ut_crc32_pclmul_enabled;
+# ifdef UT_CRC32_VPCLMUL
+	impls[3].enabled = ut_crc32_vpclmul_enabled;
+# endif /* UT_CRC32_VPCLMUL */
+#endif /* UT_CRC32_PCLMUL */
+	impls[n_impls - 1].func = ut_crc32;
+
+	ok(ut_crc32_slice8(reinterpret_cast<const byte*>("123456789"), 9)
+	   == 0xe3069283, "CRC-32C check value");
+
+	buf = static_cast<byte*>(malloc(BUF_LEN + 8));
+
+	srand(1);
+
+	for (ulint i = 0; i < BUF_LEN + 8; i++) {
+		buf[i] = (byte) rand();
+	}
+
+	for (ulint i = 0; i < n_impls; i++) {
+		if (!impls[i].enabled) {
+			skip(1, "%s is not supported by the CPU",
+			     impls[i].name);
+			continue;
+		}
+
+		ok(check_impl(&impls[i], buf), "%s", impls[i].name);
+	}
+
+	for (ulint i = 0; i < n_impls; i++) {
+		if (impls[i].enabled) {
+			bench_impl(&impls[i], buf,
+				   skip_big_tests ? 1000 : 1000000);
+		}
+	}
+
+	free(buf);
+	my_end(0);
+
+	return(exit_status());
+}
@@ -84,6 +84,20 @@ mysys/my_perf.c, contributed by Facebook under the following license.
 
 #include <string.h>
 
+/* The three-stream and the folding implementations below are written with
+compiler intrinsics, which need the target function attribute of
+GCC 4.9 or clang. */
+#if defined(__GNUC__) && defined(__x86_64__) \
+	&& (defined(__clang__) || __GNUC__ > 4 \
+	    || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+# define UT_CRC32_PCLMUL
+# include <immintrin.h>
+# if (defined(__clang__) && __clang_major__ >= 6) \
+	|| (!defined(__clang__) && __GNUC__ >= 8)
+#  define UT_CRC32_VPCLMUL
+# endif
+#endif
+
 ib_ut_crc32_t	ut_crc32;
 
 /* Precalculated table used to generate the CRC32 if the CPU does not
@@ -94,6 +108,14 @@ static ibool		ut_crc32_slice8_table_initialized = FALSE;
 /* Flag that tells whether the CPU supports CRC32 or not */
 UNIV_INTERN bool	ut_crc32_sse2_enabled = false;
 
+/* Flag that tells whether the CRC32 of three interleaved streams is
+combined with PCLMULQDQ */
+UNIV_INTERN bool	ut_crc32_pclmul_enabled = false;
+
+/* Flag that tells whether long buffers are folded with AVX-512
+VPCLMULQDQ */
+UNIV_INTERN bool	ut_crc32_vpclmul_enabled = false;
+
 /********************************************************************//**
 Initializes the table that is used to generate the CRC32 if the CPU does
 not have support for it. */
@@ -159,6 +181,46 @@ ut_cpuid(
 	}
 }
 
+# ifdef UT_CRC32_VPCLMUL
+/********************************************************************//**
+Fetches the structured extended CPU features and checks that the operating
+system saves the AVX-512 register state.
+@return true if the AVX-512 registers may be used */
+static
+bool
+ut_cpuid_ext(
+/*=========*/
+	ib_uint32_t	features_ecx,	/*!< in: CPU features ecx */
+	ib_uint32_t*	ext_ebx,	/*!< out: extended features ebx */
+	ib_uint32_t*	ext_ecx)	/*!< out: extended features ecx */
+{
+	ib_uint32_t	max_leaf;
+	ib_uint32_t	xcr0;
+
+	*ext_ebx = *ext_ecx = 0;
+
+	asm("cpuid" : "=a" (max_leaf) : "a" (0) : "ebx", "ecx", "edx");
+
+	if (max_leaf < 7) {
+		return(false);
+	}
+
+	asm("cpuid" : "=b" (*ext_ebx), "=c" (*ext_ecx)
+	    : "a" (7), "c" (0)
+	    : "edx");
+
+	/* OSXSAVE */
+	if (!((features_ecx >> 27) & 1)) {
+		return(false);
+	}
+
+	asm("xgetbv" : "=a" (xcr0) : "c" (0) : "edx");
+
+	/* SSE, AVX, opmask and the upper halves of ZMM0-15 and ZMM16-31 */
+	return((xcr0 & 0xE6) == 0xE6);
+}
+# endif /* UT_CRC32_VPCLMUL */
+
 /* opcodes taken from objdump of "crc32b (%%rdx), %%rcx"
 for RHEL4 support (GCC 3 doesn't support this instruction) */
 #define ut_crc32_sse42_byte \
@@ -268,6 +330,291 @@ ut_crc32_slice8(
 	return((ib_uint32_t) ((~crc) & 0xFFFFFFFF));
 }
 
+#ifdef UT_CRC32_PCLMUL
+/* The CRC32 instruction has a latency of 3 cycles and a throughput of one
+per cycle, so ut_crc32_sse42() waits for each quadword. ut_crc32_pclmul()
+computes the CRC32 of three adjacent blocks of a chunk independently, and
+combines them by multiplying the CRC32 of the first two blocks with the
+constant x^(8*n) mod P, n being the distance in bytes to the end of the
+chunk, with PCLMULQDQ, and reducing the product with a CRC32 instruction.
+
+The constants for a 32-bit CRC register c in the bit-reflected order are
+derived as follows: PCLMULQDQ of two reflected values a and b returns
+x*a*b, and CRC32 of a quadword d with an empty register returns
+d*x^32 mod P. Thus shifting c by n bytes, that is, c*x^(8*n) mod P, is
+CRC32(PCLMULQDQ(c, x^(8*n-33) mod P)). The same identity folds 16 bytes
+forward by n bytes in ut_crc32_vpclmul(): the first quadword is multiplied
+by x^(8*n+31) mod P and the second one by x^(8*n-33) mod P. */
+
+/** Length of a block of the long chunks, in bytes */
+#define UT_CRC32_LONG	1024
+/** Length of a block of the short chunks, in bytes */
+#define UT_CRC32_SHORT	128
+
+/* Constants for combining the blocks of the long and the short chunks:
+{x^(8*2*n-33) mod P, x^(8*n-33) mod P} */
+static ib_uint64_t	ut_crc32_pclmul_long[2];
+static ib_uint64_t	ut_crc32_pclmul_short[2];
+
+/********************************************************************//**
+Computes x^n mod P, P being the CRC-32C polynomial.
+@return x^n mod P in the bit-reflected order */
+static
+ib_uint32_t
+ut_crc32_xpow(
+/*==========*/
+	ulint	n)	/*!< in: exponent */
+{
+	/* bit-reversed poly 0x1EDC6F41, as in ut_crc32_slice8_table_init() */
+	static const ib_uint32_t	poly = 0x82f63b78;
+	/* x^0 */
+	ib_uint32_t			c = 0x80000000;
+
+	while (n--) {
+		c = (c & 1) ? (poly ^ (c >> 1)) : (c >> 1);
+	}
+
+	return(c);
+}
+
+/********************************************************************//**
+Computes the CRC32 of a chunk of three adjacent blocks.
+@return CRC32 register after the chunk */
+static inline __attribute__((target("sse4.2,pclmul"), always_inline))
+ib_uint64_t
+ut_crc32_pclmul_chunk(
+/*==================*/
+	ib_uint64_t		crc0,	/*!< in: CRC32 register */
+	const ib_uint64_t*	buf,	/*!< in: chunk, aligned to 8 bytes */
+	ulint			n,	/*!< in: block length in quadwords */
+	const ib_uint64_t*	k)	/*!< in: constants for n */
+{
+	ib_uint64_t	crc1 = 0;
+	ib_uint64_t	crc2 = 0;
+	__m128i		kk;
+	__m128i		t;
+
+	for (ulint i = 0; i < n; i++) {
+		crc0 = _mm_crc32_u64(crc0, buf[i]);
+		crc1 = _mm_crc32_u64(crc1, buf[n + i]);
+		crc2 = _mm_crc32_u64(crc2, buf[2 * n + i]);
+	}
+
+	kk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(k));
+
+	t = _mm_xor_si128(
+		_mm_clmulepi64_si128(_mm_cvtsi64_si128(crc0), kk, 0x00),
+		_mm_clmulepi64_si128(_mm_cvtsi64_si128(crc1), kk, 0x10));
+
+	return(_mm_crc32_u64(0, _mm_cvtsi128_si64(t)) ^ crc2);
+}
+
+/********************************************************************//**
+Updates a CRC32 register, processing three streams at a time.
+@return CRC32 register after the data */
+static __attribute__((target("sse4.2,pclmul")))
+ib_uint64_t
+ut_crc32_pclmul_update(
+/*===================*/
+	ib_uint64_t	crc,	/*!< in: CRC32 register */
+	const byte*	buf,	/*!< in: data over which to calculate CRC32 */
+	ulint		len)	/*!< in: data length */
+{
+	while (len && ((ulint) buf & 7)) {
+		crc = _mm_crc32_u8(static_cast<ib_uint32_t>(crc), *buf);
+		len--, buf++;
+	}
+
+	while (len >= 3 * UT_CRC32_LONG) {
+		crc = ut_crc32_pclmul_chunk(
+			crc, reinterpret_cast<const ib_uint64_t*>(buf),
+			UT_CRC32_LONG / 8, ut_crc32_pclmul_long);
+		len -= 3 * UT_CRC32_LONG, buf += 3 * UT_CRC32_LONG;
+	}
+
+	while (len >= 3 * UT_CRC32_SHORT) {
+		crc = ut_crc32_pclmul_chunk(
+			crc, reinterpret_cast<const ib_uint64_t*>(buf),
+			UT_CRC32_SHORT / 8, ut_crc32_pclmul_short);
+		len -= 3 * UT_CRC32_SHORT, buf += 3 * UT_CRC32_SHORT;
+	}
+
+	while (len >= 8) {
+		crc = _mm_crc32_u64(crc, *reinterpret_cast<const ib_uint64_t*>(
+					    buf));
+		len -= 8, buf += 8;
+	}
+
+	while (len) {
+		crc = _mm_crc32_u8(static_cast<ib_uint32_t>(crc), *buf);
+		len--, buf++;
+	}
+
+	return(crc);
+}
+
+/********************************************************************//**
+Calculates CRC32 using CPU instructions, combining three streams with
+PCLMULQDQ.
+@return CRC-32C (polynomial 0x11EDC6F41) */
+static
+ib_uint32_t
+ut_crc32_pclmul(
+/*============*/
+	const byte*	buf,	/*!< in: data over which to calculate CRC32 */
+	ulint		len)	/*!< in: data length */
+{
+	ut_ad(ut_crc32_pclmul_enabled);
+
+	return((ib_uint32_t) ~ut_crc32_pclmul_update(
+		       (ib_uint32_t) (-1), buf, len));
+}
+
+# ifdef UT_CRC32_VPCLMUL
+/** Minimum data length for ut_crc32_vpclmul() to fold, in bytes */
+#define UT_CRC32_VPCLMUL_MIN	1024
+
+/* Constants for folding 16 bytes forward by 256, 64 and 16 bytes:
+{x^(8*n+31) mod P, x^(8*n-33) mod P} */
+static ib_uint64_t	ut_crc32_vpclmul_256[2];
+static ib_uint64_t	ut_crc32_vpclmul_64[2];
+static ib_uint64_t	ut_crc32_vpclmul_16[2];
+
+/********************************************************************//**
+Folds each 16-byte lane of a 64-byte vector forward and adds data. */
+#define ut_crc32_vpclmul_fold(x, k, data)				\
+	_mm512_ternarylogic_epi64(_mm512_clmulepi64_epi128(x, k, 0x00),	\
+				  _mm512_clmulepi64_epi128(x, k, 0x11),	\
+				  data, 0x96)
+
+/********************************************************************//**
+Updates a CRC32 register, folding 256 bytes at a time with AVX-512
+VPCLMULQDQ.
+@return CRC32 register after the data */
+static __attribute__((target("avx512f,vpclmulqdq,sse4.2,pclmul")))
+ib_uint64_t
+ut_crc32_vpclmul_update(
+/*====================*/
+	ib_uint64_t	crc,	/*!< in: CRC32 register */
+	const byte*	buf,	/*!< in: data over which to calculate CRC32 */
+	ulint		len)	/*!< in: data length, a non-zero multiple
+				of 256 */
+{
+	const __m512i*	p = reinterpret_cast<const __m512i*>(buf);
+	const __m512i*	end = p + len / 64;
+	__m512i		x0;
+	__m512i		x1;
+	__m512i		x2;
+	__m512i		x3;
+	__m512i		k;
+	__m128i		x;
+	__m128i		k16;
+	ib_uint64_t	lanes[8];
+
+	ut_ad(len >= 256);
+	ut_ad(!(len & 255));
+
+	/* Adding the register to the first 4 bytes of the data is the
+	same as starting the CRC32 of the data with the register. */
+	x0 = _mm512_xor_si512(_mm512_loadu_si512(p),
+			      _mm512_set_epi64(0, 0, 0, 0, 0, 0, 0, crc));
+	x1 = _mm512_loadu_si512(p + 1);
+	x2 = _mm512_loadu_si512(p + 2);
+	x3 = _mm512_loadu_si512(p + 3);
+
+	k = _mm512_set_epi64(
+		ut_crc32_vpclmul_256[1], ut_crc32_vpclmul_256[0],
+		ut_crc32_vpclmul_256[1], ut_crc32_vpclmul_256[0],
+		ut_crc32_vpclmul_256[1], ut_crc32_vpclmul_256[0],
+		ut_crc32_vpclmul_256[1], ut_crc32_vpclmul_256[0]);
+
+	for (p += 4; p < end; p += 4) {
+		x0 = ut_crc32_vpclmul_fold(x0, k, _mm512_loadu_si512(p));
+		x1 = ut_crc32_vpclmul_fold(x1, k, _mm512_loadu_si512(p + 1));
+		x2 = ut_crc32_vpclmul_fold(x2, k, _mm512_loadu_si512(p + 2));
+		x3 = ut_crc32_vpclmul_fold(x3, k, _mm512_loadu_si512(p + 3));
+	}
+
+	k = _mm512_set_epi64(
+		ut_crc32_vpclmul_64[1], ut_crc32_vpclmul_64[0],
+		ut_crc32_vpclmul_64[1], ut_crc32_vpclmul_64[0],
+		ut_crc32_vpclmul_64[1], ut_crc32_vpclmul_64[0],
+		ut_crc32_vpclmul_64[1], ut_crc32_vpclmul_64[0]);
+
+	x1 = ut_crc32_vpclmul_fold(x0, k, x1);
+	x2 = ut_crc32_vpclmul_fold(x1, k, x2);
+	x3 = ut_crc32_vpclmul_fold(x2, k, x3);
+
+	k16 = _mm_loadu_si128(
+		reinterpret_cast<const __m128i*>(ut_crc32_vpclmul_16));
+
+	_mm512_storeu_si512(lanes, x3);
+
+	x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lanes));
+
+	for (ulint i = 2; i < 8; i += 2) {
+		x = _mm_xor_si128(
+			_mm_xor_si128(_mm_clmulepi64_si128(x, k16, 0x00),
+				      _mm_clmulepi64_si128(x, k16, 0x11)),
+			_mm_loadu_si128(
+				reinterpret_cast<const __m128i*>(lanes + i)));
+	}
+
+	/* The remaining 16 bytes have the same CRC32 as all the data. */
+	crc = _mm_crc32_u64(0, _mm_cvtsi128_si64(x));
+	return(_mm_crc32_u64(crc, _mm_extract_epi64(x, 1)));
+}
+
+/********************************************************************//**
+Calculates CRC32 using CPU instructions, folding long buffers with AVX-512
+VPCLMULQDQ.
+@return CRC-32C (polynomial 0x11EDC6F41) */
+static
+ib_uint32_t
+ut_crc32_vpclmul(
+/*=============*/
+	const byte*	buf,	/*!< in: data over which to calculate CRC32 */
+	ulint		len)	/*!< in: data length */
+{
+	ib_uint64_t	crc = (ib_uint32_t) (-1);
+
+	ut_ad(ut_crc32_vpclmul_enabled);
+
+	if (len >= UT_CRC32_VPCLMUL_MIN) {
+		ulint	n = len & ~(ulint) 255;
+
+		crc = ut_crc32_vpclmul_update(crc, buf, n);
+		buf += n;
+		len -= n;
+	}
+
+	return((ib_uint32_t) ~ut_crc32_pclmul_update(crc, buf, len));
+}
+# endif /* UT_CRC32_VPCLMUL */
+
+/********************************************************************//**
+Initializes the constants of ut_crc32_pclmul() and ut_crc32_vpclmul(). */
+static
+void
+ut_crc32_pclmul_init()
+/*==================*/
+{
+	ut_crc32_pclmul_long[0] = ut_crc32_xpow(8 * 2 * UT_CRC32_LONG - 33);
+	ut_crc32_pclmul_long[1] = ut_crc32_xpow(8 * UT_CRC32_LONG - 33);
+	ut_crc32_pclmul_short[0] = ut_crc32_xpow(8 * 2 * UT_CRC32_SHORT - 33);
+	ut_crc32_pclmul_short[1] = ut_crc32_xpow(8 * UT_CRC32_SHORT - 33);
+
+# ifdef UT_CRC32_VPCLMUL
+	ut_crc32_vpclmul_256[0] = ut_crc32_xpow(8 * 256 + 31);
+	ut_crc32_vpclmul_256[1] = ut_crc32_xpow(8 * 256 - 33);
+	ut_crc32_vpclmul_64[0] = ut_crc32_xpow(8 * 64 + 31);
+	ut_crc32_vpclmul_64[1] = ut_crc32_xpow(8 * 64 - 33);
+	ut_crc32_vpclmul_16[0] = ut_crc32_xpow(8 * 16 + 31);
+	ut_crc32_vpclmul_16[1] = ut_crc32_xpow(8 * 16 - 33);
+# endif /* UT_CRC32_VPCLMUL */
+}
+#endif /* UT_CRC32_PCLMUL */
+
 /********************************************************************//**
 Initializes the data structures used by ut_crc32(). Does not do any
 allocations, would not hurt if called twice, but would be pointless. */
@@ -305,10 +652,39 @@ ut_crc32_init()
 	*/
 #ifndef UNIV_DEBUG_VALGRIND
 	ut_crc32_sse2_enabled = (features_ecx >> 20) & 1;
+# ifdef UT_CRC32_PCLMUL
+	/* PCLMULQDQ */
+	ut_crc32_pclmul_enabled = ut_crc32_sse2_enabled
+		&& ((features_ecx >> 1) & 1);
+# endif /* UT_CRC32_PCLMUL */
+# ifdef UT_CRC32_VPCLMUL
+	if (ut_crc32_pclmul_enabled) {
+		ib_uint32_t	ext_ebx;
+		ib_uint32_t	ext_ecx;
+
+		/* AVX512F and VPCLMULQDQ */
+		ut_crc32_vpclmul_enabled
+			= ut_cpuid_ext(features_ecx, &ext_ebx, &ext_ecx)
+			&& ((ext_ebx >> 16) & 1) && ((ext_ecx >> 10) & 1);
+	}
+# endif /* UT_CRC32_VPCLMUL */
 #endif /* UNIV_DEBUG_VALGRIND */
 
 #endif /* defined(__GNUC__) && defined(__x86_64__) */
 
+#ifdef UT_CRC32_PCLMUL
+	if (ut_crc32_pclmul_enabled) {
+		ut_crc32_pclmul_init();
+# ifdef UT_CRC32_VPCLMUL
+		ut_crc32 = ut_crc32_vpclmul_enabled
+			? ut_crc32_vpclmul : ut_crc32_pclmul;
+# else
+		ut_crc32 = ut_crc32_pclmul;
+# endif /* UT_CRC32_VPCLMUL */
+		return;
+	}
+#endif /* UT_CRC32_PCLMUL */
+
 	if (ut_crc32_sse2_enabled) {
 		ut_crc32 = ut_crc32_sse42;
 	} else {
@@ -99,6 +99,11 @@ my $option_encrypt_key_file = '';
 my $encrypt_cmd = '';
 my $option_encrypt_threads = 1;
 my $option_encrypt_chunk_size = '';
+my $option_local_write_mode = '';
+my $option_local_write_threads = '';
+my $option_local_write_queue_size = '';
+my $option_buffer_memory_limit = '';
+my $option_buffer_large_pages = '';
 my $option_export = '';
 my $option_use_memory = '';
 my $option_mysql_password = '';
@@ -113,6 +118,7 @@ my $option_galera_info = '';
 my $option_no_lock = '';
 my $option_ibbackup_binary = 'xtrabackup';
 my $option_log_copy_interval = 0;
+my $option_log_filter = 0;
 
 my $option_defaults_file = '';
 my $option_defaults_extra_file = '';
@@ -136,6 +142,9 @@ my $option_parallel = '';
 my $option_safe_slave_backup = '';
 my $option_safe_slave_backup_timeout = 300;
 
+my $option_dump_innodb_buffer_pool = '';
+my $option_dump_innodb_buffer_pool_timeout = 10;
+
 my $option_compact = '';
 my $option_rebuild_indexes = '';
 my $option_rebuild_threads = 0;
@@ -1799,6 +1808,9 @@ sub decrypt_decompress {
     } elsif ($option_encrypt_key_file) {
       $decrypt_opts = $decrypt_opts . " --encrypt-key-file=$option_encrypt_key_file";
     }
+    if ($option_encrypt_threads > 1) {
+      $decrypt_opts = $decrypt_opts . " --encrypt-threads=$option_encrypt_threads";
+    }
   }
 
   # based on the mode, determine which files we are interested in
@@ -1946,6 +1958,11 @@ sub backup {
         }
     }
 
+    # let the server dump its buffer pool while the data files are copied
+    if ($option_dump_innodb_buffer_pool) {
+        $buffer_pool_filename = dump_innodb_buffer_pool(\%mysql);
+    }
+
     # start ibbackup as a child process
     start_ibbackup();
 
@@ -2020,6 +2037,10 @@ sub backup {
       mysql_query(\%mysql, 'START SLAVE SQL_THREAD;');
     }
 
+    if ($option_dump_innodb_buffer_pool) {
+        wait_for_innodb_buffer_pool_dump(\%mysql);
+    }
+
     # copy ib_lru_dump
     # Copy buffer poll dump and/or LRU dump
     foreach my $dump_name ($buffer_pool_filename, 'ib_lru_dump') {
@@ -2386,13 +2407,16 @@ sub copy_back {
     my $orig_undo_dir = $orig_ibdata_dir;
     my $iblog_files = 'ib_logfile.*';
     my $ibundo_files = 'undo[0-9]{3}';
+    # parallel doublewrite files created by --apply-log and their list
+    my $ibdblwr_files = 'xb_doublewrite_[0-9]+|ib_parallel_doublewrite';
     my $excluded_files = 
         '\.\.?|backup-my\.cnf|xtrabackup_logfile|' .
         'xtrabackup_binary|xtrabackup_binlog_info|xtrabackup_checkpoints|' .
         '.*\.qp|' .
         '.*\.pmap|.*\.tmp|' .
         $iblog_files . '|'.
-        $ibundo_files;
+        $ibundo_files . '|' .
+        $ibdblwr_files;
     my $compressed_data_file = '.*\.ibz$';
     my $file;
     my $backup_innodb_data_file_path;
@@ -2408,6 +2432,23 @@ sub copy_back {
         $orig_undo_dir = get_option(\%config, $option_defaults_group,
                                     'innodb_undo_directory');
     }
+    # a backup prepared with --export and table filters has the redo log
+    # applied to the exported tablespaces only
+    if (-e "$backup_dir/xtrabackup_checkpoints") {
+        open my $fh, '<', "$backup_dir/xtrabackup_checkpoints"
+            or die "Cannot open $backup_dir/xtrabackup_checkpoints: $OS_ERROR";
+        while (my $line = <$fh>) {
+            if ($line =~ /^backup_type\s*=\s*export-prepared\s*$/) {
+                die "The backup in '$backup_dir' has been prepared with "
+                  . "--export and table filters, only the exported tables "
+                  . "can be restored from it. Cannot "
+                  . "'$innobackup_script --copy-back ...' or "
+                  . "'$innobackup_script --move-back ...' it.";
+            }
+        }
+        close $fh;
+    }
+
     # check whether files should be copied or moved to dest directory
     my $move_or_copy_file = $move_flag ? \&move_file : \&copy_file;
     my $move_or_copy_dir = $move_flag ?
@@ -2561,6 +2602,12 @@ sub apply_log {
 
     if ($option_export) {
         $options = $options . ' --export';
+        if ($option_include) {
+            $options = $options . " --tables='$option_include'";
+        }
+        if ($option_tables_file) {
+            $options = $options . " --tables-file='$option_tables_file'";
+        }
     }
     if ($option_redo_only) {
         $options = $options . ' --apply-log-only';
@@ -2771,6 +2818,9 @@ sub start_ibbackup {
     if ($option_log_copy_interval) {
         $options = $options . " --log-copy-interval=$option_log_copy_interval";
     }
+    if ($option_log_filter) {
+        $options = $options . " --log-filter";
+    }
     if ($option_sleep) {
         $options = $options . " --sleep=$option_sleep";
     }
@@ -2794,6 +2844,21 @@ sub start_ibbackup {
 	        $options = $options . " --encrypt-chunk-size=$option_encrypt_chunk_size";
 	}
     }
+    if ($option_buffer_memory_limit) {
+        $options = $options . " --buffer-memory-limit=$option_buffer_memory_limit";
+    }
+    if ($option_buffer_large_pages) {
+        $options = $options . " --buffer-large-pages";
+    }
+    if (!$option_stream && $option_local_write_mode) {
+        $options = $options . " --local-write-mode=$option_local_write_mode";
+        if ($option_local_write_threads) {
+            $options = $options . " --local-write-threads=$option_local_write_threads";
+        }
+        if ($option_local_write_queue_size) {
+            $options = $options . " --local-write-queue-size=$option_local_write_queue_size";
+        }
+    }
     if ($option_use_memory) {
         $options = $options . " --use-memory=$option_use_memory";
     }
@@ -3720,11 +3785,17 @@ sub check_args {
                         'encrypt-key-file=s' => \$option_encrypt_key_file,
                         'encrypt-threads=i' => \$option_encrypt_threads,
                         'encrypt-chunk-size=s' => \$option_encrypt_chunk_size,
+                        'local-write-mode=s' => \$option_local_write_mode,
+                        'local-write-threads=i' => \$option_local_write_threads,
+                        'local-write-queue-size=s' => \$option_local_write_queue_size,
+                        'buffer-memory-limit=s' => \$option_buffer_memory_limit,
+                        'buffer-large-pages' => \$option_buffer_large_pages,
                         'help' => \$option_help,
                         'history:s' => \$option_history,
                         'version' => \$option_version,
                         'throttle=i' => \$option_throttle,
                         'log-copy-interval=i', \$option_log_copy_interval,
+                        'log-filter' => \$option_log_filter,
                         'sleep=i' => \$option_sleep,
                         'apply-log' => \$option_apply_log,
                         'redo-only' => \$option_redo_only,
@@ -3762,6 +3833,10 @@ sub check_args {
                         'parallel=i' => \$option_parallel,
                         'safe-slave-backup' => \$option_safe_slave_backup,
                         'safe-slave-backup-timeout=i' => \$option_safe_slave_backup_timeout,
+                        'dump-innodb-buffer-pool' =>
+                        \$option_dump_innodb_buffer_pool,
+                        'dump-innodb-buffer-pool-timeout=i' =>
+                        \$option_dump_innodb_buffer_pool_timeout,
                         'compact' => \$option_compact,
                         'rebuild-indexes' => \$option_rebuild_indexes,
                         'rebuild-threads=i' => \$option_rebuild_threads,
@@ -4610,6 +4685,70 @@ sub check_server_version {
     }
 }
 
+#
+# dump_innodb_buffer_pool subroutine makes the server dump the list of the
+# pages in its buffer pool, so that a server restored from the backup can
+# load the pages that were hot at backup time.
+#   Parameters:
+#     con    connection to the server
+#   Return value:
+#     name of the buffer pool dump file relative to the data directory
+#
+sub dump_innodb_buffer_pool {
+    my $con = shift;
+
+    get_mysql_vars($con);
+
+    if (!defined($con->{vars}->{innodb_buffer_pool_dump_now})) {
+        die "$prefix --dump-innodb-buffer-pool requires MySQL 5.6 or later\n";
+    }
+
+    print STDERR "$prefix Dumping the InnoDB buffer pool\n";
+
+    # remember the status of the previous dump to tell it from this one
+    get_mysql_status($con);
+    $con->{buffer_pool_dump_status} =
+        $con->{status}->{Innodb_buffer_pool_dump_status}->{Value};
+
+    mysql_query($con, 'SET GLOBAL innodb_buffer_pool_dump_now=ON');
+
+    return $con->{vars}->{innodb_buffer_pool_filename}->{Value};
+}
+
+#
+# wait_for_innodb_buffer_pool_dump subroutine waits for the buffer pool dump
+# started by dump_innodb_buffer_pool to complete. On timeout, the dump file
+# left by a previous dump, if any, is backed up.
+#   Parameters:
+#     con    connection to the server
+#
+sub wait_for_innodb_buffer_pool_dump {
+    my $con = shift;
+    my $n_attempts = $option_dump_innodb_buffer_pool_timeout;
+    my $status;
+
+    while (1) {
+        get_mysql_status($con);
+        $status = $con->{status}->{Innodb_buffer_pool_dump_status}->{Value};
+
+        if ($status =~ m/^Buffer pool\(s\) dump completed/
+            && $status ne $con->{buffer_pool_dump_status}) {
+            print STDERR "$prefix $status\n";
+            return;
+        }
+
+        last if ($n_attempts-- <= 0);
+
+        print STDERR "$prefix Waiting for the InnoDB buffer pool dump: " .
+            "$status\n";
+        sleep 1;
+    }
+
+    print STDERR "$prefix Warning: the InnoDB buffer pool dump did not " .
+        "complete in $option_dump_innodb_buffer_pool_timeout seconds: " .
+        "$status\n";
+}
+
 # Wait until it's safe to backup a slave.  Returns immediately if
 # the host isn't a slave.  Currently there's only one check:
 # Slave_open_temp_tables has to be zero.  Dies on timeout.
@@ -5075,12 +5214,18 @@ innobackupex [--compress] [--compress-threads=NUMBER-OF-THREADS] [--compress-chu
              [--slave-info] [--galera-info] [--stream=tar|xbstream]
              [--defaults-file=MY.CNF] [--defaults-group=GROUP-NAME]
              [--databases=LIST] [--no-lock] 
-             [--tmpdir=DIRECTORY] [--tables-file=FILE]
+             [--tmpdir=DIRECTORY] [--tables-file=FILE] [--log-filter]
              [--history=NAME]
              [--incremental] [--incremental-basedir]
              [--incremental-dir] [--incremental-force-scan] [--incremental-lsn]
              [--incremental-history-name=NAME] [--incremental-history-uuid=UUID]
              [--compact]     
+             [--dump-innodb-buffer-pool]
+             [--dump-innodb-buffer-pool-timeout=SECONDS]
+             [--local-write-mode=fsync|write-behind|direct]
+             [--local-write-threads=NUMBER-OF-THREADS]
+             [--local-write-queue-size=SIZE]
+             [--buffer-memory-limit=SIZE] [--buffer-large-pages]
              BACKUP-ROOT-DIR
 
 innobackupex --apply-log [--use-memory=B]
@@ -5152,6 +5297,14 @@ indicates an error.
 
 Prepare a backup in BACKUP-DIR by applying the transaction log file named "xtrabackup_logfile" located in the same directory. Also, create new transaction logs. The InnoDB configuration is read from the file "backup-my.cnf".
 
+=item --buffer-large-pages
+
+This option instructs xtrabackup to allocate its large I/O buffers from the reserved huge pages. It is passed directly to the xtrabackup child process. Try 'xtrabackup --help' for more details.
+
+=item --buffer-memory-limit=SIZE
+
+This option specifies the maximum amount of memory in bytes used by xtrabackup for its read, delta, compression, encryption and write buffers. It is passed directly to the xtrabackup child process. Try 'xtrabackup --help' for more details.
+
 =item --compact
 
 Create a compact backup with all secondary index pages omitted. This option is passed directly to xtrabackup. See xtrabackup documentation for details.
@@ -5206,6 +5359,14 @@ This option specifies the group name in my.cnf which should be used. This is nee
 
 This option specifies what extra file to read the default MySQL options from before the standard defaults-file.  The option accepts a string argument. It is also passed directly to xtrabackup's --defaults-extra-file option. See the xtrabackup documentation for details.
 
+=item --dump-innodb-buffer-pool
+
+This option makes the server dump the list of the pages in its InnoDB buffer pool with innodb_buffer_pool_dump_now at the start of the backup, and backs up the dump file after the data files, so that a server restored from the backup with innodb_buffer_pool_load_at_startup loads the pages that were hot at backup time. It requires MySQL 5.6 or later.
+
+=item --dump-innodb-buffer-pool-timeout=SECONDS
+
+How many seconds --dump-innodb-buffer-pool should wait for the dump to complete at the end of the backup. On timeout, the dump file left by a previous dump, if any, is backed up. (default 10)
+
 =item --encrypt=ENCRYPTION-ALGORITHM
 
 This option instructs xtrabackup to encrypt backup copies of InnoDB data
@@ -5229,7 +5390,9 @@ Try 'xtrabackup --help' for more details.
 
 This option specifies the number of worker threads that will be used
 for parallel encryption. It is passed directly to the xtrabackup
-child process. Try 'xtrabackup --help' for more details.
+child process. Try 'xtrabackup --help' for more details. With --decrypt,
+it is passed to xbcrypt and specifies the number of threads decrypting
+each file.
 
 =item --encrypt-chunk-size
 
@@ -5239,7 +5402,7 @@ xtrabackup child process. Try 'xtrabackup --help' for more details.
 
 =item --export
 
-This option is passed directly to xtrabackup's --export option. It enables exporting individual tables for import into another server. See the xtrabackup documentation for details.
+This option is passed directly to xtrabackup's --export option. It enables exporting individual tables for import into another server. When --include or --tables-file is also specified, they are passed to xtrabackup as well and only the matching tables are recovered and exported. The other InnoDB tablespaces are left untouched without the log applied, and the backup can no longer be prepared in full or copied back. See the xtrabackup documentation for details.
 
 =item --extra-lsndir=DIRECTORY
 
@@ -5301,6 +5464,10 @@ This options tells xtrabackup to perform full scan of data files for taking an i
 
 This option specifies time interval between checks done by log copying thread in milliseconds.
 
+=item --log-filter
+
+This option is used with --include or --tables-file. It tells xtrabackup to replace the redo log records of the tables excluded from a partial backup with dummy records in xtrabackup_logfile, so that the log compresses better and --apply-log has fewer records to process. It is passed directly to xtrabackup's --log-filter option. See the xtrabackup documentation for details.
+
 =item --incremental-lsn
 
 This option specifies the log sequence number (LSN) to use for the incremental backup.  The option accepts a string argument. It is used with the --incremental option. It is used instead of specifying --incremental-basedir. For databases created by MySQL and Percona Server 5.0-series versions, specify the LSN as two 32-bit integers in high:low format. For databases created in 5.1 and later, specify the LSN as a single 64-bit integer.
@@ -5313,6 +5480,18 @@ This option specifies the number of seconds innobackupex waits between starting
 
 This option specifies which types of queries should be killed to unblock the global lock. Default is "all".
 
+=item --local-write-mode=fsync|write-behind|direct
+
+This option specifies how xtrabackup writes files to a local backup directory. It is passed directly to the xtrabackup child process and is ignored with --stream. With 'write-behind', files are written by background threads and the backup directory is synced once at the end of the backup. With 'direct', the data files are also written with O_DIRECT. Try 'xtrabackup --help' for more details.
+
+=item --local-write-threads=NUMBER-OF-THREADS
+
+This option specifies the number of background writer threads used with --local-write-mode. It is passed directly to the xtrabackup child process.
+
+=item --local-write-queue-size=SIZE
+
+This option specifies the amount of data in bytes queued for the background writer threads before copying blocks. It is passed directly to the xtrabackup child process.
+
 =item --lock-wait-timeout=SECONDS
 
 This option specifies time in seconds that innobackupex should wait for queries that would block FTWRL before running it. If there are still such queries when the timeout expires, innobackupex terminates with an error.
@@ -5362,7 +5541,7 @@ This option only has effect when used together with the --apply-log option and i
 
 =item --rebuild-threads
 
-This option only has effect when used together with the --apply-log and --rebuild-indexes option and is passed directly to xtrabackup. When used, xtrabackup processes tablespaces in parallel with the specified number of threads when rebuilding indexes. See the XtraBackup manual for more information.
+This option only has effect when used together with the --apply-log and --rebuild-indexes option and is passed directly to xtrabackup. When used, xtrabackup processes tablespaces in parallel with the specified number of threads when rebuilding indexes. Threads that have no tablespaces left to process help building the secondary indexes of the remaining tables. See the XtraBackup manual for more information.
 
 =item --redo-only
 
@@ -0,0 +1,455 @@
+/******************************************************
+Copyright (c) 2013 Percona LLC and/or its affiliates.
+
+I/O buffer arena for XtraBackup.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*******************************************************/
+
+/* Recycles the large buffers used to read, filter and write data files. The
+same few buffer sizes are allocated for every copied file, so freed buffers
+are kept in a small per-thread cache and in a global free list, and reused
+by subsequent allocations of the same size class instead of being returned
+to the OS. Buffers are mmap()ed so that they are not subject to malloc()
+arena fragmentation, and buffers of 2M or more are backed by huge pages when
+possible. */
+
+#include <mysql_version.h>
+#include <my_base.h>
+#include "common.h"
+#include "buf_arena.h"
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+/* Smaller allocations are passed through to my_malloc() */
+#define XB_ARENA_MIN_SIZE	(64 * 1024)
+
+/* Allocations are rounded up to a multiple of this size when they are at
+least as large */
+#define XB_ARENA_HUGE_PAGE_SIZE	(2 * 1024 * 1024)
+
+/* The buffer header is stored in the last bytes of the first page of a
+mapping, so that buffers returned to callers are page aligned */
+#define XB_ARENA_HDR_SIZE	4096
+
+/* Maximum number of free buffers cached by each thread */
+#define XB_ARENA_THREAD_CACHE	4
+
+/* Maximum number of free buffers in the global list when memory is not
+limited */
+#define XB_ARENA_MAX_FREE	16
+
+/* How long an allocation waits for the memory limit before giving up */
+#define XB_ARENA_WAIT_TIMEOUT	1
+
+typedef struct xb_arena_buf_struct xb_arena_buf_t;
+
+struct xb_arena_buf_struct {
+	void		*base;		/* start of the mapping or of the
+					my_malloc() block */
+	size_t		map_size;	/* size of the mapping, 0 for buffers
+					allocated with my_malloc() */
+	xb_arena_buf_t	*next;		/* next buffer in a free list */
+};
+
+typedef struct {
+	xb_arena_buf_t	*bufs;
+	uint		n_bufs;
+} xb_arena_cache_t;
+
+static pthread_mutex_t	arena_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	arena_cond = PTHREAD_COND_INITIALIZER;
+static pthread_once_t	arena_once = PTHREAD_ONCE_INIT;
+static pthread_key_t	arena_cache_key;
+
+static xb_arena_buf_t	*arena_free_list = NULL;
+static uint		arena_n_free = 0;
+static uint		arena_n_waiters = 0;
+static ulonglong	arena_limit = 0;
+static my_bool		arena_large_pages = FALSE;
+static my_bool		arena_limit_warned = FALSE;
+static xb_arena_stats_t	arena_stats;
+
+static void arena_cache_destroy(void *arg);
+
+/************************************************************************
+Create the thread cache key. Called once. */
+static
+void
+arena_create_key(void)
+{
+	pthread_key_create(&arena_cache_key, arena_cache_destroy);
+}
+
+/************************************************************************
+@return the calling thread's buffer cache. */
+static
+xb_arena_cache_t *
+arena_get_cache(void)
+{
+	xb_arena_cache_t	*cache;
+
+	pthread_once(&arena_once, arena_create_key);
+
+	cache = (xb_arena_cache_t *) pthread_getspecific(arena_cache_key);
+	if (cache == NULL) {
+		cache = (xb_arena_cache_t *)
+			my_malloc(sizeof(xb_arena_cache_t),
+				  MYF(MY_FAE | MY_ZEROFILL));
+		pthread_setspecific(arena_cache_key, cache);
+	}
+
+	return cache;
+}
+
+/************************************************************************
+Map 'map_size' bytes of anonymous memory.
+@return the mapping or NULL on error. */
+static
+void *
+arena_map(size_t map_size)
+{
+#ifdef HAVE_SYS_MMAN_H
+	void	*base = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+	if (arena_large_pages && map_size % XB_ARENA_HUGE_PAGE_SIZE == 0) {
+		base = mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+			    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	}
+#endif
+	if (base == MAP_FAILED) {
+		base = mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+			    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (base == MAP_FAILED) {
+			return NULL;
+		}
+#if defined(HAVE_MADVISE) && defined(MADV_HUGEPAGE)
+		if (map_size >= XB_ARENA_HUGE_PAGE_SIZE) {
+			/* Transparent huge pages */
+			madvise(base, map_size, MADV_HUGEPAGE);
+		}
+#endif
+	}
+
+	return base;
+#else
+	return my_malloc(map_size, MYF(0));
+#endif
+}
+
+/************************************************************************
+Unmap a buffer and update the arena statistics. Must be called with the
+arena mutex held. */
+static
+void
+arena_unmap(xb_arena_buf_t *buf)
+{
+	size_t	map_size = buf->map_size;
+
+#ifdef HAVE_SYS_MMAN_H
+	munmap(buf->base, map_size);
+#else
+	my_free(buf->base);
+#endif
+	arena_stats.allocated -= map_size;
+}
+
+/************************************************************************
+Remove a buffer of the given size from a free list.
+@return the buffer or NULL if there is no buffer of that size. */
+static
+xb_arena_buf_t *
+arena_list_get(xb_arena_buf_t **list, size_t map_size)
+{
+	xb_arena_buf_t	**prev;
+
+	for (prev = list; *prev != NULL; prev = &(*prev)->next) {
+		xb_arena_buf_t	*buf = *prev;
+
+		if (buf->map_size == map_size) {
+			*prev = buf->next;
+			return buf;
+		}
+	}
+
+	return NULL;
+}
+
+/************************************************************************
+Put a free buffer to the global free list, or unmap it if the list is full.
+Must be called with the arena mutex held. */
+static
+void
+arena_put_global(xb_arena_buf_t *buf)
+{
+	if (arena_limit == 0 && arena_n_free >= XB_ARENA_MAX_FREE) {
+		arena_unmap(buf);
+		return;
+	}
+
+	buf->next = arena_free_list;
+	arena_free_list = buf;
+	arena_n_free++;
+
+	if (arena_n_waiters > 0) {
+		pthread_cond_broadcast(&arena_cond);
+	}
+}
+
+/************************************************************************
+Move all buffers cached by a thread to the global free list. Must be called
+with the arena mutex held. */
+static
+void
+arena_cache_flush(xb_arena_cache_t *cache)
+{
+	while (cache->bufs != NULL) {
+		xb_arena_buf_t	*buf = cache->bufs;
+
+		cache->bufs = buf->next;
+		arena_put_global(buf);
+	}
+	cache->n_bufs = 0;
+}
+
+/************************************************************************
+Thread cache destructor, called on thread exit. */
+static
+void
+arena_cache_destroy(void *arg)
+{
+	xb_arena_cache_t	*cache = (xb_arena_cache_t *) arg;
+
+	pthread_mutex_lock(&arena_mutex);
+	arena_cache_flush(cache);
+	pthread_mutex_unlock(&arena_mutex);
+
+	my_free(cache);
+}
+
+/************************************************************************
+Wait until 'map_size' more bytes can be allocated without exceeding the
+memory limit, unmapping free buffers of other sizes if needed. Must be called
+with the arena mutex held.
+@return a free buffer of the requested size if one has been returned to the
+arena while waiting, NULL otherwise. */
+static
+xb_arena_buf_t *
+arena_wait_for_limit(xb_arena_cache_t *cache, size_t map_size)
+{
+	my_bool		waited = FALSE;
+
+	/* The buffers cached by this thread are of wrong sizes */
+	arena_cache_flush(cache);
+
+	while (arena_stats.allocated + map_size > arena_limit) {
+		struct timespec	abstime;
+		xb_arena_buf_t	*buf;
+
+		if (arena_free_list != NULL) {
+			buf = arena_free_list;
+			arena_free_list = buf->next;
+			arena_n_free--;
+			arena_unmap(buf);
+			continue;
+		}
+
+		if (arena_stats.in_use == 0 || waited) {
+			/* Nothing can be freed, or other threads are
+			holding on to their buffers. Exceed the limit rather
+			than deadlock. */
+			if (!arena_limit_warned) {
+				msg("xtrabackup: warning: buffer memory limit "
+				    "of %llu bytes exceeded.\n", arena_limit);
+				arena_limit_warned = TRUE;
+			}
+			break;
+		}
+
+		set_timespec(abstime, XB_ARENA_WAIT_TIMEOUT);
+
+		arena_stats.n_waits++;
+		arena_n_waiters++;
+		if (pthread_cond_timedwait(&arena_cond, &arena_mutex,
+					   &abstime) == ETIMEDOUT) {
+			waited = TRUE;
+		}
+		arena_n_waiters--;
+
+		buf = arena_list_get(&arena_free_list, map_size);
+		if (buf != NULL) {
+			arena_n_free--;
+			return buf;
+		}
+	}
+
+	return NULL;
+}
+
+void
+xb_arena_set_limit(ulonglong limit)
+{
+	pthread_mutex_lock(&arena_mutex);
+	arena_limit = limit;
+	pthread_mutex_unlock(&arena_mutex);
+}
+
+void
+xb_arena_set_large_pages(my_bool large_pages)
+{
+	arena_large_pages = large_pages;
+}
+
+void *
+xb_arena_alloc(size_t size)
+{
+	xb_arena_cache_t	*cache;
+	xb_arena_buf_t		*buf;
+	size_t			map_size;
+	void			*base;
+
+	if (size < XB_ARENA_MIN_SIZE) {
+		buf = (xb_arena_buf_t *) my_malloc(sizeof(xb_arena_buf_t) +
+						   size, MYF(MY_FAE));
+		buf->base = buf;
+		buf->map_size = 0;
+		return buf + 1;
+	}
+
+	map_size = MY_ALIGN(size + XB_ARENA_HDR_SIZE, XB_ARENA_MIN_SIZE);
+	if (map_size >= XB_ARENA_HUGE_PAGE_SIZE) {
+		map_size = MY_ALIGN(map_size, XB_ARENA_HUGE_PAGE_SIZE);
+	}
+
+	cache = arena_get_cache();
+
+	buf = arena_list_get(&cache->bufs, map_size);
+	if (buf != NULL) {
+		cache->n_bufs--;
+	}
+
+	pthread_mutex_lock(&arena_mutex);
+
+	arena_stats.n_allocs++;
+
+	if (buf == NULL) {
+		buf = arena_list_get(&arena_free_list, map_size);
+		if (buf != NULL) {
+			arena_n_free--;
+		} else if (arena_limit > 0
+			   && arena_stats.allocated + map_size > arena_limit) {
+			buf = arena_wait_for_limit(cache, map_size);
+		}
+	}
+
+	if (buf != NULL) {
+		arena_stats.n_reused++;
+		arena_stats.in_use += map_size;
+		pthread_mutex_unlock(&arena_mutex);
+
+		return buf + 1;
+	}
+
+	/* Account for the new buffer before mapping it, so that concurrent
+	allocations see it */
+	arena_stats.allocated += map_size;
+	arena_stats.in_use += map_size;
+	if (arena_stats.allocated > arena_stats.peak) {
+		arena_stats.peak = arena_stats.allocated;
+	}
+
+	pthread_mutex_unlock(&arena_mutex);
+
+	base = arena_map(map_size);
+	if (base == NULL) {
+		msg("xtrabackup: error: cannot allocate %llu bytes of buffer "
+		    "memory: errno = %d\n", (ulonglong) map_size, errno);
+		exit(EXIT_FAILURE);
+	}
+
+	buf = (xb_arena_buf_t *) ((char *) base + XB_ARENA_HDR_SIZE) - 1;
+	buf->base = base;
+	buf->map_size = map_size;
+
+	return (char *) base + XB_ARENA_HDR_SIZE;
+}
+
+void
+xb_arena_free(void *ptr)
+{
+	xb_arena_cache_t	*cache;
+	xb_arena_buf_t		*buf;
+
+	if (ptr == NULL) {
+		return;
+	}
+
+	buf = (xb_arena_buf_t *) ptr - 1;
+
+	if (buf->map_size == 0) {
+		my_free(buf->base);
+		return;
+	}
+
+	cache = arena_get_cache();
+
+	pthread_mutex_lock(&arena_mutex);
+
+	arena_stats.in_use -= buf->map_size;
+
+	if (arena_n_waiters > 0 || cache->n_bufs >= XB_ARENA_THREAD_CACHE) {
+		/* Let waiting threads have it */
+		arena_put_global(buf);
+		pthread_mutex_unlock(&arena_mutex);
+		return;
+	}
+
+	pthread_mutex_unlock(&arena_mutex);
+
+	buf->next = cache->bufs;
+	cache->bufs = buf;
+	cache->n_bufs++;
+}
+
+void
+xb_arena_release(void)
+{
+	xb_arena_cache_t	*cache = arena_get_cache();
+
+	pthread_mutex_lock(&arena_mutex);
+
+	arena_cache_flush(cache);
+
+	while (arena_free_list != NULL) {
+		xb_arena_buf_t	*buf = arena_free_list;
+
+		arena_free_list = buf->next;
+		arena_unmap(buf);
+	}
+	arena_n_free = 0;
+
+	pthread_mutex_unlock(&arena_mutex);
+}
+
+void
+xb_arena_get_stats(xb_arena_stats_t *stats)
+{
+	pthread_mutex_lock(&arena_mutex);
+	*stats = arena_stats;
+	pthread_mutex_unlock(&arena_mutex);
+}
@@ -0,0 +1,67 @@
+/******************************************************
+Copyright (c) 2013 Percona LLC and/or its affiliates.
+
+I/O buffer arena for XtraBackup.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*******************************************************/
+
+#ifndef XB_BUF_ARENA_H
+#define XB_BUF_ARENA_H
+
+#include <my_global.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+	ulonglong	allocated;	/* bytes currently mapped, including
+					cached free buffers */
+	ulonglong	in_use;		/* bytes handed out to callers */
+	ulonglong	peak;		/* maximum value of 'allocated' */
+	ulonglong	n_allocs;	/* number of xb_arena_alloc() calls */
+	ulonglong	n_reused;	/* allocations served from a cache */
+	ulonglong	n_waits;	/* allocations that waited for the
+					memory limit */
+} xb_arena_stats_t;
+
+/* Limit the amount of memory allocated by the arena to 'limit' bytes, 0 means
+no limit. Allocations that would exceed the limit wait for other threads to
+free their buffers. */
+void xb_arena_set_limit(ulonglong limit);
+
+/* Try to back large buffers with explicitly reserved huge pages
+(MAP_HUGETLB). */
+void xb_arena_set_large_pages(my_bool large_pages);
+
+/* Allocate a buffer of at least 'size' bytes, aligned to the OS page size if
+it is not smaller than the minimum arena buffer size. Never returns NULL. */
+void *xb_arena_alloc(size_t size);
+
+/* Return a buffer allocated with xb_arena_alloc() to the arena. The buffer is
+kept in a per-thread cache for reuse. */
+void xb_arena_free(void *ptr);
+
+/* Unmap all cached free buffers, including the calling thread's cache. */
+void xb_arena_release(void);
+
+void xb_arena_get_stats(xb_arena_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
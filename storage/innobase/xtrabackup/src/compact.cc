@@ -83,6 +83,9 @@ static const ulint	compacted_page_magic_offset = FIL_PAGE_DATA;
 static pthread_mutex_t					table_list_mutex;
 /* List of tablespaces to process by the index rebuild operation */
 static UT_LIST_BASE_NODE_T(index_rebuild_table_t)	table_list;
+/* Number of index rebuild threads that have run out of tables and can help
+building the indexes of the remaining ones, protected by table_list_mutex */
+static ulint						rebuild_threads_idle;
 
 
 /************************************************************************
@@ -883,6 +886,10 @@ xb_rebuild_indexes_thread_func(
 
 		if (rebuild_table == NULL) {
 
+			/* Let the threads still rebuilding indexes use this
+			one for their remaining work */
+			rebuild_threads_idle++;
+
 			pthread_mutex_unlock(&table_list_mutex);
 			break;
 		}
@@ -924,6 +931,40 @@ xb_rebuild_indexes_thread_func(
 	return(NULL);
 }
 
+/******************************************************************************
+Reserve up to 'n' index rebuild threads that have run out of tables, so that
+row_merge_build_indexes() can use them to build the indexes of a single table
+in parallel.
+@return number of reserved threads */
+ulint
+xb_rebuild_threads_reserve(
+/*=======================*/
+	ulint	n)	/*!< in: number of threads wanted */
+{
+	pthread_mutex_lock(&table_list_mutex);
+
+	n = ut_min(n, rebuild_threads_idle);
+	rebuild_threads_idle -= n;
+
+	pthread_mutex_unlock(&table_list_mutex);
+
+	return(n);
+}
+
+/******************************************************************************
+Return threads reserved with xb_rebuild_threads_reserve(). */
+void
+xb_rebuild_threads_release(
+/*=======================*/
+	ulint	n)	/*!< in: number of threads to return */
+{
+	pthread_mutex_lock(&table_list_mutex);
+
+	rebuild_threads_idle += n;
+
+	pthread_mutex_unlock(&table_list_mutex);
+}
+
 /******************************************************************************
 Rebuild all secondary indexes in all tables in separate spaces. Called from
 innobase_start_or_create_for_mysql(). */
@@ -970,6 +1011,7 @@ xb_compact_rebuild_indexes(void)
 
 	pthread_mutex_init(&table_list_mutex, NULL);
 	UT_LIST_INIT(table_list);
+	rebuild_threads_idle = 0;
 
 	btr_pcur_open_at_index_side(TRUE, sys_index, BTR_SEARCH_LEAF, &pcur,
 				    TRUE, 0, &mtr);
@@ -29,6 +29,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include "ds_tmpfile.h"
 #include "ds_encrypt.h"
 #include "ds_buffer.h"
+#include "ds_spool.h"
 
 /************************************************************************
 Create a datasink of the specified type */
@@ -63,6 +64,9 @@ ds_create(const char *root, ds_type_t type)
 	case DS_TYPE_BUFFER:
 		ds = &datasink_buffer;
 		break;
+	case DS_TYPE_SPOOL:
+		ds = &datasink_spool;
+		break;
 	default:
 		msg("Unknown datasink type: %d\n", type);
 		xb_ad(0);
@@ -121,6 +125,22 @@ ds_destroy(ds_ctxt_t *ctxt)
 	ctxt->datasink->deinit(ctxt);
 }
 
+/************************************************************************
+Get runtime statistics of a datasink.
+@return TRUE on success, FALSE if the datasink does not support statistics. */
+my_bool
+ds_get_stats(ds_ctxt_t *ctxt, ds_stats_t *stats)
+{
+	if (ctxt->datasink->get_stats == NULL) {
+		return FALSE;
+	}
+
+	memset(stats, 0, sizeof(ds_stats_t));
+	ctxt->datasink->get_stats(ctxt, stats);
+
+	return TRUE;
+}
+
 /************************************************************************
 Set the destination pipe for a datasink (only makes sense for compress and
 tmpfile). */
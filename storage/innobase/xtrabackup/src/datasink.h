@@ -44,12 +44,24 @@ typedef struct {
 	datasink_t	*datasink;
 } ds_file_t;
 
+/* Runtime statistics reported by datasinks that support them */
+typedef struct {
+	const char	*name;		/* datasink name */
+	ulonglong	bytes_in;	/* bytes passed to the datasink */
+	ulonglong	bytes_out;	/* bytes written down the pipeline */
+	ulonglong	bytes_pending;	/* bytes queued and not yet written */
+	uint		workers;	/* number of worker threads */
+	uint		busy_workers;	/* worker threads with data to process */
+} ds_stats_t;
+
 struct datasink_struct {
 	ds_ctxt_t *(*init)(const char *root);
 	ds_file_t *(*open)(ds_ctxt_t *ctxt, const char *path, MY_STAT *stat);
 	int (*write)(ds_file_t *file, const void *buf, size_t len);
 	int (*close)(ds_file_t *file);
 	void (*deinit)(ds_ctxt_t *ctxt);
+	/* optional, may be NULL */
+	void (*get_stats)(ds_ctxt_t *ctxt, ds_stats_t *stats);
 };
 
 /* Supported datasink types */
@@ -61,7 +73,8 @@ typedef enum {
 	DS_TYPE_COMPRESS,
 	DS_TYPE_ENCRYPT,
 	DS_TYPE_TMPFILE,
-	DS_TYPE_BUFFER
+	DS_TYPE_BUFFER,
+	DS_TYPE_SPOOL
 } ds_type_t;
 
 /************************************************************************
@@ -87,8 +100,15 @@ Destroy a datasink handle */
 void ds_destroy(ds_ctxt_t *ctxt);
 
 /************************************************************************
-Set the destination pipe for a datasink (only makes sense for compress and
-tmpfile). */
+Get runtime statistics of a datasink. The statistics are collected without
+synchronization with the threads using the datasink, so the values are only
+approximate.
+@return TRUE on success, FALSE if the datasink does not support statistics. */
+my_bool ds_get_stats(ds_ctxt_t *ctxt, ds_stats_t *stats);
+
+/************************************************************************
+Set the destination pipe for a datasink (only makes sense for compress,
+tmpfile and spool). */
 void ds_set_pipe(ds_ctxt_t *ctxt, ds_ctxt_t *pipe_ctxt);
 
 #ifdef __cplusplus
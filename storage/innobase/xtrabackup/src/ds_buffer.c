@@ -28,6 +28,7 @@ exception for the last write for a file. */
 #include "ds_buffer.h"
 #include "common.h"
 #include "datasink.h"
+#include "buf_arena.h"
 
 #define DS_DEFAULT_BUFFER_SIZE (64 * 1024)
 
@@ -102,13 +103,12 @@ buffer_open(ds_ctxt_t *ctxt, const char *path, MY_STAT *mystat)
 	buffer_ctxt = (ds_buffer_ctxt_t *) ctxt->ptr;
 
 	file = (ds_file_t *) my_malloc(sizeof(ds_file_t) +
-				       sizeof(ds_buffer_file_t) +
-				       buffer_ctxt->buffer_size,
+				       sizeof(ds_buffer_file_t),
 				       MYF(MY_FAE));
 
 	buffer_file = (ds_buffer_file_t *) (file + 1);
 	buffer_file->dst_file = dst_file;
-	buffer_file->buf = (char *) (buffer_file + 1);
+	buffer_file->buf = (char *) xb_arena_alloc(buffer_ctxt->buffer_size);
 	buffer_file->size = buffer_ctxt->buffer_size;
 	buffer_file->pos = 0;
 
@@ -175,6 +175,7 @@ buffer_close(ds_file_t *file)
 
 	ds_close(buffer_file->dst_file);
 
+	xb_arena_free(buffer_file->buf);
 	my_free(file);
 
 	return 0;
@@ -24,6 +24,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <zlib.h>
 #include "common.h"
 #include "datasink.h"
+#include "buf_arena.h"
 
 #define COMPRESS_CHUNK_SIZE ((size_t) (xtrabackup_compress_chunk_size))
 #define MY_QLZ_COMPRESS_OVERHEAD 400
@@ -38,6 +39,8 @@ typedef struct {
 	my_bool			started;
 	my_bool			data_avail;
 	my_bool			cancelled;
+	ulonglong		bytes_in;
+	ulonglong		bytes_out;
 	const char 		*from;
 	size_t			from_len;
 	char			*to;
@@ -68,13 +71,15 @@ static ds_file_t *compress_open(ds_ctxt_t *ctxt, const char *path,
 static int compress_write(ds_file_t *file, const void *buf, size_t len);
 static int compress_close(ds_file_t *file);
 static void compress_deinit(ds_ctxt_t *ctxt);
+static void compress_get_stats(ds_ctxt_t *ctxt, ds_stats_t *stats);
 
 datasink_t datasink_compress = {
 	&compress_init,
 	&compress_open,
 	&compress_write,
 	&compress_close,
-	&compress_deinit
+	&compress_deinit,
+	&compress_get_stats
 };
 
 static inline int write_uint32_le(ds_file_t *file, ulong n);
@@ -248,6 +253,8 @@ compress_write(ds_file_t *file, const void *buf, size_t len)
 			}
 
 			comp_file->bytes_processed += threads[i].from_len;
+			threads[i].bytes_in += threads[i].from_len;
+			threads[i].bytes_out += threads[i].to_len;
 
 			if (write_uint32_le(dest_file, threads[i].adler) ||
 			    ds_write(dest_file, threads[i].to,
@@ -307,6 +314,29 @@ compress_deinit(ds_ctxt_t *ctxt)
 	my_free(ctxt);
 }
 
+static
+void
+compress_get_stats(ds_ctxt_t *ctxt, ds_stats_t *stats)
+{
+	ds_compress_ctxt_t	*comp_ctxt;
+	uint			i;
+
+	comp_ctxt = (ds_compress_ctxt_t *) ctxt->ptr;
+
+	stats->name = "compress";
+	stats->workers = comp_ctxt->nthreads;
+
+	for (i = 0; i < comp_ctxt->nthreads; i++) {
+		comp_thread_ctxt_t *thd = comp_ctxt->threads + i;
+
+		stats->bytes_in += thd->bytes_in;
+		stats->bytes_out += thd->bytes_out;
+		if (thd->data_avail) {
+			stats->busy_workers++;
+		}
+	}
+}
+
 static inline
 int
 write_uint32_le(ds_file_t *file, ulong n)
@@ -344,10 +374,11 @@ create_worker_threads(uint n)
 		thd->started = FALSE;
 		thd->cancelled = FALSE;
 		thd->data_avail = FALSE;
+		thd->bytes_in = 0;
+		thd->bytes_out = 0;
 
-		thd->to = (char *) my_malloc(COMPRESS_CHUNK_SIZE +
-						   MY_QLZ_COMPRESS_OVERHEAD,
-						   MYF(MY_FAE));
+		thd->to = (char *) xb_arena_alloc(COMPRESS_CHUNK_SIZE +
+						  MY_QLZ_COMPRESS_OVERHEAD);
 
 		/* Initialize the control mutex and condition var */
 		if (pthread_mutex_init(&thd->ctrl_mutex, NULL) ||
@@ -407,7 +438,7 @@ destroy_worker_threads(comp_thread_ctxt_t *threads, uint n)
 		pthread_cond_destroy(&thd->ctrl_cond);
 		pthread_mutex_destroy(&thd->ctrl_mutex);
 
-		my_free(thd->to);
+		xb_arena_free(thd->to);
 	}
 
 	my_free(threads);
@@ -22,6 +22,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <my_base.h>
 #include "common.h"
 #include "datasink.h"
+#include "buf_arena.h"
 
 #if GCC_VERSION >= 4002
 /* Workaround to avoid "gcry_ac_* is deprecated" warnings in gcrypt.h */
@@ -50,6 +51,8 @@ typedef struct {
 	my_bool			started;
 	my_bool			data_avail;
 	my_bool			cancelled;
+	ulonglong		bytes_in;
+	ulonglong		bytes_out;
 	const char 		*from;
 	size_t			from_len;
 	char			*to;
@@ -83,13 +86,15 @@ static ds_file_t *encrypt_open(ds_ctxt_t *ctxt, const char *path,
 static int encrypt_write(ds_file_t *file, const void *buf, size_t len);
 static int encrypt_close(ds_file_t *file);
 static void encrypt_deinit(ds_ctxt_t *ctxt);
+static void encrypt_get_stats(ds_ctxt_t *ctxt, ds_stats_t *stats);
 
 datasink_t datasink_encrypt = {
 	&encrypt_init,
 	&encrypt_open,
 	&encrypt_write,
 	&encrypt_close,
-	&encrypt_deinit
+	&encrypt_deinit,
+	&encrypt_get_stats
 };
 
 static crypt_thread_ctxt_t *create_worker_threads(uint n);
@@ -355,6 +360,8 @@ encrypt_write(ds_file_t *file, const void *buf, size_t len)
 			}
 
 			crypt_file->bytes_processed += threads[i].from_len;
+			threads[i].bytes_in += threads[i].from_len;
+			threads[i].bytes_out += threads[i].to_len;
 
 			pthread_mutex_unlock(&threads[i].data_mutex);
 			pthread_mutex_unlock(&threads[i].ctrl_mutex);
@@ -404,6 +411,29 @@ encrypt_deinit(ds_ctxt_t *ctxt)
 		my_free(xtrabackup_encrypt_key_file);
 }
 
+static
+void
+encrypt_get_stats(ds_ctxt_t *ctxt, ds_stats_t *stats)
+{
+	ds_encrypt_ctxt_t	*crypt_ctxt;
+	uint			i;
+
+	crypt_ctxt = (ds_encrypt_ctxt_t *) ctxt->ptr;
+
+	stats->name = "encrypt";
+	stats->workers = crypt_ctxt->nthreads;
+
+	for (i = 0; i < crypt_ctxt->nthreads; i++) {
+		crypt_thread_ctxt_t *thd = crypt_ctxt->threads + i;
+
+		stats->bytes_in += thd->bytes_in;
+		stats->bytes_out += thd->bytes_out;
+		if (thd->data_avail) {
+			stats->busy_workers++;
+		}
+	}
+}
+
 static
 crypt_thread_ctxt_t *
 create_worker_threads(uint n)
@@ -421,9 +451,10 @@ create_worker_threads(uint n)
 		thd->started = FALSE;
 		thd->cancelled = FALSE;
 		thd->data_avail = FALSE;
+		thd->bytes_in = 0;
+		thd->bytes_out = 0;
 
-		thd->to = (char *) my_malloc(XB_CRYPT_CHUNK_SIZE,
-						   MYF(MY_FAE));
+		thd->to = (char *) xb_arena_alloc(XB_CRYPT_CHUNK_SIZE);
 
 		thd->iv = (char *) my_malloc(encrypt_iv_len,
 						   MYF(MY_FAE));
@@ -517,7 +548,7 @@ destroy_worker_threads(crypt_thread_ctxt_t *threads, uint n)
 		if (encrypt_algo != GCRY_CIPHER_NONE)
 			gcry_cipher_close(thd->cipher_handle);
 
-		my_free(thd->to);
+		xb_arena_free(thd->to);
 		my_free(thd->iv);
 	}
 
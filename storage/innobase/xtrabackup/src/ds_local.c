@@ -21,33 +21,111 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <mysql_version.h>
 #include <my_base.h>
 #include <mysys_err.h>
+#include <fcntl.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 #include "common.h"
 #include "datasink.h"
+#include "ds_local.h"
+#include "buf_arena.h"
+
+/* Alignment of the offsets and sizes of O_DIRECT writes */
+#define DS_LOCAL_DIRECT_ALIGN		4096
+
+/* Size of the aligned write buffer of a writer thread in the 'direct'
+mode */
+#define DS_LOCAL_DIRECT_BUF_SIZE	(1024 * 1024)
+
+/* In the 'write-behind' mode, writeback of the written data is started in
+windows of this size, and each window is evicted from the page cache once
+the next one is complete */
+#define DS_LOCAL_WRITEBACK_WINDOW	(8 * 1024 * 1024)
+
+typedef struct ds_local_ctxt_struct ds_local_ctxt_t;
+typedef struct ds_local_writer_struct ds_local_writer_t;
+typedef struct ds_local_req_struct ds_local_req_t;
 
 typedef struct {
-	File fd;
+	File			fd;
+	ds_local_ctxt_t		*local_ctxt;
+	ds_local_writer_t	*writer;	/* NULL in the 'fsync' mode */
+	my_off_t		offset;		/* bytes written so far */
+	my_off_t		wb_offset;	/* start of the data for which
+						writeback has not been started
+						yet */
+	my_bool			direct;		/* O_DIRECT is in effect */
+	char			*tail;		/* unaligned end of the data in
+						the 'direct' mode */
+	size_t			tail_len;
 } ds_local_file_t;
 
+/* Data queued for a writer thread. The data follows the structure. */
+struct ds_local_req_struct {
+	ds_file_t		*file;
+	size_t			len;
+	my_bool			close;		/* close the file once the data
+						is written */
+	ds_local_req_t		*next;
+};
+
+struct ds_local_writer_struct {
+	pthread_t		id;
+	ds_local_ctxt_t		*local_ctxt;
+	ds_local_req_t		*first;		/* queued requests */
+	ds_local_req_t		*last;
+	pthread_cond_t		cond;		/* signalled when a request is
+						queued or on shutdown */
+	my_bool			busy;
+	char			*buf_base;
+	char			*buf;		/* aligned buffer for the
+						'direct' mode */
+};
+
+struct ds_local_ctxt_struct {
+	ds_local_mode_t		mode;
+	ds_local_writer_t	*writers;
+	uint			n_writers;
+	uint			next_writer;	/* writer for the next opened
+						file */
+	size_t			queue_size;	/* maximum amount of queued
+						data */
+	size_t			queued;		/* amount of queued data */
+	pthread_mutex_t		mutex;		/* protects the queues and the
+						fields below */
+	pthread_cond_t		space_cond;	/* signalled when queued data
+						has been written */
+	my_bool			shutdown;
+	my_bool			failed;		/* a background write failed */
+	ulonglong		bytes_in;
+	ulonglong		bytes_out;
+};
+
 static ds_ctxt_t *local_init(const char *root);
 static ds_file_t *local_open(ds_ctxt_t *ctxt, const char *path,
 			     MY_STAT *mystat);
 static int local_write(ds_file_t *file, const void *buf, size_t len);
 static int local_close(ds_file_t *file);
 static void local_deinit(ds_ctxt_t *ctxt);
+static void local_get_stats(ds_ctxt_t *ctxt, ds_stats_t *stats);
 
 datasink_t datasink_local = {
 	&local_init,
 	&local_open,
 	&local_write,
 	&local_close,
-	&local_deinit
+	&local_deinit,
+	&local_get_stats
 };
 
+static void *local_writer_thread_func(void *arg);
+
 static
 ds_ctxt_t *
 local_init(const char *root)
 {
-	ds_ctxt_t *ctxt;
+	ds_ctxt_t	*ctxt;
+	ds_local_ctxt_t	*local_ctxt;
 
 	if (my_mkdir(root, 0777, MYF(0)) < 0 && my_errno != EEXIST)
 	{
@@ -56,18 +134,84 @@ local_init(const char *root)
 		return NULL;
 	}
 
-	ctxt = my_malloc(sizeof(ds_ctxt_t), MYF(MY_FAE));
+	ctxt = my_malloc(sizeof(ds_ctxt_t) + sizeof(ds_local_ctxt_t),
+			 MYF(MY_FAE | MY_ZEROFILL));
+	local_ctxt = (ds_local_ctxt_t *) (ctxt + 1);
+	local_ctxt->mode = DS_LOCAL_FSYNC;
+
+	pthread_mutex_init(&local_ctxt->mutex, NULL);
+	pthread_cond_init(&local_ctxt->space_cond, NULL);
 
+	ctxt->ptr = local_ctxt;
 	ctxt->root = my_strdup(root, MYF(MY_FAE));
 
 	return ctxt;
 }
 
+/************************************************************************
+Set the write mode of a local datasink and start the writer threads. Must
+be called before any file is opened.
+@return 0 on success, 1 on error. */
+int
+ds_local_set_mode(ds_ctxt_t *ctxt, ds_local_mode_t mode, uint n_threads,
+		  size_t queue_size)
+{
+	ds_local_ctxt_t	*local_ctxt = (ds_local_ctxt_t *) ctxt->ptr;
+	uint		i;
+
+	xb_a(local_ctxt->n_writers == 0);
+
+	local_ctxt->mode = mode;
+
+	if (mode == DS_LOCAL_FSYNC) {
+		return 0;
+	}
+
+	local_ctxt->queue_size = queue_size;
+	local_ctxt->writers = my_malloc(sizeof(ds_local_writer_t) * n_threads,
+					MYF(MY_FAE | MY_ZEROFILL));
+
+	for (i = 0; i < n_threads; i++) {
+		ds_local_writer_t	*writer = local_ctxt->writers + i;
+
+		writer->local_ctxt = local_ctxt;
+		pthread_cond_init(&writer->cond, NULL);
+
+		if (mode == DS_LOCAL_DIRECT) {
+			writer->buf_base = xb_arena_alloc(
+				DS_LOCAL_DIRECT_BUF_SIZE + DS_LOCAL_DIRECT_ALIGN);
+			writer->buf = (char *)
+				MY_ALIGN((size_t) writer->buf_base,
+					 DS_LOCAL_DIRECT_ALIGN);
+		}
+
+		if (pthread_create(&writer->id, NULL,
+				   local_writer_thread_func, writer)) {
+			msg("local: pthread_create() failed: errno = %d\n",
+			    errno);
+			pthread_cond_destroy(&writer->cond);
+			xb_arena_free(writer->buf_base);
+			break;
+		}
+
+		local_ctxt->n_writers++;
+	}
+
+	if (local_ctxt->n_writers < n_threads) {
+		/* local_deinit() stops the started threads */
+		local_ctxt->failed = TRUE;
+		return 1;
+	}
+
+	return 0;
+}
+
 static
 ds_file_t *
 local_open(ds_ctxt_t *ctxt, const char *path,
 	   MY_STAT *mystat __attribute__((unused)))
 {
+	ds_local_ctxt_t	*local_ctxt = (ds_local_ctxt_t *) ctxt->ptr;
 	char 		fullpath[FN_REFLEN];
 	char		dirpath[FN_REFLEN];
 	size_t		dirpath_len;
@@ -76,6 +220,10 @@ local_open(ds_ctxt_t *ctxt, const char *path,
 	ds_file_t	*file;
 	File 		fd;
 
+	if (local_ctxt->failed) {
+		return NULL;
+	}
+
 	fn_format(fullpath, path, ctxt->root, "", MYF(MY_RELATIVE_PATH));
 
 	/* Create the directory if needed */
@@ -97,27 +245,121 @@ local_open(ds_ctxt_t *ctxt, const char *path,
 	file = (ds_file_t *) my_malloc(sizeof(ds_file_t) +
 				       sizeof(ds_local_file_t) +
 				       path_len,
-				       MYF(MY_FAE));
+				       MYF(MY_FAE | MY_ZEROFILL));
 	local_file = (ds_local_file_t *) (file + 1);
 
 	local_file->fd = fd;
+	local_file->local_ctxt = local_ctxt;
 
 	file->path = (char *) local_file + sizeof(ds_local_file_t);
 	memcpy(file->path, fullpath, path_len);
 
 	file->ptr = local_file;
 
+	if (local_ctxt->mode == DS_LOCAL_FSYNC) {
+		return file;
+	}
+
+#ifdef O_DIRECT
+	/* Filesystems not supporting O_DIRECT reject it with EINVAL, write
+	such files through the page cache */
+	if (local_ctxt->mode == DS_LOCAL_DIRECT
+	    && fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_DIRECT) == 0) {
+		local_file->direct = TRUE;
+		local_file->tail = my_malloc(DS_LOCAL_DIRECT_ALIGN,
+					     MYF(MY_FAE));
+	}
+#endif
+
+	pthread_mutex_lock(&local_ctxt->mutex);
+	local_file->writer = local_ctxt->writers + local_ctxt->next_writer;
+	local_ctxt->next_writer = (local_ctxt->next_writer + 1)
+		% local_ctxt->n_writers;
+	pthread_mutex_unlock(&local_ctxt->mutex);
+
 	return file;
 }
 
+/************************************************************************
+Queue a request for the writer thread of a file, waiting for the queued
+data to drop below the queue size limit.
+@return 0 on success, 1 if a background write has failed. */
+static
+int
+local_queue(ds_file_t *file, const void *buf, size_t len, my_bool close)
+{
+	ds_local_file_t	*local_file = (ds_local_file_t *) file->ptr;
+	ds_local_writer_t *writer = local_file->writer;
+	ds_local_ctxt_t	*local_ctxt = writer->local_ctxt;
+	ds_local_req_t	*req;
+	my_bool		failed;
+
+	req = xb_arena_alloc(sizeof(ds_local_req_t) + len);
+	req->file = file;
+	req->len = len;
+	req->close = close;
+	req->next = NULL;
+	memcpy(req + 1, buf, len);
+
+	pthread_mutex_lock(&local_ctxt->mutex);
+
+	while (local_ctxt->queued > 0
+	       && local_ctxt->queued + len > local_ctxt->queue_size
+	       && !local_ctxt->failed) {
+		pthread_cond_wait(&local_ctxt->space_cond,
+				  &local_ctxt->mutex);
+	}
+
+	failed = local_ctxt->failed;
+
+	/* Files still have to be closed after an error */
+	if (failed && !close) {
+		pthread_mutex_unlock(&local_ctxt->mutex);
+		xb_arena_free(req);
+		return 1;
+	}
+
+	if (writer->last != NULL) {
+		writer->last->next = req;
+	} else {
+		writer->first = req;
+	}
+	writer->last = req;
+
+	local_ctxt->queued += len;
+	local_ctxt->bytes_in += len;
+
+	pthread_cond_signal(&writer->cond);
+
+	pthread_mutex_unlock(&local_ctxt->mutex);
+
+	return failed ? 1 : 0;
+}
+
 static
 int
 local_write(ds_file_t *file, const void *buf, size_t len)
 {
-	File fd = ((ds_local_file_t *) file->ptr)->fd;
+	ds_local_file_t	*local_file = (ds_local_file_t *) file->ptr;
+	File fd = local_file->fd;
+
+	if (local_file->writer != NULL) {
+		return local_queue(file, buf, len, FALSE);
+	}
 
 	if (!my_write(fd, buf, len, MYF(MY_WME | MY_NABP))) {
-		posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		ds_local_ctxt_t	*local_ctxt = local_file->local_ctxt;
+
+		/* Drop the written data from the page cache */
+		posix_fadvise(fd, local_file->offset, len,
+			      POSIX_FADV_DONTNEED);
+		local_file->offset += len;
+
+		pthread_mutex_lock(&local_ctxt->mutex);
+		local_ctxt->bytes_in += len;
+		local_ctxt->bytes_out += len;
+		pthread_mutex_unlock(&local_ctxt->mutex);
+
 		return 0;
 	}
 
@@ -128,7 +370,13 @@ static
 int
 local_close(ds_file_t *file)
 {
-	File fd = ((ds_local_file_t *) file->ptr)->fd;
+	ds_local_file_t	*local_file = (ds_local_file_t *) file->ptr;
+	File fd = local_file->fd;
+
+	if (local_file->writer != NULL) {
+		/* The writer thread closes and frees the file */
+		return local_queue(file, NULL, 0, TRUE);
+	}
 
 	my_free(file);
 
@@ -137,10 +385,302 @@ local_close(ds_file_t *file)
 	return my_close(fd, MYF(MY_WME));
 }
 
+/************************************************************************
+Start writeback of the data written since the previous call, and evict the
+data of the previous window from the page cache once it is on disk. */
+static
+void
+local_writeback(ds_local_file_t *local_file, my_bool last)
+{
+	my_off_t	start = local_file->wb_offset;
+	my_off_t	end = local_file->offset;
+
+	if (end - start < DS_LOCAL_WRITEBACK_WINDOW && !last) {
+		return;
+	}
+
+#ifdef SYNC_FILE_RANGE_WRITE
+	sync_file_range(local_file->fd, start, end - start,
+			SYNC_FILE_RANGE_WRITE);
+
+	/* Waiting for the previous window rather than the one just submitted
+	keeps the device busy with one window while another is being
+	written */
+	if (start > 0) {
+		my_off_t	prev = start > DS_LOCAL_WRITEBACK_WINDOW
+			? start - DS_LOCAL_WRITEBACK_WINDOW : 0;
+
+		sync_file_range(local_file->fd, prev, start - prev,
+				SYNC_FILE_RANGE_WAIT_BEFORE
+				| SYNC_FILE_RANGE_WRITE
+				| SYNC_FILE_RANGE_WAIT_AFTER);
+		posix_fadvise(local_file->fd, prev, start - prev,
+			      POSIX_FADV_DONTNEED);
+	}
+#else
+	posix_fadvise(local_file->fd, start, end - start,
+		      POSIX_FADV_DONTNEED);
+#endif
+
+	local_file->wb_offset = end;
+}
+
+/************************************************************************
+Write data through the aligned buffer of a writer thread. Only whole
+multiples of DS_LOCAL_DIRECT_ALIGN are written, the rest is kept in the
+tail buffer of the file until more data arrives or the file is closed.
+@return 0 on success, 1 on error. */
+static
+int
+local_write_direct(ds_local_writer_t *writer, ds_local_file_t *local_file,
+		   const char *buf, size_t len)
+{
+	while (local_file->tail_len + len >= DS_LOCAL_DIRECT_ALIGN) {
+		size_t	n;
+		size_t	copy;
+
+		n = (local_file->tail_len + len) & ~(DS_LOCAL_DIRECT_ALIGN - 1);
+		if (n > DS_LOCAL_DIRECT_BUF_SIZE) {
+			n = DS_LOCAL_DIRECT_BUF_SIZE;
+		}
+		copy = n - local_file->tail_len;
+
+		memcpy(writer->buf, local_file->tail, local_file->tail_len);
+		memcpy(writer->buf + local_file->tail_len, buf, copy);
+
+		if (my_pwrite(local_file->fd, (uchar *) writer->buf, n,
+			      local_file->offset, MYF(MY_WME | MY_NABP))) {
+			return 1;
+		}
+
+		local_file->offset += n;
+		local_file->tail_len = 0;
+		buf += copy;
+		len -= copy;
+	}
+
+	memcpy(local_file->tail + local_file->tail_len, buf, len);
+	local_file->tail_len += len;
+
+	return 0;
+}
+
+/************************************************************************
+Write the remaining data of a file and close it. Durability is deferred to
+local_deinit(), except on systems without syncfs().
+@return 0 on success, 1 on error. */
+static
+int
+local_writer_close(ds_local_file_t *local_file)
+{
+	int	ret = 0;
+
+#ifdef O_DIRECT
+	if (local_file->direct) {
+		/* The tail is not aligned, write it through the page cache */
+		if (local_file->tail_len > 0
+		    && (fcntl(local_file->fd, F_SETFL,
+			      fcntl(local_file->fd, F_GETFL) & ~O_DIRECT)
+			|| my_pwrite(local_file->fd, (uchar *) local_file->tail,
+				     local_file->tail_len, local_file->offset,
+				     MYF(MY_WME | MY_NABP)))) {
+			ret = 1;
+		}
+		my_free(local_file->tail);
+	} else
+#endif
+	{
+		local_writeback(local_file, TRUE);
+	}
+
+#ifndef SYS_syncfs
+	if (my_sync(local_file->fd, MYF(MY_WME))) {
+		ret = 1;
+	}
+#endif
+
+	if (my_close(local_file->fd, MYF(MY_WME))) {
+		ret = 1;
+	}
+
+	return ret;
+}
+
+/************************************************************************
+Writer thread. Writes the queued data to the files assigned to it. */
+static
+void *
+local_writer_thread_func(void *arg)
+{
+	ds_local_writer_t	*writer = (ds_local_writer_t *) arg;
+	ds_local_ctxt_t		*local_ctxt = writer->local_ctxt;
+
+	pthread_mutex_lock(&local_ctxt->mutex);
+
+	while (1) {
+		ds_local_req_t	*req;
+		ds_local_file_t	*local_file;
+		int		err = 0;
+
+		while (writer->first == NULL && !local_ctxt->shutdown) {
+			pthread_cond_wait(&writer->cond, &local_ctxt->mutex);
+		}
+
+		req = writer->first;
+		if (req == NULL) {
+			break;
+		}
+
+		writer->first = req->next;
+		if (writer->first == NULL) {
+			writer->last = NULL;
+		}
+		writer->busy = TRUE;
+
+		pthread_mutex_unlock(&local_ctxt->mutex);
+
+		local_file = (ds_local_file_t *) req->file->ptr;
+
+		/* Skip writing after an error, but still close the files */
+		if (!local_ctxt->failed && req->len > 0) {
+			if (local_file->direct) {
+				err = local_write_direct(writer, local_file,
+							 (char *) (req + 1),
+							 req->len);
+			} else if (my_pwrite(local_file->fd,
+					     (uchar *) (req + 1), req->len,
+					     local_file->offset,
+					     MYF(MY_WME | MY_NABP))) {
+				err = 1;
+			} else {
+				local_file->offset += req->len;
+				local_writeback(local_file, FALSE);
+			}
+		}
+
+		if (req->close) {
+			if (local_writer_close(local_file)) {
+				err = 1;
+			}
+		}
+
+		if (err) {
+			msg("local: failed to write to '%s'.\n",
+			    req->file->path);
+		}
+
+		pthread_mutex_lock(&local_ctxt->mutex);
+
+		if (err) {
+			local_ctxt->failed = TRUE;
+		}
+		local_ctxt->queued -= req->len;
+		local_ctxt->bytes_out += req->len;
+		writer->busy = FALSE;
+		pthread_cond_broadcast(&local_ctxt->space_cond);
+
+		if (req->close) {
+			my_free(req->file);
+		}
+		xb_arena_free(req);
+	}
+
+	pthread_mutex_unlock(&local_ctxt->mutex);
+
+	return NULL;
+}
+
+/************************************************************************
+Make the files written by the writer threads durable.
+@return 0 on success, 1 on error. */
+static
+int
+local_sync_all(ds_ctxt_t *ctxt)
+{
+#ifdef SYS_syncfs
+	File	fd;
+	int	ret = 0;
+
+	fd = my_open(ctxt->root, O_RDONLY, MYF(MY_WME));
+	if (fd < 0) {
+		return 1;
+	}
+
+	if (syscall(SYS_syncfs, fd)) {
+		msg("local: syncfs() failed for '%s': errno = %d\n",
+		    ctxt->root, errno);
+		ret = 1;
+	}
+
+	my_close(fd, MYF(MY_WME));
+
+	return ret;
+#else
+	/* Files are synced by the writer threads when closed */
+	(void) ctxt;
+	return 0;
+#endif
+}
+
 static
 void
 local_deinit(ds_ctxt_t *ctxt)
 {
+	ds_local_ctxt_t	*local_ctxt = (ds_local_ctxt_t *) ctxt->ptr;
+	uint		i;
+
+	if (local_ctxt->n_writers > 0) {
+		pthread_mutex_lock(&local_ctxt->mutex);
+		local_ctxt->shutdown = TRUE;
+		for (i = 0; i < local_ctxt->n_writers; i++) {
+			pthread_cond_signal(&local_ctxt->writers[i].cond);
+		}
+		pthread_mutex_unlock(&local_ctxt->mutex);
+
+		for (i = 0; i < local_ctxt->n_writers; i++) {
+			ds_local_writer_t *writer = local_ctxt->writers + i;
+
+			pthread_join(writer->id, NULL);
+			pthread_cond_destroy(&writer->cond);
+			xb_arena_free(writer->buf_base);
+		}
+
+		if (!local_ctxt->failed && local_sync_all(ctxt)) {
+			local_ctxt->failed = TRUE;
+		}
+	}
+
+	if (local_ctxt->failed) {
+		/* Errors of background writes cannot be returned to the
+		callers of ds_write() and ds_close() anymore */
+		msg("local: failed to write files to '%s'.\n", ctxt->root);
+		exit(EXIT_FAILURE);
+	}
+
+	my_free(local_ctxt->writers);
+	pthread_cond_destroy(&local_ctxt->space_cond);
+	pthread_mutex_destroy(&local_ctxt->mutex);
+
 	my_free(ctxt->root);
 	my_free(ctxt);
 }
+
+static
+void
+local_get_stats(ds_ctxt_t *ctxt, ds_stats_t *stats)
+{
+	ds_local_ctxt_t	*local_ctxt = (ds_local_ctxt_t *) ctxt->ptr;
+	uint		i;
+
+	stats->name = "local";
+	stats->bytes_in = local_ctxt->bytes_in;
+	stats->bytes_out = local_ctxt->bytes_out;
+	stats->bytes_pending = local_ctxt->queued;
+	stats->workers = local_ctxt->n_writers;
+
+	for (i = 0; i < local_ctxt->n_writers; i++) {
+		if (local_ctxt->writers[i].busy) {
+			stats->busy_workers++;
+		}
+	}
+}
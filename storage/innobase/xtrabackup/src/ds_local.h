@@ -23,6 +23,36 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 #include "datasink.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 extern datasink_t datasink_local;
 
+/* Write modes of the local datasink */
+typedef enum {
+	/* Write files synchronously and fsync() each file when closed */
+	DS_LOCAL_FSYNC,
+	/* Queue writes to writer threads, start writeback of the written
+	data incrementally and sync all files when the datasink is
+	destroyed */
+	DS_LOCAL_WRITE_BEHIND,
+	/* Like DS_LOCAL_WRITE_BEHIND, but write through aligned O_DIRECT
+	buffers */
+	DS_LOCAL_DIRECT
+} ds_local_mode_t;
+
+/************************************************************************
+Set the write mode of a local datasink. Must be called before any file is
+opened. In the background modes, up to queue_size bytes of written data are
+queued for n_threads writer threads, and errors are reported by subsequent
+calls or when the datasink is destroyed.
+@return 0 on success, 1 on error. */
+int ds_local_set_mode(ds_ctxt_t *ctxt, ds_local_mode_t mode, uint n_threads,
+		      size_t queue_size);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -0,0 +1,437 @@
+/******************************************************
+Copyright (c) 2013 Percona LLC and/or its affiliates.
+
+Spooling datasink for XtraBackup.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*******************************************************/
+
+/* Lets multiple threads write files to a destination datasink that can only
+write one file at a time, such as the 'tar' archive datasink.
+
+Each file is spooled to a memory buffer of a fixed size first. When the
+buffer is full, the file either takes over the destination datasink if no
+other file is using it, and then writes through until it is closed, or
+spills the buffered data to a temporary file and continues spooling. Files
+that are completely spooled are emitted to the destination datasink in one
+piece when closed. */
+
+#include <my_base.h>
+#include "common.h"
+#include "datasink.h"
+#include "ds_spool.h"
+#include "ds_tmpfile.h"
+#include "buf_arena.h"
+
+#define DS_DEFAULT_SPOOL_SIZE (16 * 1024 * 1024)
+
+typedef struct {
+	pthread_mutex_t	 mutex;		/* serializes access to the
+					destination datasink */
+	size_t		 spool_size;	/* memory buffer size per file */
+	pthread_mutex_t	 stats_mutex;	/* protects the counters below */
+	ulonglong	 bytes_in;
+	ulonglong	 bytes_out;
+	ulonglong	 bytes_pending;
+	uint		 n_spilled;	/* files spilled to temporary
+					files */
+	uint		 n_written_through; /* files that took over the
+					destination datasink */
+} ds_spool_ctxt_t;
+
+typedef struct {
+	ds_ctxt_t	*ctxt;
+	char		*path;
+	MY_STAT		 mystat;
+	char		*buf;		/* memory spool */
+	size_t		 pos;
+	File		 fd;		/* spill file or -1 */
+	ulonglong	 spilled;	/* bytes in the spill file */
+	ds_file_t	*dst_file;	/* set when writing through */
+} ds_spool_file_t;
+
+static ds_ctxt_t *spool_init(const char *root);
+static ds_file_t *spool_open(ds_ctxt_t *ctxt, const char *path,
+			     MY_STAT *mystat);
+static int spool_write(ds_file_t *file, const void *buf, size_t len);
+static int spool_close(ds_file_t *file);
+static void spool_deinit(ds_ctxt_t *ctxt);
+static void spool_get_stats(ds_ctxt_t *ctxt, ds_stats_t *stats);
+static int spool_spill(ds_spool_file_t *spool_file);
+
+datasink_t datasink_spool = {
+	&spool_init,
+	&spool_open,
+	&spool_write,
+	&spool_close,
+	&spool_deinit,
+	&spool_get_stats
+};
+
+/* Change the size of the memory buffer used for each file */
+void
+ds_spool_set_size(ds_ctxt_t *ctxt, size_t size)
+{
+	ds_spool_ctxt_t *spool_ctxt = (ds_spool_ctxt_t *) ctxt->ptr;
+
+	spool_ctxt->spool_size = size;
+}
+
+/* Update the statistics counters, 'pending' may be negative */
+static
+void
+spool_account(ds_spool_ctxt_t *spool_ctxt, ulonglong in, ulonglong out,
+	      longlong pending)
+{
+	pthread_mutex_lock(&spool_ctxt->stats_mutex);
+	spool_ctxt->bytes_in += in;
+	spool_ctxt->bytes_out += out;
+	spool_ctxt->bytes_pending += pending;
+	pthread_mutex_unlock(&spool_ctxt->stats_mutex);
+}
+
+static ds_ctxt_t *
+spool_init(const char *root)
+{
+	ds_ctxt_t		*ctxt;
+	ds_spool_ctxt_t		*spool_ctxt;
+
+	ctxt = my_malloc(sizeof(ds_ctxt_t) + sizeof(ds_spool_ctxt_t),
+			 MYF(MY_FAE | MY_ZEROFILL));
+	spool_ctxt = (ds_spool_ctxt_t *) (ctxt + 1);
+	spool_ctxt->spool_size = DS_DEFAULT_SPOOL_SIZE;
+
+	if (pthread_mutex_init(&spool_ctxt->mutex, NULL)) {
+		my_free(ctxt);
+		return NULL;
+	}
+	if (pthread_mutex_init(&spool_ctxt->stats_mutex, NULL)) {
+		pthread_mutex_destroy(&spool_ctxt->mutex);
+		my_free(ctxt);
+		return NULL;
+	}
+
+	ctxt->ptr = spool_ctxt;
+	ctxt->root = my_strdup(root, MYF(MY_FAE));
+
+	return ctxt;
+}
+
+static ds_file_t *
+spool_open(ds_ctxt_t *ctxt, const char *path, MY_STAT *mystat)
+{
+	ds_spool_ctxt_t		*spool_ctxt;
+	ds_spool_file_t		*spool_file;
+	ds_file_t		*file;
+	size_t			 path_len;
+
+	xb_a(ctxt->pipe_ctxt != NULL);
+
+	spool_ctxt = (ds_spool_ctxt_t *) ctxt->ptr;
+
+	path_len = strlen(path) + 1;
+
+	file = (ds_file_t *) my_malloc(sizeof(ds_file_t) +
+				       sizeof(ds_spool_file_t) + path_len,
+				       MYF(MY_FAE));
+	spool_file = (ds_spool_file_t *) (file + 1);
+
+	/* Save a copy of 'path', since the file is only opened in the
+	destination datasink later */
+	spool_file->path = (char *) (spool_file + 1);
+	memcpy(spool_file->path, path, path_len);
+	memcpy(&spool_file->mystat, mystat, sizeof(MY_STAT));
+
+	spool_file->ctxt = ctxt;
+	spool_file->buf = (char *) xb_arena_alloc(spool_ctxt->spool_size);
+	spool_file->pos = 0;
+	spool_file->fd = -1;
+	spool_file->spilled = 0;
+	spool_file->dst_file = NULL;
+
+	file->path = spool_file->path;
+	file->ptr = spool_file;
+
+	return file;
+}
+
+/************************************************************************
+Copy the spill file of 'spool_file' to its destination file. */
+static int
+spool_copy_spilled(ds_spool_file_t *spool_file)
+{
+	ds_spool_ctxt_t	*spool_ctxt;
+	size_t		 bytes;
+
+	spool_ctxt = (ds_spool_ctxt_t *) spool_file->ctxt->ptr;
+
+	posix_fadvise(spool_file->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	if (my_seek(spool_file->fd, 0, SEEK_SET, MYF(0)) ==
+	    MY_FILEPOS_ERROR) {
+		msg("error: my_seek() failed for the spill file of '%s', "
+		    "errno = %d.\n", spool_file->path, my_errno);
+		return 1;
+	}
+
+	/* The memory spool is empty after spilling, reuse it for copying */
+	xb_ad(spool_file->pos == 0);
+
+	while ((bytes = my_read(spool_file->fd, (uchar *) spool_file->buf,
+				spool_ctxt->spool_size, MYF(MY_WME))) > 0) {
+		if (bytes == (size_t) -1) {
+			return 1;
+		}
+		posix_fadvise(spool_file->fd, 0, 0, POSIX_FADV_DONTNEED);
+		if (ds_write(spool_file->dst_file, spool_file->buf, bytes)) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/************************************************************************
+Open 'spool_file' in the destination datasink and write everything spooled
+so far to it. Must be called with the destination datasink mutex held.
+@return 0 on success, 1 on error. */
+static int
+spool_emit(ds_spool_file_t *spool_file, MY_STAT *mystat)
+{
+	ds_spool_ctxt_t	*spool_ctxt;
+	ulonglong	 bytes;
+
+	spool_ctxt = (ds_spool_ctxt_t *) spool_file->ctxt->ptr;
+
+	spool_file->dst_file = ds_open(spool_file->ctxt->pipe_ctxt,
+				       spool_file->path, mystat);
+	if (spool_file->dst_file == NULL) {
+		msg("error: could not stream '%s'\n", spool_file->path);
+		return 1;
+	}
+
+	bytes = spool_file->spilled + spool_file->pos;
+
+	if (spool_file->fd >= 0) {
+		/* Append the memory spool to the spill file, so that the
+		buffer can be used for copying */
+		if ((spool_file->pos > 0 && spool_spill(spool_file)) ||
+		    spool_copy_spilled(spool_file)) {
+			return 1;
+		}
+		my_close(spool_file->fd, MYF(MY_WME));
+		spool_file->fd = -1;
+	}
+
+	if (spool_file->pos > 0 &&
+	    ds_write(spool_file->dst_file, spool_file->buf, spool_file->pos)) {
+		return 1;
+	}
+
+	spool_account(spool_ctxt, 0, bytes, -(longlong) bytes);
+
+	spool_file->spilled = 0;
+	spool_file->pos = 0;
+
+	return 0;
+}
+
+/************************************************************************
+Move the memory spool of 'spool_file' to its spill file, creating it if
+necessary. Code for creating the file copied from ds_tmpfile.c.
+@return 0 on success, 1 on error. */
+static int
+spool_spill(ds_spool_file_t *spool_file)
+{
+	ds_spool_ctxt_t	*spool_ctxt;
+
+	spool_ctxt = (ds_spool_ctxt_t *) spool_file->ctxt->ptr;
+
+	if (spool_file->fd < 0) {
+		char	tmp_path[FN_REFLEN];
+		File	fd;
+
+		fd = create_temp_file(tmp_path,
+				      my_tmpdir(&mysql_tmpdir_list),
+				      "xbspool",
+#ifdef __WIN__
+				      O_BINARY | O_TRUNC | O_SEQUENTIAL |
+				      O_TEMPORARY | O_SHORT_LIVED |
+#endif /* __WIN__ */
+				      O_CREAT | O_EXCL | O_RDWR,
+				      MYF(MY_WME));
+		if (fd < 0) {
+			return 1;
+		}
+#ifndef __WIN__
+		unlink(tmp_path);
+#endif /* !__WIN__ */
+
+		spool_file->fd = fd;
+
+		pthread_mutex_lock(&spool_ctxt->stats_mutex);
+		spool_ctxt->n_spilled++;
+		pthread_mutex_unlock(&spool_ctxt->stats_mutex);
+	}
+
+	if (my_write(spool_file->fd, (uchar *) spool_file->buf,
+		     spool_file->pos, MYF(MY_WME | MY_NABP))) {
+		return 1;
+	}
+	posix_fadvise(spool_file->fd, 0, 0, POSIX_FADV_DONTNEED);
+
+	spool_file->spilled += spool_file->pos;
+	spool_file->pos = 0;
+
+	return 0;
+}
+
+static int
+spool_write(ds_file_t *file, const void *buf, size_t len)
+{
+	ds_spool_file_t	*spool_file;
+	ds_spool_ctxt_t	*spool_ctxt;
+
+	spool_file = (ds_spool_file_t *) file->ptr;
+	spool_ctxt = (ds_spool_ctxt_t *) spool_file->ctxt->ptr;
+
+	while (len > 0) {
+		size_t	bytes;
+
+		if (spool_file->dst_file != NULL) {
+			/* Writing through */
+			if (ds_write(spool_file->dst_file, buf, len)) {
+				return 1;
+			}
+			spool_account(spool_ctxt, len, len, 0);
+			break;
+		}
+
+		if (spool_file->pos == spool_ctxt->spool_size) {
+			/* The memory spool is full. Take over the
+			destination datasink if it is free, spill to disk
+			otherwise. The archive header is written with the
+			size known when the file was opened. */
+			if (pthread_mutex_trylock(&spool_ctxt->mutex) == 0) {
+				if (spool_emit(spool_file,
+					       &spool_file->mystat)) {
+					if (spool_file->dst_file == NULL) {
+						pthread_mutex_unlock(
+							&spool_ctxt->mutex);
+					}
+					return 1;
+				}
+
+				pthread_mutex_lock(&spool_ctxt->stats_mutex);
+				spool_ctxt->n_written_through++;
+				pthread_mutex_unlock(&spool_ctxt->stats_mutex);
+			} else if (spool_spill(spool_file)) {
+				return 1;
+			}
+			continue;
+		}
+
+		bytes = spool_ctxt->spool_size - spool_file->pos;
+		if (bytes > len) {
+			bytes = len;
+		}
+
+		memcpy(spool_file->buf + spool_file->pos, buf, bytes);
+		spool_file->pos += bytes;
+		spool_account(spool_ctxt, bytes, 0, bytes);
+
+		buf = (const char *) buf + bytes;
+		len -= bytes;
+	}
+
+	return 0;
+}
+
+static int
+spool_close(ds_file_t *file)
+{
+	ds_spool_file_t	*spool_file;
+	ds_spool_ctxt_t	*spool_ctxt;
+	int		 rc = 0;
+
+	spool_file = (ds_spool_file_t *) file->ptr;
+	spool_ctxt = (ds_spool_ctxt_t *) spool_file->ctxt->ptr;
+
+	if (spool_file->dst_file == NULL) {
+		MY_STAT	mystat;
+
+		/* The whole file is spooled, emit it with its actual
+		size */
+		memcpy(&mystat, &spool_file->mystat, sizeof(MY_STAT));
+		mystat.st_size = spool_file->spilled + spool_file->pos;
+
+		pthread_mutex_lock(&spool_ctxt->mutex);
+		rc = spool_emit(spool_file, &mystat);
+	}
+
+	if (spool_file->dst_file != NULL && ds_close(spool_file->dst_file)) {
+		rc = 1;
+	}
+
+	pthread_mutex_unlock(&spool_ctxt->mutex);
+
+	if (spool_file->fd >= 0) {
+		my_close(spool_file->fd, MYF(MY_WME));
+	}
+
+	xb_arena_free(spool_file->buf);
+	my_free(file);
+
+	return rc;
+}
+
+static void
+spool_deinit(ds_ctxt_t *ctxt)
+{
+	ds_spool_ctxt_t	*spool_ctxt;
+
+	spool_ctxt = (ds_spool_ctxt_t *) ctxt->ptr;
+
+	if (spool_ctxt->n_spilled > 0) {
+		msg("xtrabackup: %u files were spilled to temporary files "
+		    "while waiting for the stream.\n", spool_ctxt->n_spilled);
+	}
+
+	if (spool_ctxt->n_written_through > 0) {
+		msg("xtrabackup: %u files were written directly to the "
+		    "stream.\n", spool_ctxt->n_written_through);
+	}
+
+	pthread_mutex_destroy(&spool_ctxt->stats_mutex);
+	pthread_mutex_destroy(&spool_ctxt->mutex);
+
+	my_free(ctxt->root);
+	my_free(ctxt);
+}
+
+static void
+spool_get_stats(ds_ctxt_t *ctxt, ds_stats_t *stats)
+{
+	ds_spool_ctxt_t	*spool_ctxt;
+
+	spool_ctxt = (ds_spool_ctxt_t *) ctxt->ptr;
+
+	stats->name = "spool";
+
+	pthread_mutex_lock(&spool_ctxt->stats_mutex);
+	stats->bytes_in = spool_ctxt->bytes_in;
+	stats->bytes_out = spool_ctxt->bytes_out;
+	stats->bytes_pending = spool_ctxt->bytes_pending;
+	pthread_mutex_unlock(&spool_ctxt->stats_mutex);
+}
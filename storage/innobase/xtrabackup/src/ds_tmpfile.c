@@ -36,6 +36,7 @@ typedef struct {
 	char		*orig_path;
 	MY_STAT		 mystat;
 	ds_file_t	*file;
+	ulonglong	 bytes;
 } ds_tmp_file_t;
 
 static ds_ctxt_t *tmpfile_init(const char *root);
@@ -44,13 +45,15 @@ static ds_file_t *tmpfile_open(ds_ctxt_t *ctxt, const char *path,
 static int tmpfile_write(ds_file_t *file, const void *buf, size_t len);
 static int tmpfile_close(ds_file_t *file);
 static void tmpfile_deinit(ds_ctxt_t *ctxt);
+static void tmpfile_get_stats(ds_ctxt_t *ctxt, ds_stats_t *stats);
 
 datasink_t datasink_tmpfile = {
 	&tmpfile_init,
 	&tmpfile_open,
 	&tmpfile_write,
 	&tmpfile_close,
-	&tmpfile_deinit
+	&tmpfile_deinit,
+	&tmpfile_get_stats
 };
 
 MY_TMPDIR mysql_tmpdir_list;
@@ -125,6 +128,7 @@ tmpfile_open(ds_ctxt_t *ctxt, const char *path,
 	tmp_file->orig_path = (char *) tmp_file + sizeof(ds_tmp_file_t);
 
 	tmp_file->fd = fd;
+	tmp_file->bytes = 0;
 	memcpy(tmp_file->orig_path, path, path_len);
 
 	/* Store the real temporary file name in file->path */
@@ -146,10 +150,12 @@ tmpfile_open(ds_ctxt_t *ctxt, const char *path,
 static int
 tmpfile_write(ds_file_t *file, const void *buf, size_t len)
 {
-	File fd = ((ds_tmp_file_t *) file->ptr)->fd;
+	ds_tmp_file_t	*tmp_file = (ds_tmp_file_t *) file->ptr;
+	File		 fd = tmp_file->fd;
 
 	if (!my_write(fd, buf, len, MYF(MY_WME | MY_NABP))) {
 		posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		tmp_file->bytes += len;
 		return 0;
 	}
 
@@ -243,3 +249,26 @@ tmpfile_deinit(ds_ctxt_t *ctxt)
 	my_free(ctxt->root);
 	my_free(ctxt);
 }
+
+/* All data written to temporary files stays queued until tmpfile_deinit()
+pipes it to the destination datasink. */
+static void
+tmpfile_get_stats(ds_ctxt_t *ctxt, ds_stats_t *stats)
+{
+	ds_tmpfile_ctxt_t	*tmpfile_ctxt;
+	LIST			*list;
+
+	tmpfile_ctxt = (ds_tmpfile_ctxt_t *) ctxt->ptr;
+
+	stats->name = "tmpfile";
+
+	pthread_mutex_lock(&tmpfile_ctxt->mutex);
+	for (list = tmpfile_ctxt->file_list; list != NULL;
+	     list = list_rest(list)) {
+		ds_tmp_file_t	*tmp_file = (ds_tmp_file_t *) list->data;
+
+		stats->bytes_in += tmp_file->bytes;
+		stats->bytes_pending += tmp_file->bytes;
+	}
+	pthread_mutex_unlock(&tmpfile_ctxt->mutex);
+}
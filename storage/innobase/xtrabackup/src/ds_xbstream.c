@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include "common.h"
 #include "datasink.h"
 #include "xbstream.h"
+#include "ds_xbstream.h"
 
 typedef struct {
 	xb_wstream_t	*xbstream;
@@ -99,6 +100,14 @@ err:
 	return NULL;
 }
 
+int
+ds_xbstream_set_lock(ds_ctxt_t *ctxt, int fd)
+{
+	ds_stream_ctxt_t	*stream_ctxt = (ds_stream_ctxt_t *) ctxt->ptr;
+
+	return xb_stream_write_set_lock(stream_ctxt->xbstream, fd);
+}
+
 static
 ds_file_t *
 xbstream_open(ds_ctxt_t *ctxt, const char *path, MY_STAT *mystat)
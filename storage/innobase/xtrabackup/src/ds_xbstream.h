@@ -23,6 +23,19 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 #include "datasink.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 extern datasink_t datasink_xbstream;
 
+/* Lock 'fd' around every chunk written to the stream, so that other processes
+can write to the same output concurrently. Returns non-zero if 'fd' cannot be
+locked. */
+int ds_xbstream_set_lock(ds_ctxt_t *ctxt, int fd);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
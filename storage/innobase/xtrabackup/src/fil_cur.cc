@@ -33,6 +33,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include "common.h"
 #include "read_filt.h"
 #include "xtrabackup.h"
+#include "buf_arena.h"
 
 /* Size of read buffer in pages */
 #define XB_FIL_CUR_PAGES 64
@@ -46,7 +47,6 @@ For user tablespaces both "./database/table.ibd" and
 
 For system tablepsaces (i.e. When is_system is TRUE) both "/remote/dir/ibdata1"
 and "./ibdata1" yield "ibdata1" in the output. */
-static
 const char *
 xb_get_relative_path(
 /*=================*/
@@ -146,6 +146,7 @@ xb_fil_cur_open(
 	in case of error */
 	cursor->orig_buf = NULL;
 	cursor->node = NULL;
+	cursor->extent_lsn = NULL;
 
 	cursor->space_id = node->space->id;
 	cursor->is_system = !fil_is_user_tablespace_id(node->space->id);
@@ -201,6 +202,10 @@ xb_fil_cur_open(
 	cursor->node = node;
 	cursor->file = node->handle;
 
+	/* Remember when the copy started, before the file attributes are
+	read, for the LSN summary */
+	cursor->open_time = time(NULL);
+
 	if (my_fstat(cursor->file, &cursor->statinfo, MYF(MY_WME))) {
 		msg("[%02u] xtrabackup: error: cannot stat %s\n",
 		    thread_n, cursor->abs_path);
@@ -244,7 +249,7 @@ xb_fil_cur_open(
 	/* Allocate read buffer */
 	cursor->buf_size = XB_FIL_CUR_PAGES * page_size;
 	cursor->orig_buf = static_cast<byte *>
-		(ut_malloc(cursor->buf_size + UNIV_PAGE_SIZE));
+		(xb_arena_alloc(cursor->buf_size + UNIV_PAGE_SIZE));
 	cursor->buf = static_cast<byte *>
 		(ut_align(cursor->orig_buf, UNIV_PAGE_SIZE));
 
@@ -256,6 +261,17 @@ xb_fil_cur_open(
 
 	cursor->space_size = cursor->statinfo.st_size / page_size;
 
+	/* Collect the max page LSN per extent when taking a backup */
+	cursor->n_extents = (cursor->space_size + FSP_EXTENT_SIZE - 1)
+		/ FSP_EXTENT_SIZE;
+	if (srv_backup_mode) {
+		cursor->extent_lsn = static_cast<lsn_t *>
+			(ut_malloc(ut_max(cursor->n_extents, 1)
+				   * sizeof(lsn_t)));
+		memset(cursor->extent_lsn, 0,
+		       ut_max(cursor->n_extents, 1) * sizeof(lsn_t));
+	}
+
 	cursor->read_filter = read_filter;
 	cursor->read_filter->init(&cursor->read_filter_ctxt, cursor,
 				  node->space->id);
@@ -357,6 +373,20 @@ read_retry:
 		cursor->buf_npages++;
 	}
 
+	if (cursor->extent_lsn != NULL) {
+		for (page = cursor->buf, i = 0; i < cursor->buf_npages;
+		     page += cursor->page_size, i++) {
+			ulint	extent = (cursor->buf_page_no + i)
+				/ FSP_EXTENT_SIZE;
+			lsn_t	lsn = mach_read_from_8(page + FIL_PAGE_LSN);
+
+			if (extent < cursor->n_extents
+			    && lsn > cursor->extent_lsn[extent]) {
+				cursor->extent_lsn[extent] = lsn;
+			}
+		}
+	}
+
 	posix_fadvise(cursor->file, 0, 0, POSIX_FADV_DONTNEED);
 
 	return(ret);
@@ -373,7 +403,11 @@ xb_fil_cur_close(
 	cursor->read_filter->deinit(&cursor->read_filter_ctxt);
 
 	if (cursor->orig_buf != NULL) {
-		ut_free(cursor->orig_buf);
+		xb_arena_free(cursor->orig_buf);
+	}
+	if (cursor->extent_lsn != NULL) {
+		ut_free(cursor->extent_lsn);
+		cursor->extent_lsn = NULL;
 	}
 	if (cursor->node != NULL) {
 		xb_fil_node_close_file(cursor->node);
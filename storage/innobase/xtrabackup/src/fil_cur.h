@@ -61,6 +61,10 @@ struct xb_fil_cur_t {
 	uint		thread_n;	/*!< thread number for diagnostics */
 	ulint		space_id;	/*!< ID of tablespace */
 	ulint		space_size;	/*!< space size in pages */
+	time_t		open_time;	/*!< time the file was opened */
+	lsn_t*		extent_lsn;	/*!< max LSN of the pages read per
+					extent, for the LSN summary, or NULL */
+	ulint		n_extents;	/*!< size of extent_lsn[] */
 };
 
 typedef enum {
@@ -70,6 +74,18 @@ typedef enum {
 	XB_FIL_CUR_EOF
 } xb_fil_cur_result_t;
 
+/***********************************************************************
+Extracts the relative path ("database/table.ibd") of a tablespace from a
+specified possibly absolute path. */
+const char *
+xb_get_relative_path(
+/*=================*/
+	const char*	path,		/*!< in: tablespace path (either
+			  		relative or absolute) */
+	ibool		is_system);	/*!< in: TRUE for system tablespaces,
+					i.e. when only the filename must be
+					returned. */
+
 /************************************************************************
 Open a source file cursor and initialize the associated read filter.
 
@@ -0,0 +1,430 @@
+/******************************************************
+XtraBackup: hot backup tool for InnoDB
+(c) 2009-2013 Percona LLC and/or its affiliates.
+Originally Created 3/3/2009 Yasufumi Kinoshita
+Written by Alexey Kopytov, Aleksandr Kuzminsky, Stewart Smith, Vadim Tkachenko,
+Yasufumi Kinoshita, Ignacio Nin and Baron Schwartz.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*******************************************************/
+
+/* Redo log filter implementation.
+
+The log blocks are written in the order they are copied, but a block is held
+back until all the log records starting in the blocks before it have been
+parsed, because filtering a record may modify every block it spans. The
+records of the excluded tablespaces are overwritten in place with
+MLOG_DUMMY_RECORD bytes, and the checksums of the modified blocks are
+recalculated with the algorithm the block was written with.
+
+The tablespaces excluded by --tables or --tables_file are never opened, so
+their ids are not known. Instead, a page record is filtered out if it belongs
+to a single-table tablespace that is neither being backed up nor has been
+created or renamed while the log was being copied. Log records of file
+operations are always kept. */
+
+#include <my_base.h>
+
+#include <univ.i>
+#include <fil0fil.h>
+#include <log0log.h>
+#include <log0recv.h>
+#include <mtr0mtr.h>
+#include <trx0sys.h>
+
+#include "common.h"
+#include "log_filt.h"
+
+/* Log blocks not written yet */
+static byte*		filt_buf = NULL;
+static ulint		filt_buf_len;
+static ulint		filt_buf_size;
+
+/* LSN of the first byte of filt_buf */
+static lsn_t		filt_buf_lsn;
+
+/* Start LSN of the first log record not parsed yet */
+static lsn_t		filt_parse_lsn;
+
+/* Log record data of filt_buf from filt_parse_lsn on, without the log block
+headers and trailers */
+static byte*		filt_rec_buf = NULL;
+static ulint		filt_rec_buf_size;
+
+/* Sorted ids of the tablespaces being backed up, NULL until known */
+static ulint*		filt_space_ids = NULL;
+static ulint		filt_n_space_ids;
+
+/* Ids of the tablespaces created or renamed after the backup started */
+static ulint*		filt_new_space_ids = NULL;
+static ulint		filt_n_new_space_ids;
+static ulint		filt_new_space_ids_size;
+
+/* TRUE if the log could not be parsed and is written unfiltered */
+static ibool		filt_disabled;
+
+/* TRUE if recv_sys was created for parsing */
+static ibool		filt_created_recv_sys;
+
+/* Statistics */
+static ib_uint64_t	filt_n_recs;
+static ib_uint64_t	filt_n_recs_filtered;
+static ib_uint64_t	filt_n_bytes;
+static ib_uint64_t	filt_n_bytes_filtered;
+
+/****************************************************************//**
+Initialize the redo log filter. The first log block to be written must be the
+one containing 'start_lsn', which must be the start of a log record. */
+void
+xb_log_filt_init(
+/*=============*/
+	lsn_t	start_lsn)	/*!< in: LSN to start parsing at */
+{
+	filt_buf_len = 0;
+	filt_buf_size = 0;
+	filt_buf_lsn = ut_uint64_align_down(start_lsn, OS_FILE_LOG_BLOCK_SIZE);
+	filt_parse_lsn = start_lsn;
+	filt_rec_buf_size = 0;
+	filt_n_space_ids = 0;
+	filt_n_new_space_ids = 0;
+	filt_new_space_ids_size = 0;
+	filt_disabled = FALSE;
+	filt_n_recs = filt_n_recs_filtered = 0;
+	filt_n_bytes = filt_n_bytes_filtered = 0;
+
+	/* The log record parser reports corruption in recv_sys */
+	filt_created_recv_sys = (recv_sys == NULL);
+	recv_sys_create();
+}
+
+/****************************************************************//**
+Compare two space ids for qsort() and bsearch(). */
+static
+int
+xb_log_filt_cmp_space_id(
+/*=====================*/
+	const void*	a,	/*!< in: space id */
+	const void*	b)	/*!< in: space id */
+{
+	ulint	id_a = *static_cast<const ulint*>(a);
+	ulint	id_b = *static_cast<const ulint*>(b);
+
+	return(id_a < id_b ? -1 : (id_a > id_b ? 1 : 0));
+}
+
+/****************************************************************//**
+Set the single-table tablespaces being backed up. Until this is called, all
+log records are kept. The caller must not hold log_sys->mutex. */
+void
+xb_log_filt_set_included(
+/*=====================*/
+	ulint*	space_ids,	/*!< in: space ids, the array is owned by
+				the filter after this call */
+	ulint	n_space_ids)	/*!< in: number of space ids */
+{
+	qsort(space_ids, n_space_ids, sizeof(ulint),
+	      xb_log_filt_cmp_space_id);
+
+	mutex_enter(&log_sys->mutex);
+	filt_space_ids = space_ids;
+	filt_n_space_ids = n_space_ids;
+	mutex_exit(&log_sys->mutex);
+}
+
+/****************************************************************//**
+Check if a log record is to be filtered out.
+@return TRUE if the record belongs to an excluded tablespace */
+static
+ibool
+xb_log_filt_is_excluded(
+/*====================*/
+	byte	type,	/*!< in: log record type */
+	ulint	space)	/*!< in: space id */
+{
+	switch (type) {
+	case MLOG_MULTI_REC_END:
+	case MLOG_DUMMY_RECORD:
+	case MLOG_FILE_DELETE:
+		return(FALSE);
+	case MLOG_FILE_CREATE:
+	case MLOG_FILE_CREATE2:
+	case MLOG_FILE_RENAME:
+		/* Keep the records of tablespaces created or renamed during
+		the backup, they may match the filters */
+		if (filt_n_new_space_ids == filt_new_space_ids_size) {
+			filt_new_space_ids_size = 2 * filt_new_space_ids_size
+				+ 16;
+			filt_new_space_ids = static_cast<ulint*>(
+				ut_realloc(filt_new_space_ids,
+					   filt_new_space_ids_size
+					   * sizeof(ulint)));
+		}
+		filt_new_space_ids[filt_n_new_space_ids++] = space;
+		return(FALSE);
+	}
+
+	if (filt_space_ids == NULL || !fil_is_user_tablespace_id(space)) {
+		return(FALSE);
+	}
+
+	if (bsearch(&space, filt_space_ids, filt_n_space_ids, sizeof(ulint),
+		    xb_log_filt_cmp_space_id) != NULL) {
+		return(FALSE);
+	}
+
+	for (ulint i = 0; i < filt_n_new_space_ids; i++) {
+		if (filt_new_space_ids[i] == space) {
+			return(FALSE);
+		}
+	}
+
+	return(TRUE);
+}
+
+/****************************************************************//**
+Overwrite a log record in filt_buf with dummy records and update the
+checksums of the modified log blocks. */
+static
+void
+xb_log_filt_fill_dummy(
+/*===================*/
+	lsn_t	start_lsn,	/*!< in: start LSN of the record */
+	lsn_t	end_lsn)	/*!< in: end LSN of the record */
+{
+	lsn_t	lsn = start_lsn;
+
+	while (lsn < end_lsn) {
+		lsn_t	block_lsn = ut_uint64_align_down(
+			lsn, OS_FILE_LOG_BLOCK_SIZE);
+		byte*	block = filt_buf + (block_lsn - filt_buf_lsn);
+		ulint	start = (ulint) (lsn - block_lsn);
+		ulint	end = OS_FILE_LOG_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE;
+		ulint	checksum = log_block_get_checksum(block);
+		ibool	is_crc32;
+
+		if (start >= end) {
+			lsn = block_lsn + OS_FILE_LOG_BLOCK_SIZE
+				+ LOG_BLOCK_HDR_SIZE;
+			continue;
+		}
+
+		if (end_lsn - lsn < end - start) {
+			end = start + (ulint) (end_lsn - lsn);
+		}
+
+		is_crc32 = (checksum == log_block_calc_checksum_crc32(block));
+
+		memset(block + start, MLOG_DUMMY_RECORD, end - start);
+
+		if (checksum == LOG_NO_CHECKSUM_MAGIC) {
+			/* the block is not checksummed */
+		} else if (is_crc32) {
+			log_block_set_checksum(
+				block, log_block_calc_checksum_crc32(block));
+		} else {
+			log_block_set_checksum(
+				block, log_block_calc_checksum_innodb(block));
+		}
+
+		lsn += end - start;
+	}
+}
+
+/****************************************************************//**
+Copy the log record data from filt_parse_lsn on to filt_rec_buf.
+@return length of the data */
+static
+ulint
+xb_log_filt_gather(void)
+/*====================*/
+{
+	lsn_t	lsn = filt_parse_lsn;
+	ulint	len = 0;
+
+	if (filt_rec_buf_size < filt_buf_len) {
+		filt_rec_buf_size = filt_buf_len;
+		filt_rec_buf = static_cast<byte*>(
+			ut_realloc(filt_rec_buf, filt_rec_buf_size));
+	}
+
+	while (lsn < filt_buf_lsn + filt_buf_len) {
+		lsn_t		block_lsn = ut_uint64_align_down(
+			lsn, OS_FILE_LOG_BLOCK_SIZE);
+		const byte*	block = filt_buf + (block_lsn - filt_buf_lsn);
+		ulint		data_len = log_block_get_data_len(block);
+		ulint		start = (ulint) (lsn - block_lsn);
+		ulint		end = ut_min(data_len, OS_FILE_LOG_BLOCK_SIZE
+					     - LOG_BLOCK_TRL_SIZE);
+
+		if (start < end) {
+			memcpy(filt_rec_buf + len, block + start, end - start);
+			len += end - start;
+		}
+
+		if (data_len < OS_FILE_LOG_BLOCK_SIZE) {
+			/* the end of the log */
+			break;
+		}
+
+		lsn = block_lsn + OS_FILE_LOG_BLOCK_SIZE + LOG_BLOCK_HDR_SIZE;
+	}
+
+	return(len);
+}
+
+/****************************************************************//**
+Parse the complete log records in filt_buf and filter them. */
+static
+void
+xb_log_filt_parse(void)
+/*===================*/
+{
+	ulint	len = xb_log_filt_gather();
+	byte*	ptr = filt_rec_buf;
+	byte*	end_ptr = filt_rec_buf + len;
+
+	while (ptr < end_ptr) {
+		byte	type;
+		ulint	space;
+		ulint	page_no;
+		byte*	body;
+		ulint	rec_len;
+		lsn_t	end_lsn;
+
+		rec_len = recv_parse_log_rec(ptr, end_ptr, &type, &space,
+					     &page_no, &body);
+
+		if (recv_sys->found_corrupt_log) {
+			msg("xtrabackup: warning: cannot parse the log record "
+			    "at lsn " LSN_PF ", the rest of the log is copied "
+			    "unfiltered.\n", filt_parse_lsn);
+			recv_sys->found_corrupt_log = FALSE;
+			filt_disabled = TRUE;
+			return;
+		}
+
+		if (rec_len == 0) {
+			/* incomplete record */
+			break;
+		}
+
+		end_lsn = recv_calc_lsn_on_data_add(filt_parse_lsn, rec_len);
+
+		filt_n_recs++;
+		filt_n_bytes += rec_len;
+
+		if (xb_log_filt_is_excluded(type, space)) {
+			xb_log_filt_fill_dummy(filt_parse_lsn, end_lsn);
+			filt_n_recs_filtered++;
+			filt_n_bytes_filtered += rec_len;
+		}
+
+		filt_parse_lsn = end_lsn;
+		ptr += rec_len;
+	}
+}
+
+/****************************************************************//**
+Filter and write complete log blocks. The blocks must follow the ones
+previously written. The blocks containing an incomplete log record are held
+back until the record is complete, unless 'is_last' is TRUE.
+@return 0 on success, 1 on error */
+int
+xb_log_filt_write(
+/*==============*/
+	ds_file_t*	file,		/*!< in: log file datasink */
+	const byte*	buf,		/*!< in: log blocks */
+	ulint		len,		/*!< in: length, a multiple of
+					OS_FILE_LOG_BLOCK_SIZE */
+	my_bool		is_last)	/*!< in: TRUE if these are the last
+					blocks */
+{
+	ulint	n_write;
+
+	ut_a(len % OS_FILE_LOG_BLOCK_SIZE == 0);
+
+	if (filt_buf_len + len > filt_buf_size) {
+		filt_buf_size = filt_buf_len + len;
+		filt_buf = static_cast<byte*>(
+			ut_realloc(filt_buf, filt_buf_size));
+	}
+
+	memcpy(filt_buf + filt_buf_len, buf, len);
+	filt_buf_len += len;
+
+	if (!filt_disabled) {
+		xb_log_filt_parse();
+	}
+
+	if (is_last || filt_disabled) {
+		n_write = filt_buf_len;
+	} else {
+		/* Write the blocks before the one the next record starts
+		in */
+		lsn_t	keep_lsn = ut_uint64_align_down(
+			filt_parse_lsn, OS_FILE_LOG_BLOCK_SIZE);
+
+		n_write = (ulint) ut_min(keep_lsn - filt_buf_lsn,
+					 filt_buf_len);
+	}
+
+	if (n_write == 0) {
+		return(0);
+	}
+
+	if (ds_write(file, filt_buf, n_write)) {
+		return(1);
+	}
+
+	memmove(filt_buf, filt_buf + n_write, filt_buf_len - n_write);
+	filt_buf_len -= n_write;
+	filt_buf_lsn += n_write;
+
+	return(0);
+}
+
+/****************************************************************//**
+Print the filter statistics and free its resources. */
+void
+xb_log_filt_deinit(void)
+/*====================*/
+{
+	msg("xtrabackup: Redo log filter: %llu of %llu log records, %llu of "
+	    "%llu bytes replaced with dummy records.\n",
+	    (ulonglong) filt_n_recs_filtered, (ulonglong) filt_n_recs,
+	    (ulonglong) filt_n_bytes_filtered, (ulonglong) filt_n_bytes);
+
+	ut_a(filt_buf_len == 0);
+
+	if (filt_buf != NULL) {
+		ut_free(filt_buf);
+		filt_buf = NULL;
+	}
+	if (filt_rec_buf != NULL) {
+		ut_free(filt_rec_buf);
+		filt_rec_buf = NULL;
+	}
+	if (filt_space_ids != NULL) {
+		ut_free(filt_space_ids);
+		filt_space_ids = NULL;
+	}
+	if (filt_new_space_ids != NULL) {
+		ut_free(filt_new_space_ids);
+		filt_new_space_ids = NULL;
+	}
+	if (filt_created_recv_sys) {
+		recv_sys_close();
+	}
+}
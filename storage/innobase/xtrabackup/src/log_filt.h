@@ -0,0 +1,75 @@
+/******************************************************
+XtraBackup: hot backup tool for InnoDB
+(c) 2009-2013 Percona LLC and/or its affiliates.
+Originally Created 3/3/2009 Yasufumi Kinoshita
+Written by Alexey Kopytov, Aleksandr Kuzminsky, Stewart Smith, Vadim Tkachenko,
+Yasufumi Kinoshita, Ignacio Nin and Baron Schwartz.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*******************************************************/
+
+/* Redo log filter interface.
+
+The filter parses the log records copied to xtrabackup_logfile and replaces
+the page records of the tablespaces excluded from a partial backup with
+MLOG_DUMMY_RECORD bytes. The LSN of every remaining record is preserved, as it
+is compared against the page LSNs on recovery. */
+
+#ifndef XB_LOG_FILT_H
+#define XB_LOG_FILT_H
+
+#include <univ.i>
+#include "datasink.h"
+
+/****************************************************************//**
+Initialize the redo log filter. The first log block to be written must be the
+one containing 'start_lsn', which must be the start of a log record. */
+void
+xb_log_filt_init(
+/*=============*/
+	lsn_t	start_lsn);	/*!< in: LSN to start parsing at */
+
+/****************************************************************//**
+Set the single-table tablespaces being backed up. Until this is called, all
+log records are kept. The caller must not hold log_sys->mutex. */
+void
+xb_log_filt_set_included(
+/*=====================*/
+	ulint*	space_ids,	/*!< in: space ids, the array is owned by
+				the filter after this call */
+	ulint	n_space_ids);	/*!< in: number of space ids */
+
+/****************************************************************//**
+Filter and write complete log blocks. The blocks must follow the ones
+previously written. The blocks containing an incomplete log record are held
+back until the record is complete, unless 'is_last' is TRUE.
+@return 0 on success, 1 on error */
+int
+xb_log_filt_write(
+/*==============*/
+	ds_file_t*	file,		/*!< in: log file datasink */
+	const byte*	buf,		/*!< in: log blocks */
+	ulint		len,		/*!< in: length, a multiple of
+					OS_FILE_LOG_BLOCK_SIZE */
+	my_bool		is_last);	/*!< in: TRUE if these are the last
+					blocks */
+
+/****************************************************************//**
+Print the filter statistics and free its resources. */
+void
+xb_log_filt_deinit(void);
+/*====================*/
+
+#endif
@@ -0,0 +1,440 @@
+/******************************************************
+XtraBackup: hot backup tool for InnoDB
+(c) 2009-2013 Percona LLC and/or its affiliates.
+Originally Created 3/3/2009 Yasufumi Kinoshita
+Written by Alexey Kopytov, Aleksandr Kuzminsky, Stewart Smith, Vadim Tkachenko,
+Yasufumi Kinoshita, Ignacio Nin and Baron Schwartz.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*******************************************************/
+
+/* Per-tablespace LSN summary implementation.
+
+The summary file contains two lines per data file:
+
+<space id> <size> <mtime> <inode> <copy start time> <extents> <path>
+<max LSN of extent 0> <max LSN of extent 1> ...
+
+An extent is FSP_EXTENT_SIZE pages. The LSN of an extent whose pages were not
+read (e.g. because of the changed page bitmap) is 0. */
+
+#include <my_base.h>
+#include <fil0fil.h>
+#include <hash0hash.h>
+#include <ut0lst.h>
+#include <m_string.h>
+
+#include "common.h"
+#include "fil_cur.h"
+#include "lsn_summary.h"
+
+/* Summary entry of a data file */
+struct xb_lsn_summary_t {
+	char*		path;		/*!< path relative to the backup root */
+	ulint		space_id;	/*!< tablespace id */
+	ib_uint64_t	size;		/*!< file size when copying started */
+	ib_uint64_t	mtime;		/*!< modification time when copying
+					started */
+	ib_uint64_t	inode;		/*!< inode number */
+	ib_uint64_t	start_time;	/*!< time copying started, the backup
+					chain contains the file contents as of
+					that time */
+	ulint		n_extents;	/*!< size of extent_lsn[] */
+	lsn_t*		extent_lsn;	/*!< max page LSN per extent */
+	hash_node_t	hash;		/*!< hash chain node */
+	UT_LIST_NODE_T(xb_lsn_summary_t) list;
+					/*!< list node */
+};
+
+/* Summary of the base backup, keyed by path */
+static hash_table_t*				base_hash = NULL;
+static UT_LIST_BASE_NODE_T(xb_lsn_summary_t)	base_list;
+
+/* Summary of the current backup */
+static UT_LIST_BASE_NODE_T(xb_lsn_summary_t)	summary_list;
+static os_ib_mutex_t				summary_mutex = NULL;
+
+/****************************************************************//**
+Allocate a summary entry. */
+static
+xb_lsn_summary_t*
+xb_lsn_summary_create(
+/*==================*/
+	const char*	path,		/*!< in: relative path */
+	ulint		n_extents)	/*!< in: number of extents */
+{
+	xb_lsn_summary_t*	entry;
+
+	entry = static_cast<xb_lsn_summary_t*>(ut_malloc(sizeof(*entry)));
+	memset(entry, 0, sizeof(*entry));
+
+	entry->path = static_cast<char*>(ut_malloc(strlen(path) + 1));
+	strcpy(entry->path, path);
+
+	entry->n_extents = n_extents;
+	if (n_extents > 0) {
+		entry->extent_lsn = static_cast<lsn_t*>(
+			ut_malloc(n_extents * sizeof(lsn_t)));
+		memset(entry->extent_lsn, 0, n_extents * sizeof(lsn_t));
+	}
+
+	return(entry);
+}
+
+/****************************************************************//**
+Free a summary entry. */
+static
+void
+xb_lsn_summary_destroy(
+/*===================*/
+	xb_lsn_summary_t*	entry)	/*!< in: entry to free */
+{
+	if (entry->extent_lsn != NULL) {
+		ut_free(entry->extent_lsn);
+	}
+	ut_free(entry->path);
+	ut_free(entry);
+}
+
+/****************************************************************//**
+Find the base backup entry of a data file.
+@return entry or NULL */
+static
+xb_lsn_summary_t*
+xb_lsn_summary_find(
+/*================*/
+	const char*	path)	/*!< in: relative path */
+{
+	xb_lsn_summary_t*	entry;
+
+	if (base_hash == NULL) {
+		return(NULL);
+	}
+
+	HASH_SEARCH(hash, base_hash, ut_fold_string(path),
+		    xb_lsn_summary_t*, entry, (void) 0,
+		    !strcmp(entry->path, path));
+
+	return(entry);
+}
+
+/****************************************************************//**
+Free the summary of the base backup. */
+static
+void
+xb_lsn_summary_free_base(void)
+/*==========================*/
+{
+	xb_lsn_summary_t*	entry;
+
+	while ((entry = UT_LIST_GET_FIRST(base_list)) != NULL) {
+		UT_LIST_REMOVE(list, base_list, entry);
+		xb_lsn_summary_destroy(entry);
+	}
+
+	if (base_hash != NULL) {
+		hash_table_free(base_hash);
+		base_hash = NULL;
+	}
+}
+
+/****************************************************************//**
+Load the summary of the base backup.
+@return TRUE on success, FALSE if the file is missing or malformed. */
+static
+ibool
+xb_lsn_summary_load(
+/*================*/
+	const char*	filename)	/*!< in: summary file name */
+{
+	FILE*			fp;
+	char			path[FN_REFLEN];
+	unsigned long long	space_id;
+	unsigned long long	size;
+	unsigned long long	mtime;
+	unsigned long long	inode;
+	unsigned long long	start_time;
+	unsigned long long	n_extents;
+	unsigned long long	lsn;
+	xb_lsn_summary_t*	entry;
+	ibool			ret = TRUE;
+
+	fp = fopen(filename, "r");
+	if (fp == NULL) {
+		return(FALSE);
+	}
+
+	while (fscanf(fp, "%llu %llu %llu %llu %llu %llu %511s", &space_id,
+		      &size, &mtime, &inode, &start_time, &n_extents,
+		      path) == 7) {
+
+		entry = xb_lsn_summary_create(path, (ulint) n_extents);
+		entry->space_id = (ulint) space_id;
+		entry->size = size;
+		entry->mtime = mtime;
+		entry->inode = inode;
+		entry->start_time = start_time;
+
+		for (ulint i = 0; i < entry->n_extents; i++) {
+			if (fscanf(fp, "%llu", &lsn) != 1) {
+				ret = FALSE;
+				break;
+			}
+			entry->extent_lsn[i] = lsn;
+		}
+
+		UT_LIST_ADD_LAST(list, base_list, entry);
+		HASH_INSERT(xb_lsn_summary_t, hash, base_hash,
+			    ut_fold_string(entry->path), entry);
+
+		if (!ret) {
+			break;
+		}
+	}
+
+	if (!feof(fp)) {
+		ret = FALSE;
+	}
+
+	fclose(fp);
+
+	return(ret);
+}
+
+/****************************************************************//**
+Initialize the LSN summary of the current backup. If 'basedir' is not NULL,
+load the summary of the base backup from it, so that unchanged data files can
+be detected. A missing base summary is not an error. */
+void
+xb_lsn_summary_init(
+/*================*/
+	const char*	basedir)	/*!< in: base backup directory or
+					NULL */
+{
+	char	filename[FN_REFLEN];
+
+	summary_mutex = os_mutex_create();
+	UT_LIST_INIT(summary_list);
+	UT_LIST_INIT(base_list);
+
+	if (basedir == NULL) {
+		return;
+	}
+
+	base_hash = hash_create(1000);
+
+	snprintf(filename, sizeof(filename), "%s/%s", basedir,
+		 XB_LSN_SUMMARY_FILENAME);
+
+	if (!xb_lsn_summary_load(filename)) {
+		msg("xtrabackup: %s is missing or incomplete, all data files "
+		    "will be scanned.\n", filename);
+		xb_lsn_summary_free_base();
+	}
+}
+
+/****************************************************************//**
+Check if a data file has not been written to since the base backup started
+copying it, in which case all of its pages in the backup chain are current.
+@return TRUE if the file is unchanged. */
+ibool
+xb_lsn_summary_is_unchanged(
+/*========================*/
+	const fil_node_t*	node,	/*!< in: data file */
+	const char*		rel_path)/*!< in: path relative to the backup
+					root */
+{
+	xb_lsn_summary_t*	entry;
+	MY_STAT			statinfo;
+
+	entry = xb_lsn_summary_find(rel_path);
+	if (entry == NULL || entry->space_id != node->space->id) {
+		return(FALSE);
+	}
+
+	if (my_stat(node->name, &statinfo, MYF(0)) == NULL) {
+		return(FALSE);
+	}
+
+	/* Any write to the file after the base backup stat()'ed it would have
+	set its modification time to at least the time copying started, minus
+	the lag of the coarse kernel clock. So if the file was last modified
+	well before that and has not been modified since, its contents are
+	still the ones the base backup copied. Changes to pages that have not
+	been flushed yet are in the redo log copied by this backup. */
+	return(statinfo.st_size == (off_t) entry->size
+	       && (ib_uint64_t) statinfo.st_mtime == entry->mtime
+	       && (ib_uint64_t) statinfo.st_ino == entry->inode
+	       && entry->mtime + 1 < entry->start_time);
+}
+
+/****************************************************************//**
+Record a copied data file in the summary of the current backup. */
+void
+xb_lsn_summary_add(
+/*===============*/
+	const xb_fil_cur_t*	cursor,	/*!< in: cursor the file was
+					copied with */
+	ibool			unchanged)/*!< in: TRUE if the pages were not
+					read because the file was unchanged */
+{
+	xb_lsn_summary_t*	base;
+	xb_lsn_summary_t*	entry;
+
+	if (summary_mutex == NULL || cursor->extent_lsn == NULL) {
+		return;
+	}
+
+	base = xb_lsn_summary_find(cursor->rel_path);
+
+	entry = xb_lsn_summary_create(cursor->rel_path, cursor->n_extents);
+
+	if (unchanged) {
+		/* The backup chain still has the contents copied by the
+		base backup */
+		ut_a(base != NULL);
+
+		entry->space_id = base->space_id;
+		entry->size = base->size;
+		entry->mtime = base->mtime;
+		entry->inode = base->inode;
+		entry->start_time = base->start_time;
+	} else {
+		entry->space_id = cursor->space_id;
+		entry->size = cursor->statinfo.st_size;
+		entry->mtime = cursor->statinfo.st_mtime;
+		entry->inode = cursor->statinfo.st_ino;
+		entry->start_time = cursor->open_time;
+	}
+
+	for (ulint i = 0; i < entry->n_extents; i++) {
+		entry->extent_lsn[i] = cursor->extent_lsn[i];
+
+		/* Keep what the base backup has read for extents not read
+		this time */
+		if (base != NULL && base->space_id == cursor->space_id
+		    && i < base->n_extents
+		    && base->extent_lsn[i] > entry->extent_lsn[i]) {
+			entry->extent_lsn[i] = base->extent_lsn[i];
+		}
+	}
+
+	os_mutex_enter(summary_mutex);
+	UT_LIST_ADD_LAST(list, summary_list, entry);
+	os_mutex_exit(summary_mutex);
+}
+
+/****************************************************************//**
+Write the summary of the current backup to a datasink and, optionally, to a
+local directory.
+@return TRUE on success, FALSE on error. */
+my_bool
+xb_lsn_summary_write(
+/*=================*/
+	ds_ctxt_t*	ds,		/*!< in: datasink */
+	const char*	extra_dir)	/*!< in: directory for an extra copy,
+					or NULL */
+{
+	DYNAMIC_STRING		buf;
+	xb_lsn_summary_t*	entry;
+	ds_file_t*		stream;
+	MY_STAT			mystat;
+	my_bool			ret = TRUE;
+	char			line[FN_REFLEN + 128];
+
+	if (init_dynamic_string(&buf, "", 64 * 1024, 64 * 1024)) {
+		return(FALSE);
+	}
+
+	for (entry = UT_LIST_GET_FIRST(summary_list); entry != NULL;
+	     entry = UT_LIST_GET_NEXT(list, entry)) {
+
+		snprintf(line, sizeof(line),
+			 "%lu " UINT64PF " " UINT64PF " " UINT64PF " " UINT64PF
+			 " %lu %s\n", entry->space_id, entry->size,
+			 entry->mtime, entry->inode, entry->start_time,
+			 entry->n_extents, entry->path);
+		dynstr_append(&buf, line);
+
+		for (ulint i = 0; i < entry->n_extents; i++) {
+			snprintf(line, sizeof(line), i ? " " LSN_PF : LSN_PF,
+				 entry->extent_lsn[i]);
+			dynstr_append(&buf, line);
+		}
+		dynstr_append(&buf, "\n");
+	}
+
+	mystat.st_size = buf.length;
+	mystat.st_mtime = my_time(0);
+
+	stream = ds_open(ds, XB_LSN_SUMMARY_FILENAME, &mystat);
+	if (stream == NULL) {
+		msg("xtrabackup: Error: cannot open output stream for %s\n",
+		    XB_LSN_SUMMARY_FILENAME);
+		ret = FALSE;
+	} else {
+		if (ds_write(stream, buf.str, buf.length)) {
+			ret = FALSE;
+		}
+		ds_close(stream);
+	}
+
+	if (ret && extra_dir != NULL) {
+		char	filename[FN_REFLEN];
+		FILE*	fp;
+
+		snprintf(filename, sizeof(filename), "%s/%s", extra_dir,
+			 XB_LSN_SUMMARY_FILENAME);
+
+		fp = fopen(filename, "w");
+		if (fp == NULL) {
+			msg("xtrabackup: Error: cannot open %s\n", filename);
+			ret = FALSE;
+		} else {
+			if (fwrite(buf.str, buf.length, 1, fp) < 1
+			    && buf.length > 0) {
+				ret = FALSE;
+			}
+			if (fclose(fp)) {
+				ret = FALSE;
+			}
+		}
+	}
+
+	dynstr_free(&buf);
+
+	return(ret);
+}
+
+/****************************************************************//**
+Free the LSN summaries. */
+void
+xb_lsn_summary_free(void)
+/*=====================*/
+{
+	xb_lsn_summary_t*	entry;
+
+	while ((entry = UT_LIST_GET_FIRST(summary_list)) != NULL) {
+		UT_LIST_REMOVE(list, summary_list, entry);
+		xb_lsn_summary_destroy(entry);
+	}
+
+	xb_lsn_summary_free_base();
+
+	if (summary_mutex != NULL) {
+		os_mutex_free(summary_mutex);
+		summary_mutex = NULL;
+	}
+}
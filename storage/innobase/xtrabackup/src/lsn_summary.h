@@ -0,0 +1,89 @@
+/******************************************************
+XtraBackup: hot backup tool for InnoDB
+(c) 2009-2013 Percona LLC and/or its affiliates.
+Originally Created 3/3/2009 Yasufumi Kinoshita
+Written by Alexey Kopytov, Aleksandr Kuzminsky, Stewart Smith, Vadim Tkachenko,
+Yasufumi Kinoshita, Ignacio Nin and Baron Schwartz.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*******************************************************/
+
+/* Per-tablespace LSN summary interface.
+
+Every backup records, for each data file it copies, the file attributes at the
+time the copy started and the maximum page LSN of every extent it has read. A
+full-scan incremental backup based on that backup skips reading the data files
+that provably have not been written to since the base backup copied them. */
+
+#ifndef XB_LSN_SUMMARY_H
+#define XB_LSN_SUMMARY_H
+
+#include <univ.i>
+#include "datasink.h"
+
+struct xb_fil_cur_t;
+
+/* Name of the LSN summary file in the backup directory */
+#define XB_LSN_SUMMARY_FILENAME "xtrabackup_lsn_summary"
+
+/****************************************************************//**
+Initialize the LSN summary of the current backup. If 'basedir' is not NULL,
+load the summary of the base backup from it, so that unchanged data files can
+be detected. A missing base summary is not an error. */
+void
+xb_lsn_summary_init(
+/*================*/
+	const char*	basedir);	/*!< in: base backup directory or
+					NULL */
+
+/****************************************************************//**
+Check if a data file has not been written to since the base backup started
+copying it, in which case all of its pages in the backup chain are current.
+@return TRUE if the file is unchanged. */
+ibool
+xb_lsn_summary_is_unchanged(
+/*========================*/
+	const fil_node_t*	node,	/*!< in: data file */
+	const char*		rel_path);/*!< in: path relative to the backup
+					root */
+
+/****************************************************************//**
+Record a copied data file in the summary of the current backup. */
+void
+xb_lsn_summary_add(
+/*===============*/
+	const xb_fil_cur_t*	cursor,	/*!< in: cursor the file was
+					copied with */
+	ibool			unchanged);/*!< in: TRUE if the pages were not
+					read because the file was unchanged */
+
+/****************************************************************//**
+Write the summary of the current backup to a datasink and, optionally, to a
+local directory.
+@return TRUE on success, FALSE on error. */
+my_bool
+xb_lsn_summary_write(
+/*=================*/
+	ds_ctxt_t*	ds,		/*!< in: datasink */
+	const char*	extra_dir);	/*!< in: directory for an extra copy,
+					or NULL */
+
+/****************************************************************//**
+Free the LSN summaries. */
+void
+xb_lsn_summary_free(void);
+/*=====================*/
+
+#endif
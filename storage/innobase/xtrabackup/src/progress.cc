@@ -0,0 +1,682 @@
+/******************************************************
+XtraBackup: hot backup tool for InnoDB
+(c) 2009-2013 Percona LLC and/or its affiliates.
+Originally Created 3/3/2009 Yasufumi Kinoshita
+Written by Alexey Kopytov, Aleksandr Kuzminsky, Stewart Smith, Vadim Tkachenko,
+Yasufumi Kinoshita, Ignacio Nin and Baron Schwartz.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*******************************************************/
+
+/* Machine-readable progress reporting (--status-file).
+
+A dedicated thread periodically rewrites the status file with a JSON
+document. The file is first written under a temporary name and then renamed,
+so readers never see a partially written document. The counters are updated
+by the copy threads without synchronization, except for those shared between
+threads, which are protected by progress_mutex. The status thread does not use
+any InnoDB synchronization primitives, because they are reinitialized several
+times in the course of --prepare. */
+
+#include <my_base.h>
+
+#include <univ.i>
+#include <ut0ut.h>
+#include <log0recv.h>
+
+#include "common.h"
+#include "datasink.h"
+#include "progress.h"
+#include "xtrabackup.h"
+
+#define XB_PROGRESS_MAX_DATASINKS 10
+
+extern long		xtrabackup_throttle;
+
+/* Per data copy thread counters */
+typedef struct {
+	ib_uint64_t	bytes;		/* bytes read */
+	ib_uint64_t	pages;		/* pages read */
+	ulint		files;		/* data files completed */
+	/* values at the previous snapshot, used to compute rates */
+	ib_uint64_t	prev_bytes;
+	ib_uint64_t	prev_pages;
+} xb_progress_thread_t;
+
+typedef struct {
+	ds_ctxt_t	*ds;		/* NULL if forgotten */
+	ds_stats_t	 stats;		/* last snapshot */
+	my_bool		 valid;		/* TRUE if stats have been taken */
+} xb_progress_datasink_t;
+
+static my_bool			progress_enabled = FALSE;
+static char			*progress_path = NULL;
+static char			*progress_tmp_path = NULL;
+static ulong			progress_interval_ms;
+static const char		*progress_mode;
+static const char		*progress_phase = "starting";
+static const char		*progress_failed_phase = NULL;
+
+static pthread_t		progress_thread;
+static pthread_mutex_t		progress_mutex;
+static pthread_cond_t		progress_cond;
+static my_bool			progress_stop;
+static my_bool			progress_write_failed = FALSE;
+
+static ib_uint64_t		progress_start_time;
+static ib_uint64_t		progress_prev_time;
+
+static xb_progress_thread_t	*progress_threads = NULL;
+static uint			progress_n_threads;
+
+static ulint			progress_files_total;
+static ib_uint64_t		progress_bytes_total;
+static ib_uint64_t		progress_copy_start_time;
+
+static ib_uint64_t		progress_throttle_waits;
+static ib_uint64_t		progress_throttle_wait_us;
+
+static lsn_t			progress_latest_cp;
+static lsn_t			progress_log_capacity;
+static lsn_t			progress_prev_scanned_lsn;
+
+static lsn_t			progress_recv_end_lsn;
+
+static xb_progress_datasink_t	progress_datasinks[XB_PROGRESS_MAX_DATASINKS];
+static uint			progress_n_datasinks = 0;
+
+/************************************************************************
+Compute a per-second rate.
+@return rate */
+static
+double
+xb_progress_rate(
+/*=============*/
+	ib_uint64_t	delta,		/*!< in: counter increment */
+	ib_uint64_t	usec)		/*!< in: time interval */
+{
+	return(usec ? (double) delta * 1000000.0 / (double) usec : 0.0);
+}
+
+/************************************************************************
+Refresh the cached statistics of registered datasinks. Must be called with
+progress_mutex held. */
+static
+void
+xb_progress_refresh_datasinks(void)
+/*===============================*/
+{
+	uint	i;
+
+	for (i = 0; i < progress_n_datasinks; i++) {
+		xb_progress_datasink_t*	pds = &progress_datasinks[i];
+
+		if (pds->ds != NULL) {
+			pds->valid = ds_get_stats(pds->ds, &pds->stats);
+		}
+	}
+}
+
+/************************************************************************
+Write the data copy section of the status document. */
+static
+void
+xb_progress_write_data(
+/*===================*/
+	FILE*		f,		/*!< in: status file */
+	ib_uint64_t	now,		/*!< in: current time */
+	ib_uint64_t	interval)	/*!< in: time since previous snapshot */
+{
+	ib_uint64_t	bytes_done = 0;
+	ulint		files_done = 0;
+	double		rate = 0.0;
+	uint		i;
+
+	fprintf(f, "  \"data\": {\n    \"threads\": [");
+
+	for (i = 0; i < progress_n_threads; i++) {
+		xb_progress_thread_t*	thd = &progress_threads[i];
+		ib_uint64_t		bytes = thd->bytes;
+		ib_uint64_t		pages = thd->pages;
+
+		fprintf(f, "%s\n      {\"id\": %u, \"files\": %lu, "
+			"\"bytes\": " UINT64PF ", \"pages\": " UINT64PF ", "
+			"\"bytes_per_sec\": %.0f, \"pages_per_sec\": %.0f}",
+			i ? "," : "", i + 1, (ulong) thd->files,
+			bytes, pages,
+			xb_progress_rate(bytes - thd->prev_bytes, interval),
+			xb_progress_rate(pages - thd->prev_pages, interval));
+
+		thd->prev_bytes = bytes;
+		thd->prev_pages = pages;
+
+		bytes_done += bytes;
+		files_done += thd->files;
+	}
+
+	fprintf(f, "\n    ],\n");
+
+	if (progress_copy_start_time) {
+		rate = xb_progress_rate(bytes_done,
+					now - progress_copy_start_time);
+	}
+
+	fprintf(f, "    \"files_total\": %lu,\n"
+		"    \"files_done\": %lu,\n"
+		"    \"bytes_total\": " UINT64PF ",\n"
+		"    \"bytes_done\": " UINT64PF ",\n"
+		"    \"bytes_per_sec\": %.0f,\n",
+		(ulong) progress_files_total, (ulong) files_done,
+		progress_bytes_total, bytes_done, rate);
+
+	/* The estimate is based on the average rate since the start of data
+	copying. Incremental backups using the changed page bitmap read less
+	than the total data size, so the estimate is pessimistic for them. */
+	if (progress_bytes_total > bytes_done && rate > 0.0) {
+		fprintf(f, "    \"eta\": %.0f\n  },\n",
+			(double) (progress_bytes_total - bytes_done) / rate);
+	} else {
+		fprintf(f, "    \"eta\": %s\n  },\n",
+			progress_files_total
+			&& files_done >= progress_files_total ? "0" : "null");
+	}
+}
+
+/************************************************************************
+Write the log copying section of the status document. */
+static
+void
+xb_progress_write_log(
+/*==================*/
+	FILE*		f,		/*!< in: status file */
+	ib_uint64_t	interval)	/*!< in: time since previous snapshot */
+{
+	lsn_t	scanned_lsn = log_copy_scanned_lsn;
+	lsn_t	copied;
+	lsn_t	lag;
+
+	copied = scanned_lsn > checkpoint_lsn_start
+		? scanned_lsn - checkpoint_lsn_start : 0;
+	lag = progress_latest_cp > scanned_lsn
+		? progress_latest_cp - scanned_lsn : 0;
+
+	fprintf(f, "  \"log\": {\n"
+		"    \"start_lsn\": " LSN_PF ",\n"
+		"    \"scanned_lsn\": " LSN_PF ",\n"
+		"    \"checkpoint_lsn\": " LSN_PF ",\n"
+		"    \"lag\": " LSN_PF ",\n"
+		"    \"capacity\": " LSN_PF ",\n"
+		"    \"bytes_copied\": " LSN_PF ",\n"
+		"    \"bytes_per_sec\": %.0f\n  },\n",
+		checkpoint_lsn_start, scanned_lsn, progress_latest_cp, lag,
+		progress_log_capacity, copied,
+		xb_progress_rate(progress_prev_scanned_lsn
+				 && scanned_lsn > progress_prev_scanned_lsn
+				 ? scanned_lsn - progress_prev_scanned_lsn
+				 : 0, interval));
+
+	progress_prev_scanned_lsn = scanned_lsn;
+}
+
+/************************************************************************
+Write the recovery section of the status document. */
+static
+void
+xb_progress_write_recovery(
+/*=======================*/
+	FILE*		f)		/*!< in: status file */
+{
+	lsn_t	start_lsn = recv_progress_start_lsn;
+	lsn_t	scanned_lsn = recv_progress_scanned_lsn;
+	ulint	scan_percent = 0;
+
+	if (start_lsn && progress_recv_end_lsn > start_lsn
+	    && scanned_lsn > start_lsn) {
+		scan_percent = (ulint)
+			((ut_min(scanned_lsn, progress_recv_end_lsn)
+			  - start_lsn) * 100
+			 / (progress_recv_end_lsn - start_lsn));
+	}
+
+	fprintf(f, "  \"recovery\": {\n"
+		"    \"start_lsn\": " LSN_PF ",\n"
+		"    \"end_lsn\": " LSN_PF ",\n"
+		"    \"scanned_lsn\": " LSN_PF ",\n"
+		"    \"scan_percent\": %lu,\n"
+		"    \"apply_batches\": %lu,\n"
+		"    \"apply_percent\": %lu,\n"
+		"    \"pending_pages\": %lu\n  },\n",
+		start_lsn, progress_recv_end_lsn, scanned_lsn,
+		(ulong) scan_percent, (ulong) recv_progress_apply_batches,
+		(ulong) recv_progress_apply_percent,
+		(ulong) recv_progress_pending_pages);
+}
+
+/************************************************************************
+Write the datasinks section of the status document. */
+static
+void
+xb_progress_write_datasinks(
+/*========================*/
+	FILE*		f)		/*!< in: status file */
+{
+	uint	i;
+	uint	n = 0;
+
+	fprintf(f, "  \"datasinks\": [");
+
+	for (i = 0; i < progress_n_datasinks; i++) {
+		const ds_stats_t*	stats = &progress_datasinks[i].stats;
+
+		if (!progress_datasinks[i].valid) {
+			continue;
+		}
+
+		fprintf(f, "%s\n    {\"name\": \"%s\", "
+			"\"bytes_in\": " UINT64PF ", "
+			"\"bytes_out\": " UINT64PF ", "
+			"\"ratio\": %.3f, "
+			"\"bytes_pending\": " UINT64PF ", "
+			"\"workers\": %u, \"busy_workers\": %u}",
+			n++ ? "," : "", stats->name,
+			(ib_uint64_t) stats->bytes_in,
+			(ib_uint64_t) stats->bytes_out,
+			stats->bytes_in
+			? (double) stats->bytes_out / stats->bytes_in : 0.0,
+			(ib_uint64_t) stats->bytes_pending,
+			stats->workers, stats->busy_workers);
+	}
+
+	fprintf(f, "%s]\n", n ? "\n  " : "");
+}
+
+/************************************************************************
+Write the status document to the temporary file and rename it over the
+status file. Must be called with progress_mutex held. */
+static
+void
+xb_progress_write(void)
+/*===================*/
+{
+	FILE*		f;
+	ib_uint64_t	now = ut_time_us(NULL);
+	ib_uint64_t	interval = now - progress_prev_time;
+	my_bool		is_backup = !strcmp(progress_mode, "backup");
+
+	f = fopen(progress_tmp_path, "w");
+	if (f == NULL) {
+		goto err;
+	}
+
+	xb_progress_refresh_datasinks();
+
+	fprintf(f, "{\n"
+		"  \"mode\": \"%s\",\n"
+		"  \"phase\": \"%s\",\n"
+		"  \"timestamp\": " UINT64PF ",\n"
+		"  \"elapsed\": %.3f,\n",
+		progress_mode, progress_phase, now / 1000000,
+		(double) (now - progress_start_time) / 1000000.0);
+
+	if (progress_failed_phase != NULL) {
+		fprintf(f, "  \"failed_phase\": \"%s\",\n",
+			progress_failed_phase);
+	}
+
+	if (is_backup) {
+		xb_progress_write_data(f, now, interval);
+
+		fprintf(f, "  \"throttle\": {\n"
+			"    \"limit\": %ld,\n"
+			"    \"waits\": " UINT64PF ",\n"
+			"    \"wait_time\": %.3f\n  },\n",
+			xtrabackup_throttle, progress_throttle_waits,
+			(double) progress_throttle_wait_us / 1000000.0);
+
+		xb_progress_write_log(f, interval);
+	} else {
+		xb_progress_write_recovery(f);
+	}
+
+	xb_progress_write_datasinks(f);
+
+	fprintf(f, "}\n");
+
+	progress_prev_time = now;
+
+	if (fclose(f) != 0 || rename(progress_tmp_path, progress_path) != 0) {
+		goto err;
+	}
+
+	progress_write_failed = FALSE;
+
+	return;
+
+err:
+	/* Report the error once and keep trying on subsequent updates */
+	if (!progress_write_failed) {
+		msg("xtrabackup: warning: cannot write the status file '%s' "
+		    "(errno = %d)\n", progress_path, errno);
+		progress_write_failed = TRUE;
+	}
+}
+
+/************************************************************************
+Status reporting thread. */
+static
+void*
+xb_progress_thread_func(
+/*====================*/
+	void*	arg __attribute__((unused)))
+{
+	struct timespec	abstime;
+
+	pthread_mutex_lock(&progress_mutex);
+
+	while (!progress_stop) {
+		xb_progress_write();
+
+		set_timespec_nsec(abstime,
+				  (ulonglong) progress_interval_ms * 1000000ULL);
+		pthread_cond_timedwait(&progress_cond, &progress_mutex,
+				       &abstime);
+	}
+
+	pthread_mutex_unlock(&progress_mutex);
+
+	return(NULL);
+}
+
+/************************************************************************
+Set the final phase, stop the status reporting thread and write the final
+status. */
+static
+void
+xb_progress_finish(
+/*===============*/
+	const char*	phase)		/*!< in: final phase */
+{
+	pthread_mutex_lock(&progress_mutex);
+	if (!strcmp(phase, "failed")) {
+		progress_failed_phase = progress_phase;
+	}
+	progress_phase = phase;
+	progress_stop = TRUE;
+	pthread_cond_signal(&progress_cond);
+	pthread_mutex_unlock(&progress_mutex);
+
+	pthread_join(progress_thread, NULL);
+
+	/* Final update */
+	pthread_mutex_lock(&progress_mutex);
+	xb_progress_write();
+	pthread_mutex_unlock(&progress_mutex);
+}
+
+/************************************************************************
+Exit handler. If xb_progress_stop() has not been called, the process is
+exiting on an error: record the failed phase in the status file. Other
+threads may still be running and using the progress state, so it is not
+freed here. */
+static
+void
+xb_progress_exit_handler(void)
+/*==========================*/
+{
+	if (!progress_enabled) {
+		return;
+	}
+
+	progress_enabled = FALSE;
+
+	xb_progress_finish("failed");
+}
+
+/************************************************************************
+Start the status reporting thread.
+
+@return TRUE on success, FALSE on error. */
+my_bool
+xb_progress_start(
+/*==============*/
+	const char*	path,		/*!< in: status file path */
+	ulong		interval_ms,	/*!< in: update interval */
+	const char*	mode,		/*!< in: "backup" or "prepare" */
+	uint		n_threads)	/*!< in: number of data copy threads */
+{
+	size_t	len = strlen(path);
+
+	progress_path = (char *) my_malloc(len + 1, MYF(MY_FAE));
+	memcpy(progress_path, path, len + 1);
+
+	progress_tmp_path = (char *) my_malloc(len + sizeof(".tmp"),
+					       MYF(MY_FAE));
+	memcpy(progress_tmp_path, path, len);
+	memcpy(progress_tmp_path + len, ".tmp", sizeof(".tmp"));
+
+	progress_interval_ms = interval_ms;
+	progress_mode = mode;
+	progress_n_threads = n_threads;
+	progress_threads = (xb_progress_thread_t *)
+		my_malloc(sizeof(xb_progress_thread_t) * n_threads,
+			  MYF(MY_FAE | MY_ZEROFILL));
+
+	progress_start_time = progress_prev_time = ut_time_us(NULL);
+	progress_stop = FALSE;
+
+	pthread_mutex_init(&progress_mutex, NULL);
+	pthread_cond_init(&progress_cond, NULL);
+
+	progress_enabled = TRUE;
+
+	/* Every exit(EXIT_FAILURE) path is covered by the exit handler,
+	which records the failure in the status file */
+	atexit(xb_progress_exit_handler);
+
+	if (pthread_create(&progress_thread, NULL, xb_progress_thread_func,
+			   NULL)) {
+		msg("xtrabackup: error: cannot create the status reporting "
+		    "thread: errno = %d\n", errno);
+		progress_enabled = FALSE;
+		return(FALSE);
+	}
+
+	return(TRUE);
+}
+
+/************************************************************************
+Write the final status and stop the status reporting thread. */
+void
+xb_progress_stop(void)
+/*==================*/
+{
+	if (!progress_enabled) {
+		return;
+	}
+
+	xb_progress_finish("completed");
+
+	progress_enabled = FALSE;
+
+	pthread_cond_destroy(&progress_cond);
+	pthread_mutex_destroy(&progress_mutex);
+
+	my_free(progress_threads);
+	my_free(progress_tmp_path);
+	my_free(progress_path);
+}
+
+/************************************************************************
+Set the name of the current phase reported in the status file. */
+void
+xb_progress_set_phase(
+/*==================*/
+	const char*	phase)		/*!< in: static string */
+{
+	if (!progress_enabled) {
+		return;
+	}
+
+	pthread_mutex_lock(&progress_mutex);
+	progress_phase = phase;
+	pthread_mutex_unlock(&progress_mutex);
+}
+
+/************************************************************************
+Set the amount of data to be copied, used to estimate completion time. */
+void
+xb_progress_set_totals(
+/*===================*/
+	ulint		files,		/*!< in: number of data files */
+	ib_uint64_t	bytes)		/*!< in: total size of data files */
+{
+	if (!progress_enabled) {
+		return;
+	}
+
+	pthread_mutex_lock(&progress_mutex);
+	progress_files_total = files;
+	progress_bytes_total = bytes;
+	progress_copy_start_time = ut_time_us(NULL);
+	pthread_mutex_unlock(&progress_mutex);
+}
+
+/************************************************************************
+Account a block of pages read by a data copy thread. */
+void
+xb_progress_data_read(
+/*==================*/
+	uint		thread_n,	/*!< in: copy thread number */
+	ulint		npages,		/*!< in: number of pages read */
+	ulint		bytes)		/*!< in: number of bytes read */
+{
+	if (!progress_enabled || thread_n == 0
+	    || thread_n > progress_n_threads) {
+		return;
+	}
+
+	/* Each slot is only updated by its own thread */
+	progress_threads[thread_n - 1].pages += npages;
+	progress_threads[thread_n - 1].bytes += bytes;
+}
+
+/************************************************************************
+Account a data file completely copied by a data copy thread. */
+void
+xb_progress_data_file_done(
+/*=======================*/
+	uint		thread_n)	/*!< in: copy thread number */
+{
+	if (!progress_enabled || thread_n == 0
+	    || thread_n > progress_n_threads) {
+		return;
+	}
+
+	progress_threads[thread_n - 1].files++;
+}
+
+/************************************************************************
+Account time spent waiting in xtrabackup_io_throttling(). */
+void
+xb_progress_throttle_wait(
+/*======================*/
+	ib_uint64_t	usec)		/*!< in: wait time in microseconds */
+{
+	if (!progress_enabled) {
+		return;
+	}
+
+	pthread_mutex_lock(&progress_mutex);
+	progress_throttle_waits++;
+	progress_throttle_wait_us += usec;
+	pthread_mutex_unlock(&progress_mutex);
+}
+
+/************************************************************************
+Update the log copying state reported in the status file. */
+void
+xb_progress_set_log_state(
+/*======================*/
+	lsn_t		latest_cp,	/*!< in: latest server checkpoint */
+	lsn_t		capacity)	/*!< in: log group capacity, or 0 if
+					unchanged */
+{
+	if (!progress_enabled) {
+		return;
+	}
+
+	pthread_mutex_lock(&progress_mutex);
+	progress_latest_cp = latest_cp;
+	if (capacity) {
+		progress_log_capacity = capacity;
+	}
+	pthread_mutex_unlock(&progress_mutex);
+}
+
+/************************************************************************
+Set the LSN recovery is expected to reach in --prepare. */
+void
+xb_progress_set_recovery_target(
+/*============================*/
+	lsn_t		end_lsn)	/*!< in: target LSN */
+{
+	if (!progress_enabled) {
+		return;
+	}
+
+	pthread_mutex_lock(&progress_mutex);
+	progress_recv_end_lsn = end_lsn;
+	pthread_mutex_unlock(&progress_mutex);
+}
+
+/************************************************************************
+Register a datasink to report its statistics in the status file. */
+void
+xb_progress_add_datasink(
+/*=====================*/
+	ds_ctxt_t*	ds)		/*!< in: datasink */
+{
+	if (!progress_enabled) {
+		return;
+	}
+
+	pthread_mutex_lock(&progress_mutex);
+	xb_a(progress_n_datasinks < XB_PROGRESS_MAX_DATASINKS);
+	progress_datasinks[progress_n_datasinks].ds = ds;
+	progress_datasinks[progress_n_datasinks].valid = FALSE;
+	progress_n_datasinks++;
+	pthread_mutex_unlock(&progress_mutex);
+}
+
+/************************************************************************
+Take the final statistics snapshot of all registered datasinks and stop
+querying them. */
+void
+xb_progress_forget_datasinks(void)
+/*==============================*/
+{
+	uint	i;
+
+	if (!progress_enabled) {
+		return;
+	}
+
+	pthread_mutex_lock(&progress_mutex);
+	xb_progress_refresh_datasinks();
+	for (i = 0; i < progress_n_datasinks; i++) {
+		progress_datasinks[i].ds = NULL;
+	}
+	pthread_mutex_unlock(&progress_mutex);
+}
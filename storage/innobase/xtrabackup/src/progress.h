@@ -0,0 +1,120 @@
+/******************************************************
+XtraBackup: hot backup tool for InnoDB
+(c) 2009-2013 Percona LLC and/or its affiliates.
+Originally Created 3/3/2009 Yasufumi Kinoshita
+Written by Alexey Kopytov, Aleksandr Kuzminsky, Stewart Smith, Vadim Tkachenko,
+Yasufumi Kinoshita, Ignacio Nin and Baron Schwartz.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*******************************************************/
+
+/* Machine-readable progress reporting (--status-file) */
+
+#ifndef XB_PROGRESS_H
+#define XB_PROGRESS_H
+
+#include <univ.i>
+#include "datasink.h"
+
+/************************************************************************
+Start the status reporting thread which periodically rewrites the status
+file with a JSON document describing the current state of the backup or
+prepare.
+
+@return TRUE on success, FALSE on error. */
+my_bool
+xb_progress_start(
+/*==============*/
+	const char*	path,		/*!< in: status file path */
+	ulong		interval_ms,	/*!< in: update interval */
+	const char*	mode,		/*!< in: "backup" or "prepare" */
+	uint		n_threads);	/*!< in: number of data copy threads */
+
+/************************************************************************
+Write the final status and stop the status reporting thread. Does nothing
+if the thread has not been started. */
+void
+xb_progress_stop(void);
+/*==================*/
+
+/************************************************************************
+Set the name of the current phase reported in the status file. */
+void
+xb_progress_set_phase(
+/*==================*/
+	const char*	phase);		/*!< in: static string */
+
+/************************************************************************
+Set the amount of data to be copied, used to estimate completion time. */
+void
+xb_progress_set_totals(
+/*===================*/
+	ulint		files,		/*!< in: number of data files */
+	ib_uint64_t	bytes);		/*!< in: total size of data files */
+
+/************************************************************************
+Account a block of pages read by a data copy thread. */
+void
+xb_progress_data_read(
+/*==================*/
+	uint		thread_n,	/*!< in: copy thread number */
+	ulint		npages,		/*!< in: number of pages read */
+	ulint		bytes);		/*!< in: number of bytes read */
+
+/************************************************************************
+Account a data file completely copied by a data copy thread. */
+void
+xb_progress_data_file_done(
+/*=======================*/
+	uint		thread_n);	/*!< in: copy thread number */
+
+/************************************************************************
+Account time spent waiting in xtrabackup_io_throttling(). */
+void
+xb_progress_throttle_wait(
+/*======================*/
+	ib_uint64_t	usec);		/*!< in: wait time in microseconds */
+
+/************************************************************************
+Update the log copying state reported in the status file. */
+void
+xb_progress_set_log_state(
+/*======================*/
+	lsn_t		latest_cp,	/*!< in: latest server checkpoint */
+	lsn_t		capacity);	/*!< in: log group capacity, or 0 if
+					unchanged */
+
+/************************************************************************
+Set the LSN recovery is expected to reach in --prepare. */
+void
+xb_progress_set_recovery_target(
+/*============================*/
+	lsn_t		end_lsn);	/*!< in: target LSN */
+
+/************************************************************************
+Register a datasink to report its statistics in the status file. */
+void
+xb_progress_add_datasink(
+/*=====================*/
+	ds_ctxt_t*	ds);		/*!< in: datasink */
+
+/************************************************************************
+Take the final statistics snapshot of all registered datasinks and stop
+querying them. Must be called before the datasinks are destroyed. */
+void
+xb_progress_forget_datasinks(void);
+/*==============================*/
+
+#endif /* XB_PROGRESS_H */
@@ -82,6 +82,26 @@ rf_pass_through_get_next_batch(
 	ctxt->offset += *read_batch_len;
 }
 
+/****************************************************************//**
+Get the next batch of pages for the skipping read filter, i.e. none.  */
+static
+void
+rf_skip_get_next_batch(
+/*===================*/
+	xb_read_filt_ctxt_t*	ctxt __attribute__((unused)),
+							/*!<in/out: read filter
+							context */
+	ib_int64_t*		read_batch_start,	/*!<out: starting read
+							offset in bytes for the
+							next batch of pages */
+	ib_int64_t*		read_batch_len)		/*!<out: length in
+							bytes of the next batch
+							of pages */
+{
+	*read_batch_start = 0;
+	*read_batch_len = 0;
+}
+
 /****************************************************************//**
 Deinitialize the pass-through read filter.  */
 static
@@ -204,3 +224,11 @@ xb_read_filt_t rf_bitmap = {
 	&rf_bitmap_get_next_batch,
 	&rf_bitmap_deinit
 };
+
+/* The read filter for data files that are known to be unchanged, reads no
+pages */
+xb_read_filt_t rf_skip = {
+	&rf_pass_through_init,
+	&rf_skip_get_next_batch,
+	&rf_pass_through_deinit
+};
@@ -58,5 +58,6 @@ struct xb_read_filt_t {
 
 extern xb_read_filt_t rf_pass_through;
 extern xb_read_filt_t rf_bitmap;
+extern xb_read_filt_t rf_skip;
 
 #endif
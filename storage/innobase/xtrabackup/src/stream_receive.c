@@ -0,0 +1,477 @@
+/******************************************************
+Copyright (c) 2013 Percona LLC and/or its affiliates.
+
+Receiving a backup stream for xtrabackup --prepare.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*******************************************************/
+
+#include <mysql_version.h>
+#include <my_base.h>
+#include <hash.h>
+#include <quicklz.h>
+#include <zlib.h>
+#include "common.h"
+#include "xbstream.h"
+#include "buf_arena.h"
+#include "stream_receive.h"
+
+#define START_FILE_HASH_SIZE 16
+
+/* Upper bound for the chunk size in a qpress archive header. ds_compress
+uses 64K chunks, anything much larger means a corrupted stream. */
+#define QP_MAX_CHUNK_SIZE (64 * 1024 * 1024UL)
+
+/* "qpress10" + chunk size + "F" + name length */
+#define QP_ARCHIVE_HEADER_LEN (8 + 8 + 1 + 4)
+/* "NEWBNEWB" + offset + Adler-32 */
+#define QP_BLOCK_HEADER_LEN (8 + 8 + 4)
+/* "ENDSENDS" + recovery information */
+#define QP_TRAILER_LEN (8 + 8)
+
+typedef enum {
+	QP_STATE_HEADER,
+	QP_STATE_BLOCKS,
+	QP_STATE_DONE
+} qp_state_t;
+
+/* Incremental decoder for a single-file qpress archive as written by
+ds_compress. Input is fed in arbitrary pieces as stream chunks arrive, an
+incomplete block at the end of a piece is kept until the next one. */
+typedef struct {
+	qp_state_t		state;
+	uchar			*buf;		/* pending input */
+	size_t			buf_len;
+	size_t			buf_size;
+	size_t			chunk_size;	/* from the archive header */
+	ulonglong		bytes_out;
+	char			*out;
+	qlz_state_decompress	qlz;
+} qp_decoder_t;
+
+typedef struct {
+	char		*path;
+	uint		pathlen;
+	ds_file_t	*file;
+	my_off_t	offset;
+	qp_decoder_t	*qp;		/* NULL for uncompressed files */
+} recv_file_t;
+
+static
+qp_decoder_t *
+qp_decoder_new(void)
+{
+	return (qp_decoder_t *) my_malloc(sizeof(qp_decoder_t),
+					  MYF(MY_FAE | MY_ZEROFILL));
+}
+
+static
+void
+qp_decoder_free(qp_decoder_t *qp)
+{
+	if (qp->out != NULL) {
+		xb_arena_free(qp->out);
+	}
+	my_free(qp->buf);
+	my_free(qp);
+}
+
+/************************************************************************
+Decode as much of [data, data + len) as possible and write the decompressed
+data to 'file'. Sets *used to the number of bytes consumed.
+@return 0 on success, non-zero on a corrupted archive or write error. */
+static
+int
+qp_decode(qp_decoder_t *qp, ds_file_t *file, const char *path,
+	  const uchar *data, size_t len, size_t *used)
+{
+	const uchar	*p = data;
+	size_t		avail = len;
+
+	while (avail > 0) {
+		if (qp->state == QP_STATE_HEADER) {
+			ulong	name_len;
+
+			if (avail < QP_ARCHIVE_HEADER_LEN) {
+				break;
+			}
+			if (memcmp(p, "qpress10", 8) || p[16] != 'F') {
+				msg("xtrabackup: %s: bad qpress archive "
+				    "header.\n", path);
+				return 1;
+			}
+			qp->chunk_size = (size_t) uint8korr(p + 8);
+			name_len = uint4korr(p + 17);
+			if (qp->chunk_size == 0 ||
+			    qp->chunk_size > QP_MAX_CHUNK_SIZE ||
+			    name_len >= FN_REFLEN) {
+				msg("xtrabackup: %s: bad qpress archive "
+				    "header.\n", path);
+				return 1;
+			}
+			if (avail < QP_ARCHIVE_HEADER_LEN + name_len + 1) {
+				break;
+			}
+			qp->out = (char *) xb_arena_alloc(qp->chunk_size);
+
+			p += QP_ARCHIVE_HEADER_LEN + name_len + 1;
+			avail -= QP_ARCHIVE_HEADER_LEN + name_len + 1;
+			qp->state = QP_STATE_BLOCKS;
+		} else if (qp->state == QP_STATE_BLOCKS) {
+			const char	*block;
+			size_t		comp_len;
+			size_t		decomp_len;
+
+			if (avail < 8) {
+				break;
+			}
+			if (!memcmp(p, "ENDSENDS", 8)) {
+				if (avail < QP_TRAILER_LEN) {
+					break;
+				}
+				p += QP_TRAILER_LEN;
+				avail -= QP_TRAILER_LEN;
+				qp->state = QP_STATE_DONE;
+				continue;
+			}
+			if (memcmp(p, "NEWBNEWB", 8)) {
+				msg("xtrabackup: %s: bad qpress block "
+				    "header.\n", path);
+				return 1;
+			}
+
+			/* The QuickLZ header of the block tells its
+			length */
+			if (avail < QP_BLOCK_HEADER_LEN + 1) {
+				break;
+			}
+			block = (const char *) p + QP_BLOCK_HEADER_LEN;
+			if (avail < QP_BLOCK_HEADER_LEN
+			    + qlz_size_header(block)) {
+				break;
+			}
+			comp_len = qlz_size_compressed(block);
+			decomp_len = qlz_size_decompressed(block);
+			if (comp_len < qlz_size_header(block) ||
+			    decomp_len > qp->chunk_size) {
+				msg("xtrabackup: %s: bad QuickLZ block "
+				    "header.\n", path);
+				return 1;
+			}
+			if (avail < QP_BLOCK_HEADER_LEN + comp_len) {
+				break;
+			}
+
+			if (uint8korr(p + 8) != qp->bytes_out) {
+				msg("xtrabackup: %s: qpress block at offset "
+				    "%llu, expected %llu.\n", path,
+				    (ulonglong) uint8korr(p + 8),
+				    qp->bytes_out);
+				return 1;
+			}
+			/* See comp_worker_func() in ds_compress.c on the
+			initial value */
+			if (adler32(0x00000001, (const uchar *) block,
+				    comp_len) != uint4korr(p + 16)) {
+				msg("xtrabackup: %s: checksum mismatch in "
+				    "qpress block at offset %llu.\n", path,
+				    qp->bytes_out);
+				return 1;
+			}
+			if (qlz_decompress(block, qp->out, &qp->qlz)
+			    != decomp_len) {
+				msg("xtrabackup: %s: failed to decompress "
+				    "block at offset %llu.\n", path,
+				    qp->bytes_out);
+				return 1;
+			}
+			if (ds_write(file, qp->out, decomp_len)) {
+				return 1;
+			}
+			qp->bytes_out += decomp_len;
+
+			p += QP_BLOCK_HEADER_LEN + comp_len;
+			avail -= QP_BLOCK_HEADER_LEN + comp_len;
+		} else {
+			msg("xtrabackup: %s: unexpected data after the qpress "
+			    "archive trailer.\n", path);
+			return 1;
+		}
+	}
+
+	*used = len - avail;
+
+	return 0;
+}
+
+/************************************************************************
+Feed a piece of a compressed file to its decoder. Complete blocks are decoded
+directly from the stream chunk, only an incomplete tail is copied aside.
+@return 0 on success, non-zero on error. */
+static
+int
+qp_decoder_write(qp_decoder_t *qp, ds_file_t *file, const char *path,
+		 const uchar *data, size_t len)
+{
+	size_t	used;
+
+	if (qp->buf_len > 0) {
+		if (qp->buf_len + len > qp->buf_size) {
+			qp->buf_size = qp->buf_len + len;
+			qp->buf = (uchar *) my_realloc(qp->buf, qp->buf_size,
+						       MYF(MY_FAE));
+		}
+		memcpy(qp->buf + qp->buf_len, data, len);
+		qp->buf_len += len;
+
+		if (qp_decode(qp, file, path, qp->buf, qp->buf_len, &used)) {
+			return 1;
+		}
+		memmove(qp->buf, qp->buf + used, qp->buf_len - used);
+		qp->buf_len -= used;
+
+		return 0;
+	}
+
+	if (qp_decode(qp, file, path, data, len, &used)) {
+		return 1;
+	}
+
+	if (used < len) {
+		if (len - used > qp->buf_size) {
+			qp->buf_size = len - used;
+			qp->buf = (uchar *) my_realloc(qp->buf, qp->buf_size,
+						       MYF(MY_FAE));
+		}
+		memcpy(qp->buf, data + used, len - used);
+		qp->buf_len = len - used;
+	}
+
+	return 0;
+}
+
+static
+my_bool
+path_has_suffix(const char *path, uint pathlen, const char *suffix)
+{
+	size_t	suffix_len = strlen(suffix);
+
+	return(pathlen > suffix_len &&
+	       !strcmp(path + pathlen - suffix_len, suffix));
+}
+
+static
+recv_file_t *
+recv_file_new(ds_ctxt_t *ds_ctxt, const char *path, uint pathlen)
+{
+	recv_file_t	*entry;
+	char		dst_path[FN_REFLEN];
+
+	if (path_has_suffix(path, pathlen, ".xbcrypt")) {
+		msg("xtrabackup: error: %s is encrypted. Encrypted backups "
+		    "have to be extracted with xbstream and decrypted before "
+		    "they can be prepared.\n", path);
+		return NULL;
+	}
+
+	entry = (recv_file_t *) my_malloc(sizeof(recv_file_t),
+					  MYF(MY_FAE | MY_ZEROFILL));
+	entry->path = my_strndup(path, pathlen, MYF(MY_FAE));
+	entry->pathlen = pathlen;
+
+	strmake(dst_path, path, pathlen);
+	if (path_has_suffix(path, pathlen, ".qp")) {
+		dst_path[pathlen - 3] = '\0';
+		entry->qp = qp_decoder_new();
+	}
+
+	entry->file = ds_open(ds_ctxt, dst_path, NULL);
+	if (entry->file == NULL) {
+		msg("xtrabackup: error: cannot create %s.\n", dst_path);
+		if (entry->qp != NULL) {
+			qp_decoder_free(entry->qp);
+		}
+		my_free(entry->path);
+		my_free(entry);
+		return NULL;
+	}
+
+	return entry;
+}
+
+static
+uchar *
+get_recv_file_key(recv_file_t *entry, size_t *length,
+		  my_bool not_used __attribute__((unused)))
+{
+	*length = entry->pathlen;
+	return (uchar *) entry->path;
+}
+
+static
+void
+recv_file_free(recv_file_t *entry)
+{
+	if (entry->file != NULL) {
+		ds_close(entry->file);
+	}
+	if (entry->qp != NULL) {
+		qp_decoder_free(entry->qp);
+	}
+	my_free(entry->path);
+	my_free(entry);
+}
+
+/************************************************************************
+Complete a file on its EOF chunk.
+@return 0 on success, non-zero on error. */
+static
+int
+recv_file_close(recv_file_t *entry, my_bool verbose)
+{
+	int	err = 0;
+
+	if (entry->qp != NULL &&
+	    (entry->qp->state != QP_STATE_DONE || entry->qp->buf_len > 0)) {
+		msg("xtrabackup: error: %s: compressed file is "
+		    "truncated.\n", entry->path);
+		err = 1;
+	}
+
+	if (ds_close(entry->file)) {
+		err = 1;
+	}
+	entry->file = NULL;
+
+	if (verbose && !err) {
+		msg("xtrabackup: received %s\n", entry->path);
+	}
+
+	return err;
+}
+
+int
+xb_stream_receive(ds_ctxt_t *ds_ctxt, my_bool verbose)
+{
+	xb_rstream_t		*stream;
+	xb_rstream_result_t	res;
+	xb_rstream_chunk_t	chunk;
+	HASH			filehash;
+	recv_file_t		*entry;
+	ulong			n_files = 0;
+	ulonglong		n_bytes = 0;
+	ulong			i;
+
+	stream = xb_stream_read_new();
+	if (stream == NULL) {
+		msg("xtrabackup: error: xb_stream_read_new() failed.\n");
+		return 1;
+	}
+
+	if (my_hash_init(&filehash, &my_charset_bin, START_FILE_HASH_SIZE,
+			  0, 0, (my_hash_get_key) get_recv_file_key,
+			  (my_hash_free_key) recv_file_free, MYF(0))) {
+		msg("xtrabackup: error: failed to initialize file hash.\n");
+		xb_stream_read_done(stream);
+		return 1;
+	}
+
+	while ((res = xb_stream_read_chunk(stream, &chunk)) ==
+	       XB_STREAM_READ_CHUNK) {
+		/* Chunks of unknown type that are not ignorable have been
+		rejected by xb_stream_read_chunk(), skip the ignorable ones */
+		if (chunk.type == XB_CHUNK_TYPE_UNKNOWN &&
+		    (chunk.flags & XB_STREAM_FLAG_IGNORABLE)) {
+			continue;
+		}
+
+		entry = (recv_file_t *) my_hash_search(&filehash,
+						       (uchar *) chunk.path,
+						       chunk.pathlen);
+		if (entry == NULL) {
+			entry = recv_file_new(ds_ctxt, chunk.path,
+					      chunk.pathlen);
+			if (entry == NULL) {
+				goto err;
+			}
+			if (my_hash_insert(&filehash, (uchar *) entry)) {
+				msg("xtrabackup: error: my_hash_insert() "
+				    "failed.\n");
+				recv_file_free(entry);
+				goto err;
+			}
+		}
+
+		if (chunk.type == XB_CHUNK_TYPE_EOF) {
+			if (recv_file_close(entry, verbose)) {
+				goto err;
+			}
+			my_hash_delete(&filehash, (uchar *) entry);
+			n_files++;
+
+			continue;
+		}
+
+		if (entry->offset != chunk.offset) {
+			msg("xtrabackup: error: %s: out-of-order chunk: real "
+			    "offset = 0x%llx, expected offset = 0x%llx\n",
+			    entry->path, chunk.offset, entry->offset);
+			goto err;
+		}
+
+		if (entry->qp != NULL) {
+			if (qp_decoder_write(entry->qp, entry->file,
+					     entry->path,
+					     (const uchar *) chunk.data,
+					     chunk.length)) {
+				goto err;
+			}
+		} else if (ds_write(entry->file, chunk.data, chunk.length)) {
+			msg("xtrabackup: error: %s: write failed.\n",
+			    entry->path);
+			goto err;
+		}
+
+		entry->offset += chunk.length;
+		n_bytes += chunk.length;
+	}
+
+	if (res == XB_STREAM_READ_ERROR) {
+		goto err;
+	}
+
+	if (filehash.records > 0) {
+		for (i = 0; i < filehash.records; i++) {
+			entry = (recv_file_t *) my_hash_element(&filehash, i);
+			msg("xtrabackup: error: the stream ended before %s "
+			    "was complete.\n", entry->path);
+		}
+		goto err;
+	}
+
+	msg("xtrabackup: received %lu files, %llu bytes from the stream.\n",
+	    n_files, n_bytes);
+
+	my_hash_free(&filehash);
+	xb_stream_read_done(stream);
+
+	return 0;
+
+err:
+	my_hash_free(&filehash);
+	xb_stream_read_done(stream);
+
+	return 1;
+}
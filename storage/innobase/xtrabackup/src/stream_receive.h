@@ -0,0 +1,40 @@
+/******************************************************
+Copyright (c) 2013 Percona LLC and/or its affiliates.
+
+Receiving a backup stream for xtrabackup --prepare.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*******************************************************/
+
+#ifndef XB_STREAM_RECEIVE_H
+#define XB_STREAM_RECEIVE_H
+
+#include "datasink.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Read an XBSTREAM stream from the standard input and write the files it
+contains to 'ds_ctxt'. Files compressed with --compress are decompressed on
+the fly and written without the .qp suffix. Returns non-zero on error,
+including a stream that ends before all files in it are complete. */
+int xb_stream_receive(ds_ctxt_t *ds_ctxt, my_bool verbose);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
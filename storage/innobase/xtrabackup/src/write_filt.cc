@@ -27,6 +27,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include "write_filt.h"
 #include "fil_cur.h"
 #include "xtrabackup.h"
+#include "buf_arena.h"
 
 /************************************************************************
 Write-through page write filter. */
@@ -74,12 +75,15 @@ wf_incremental_init(xb_write_filt_ctxt_t *ctxt, char *dst_name,
 
 	ctxt->cursor = cursor;
 
-	/* allocate buffer for incremental backup (4096 pages) */
-	buf_size = (UNIV_PAGE_SIZE_MAX / 4 + 1) * UNIV_PAGE_SIZE_MAX;
-	cp->delta_buf_base = static_cast<byte *>(ut_malloc(buf_size));
-	memset(cp->delta_buf_base, 0, buf_size);
+	/* allocate buffer for incremental backup (page_size / 4 pages and
+	the header page). The buffer is recycled, only the header page has to
+	be cleared, as only the filled part of the buffer is written. */
+	buf_size = (cursor->page_size / 4 + 1) * cursor->page_size;
+	cp->delta_buf_base = static_cast<byte *>
+		(xb_arena_alloc(buf_size + UNIV_PAGE_SIZE_MAX));
 	cp->delta_buf = static_cast<byte *>
 		(ut_align(cp->delta_buf_base, UNIV_PAGE_SIZE_MAX));
+	memset(cp->delta_buf, 0, cursor->page_size);
 
 	/* write delta meta info */
 	snprintf(meta_name, sizeof(meta_name), "%s%s", dst_name,
@@ -133,8 +137,8 @@ wf_incremental_process(xb_write_filt_ctxt_t *ctxt, ds_file_t *dstfile)
 				return(FALSE);
 			}
 
-			/* clear buffer */
-			memset(cp->delta_buf, 0, page_size / 4 * page_size);
+			/* clear the header page */
+			memset(cp->delta_buf, 0, page_size);
 			/*"xtra"*/
 			mach_write_to_4(cp->delta_buf, 0x78747261UL);
 			cp->npages = 1;
@@ -185,7 +189,7 @@ wf_incremental_deinit(xb_write_filt_ctxt_t *ctxt)
 	xb_wf_incremental_ctxt_t	*cp = &(ctxt->u.wf_incremental_ctxt);
 
 	if (cp->delta_buf_base != NULL) {
-		ut_free(cp->delta_buf_base);
+		xb_arena_free(cp->delta_buf_base);
 	}
 }
 
@@ -0,0 +1,1203 @@
+/******************************************************
+Copyright (c) 2013 Percona LLC and/or its affiliates.
+
+The xbbench utility: datasink pipeline throughput benchmark.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*******************************************************/
+
+/* Pushes synthetic or sampled InnoDB pages through a chain of datasinks
+configured the same way xtrabackup configures them, and reports throughput,
+CPU usage and write latencies for every stage of the chain.
+
+Each stage is preceded by a probe datasink that accounts bytes and the time
+spent in the stage and all stages below it. The time spent in the stage itself
+is the difference between two adjacent probes. */
+
+#include <my_base.h>
+#include <my_getopt.h>
+#include <my_rdtsc.h>
+#include <myisampack.h>
+#include <sys/resource.h>
+#include "common.h"
+#include "datasink.h"
+#include "ds_buffer.h"
+#include "ds_local.h"
+#include "ds_spool.h"
+#include "ds_tmpfile.h"
+#include "buf_arena.h"
+
+#define XBBENCH_VERSION "1.0"
+
+#define XBBENCH_MAX_STAGES 8
+
+/* Size of the pool of distinct synthetic pages */
+#define XBBENCH_SYNTHETIC_POOL_SIZE (4 * 1024 * 1024UL)
+
+/* Size of the per-file ring buffer used by the 'memory' sink */
+#define XBBENCH_MEMORY_SINK_SIZE (1024 * 1024UL)
+
+/* Compression and encryption options used by ds_compress.c and ds_encrypt.c.
+In xtrabackup they are defined in xtrabackup.cc. */
+uint		xtrabackup_compress_threads;
+ulonglong	xtrabackup_compress_chunk_size;
+ulong		xtrabackup_encrypt_algo;
+char		*xtrabackup_encrypt_key = NULL;
+char		*xtrabackup_encrypt_key_file = NULL;
+uint		xtrabackup_encrypt_threads;
+ulonglong	xtrabackup_encrypt_chunk_size;
+
+const char *xbbench_encrypt_algo_names[] =
+{ "NONE", "AES128", "AES192", "AES256", NullS};
+TYPELIB xbbench_encrypt_algo_typelib=
+{array_elements(xbbench_encrypt_algo_names)-1,"",
+	xbbench_encrypt_algo_names, NULL};
+
+const char *xbbench_local_write_mode_names[] =
+{ "fsync", "write-behind", "direct", NullS};
+TYPELIB xbbench_local_write_mode_typelib=
+{array_elements(xbbench_local_write_mode_names)-1,"",
+	xbbench_local_write_mode_names, NULL};
+
+/* Key used when neither --encrypt-key nor --encrypt-key-file is given */
+static const char xbbench_default_key[] = "percona_xtrabackup_is_awesome___";
+
+enum options_xbbench
+{
+	OPT_SAMPLE_SIZE = 256,
+	OPT_PAGE_SIZE,
+	OPT_FILL_FACTOR,
+	OPT_BUFFER_SIZE,
+	OPT_SPOOL_SIZE,
+	OPT_COMPRESS_THREADS,
+	OPT_COMPRESS_CHUNK_SIZE,
+	OPT_ENCRYPT,
+	OPT_ENCRYPT_KEY,
+	OPT_ENCRYPT_KEY_FILE,
+	OPT_ENCRYPT_THREADS,
+	OPT_ENCRYPT_CHUNK_SIZE,
+	OPT_LOCAL_WRITE_MODE,
+	OPT_LOCAL_WRITE_THREADS,
+	OPT_LOCAL_WRITE_QUEUE_SIZE,
+	OPT_BUFFER_MEMORY_LIMIT,
+	OPT_BUFFER_LARGE_PAGES
+};
+
+typedef enum {
+	STAGE_BUFFER,
+	STAGE_SPOOL,
+	STAGE_COMPRESS,
+	STAGE_ENCRYPT,
+	STAGE_XBSTREAM,
+	STAGE_ARCHIVE,
+	STAGE_LOCAL,
+	STAGE_STDOUT,
+	STAGE_MEMORY,
+	STAGE_NULL
+} stage_type_t;
+
+static const char *stage_names[] = {
+	"buffer", "spool", "compress", "encrypt", "xbstream", "archive", "local",
+	"stdout", "memory", "null", NullS
+};
+
+/* Per-stage statistics collected by a probe datasink */
+typedef struct {
+	stage_type_t	type;
+	ulonglong	bytes;		/* bytes written into the stage */
+	ulonglong	writes;		/* number of ds_write() calls */
+	ulonglong	time_ns;	/* time spent in the stage and below */
+	ulonglong	*lat;		/* ds_write() latencies in ns */
+	size_t		lat_n;
+	size_t		lat_size;
+	pthread_mutex_t	mutex;
+} stage_stats_t;
+
+typedef struct {
+	ds_file_t	*dst_file;
+	stage_stats_t	*stats;
+	ulonglong	bytes;
+	ulonglong	writes;
+	ulonglong	time_ns;
+	ulonglong	*lat;
+	size_t		lat_n;
+	size_t		lat_size;
+} ds_probe_file_t;
+
+typedef struct {
+	char		*buf;
+	size_t		pos;
+} ds_memory_file_t;
+
+typedef struct {
+	pthread_t	id;
+	uint		num;
+	my_bool		failed;
+} bench_thread_t;
+
+static char		*opt_pipeline = NULL;
+static char		*opt_input_file = NULL;
+static char		*opt_target_dir = NULL;
+static uint		opt_threads;
+static uint		opt_files;
+static ulonglong	opt_file_size;
+static ulonglong	opt_write_size;
+static ulonglong	opt_sample_size;
+static ulong		opt_page_size;
+static uint		opt_fill_factor;
+static ulonglong	opt_buffer_size;
+static ulonglong	opt_spool_size;
+static ulong		opt_local_write_mode;
+static uint		opt_local_write_threads;
+static ulonglong	opt_local_write_queue_size;
+static ulonglong	opt_buffer_memory_limit;
+static my_bool		opt_buffer_large_pages;
+
+static struct my_option my_long_options[] =
+{
+	{"help", '?', "Display this help and exit.",
+	 0, 0, 0, GET_NO_ARG, NO_ARG, 0, 0, 0, 0, 0, 0},
+
+	{"pipeline", 'p', "Comma-separated list of datasinks to push data "
+	 "through, from the source to the sink. Supported stages are "
+	 "'buffer', 'spool', 'compress', 'encrypt', 'xbstream' and 'archive'. "
+	 "The last stage must be one of 'local', 'stdout', 'memory' or 'null'. "
+	 "The default is 'compress,buffer,xbstream,null'.",
+	 &opt_pipeline, &opt_pipeline, 0,
+	 GET_STR_ALLOC, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
+
+	{"input", 'i', "Sample pages from the specified data file instead of "
+	 "generating synthetic pages.",
+	 &opt_input_file, &opt_input_file, 0,
+	 GET_STR_ALLOC, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
+
+	{"target-dir", 'C', "Destination directory for the 'local' sink.",
+	 &opt_target_dir, &opt_target_dir, 0,
+	 GET_STR_ALLOC, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
+
+	{"parallel", 'j', "Number of threads writing files to the pipeline "
+	 "concurrently, the same as xtrabackup --parallel. The default value "
+	 "is 1.",
+	 &opt_threads, &opt_threads, 0,
+	 GET_UINT, REQUIRED_ARG, 1, 1, UINT_MAX, 0, 0, 0},
+
+	{"files", 'n', "Number of files to write. The default value is 4.",
+	 &opt_files, &opt_files, 0,
+	 GET_UINT, REQUIRED_ARG, 4, 1, UINT_MAX, 0, 0, 0},
+
+	{"file-size", 's', "Size of each file in bytes. The default value is "
+	 "256M.",
+	 &opt_file_size, &opt_file_size, 0,
+	 GET_ULL, REQUIRED_ARG, 256 * 1024 * 1024ULL, 1024, ULONGLONG_MAX,
+	 0, 0, 0},
+
+	{"write-size", 'w', "Size of each write to the pipeline in bytes. The "
+	 "default value is 1M, i.e. what xtrabackup writes for 64 16K pages.",
+	 &opt_write_size, &opt_write_size, 0,
+	 GET_ULL, REQUIRED_ARG, 1024 * 1024, 512, 1024 * 1024 * 1024ULL,
+	 0, 0, 0},
+
+	{"sample-size", OPT_SAMPLE_SIZE, "Maximum number of bytes to "
+	 "sample from the --input file. The default value is 64M.",
+	 &opt_sample_size, &opt_sample_size, 0,
+	 GET_ULL, REQUIRED_ARG, 64 * 1024 * 1024ULL, 1024, ULONGLONG_MAX,
+	 0, 0, 0},
+
+	{"page-size", OPT_PAGE_SIZE, "Page size of synthetic "
+	 "pages. The default value is 16K.",
+	 &opt_page_size, &opt_page_size, 0,
+	 GET_ULONG, REQUIRED_ARG, 16384, 1024, 65536, 0, 1024, 0},
+
+	{"fill-factor", OPT_FILL_FACTOR, "Percentage of each "
+	 "synthetic page filled with random (incompressible) data, the rest "
+	 "is zero-filled. The default value is 50.",
+	 &opt_fill_factor, &opt_fill_factor, 0,
+	 GET_UINT, REQUIRED_ARG, 50, 0, 100, 0, 0, 0},
+
+	{"buffer-size", OPT_BUFFER_SIZE, "Buffer size for the "
+	 "'buffer' stage. The default value is 1M, i.e. the one xtrabackup "
+	 "uses for compressed output.",
+	 &opt_buffer_size, &opt_buffer_size, 0,
+	 GET_ULL, REQUIRED_ARG, 1024 * 1024, 1024, ULONGLONG_MAX, 0, 0, 0},
+
+	{"spool-size", OPT_SPOOL_SIZE, "Memory buffer size per file for the "
+	 "'spool' stage. The default value is 16M, the same as xtrabackup "
+	 "--stream-spool-size.",
+	 &opt_spool_size, &opt_spool_size, 0,
+	 GET_ULL, REQUIRED_ARG, 16 * 1024 * 1024, 64 * 1024, ULONGLONG_MAX,
+	 0, 1024, 0},
+
+	{"compress-threads", OPT_COMPRESS_THREADS,
+	 "Number of threads for parallel data compression. The default value "
+	 "is 1.",
+	 &xtrabackup_compress_threads, &xtrabackup_compress_threads,
+	 0, GET_UINT, REQUIRED_ARG, 1, 1, UINT_MAX, 0, 0, 0},
+
+	{"compress-chunk-size", OPT_COMPRESS_CHUNK_SIZE,
+	 "Size of working buffer(s) for compression threads in bytes. The "
+	 "default value is 64K.",
+	 &xtrabackup_compress_chunk_size, &xtrabackup_compress_chunk_size,
+	 0, GET_ULL, REQUIRED_ARG, (1 << 16), 1024, ULONGLONG_MAX, 0, 0, 0},
+
+	{"encrypt", OPT_ENCRYPT, "Encryption algorithm for the "
+	 "'encrypt' stage. The default is AES256.",
+	 &xtrabackup_encrypt_algo, &xtrabackup_encrypt_algo,
+	 &xbbench_encrypt_algo_typelib, GET_ENUM, REQUIRED_ARG, 3, 0, 0,
+	 0, 0, 0},
+
+	{"encrypt-key", OPT_ENCRYPT_KEY, "Encryption key to use.",
+	 &xtrabackup_encrypt_key, &xtrabackup_encrypt_key, 0,
+	 GET_STR_ALLOC, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
+
+	{"encrypt-key-file", OPT_ENCRYPT_KEY_FILE,
+	 "File which contains encryption key to use.",
+	 &xtrabackup_encrypt_key_file, &xtrabackup_encrypt_key_file, 0,
+	 GET_STR_ALLOC, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
+
+	{"encrypt-threads", OPT_ENCRYPT_THREADS,
+	 "Number of threads for parallel data encryption. The default value "
+	 "is 1.",
+	 &xtrabackup_encrypt_threads, &xtrabackup_encrypt_threads,
+	 0, GET_UINT, REQUIRED_ARG, 1, 1, UINT_MAX, 0, 0, 0},
+
+	{"encrypt-chunk-size", OPT_ENCRYPT_CHUNK_SIZE,
+	 "Size of working buffer(s) for encryption threads in bytes. The "
+	 "default value is 64K.",
+	 &xtrabackup_encrypt_chunk_size, &xtrabackup_encrypt_chunk_size,
+	 0, GET_ULL, REQUIRED_ARG, (1 << 16), 1024, ULONGLONG_MAX, 0, 0, 0},
+
+	{"local-write-mode", OPT_LOCAL_WRITE_MODE, "Write mode of the "
+	 "'local' sink: 'fsync', 'write-behind' or 'direct'. The default is "
+	 "'fsync', i.e. what xtrabackup uses by default.",
+	 &opt_local_write_mode, &opt_local_write_mode,
+	 &xbbench_local_write_mode_typelib, GET_ENUM, REQUIRED_ARG,
+	 DS_LOCAL_FSYNC, 0, 0, 0, 0, 0},
+
+	{"local-write-threads", OPT_LOCAL_WRITE_THREADS,
+	 "Number of writer threads of the 'local' sink in the 'write-behind' "
+	 "and 'direct' modes. The default value is 1.",
+	 &opt_local_write_threads, &opt_local_write_threads,
+	 0, GET_UINT, REQUIRED_ARG, 1, 1, UINT_MAX, 0, 0, 0},
+
+	{"local-write-queue-size", OPT_LOCAL_WRITE_QUEUE_SIZE,
+	 "Maximum amount of data queued for the writer threads of the 'local' "
+	 "sink. The default value is 64M.",
+	 &opt_local_write_queue_size, &opt_local_write_queue_size,
+	 0, GET_ULL, REQUIRED_ARG, 64 * 1024 * 1024ULL, 1024 * 1024,
+	 ULONGLONG_MAX, 0, 0, 0},
+
+	{"buffer-memory-limit", OPT_BUFFER_MEMORY_LIMIT,
+	 "Memory limit of the datasink buffers, as with xtrabackup. The "
+	 "default value is 0 (no limit).",
+	 &opt_buffer_memory_limit, &opt_buffer_memory_limit,
+	 0, GET_ULL, REQUIRED_ARG, 0, 0, ULONGLONG_MAX, 0, 0, 0},
+
+	{"buffer-large-pages", OPT_BUFFER_LARGE_PAGES,
+	 "Allocate large datasink buffers from the reserved huge pages, as "
+	 "with xtrabackup.",
+	 &opt_buffer_large_pages, &opt_buffer_large_pages,
+	 0, GET_BOOL, NO_ARG, 0, 0, 0, 0, 0, 0},
+
+	{0, 0, 0, 0, 0, 0, GET_NO_ARG, NO_ARG, 0, 0, 0, 0, 0, 0}
+};
+
+static stage_type_t	stages[XBBENCH_MAX_STAGES];
+static uint		n_stages = 0;
+static stage_stats_t	stage_stats[XBBENCH_MAX_STAGES];
+static ds_ctxt_t	*stage_ctxts[XBBENCH_MAX_STAGES];
+static ds_ctxt_t	*probe_ctxts[XBBENCH_MAX_STAGES];
+
+/* Source data, shared read-only by all writer threads */
+static char		*src_buf = NULL;
+static size_t		src_len = 0;
+
+static pthread_mutex_t	next_file_mutex;
+static uint		next_file = 0;
+
+static int get_options(int *argc, char ***argv);
+static my_bool get_one_option(int optid, const struct my_option *opt,
+			      char *argument);
+static void usage(void);
+
+/***********************************************************************
+Probe datasink. Passes everything through to the next stage and accounts the
+time spent there. */
+
+static ds_file_t *probe_open(ds_ctxt_t *ctxt, const char *path,
+			     MY_STAT *mystat);
+static int probe_write(ds_file_t *file, const void *buf, size_t len);
+static int probe_close(ds_file_t *file);
+static void probe_deinit(ds_ctxt_t *ctxt);
+
+static datasink_t datasink_probe = {
+	NULL,
+	&probe_open,
+	&probe_write,
+	&probe_close,
+	&probe_deinit
+};
+
+static
+ds_ctxt_t *
+probe_create(stage_stats_t *stats, ds_ctxt_t *stage_ctxt)
+{
+	ds_ctxt_t	*ctxt;
+
+	ctxt = (ds_ctxt_t *) my_malloc(sizeof(ds_ctxt_t), MYF(MY_FAE));
+
+	ctxt->datasink = &datasink_probe;
+	ctxt->root = NULL;
+	ctxt->ptr = stats;
+	ctxt->pipe_ctxt = stage_ctxt;
+
+	return ctxt;
+}
+
+static
+ds_file_t *
+probe_open(ds_ctxt_t *ctxt, const char *path, MY_STAT *mystat)
+{
+	ds_file_t	*file;
+	ds_probe_file_t	*probe_file;
+	ds_file_t	*dst_file;
+	ulonglong	start;
+
+	start = my_timer_nanoseconds();
+
+	dst_file = ds_open(ctxt->pipe_ctxt, path, mystat);
+	if (dst_file == NULL) {
+		return NULL;
+	}
+
+	file = (ds_file_t *) my_malloc(sizeof(ds_file_t) +
+				       sizeof(ds_probe_file_t),
+				       MYF(MY_FAE | MY_ZEROFILL));
+	probe_file = (ds_probe_file_t *) (file + 1);
+
+	probe_file->dst_file = dst_file;
+	probe_file->stats = (stage_stats_t *) ctxt->ptr;
+	probe_file->time_ns = my_timer_nanoseconds() - start;
+
+	file->ptr = probe_file;
+	file->path = dst_file->path;
+
+	return file;
+}
+
+static
+int
+probe_write(ds_file_t *file, const void *buf, size_t len)
+{
+	ds_probe_file_t	*probe_file;
+	ulonglong	start;
+	ulonglong	lat;
+	int		rc;
+
+	probe_file = (ds_probe_file_t *) file->ptr;
+
+	start = my_timer_nanoseconds();
+	rc = ds_write(probe_file->dst_file, buf, len);
+	lat = my_timer_nanoseconds() - start;
+
+	if (probe_file->lat_n == probe_file->lat_size) {
+		probe_file->lat_size = probe_file->lat_size ?
+			probe_file->lat_size * 2 : 1024;
+		probe_file->lat = (ulonglong *)
+			my_realloc(probe_file->lat,
+				   probe_file->lat_size * sizeof(ulonglong),
+				   MYF(MY_FAE | MY_ALLOW_ZERO_PTR));
+	}
+	probe_file->lat[probe_file->lat_n++] = lat;
+
+	probe_file->bytes += len;
+	probe_file->writes++;
+	probe_file->time_ns += lat;
+
+	return rc;
+}
+
+static
+int
+probe_close(ds_file_t *file)
+{
+	ds_probe_file_t	*probe_file;
+	stage_stats_t	*stats;
+	ulonglong	start;
+	int		rc;
+
+	probe_file = (ds_probe_file_t *) file->ptr;
+	stats = probe_file->stats;
+
+	start = my_timer_nanoseconds();
+	rc = ds_close(probe_file->dst_file);
+	probe_file->time_ns += my_timer_nanoseconds() - start;
+
+	/* Merge the per-file counters into the stage statistics */
+	pthread_mutex_lock(&stats->mutex);
+
+	stats->bytes += probe_file->bytes;
+	stats->writes += probe_file->writes;
+	stats->time_ns += probe_file->time_ns;
+
+	if (probe_file->lat_n > 0) {
+		if (stats->lat_n + probe_file->lat_n > stats->lat_size) {
+			stats->lat_size = stats->lat_n + probe_file->lat_n;
+			stats->lat = (ulonglong *)
+				my_realloc(stats->lat,
+					   stats->lat_size * sizeof(ulonglong),
+					   MYF(MY_FAE | MY_ALLOW_ZERO_PTR));
+		}
+		memcpy(stats->lat + stats->lat_n, probe_file->lat,
+		       probe_file->lat_n * sizeof(ulonglong));
+		stats->lat_n += probe_file->lat_n;
+	}
+
+	pthread_mutex_unlock(&stats->mutex);
+
+	my_free(probe_file->lat);
+	my_free(file);
+
+	return rc;
+}
+
+static
+void
+probe_deinit(ds_ctxt_t *ctxt)
+{
+	my_free(ctxt);
+}
+
+/***********************************************************************
+Terminal datasinks which do not touch the filesystem. 'null' discards the
+data, 'memory' copies it into a per-file ring buffer. */
+
+static ds_ctxt_t *sink_init(const char *root);
+static ds_file_t *sink_open(ds_ctxt_t *ctxt, const char *path,
+			    MY_STAT *mystat);
+static int null_write(ds_file_t *file, const void *buf, size_t len);
+static int memory_write(ds_file_t *file, const void *buf, size_t len);
+static int sink_close(ds_file_t *file);
+static void sink_deinit(ds_ctxt_t *ctxt);
+
+static datasink_t datasink_null = {
+	&sink_init,
+	&sink_open,
+	&null_write,
+	&sink_close,
+	&sink_deinit
+};
+
+static datasink_t datasink_memory = {
+	&sink_init,
+	&sink_open,
+	&memory_write,
+	&sink_close,
+	&sink_deinit
+};
+
+static
+ds_ctxt_t *
+sink_init(const char *root)
+{
+	ds_ctxt_t	*ctxt;
+
+	ctxt = (ds_ctxt_t *) my_malloc(sizeof(ds_ctxt_t),
+				       MYF(MY_FAE | MY_ZEROFILL));
+	ctxt->root = my_strdup(root, MYF(MY_FAE));
+
+	return ctxt;
+}
+
+static
+ds_file_t *
+sink_open(ds_ctxt_t *ctxt, const char *path __attribute__((unused)),
+	  MY_STAT *mystat __attribute__((unused)))
+{
+	ds_file_t		*file;
+	ds_memory_file_t	*memory_file;
+	my_bool			is_memory;
+
+	is_memory = (ctxt->datasink == &datasink_memory);
+
+	file = (ds_file_t *) my_malloc(sizeof(ds_file_t) +
+				       sizeof(ds_memory_file_t) +
+				       (is_memory ?
+					XBBENCH_MEMORY_SINK_SIZE : 0),
+				       MYF(MY_FAE));
+	memory_file = (ds_memory_file_t *) (file + 1);
+	memory_file->buf = (char *) (memory_file + 1);
+	memory_file->pos = 0;
+
+	file->ptr = memory_file;
+	file->path = (char *) (is_memory ? "<MEMORY>" : "<NULL>");
+
+	return file;
+}
+
+static
+int
+null_write(ds_file_t *file __attribute__((unused)),
+	   const void *buf __attribute__((unused)),
+	   size_t len __attribute__((unused)))
+{
+	return 0;
+}
+
+static
+int
+memory_write(ds_file_t *file, const void *buf, size_t len)
+{
+	ds_memory_file_t	*memory_file;
+
+	memory_file = (ds_memory_file_t *) file->ptr;
+
+	while (len > 0) {
+		size_t	bytes;
+
+		bytes = XBBENCH_MEMORY_SINK_SIZE - memory_file->pos;
+		if (bytes > len) {
+			bytes = len;
+		}
+
+		memcpy(memory_file->buf + memory_file->pos, buf, bytes);
+
+		memory_file->pos = (memory_file->pos + bytes) %
+			XBBENCH_MEMORY_SINK_SIZE;
+		buf = (const char *) buf + bytes;
+		len -= bytes;
+	}
+
+	return 0;
+}
+
+static
+int
+sink_close(ds_file_t *file)
+{
+	my_free(file);
+
+	return 0;
+}
+
+static
+void
+sink_deinit(ds_ctxt_t *ctxt)
+{
+	my_free(ctxt->root);
+	my_free(ctxt);
+}
+
+/***********************************************************************
+Parse the --pipeline option value.
+@return 0 on success, 1 on error. */
+static
+int
+parse_pipeline(const char *spec)
+{
+	char	buf[256];
+	char	*token;
+	char	*saveptr;
+	uint	i;
+
+	strmake(buf, spec, sizeof(buf) - 1);
+
+	for (token = strtok_r(buf, ",", &saveptr); token != NULL;
+	     token = strtok_r(NULL, ",", &saveptr)) {
+
+		for (i = 0; stage_names[i] != NullS; i++) {
+			if (!strcasecmp(token, stage_names[i])) {
+				break;
+			}
+		}
+
+		if (stage_names[i] == NullS) {
+			msg("%s: unknown pipeline stage '%s'.\n", my_progname,
+			    token);
+			return 1;
+		}
+
+		if (n_stages == XBBENCH_MAX_STAGES) {
+			msg("%s: too many pipeline stages.\n", my_progname);
+			return 1;
+		}
+
+		stages[n_stages++] = (stage_type_t) i;
+	}
+
+	if (n_stages == 0) {
+		msg("%s: empty pipeline.\n", my_progname);
+		return 1;
+	}
+
+	for (i = 0; i < n_stages; i++) {
+		my_bool	is_sink = stages[i] >= STAGE_LOCAL;
+
+		if (is_sink != (i == n_stages - 1)) {
+			msg("%s: the pipeline must end with exactly one of "
+			    "'local', 'stdout', 'memory' or 'null'.\n",
+			    my_progname);
+			return 1;
+		}
+		if (stages[i] == STAGE_ARCHIVE && opt_threads > 1 &&
+		    (i == 0 || stages[i - 1] != STAGE_SPOOL)) {
+			msg("%s: the 'archive' stage requires a 'spool' stage "
+			    "in front of it with --parallel > 1.\n",
+			    my_progname);
+			return 1;
+		}
+	}
+
+	if (stages[n_stages - 1] == STAGE_LOCAL && opt_target_dir == NULL) {
+		msg("%s: the 'local' sink requires --target-dir.\n",
+		    my_progname);
+		return 1;
+	}
+
+	return 0;
+}
+
+/***********************************************************************
+@return TRUE if the pipeline has a stage of the given type. */
+static
+my_bool
+have_stage(stage_type_t type)
+{
+	uint	i;
+
+	for (i = 0; i < n_stages; i++) {
+		if (stages[i] == type) {
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/***********************************************************************
+Create the datasink chain from the sink back to the source, putting a probe in
+front of every stage.
+@return the head of the chain. */
+static
+ds_ctxt_t *
+create_pipeline(void)
+{
+	ds_ctxt_t	*next = NULL;
+	const char	*root;
+	uint		i;
+
+	root = opt_target_dir ? opt_target_dir : ".";
+
+	for (i = n_stages; i > 0; i--) {
+		stage_type_t	type = stages[i - 1];
+		ds_ctxt_t	*ctxt;
+
+		switch (type) {
+		case STAGE_BUFFER:
+			ctxt = ds_create(root, DS_TYPE_BUFFER);
+			ds_buffer_set_size(ctxt, (size_t) opt_buffer_size);
+			break;
+		case STAGE_SPOOL:
+			ctxt = ds_create(root, DS_TYPE_SPOOL);
+			ds_spool_set_size(ctxt, (size_t) opt_spool_size);
+			break;
+		case STAGE_COMPRESS:
+			ctxt = ds_create(root, DS_TYPE_COMPRESS);
+			break;
+		case STAGE_ENCRYPT:
+			ctxt = ds_create(root, DS_TYPE_ENCRYPT);
+			break;
+		case STAGE_XBSTREAM:
+			ctxt = ds_create(root, DS_TYPE_XBSTREAM);
+			break;
+		case STAGE_ARCHIVE:
+			ctxt = ds_create(root, DS_TYPE_ARCHIVE);
+			break;
+		case STAGE_LOCAL:
+			ctxt = ds_create(root, DS_TYPE_LOCAL);
+			if (ds_local_set_mode(ctxt,
+					      (ds_local_mode_t)
+					      opt_local_write_mode,
+					      opt_local_write_threads,
+					      (size_t)
+					      opt_local_write_queue_size)) {
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case STAGE_STDOUT:
+			ctxt = ds_create(root, DS_TYPE_STDOUT);
+			break;
+		case STAGE_MEMORY:
+			ctxt = datasink_memory.init(root);
+			ctxt->datasink = &datasink_memory;
+			break;
+		case STAGE_NULL:
+		default:
+			ctxt = datasink_null.init(root);
+			ctxt->datasink = &datasink_null;
+			break;
+		}
+
+		if (next != NULL) {
+			ds_set_pipe(ctxt, next);
+		}
+
+		stage_stats[i - 1].type = type;
+		pthread_mutex_init(&stage_stats[i - 1].mutex, NULL);
+
+		stage_ctxts[i - 1] = ctxt;
+		probe_ctxts[i - 1] = probe_create(&stage_stats[i - 1], ctxt);
+
+		next = probe_ctxts[i - 1];
+	}
+
+	return next;
+}
+
+/***********************************************************************
+Destroy the datasink chain starting from the source so that every stage can
+flush its data down the pipeline. */
+static
+void
+destroy_pipeline(void)
+{
+	uint	i;
+
+	for (i = 0; i < n_stages; i++) {
+		ds_destroy(stage_ctxts[i]);
+		ds_destroy(probe_ctxts[i]);
+	}
+}
+
+/***********************************************************************
+Generate a pool of synthetic pages. Every page gets a valid-looking FIL header
+and trailer, and opt_fill_factor percent of its body is filled with random
+bytes. */
+static
+void
+init_synthetic_source(void)
+{
+	ulonglong	rnd = 0x9E3779B97F4A7C15ULL;
+	size_t		page_no;
+	size_t		n_pages;
+	size_t		fill;
+
+	src_len = XBBENCH_SYNTHETIC_POOL_SIZE;
+	if (src_len < opt_write_size) {
+		src_len = (size_t) opt_write_size;
+	}
+	src_len -= src_len % opt_page_size;
+
+	src_buf = (char *) my_malloc(src_len, MYF(MY_FAE | MY_ZEROFILL));
+
+	n_pages = src_len / opt_page_size;
+	fill = (opt_page_size - 38 - 8) * opt_fill_factor / 100;
+
+	for (page_no = 0; page_no < n_pages; page_no++) {
+		uchar	*page = (uchar *) src_buf + page_no * opt_page_size;
+		size_t	i;
+
+		/* FIL_PAGE_OFFSET, FIL_PAGE_LSN and FIL_PAGE_TYPE_INDEX */
+		mi_int4store(page + 4, page_no);
+		mi_int4store(page + 20, page_no * 100);
+		mi_int2store(page + 24, 17855);
+
+		for (i = 0; i < fill; i++) {
+			/* xorshift64 */
+			rnd ^= rnd << 13;
+			rnd ^= rnd >> 7;
+			rnd ^= rnd << 17;
+			page[38 + i] = (uchar) rnd;
+		}
+
+		mi_int4store(page + opt_page_size - 4, page_no * 100);
+	}
+}
+
+/***********************************************************************
+Read up to opt_sample_size bytes from the --input file.
+@return 0 on success, 1 on error. */
+static
+int
+init_sampled_source(void)
+{
+	MY_STAT	mystat;
+	File	fd;
+	size_t	len;
+
+	if (my_stat(opt_input_file, &mystat, MYF(MY_WME)) == NULL) {
+		return 1;
+	}
+
+	len = (size_t) MY_MIN((ulonglong) mystat.st_size, opt_sample_size);
+	if (len == 0) {
+		msg("%s: input file '%s' is empty.\n", my_progname,
+		    opt_input_file);
+		return 1;
+	}
+
+	fd = my_open(opt_input_file, O_RDONLY, MYF(MY_WME));
+	if (fd < 0) {
+		return 1;
+	}
+
+	src_buf = (char *) my_malloc(len, MYF(MY_FAE));
+
+	if (my_read(fd, (uchar *) src_buf, len, MYF(MY_WME | MY_NABP))) {
+		my_close(fd, MYF(MY_WME));
+		return 1;
+	}
+
+	my_close(fd, MYF(0));
+
+	src_len = len;
+
+	return 0;
+}
+
+/***********************************************************************
+Write one file of opt_file_size bytes to the pipeline.
+@return 0 on success, 1 on error. */
+static
+int
+bench_one_file(ds_ctxt_t *head, uint file_no)
+{
+	char		path[FN_REFLEN];
+	MY_STAT		mystat;
+	ds_file_t	*file;
+	ulonglong	left;
+	size_t		offset = 0;
+
+	snprintf(path, sizeof(path), "xbbench/file_%u.ibd", file_no);
+
+	memset(&mystat, 0, sizeof(mystat));
+	mystat.st_size = opt_file_size;
+	mystat.st_mtime = my_time(0);
+
+	file = ds_open(head, path, &mystat);
+	if (file == NULL) {
+		msg("%s: cannot open %s in the pipeline.\n", my_progname,
+		    path);
+		return 1;
+	}
+
+	for (left = opt_file_size; left > 0; ) {
+		size_t	len = (size_t) MY_MIN(left, opt_write_size);
+
+		if (len > src_len - offset) {
+			len = src_len - offset;
+		}
+
+		if (ds_write(file, src_buf + offset, len)) {
+			msg("%s: write to %s failed.\n", my_progname, path);
+			ds_close(file);
+			return 1;
+		}
+
+		offset = (offset + len) % src_len;
+		left -= len;
+	}
+
+	return ds_close(file);
+}
+
+static
+void *
+bench_thread_func(void *arg)
+{
+	bench_thread_t	*thd = (bench_thread_t *) arg;
+	ds_ctxt_t	*head = probe_ctxts[0];
+
+	my_thread_init();
+
+	for (;;) {
+		uint	file_no;
+
+		pthread_mutex_lock(&next_file_mutex);
+		file_no = next_file++;
+		pthread_mutex_unlock(&next_file_mutex);
+
+		if (file_no >= opt_files) {
+			break;
+		}
+
+		if (bench_one_file(head, file_no)) {
+			thd->failed = TRUE;
+			break;
+		}
+	}
+
+	my_thread_end();
+
+	return NULL;
+}
+
+static
+int
+cmp_ulonglong(const void *a, const void *b)
+{
+	ulonglong	x = *(const ulonglong *) a;
+	ulonglong	y = *(const ulonglong *) b;
+
+	return (x > y) - (x < y);
+}
+
+/***********************************************************************
+Return the given percentile of sorted latencies in microseconds. */
+static
+double
+percentile_us(const stage_stats_t *stats, double pct)
+{
+	size_t	i;
+
+	if (stats->lat_n == 0) {
+		return 0.0;
+	}
+
+	i = (size_t) (pct / 100.0 * (stats->lat_n - 1) + 0.5);
+
+	return stats->lat[i] / 1000.0;
+}
+
+static
+double
+tv_to_sec(const struct timeval *tv)
+{
+	return tv->tv_sec + tv->tv_usec / 1000000.0;
+}
+
+static
+void
+print_report(ulonglong wall_ns, const struct rusage *ru_start,
+	     const struct rusage *ru_end)
+{
+	ulonglong	total = (ulonglong) opt_files * opt_file_size;
+	double		wall = wall_ns / 1e9;
+	double		user;
+	double		sys;
+	uint		i;
+	xb_arena_stats_t arena_stats;
+
+	user = tv_to_sec(&ru_end->ru_utime) - tv_to_sec(&ru_start->ru_utime);
+	sys = tv_to_sec(&ru_end->ru_stime) - tv_to_sec(&ru_start->ru_stime);
+
+	msg("%s: %u file(s), %llu bytes, %u thread(s), %.3f s, %.1f MB/s\n",
+	    my_progname, opt_files, total, opt_threads, wall,
+	    total / wall / (1024 * 1024));
+	msg("%s: CPU %.3f s (user %.3f s, sys %.3f s), %.3f ns/byte\n",
+	    my_progname, user + sys, user, sys,
+	    (user + sys) * 1e9 / total);
+
+	msg("%-9s %14s %14s %6s %10s %9s %9s %9s %9s %9s %9s\n",
+	    "stage", "bytes in", "bytes out", "ratio", "writes", "self s",
+	    "MB/s", "p50 us", "p90 us", "p99 us", "max us");
+
+	for (i = 0; i < n_stages; i++) {
+		stage_stats_t	*stats = &stage_stats[i];
+		ulonglong	out;
+		ulonglong	self_ns;
+		double		self;
+
+		out = (i + 1 < n_stages) ? stage_stats[i + 1].bytes : 0;
+		self_ns = stats->time_ns;
+		if (i + 1 < n_stages) {
+			self_ns = (self_ns > stage_stats[i + 1].time_ns) ?
+				self_ns - stage_stats[i + 1].time_ns : 0;
+		}
+		self = self_ns / 1e9;
+
+		qsort(stats->lat, stats->lat_n, sizeof(ulonglong),
+		      cmp_ulonglong);
+
+		msg("%-9s %14llu %14llu %6.3f %10llu %9.3f %9.1f "
+		    "%9.1f %9.1f %9.1f %9.1f\n",
+		    stage_names[stats->type], stats->bytes, out,
+		    (out && stats->bytes) ? (double) out / stats->bytes : 0.0,
+		    stats->writes, self,
+		    self > 0 ? stats->bytes / self / (1024 * 1024) : 0.0,
+		    percentile_us(stats, 50), percentile_us(stats, 90),
+		    percentile_us(stats, 99), percentile_us(stats, 100));
+	}
+
+	xb_arena_get_stats(&arena_stats);
+	msg("%s: buffer memory %llu bytes peak, %llu of %llu allocations "
+	    "reused, %llu waits\n", my_progname, arena_stats.peak,
+	    arena_stats.n_reused, arena_stats.n_allocs, arena_stats.n_waits);
+}
+
+int
+main(int argc, char **argv)
+{
+	bench_thread_t	*threads = NULL;
+	struct rusage	ru_start;
+	struct rusage	ru_end;
+	ulonglong	start;
+	ulonglong	wall_ns;
+	my_bool		failed = FALSE;
+	uint		i;
+
+	MY_INIT(argv[0]);
+
+	if (get_options(&argc, &argv)) {
+		goto err;
+	}
+
+	if (parse_pipeline(opt_pipeline ? opt_pipeline :
+			   "compress,buffer,xbstream,null")) {
+		goto err;
+	}
+
+	/* The 'spool' stage spills to temporary files */
+	if (have_stage(STAGE_SPOOL) &&
+	    init_tmpdir(&mysql_tmpdir_list, NULL)) {
+		goto err;
+	}
+
+	if (have_stage(STAGE_ENCRYPT) &&
+	    xtrabackup_encrypt_key == NULL &&
+	    xtrabackup_encrypt_key_file == NULL) {
+		xtrabackup_encrypt_key = my_strdup(xbbench_default_key,
+						   MYF(MY_FAE));
+	}
+
+	if (opt_input_file) {
+		if (init_sampled_source()) {
+			goto err;
+		}
+	} else {
+		init_synthetic_source();
+	}
+
+	xb_arena_set_limit(opt_buffer_memory_limit);
+	xb_arena_set_large_pages(opt_buffer_large_pages);
+
+	create_pipeline();
+
+	pthread_mutex_init(&next_file_mutex, NULL);
+
+	threads = (bench_thread_t *) my_malloc(sizeof(bench_thread_t) *
+					       opt_threads,
+					       MYF(MY_FAE | MY_ZEROFILL));
+
+	getrusage(RUSAGE_SELF, &ru_start);
+	start = my_timer_nanoseconds();
+
+	for (i = 0; i < opt_threads; i++) {
+		threads[i].num = i + 1;
+		if (pthread_create(&threads[i].id, NULL, bench_thread_func,
+				   threads + i)) {
+			msg("%s: pthread_create() failed: errno = %d\n",
+			    my_progname, errno);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	for (i = 0; i < opt_threads; i++) {
+		pthread_join(threads[i].id, NULL);
+		failed |= threads[i].failed;
+	}
+
+	destroy_pipeline();
+
+	if (have_stage(STAGE_ENCRYPT)) {
+		/* encrypt_deinit() has already freed both of them */
+		xtrabackup_encrypt_key = NULL;
+		xtrabackup_encrypt_key_file = NULL;
+	}
+
+	wall_ns = my_timer_nanoseconds() - start;
+	getrusage(RUSAGE_SELF, &ru_end);
+
+	if (failed) {
+		goto err;
+	}
+
+	print_report(wall_ns, &ru_start, &ru_end);
+
+	for (i = 0; i < n_stages; i++) {
+		my_free(stage_stats[i].lat);
+		pthread_mutex_destroy(&stage_stats[i].mutex);
+	}
+	pthread_mutex_destroy(&next_file_mutex);
+	my_free(threads);
+	my_free(src_buf);
+
+	my_cleanup_options(my_long_options);
+
+	my_end(0);
+
+	return EXIT_SUCCESS;
+err:
+	my_cleanup_options(my_long_options);
+
+	my_end(0);
+
+	exit(EXIT_FAILURE);
+}
+
+static
+int
+get_options(int *argc, char ***argv)
+{
+	int ho_error;
+
+	if ((ho_error= handle_options(argc, argv, my_long_options,
+				      get_one_option))) {
+		exit(EXIT_FAILURE);
+	}
+
+	return 0;
+}
+
+static
+my_bool
+get_one_option(int optid, const struct my_option *opt __attribute__((unused)),
+	       char *argument __attribute__((unused)))
+{
+	switch (optid) {
+	case '?':
+		usage();
+		exit(0);
+	}
+
+	return FALSE;
+}
+
+static
+void
+print_version(void)
+{
+	printf("%s  Ver %s for %s (%s)\n", my_progname, XBBENCH_VERSION,
+	       SYSTEM_TYPE, MACHINE_TYPE);
+}
+
+static
+void
+usage(void)
+{
+	print_version();
+	puts("Copyright (C) 2013 Percona LLC and/or its affiliates.");
+	puts("This software comes with ABSOLUTELY NO WARRANTY. "
+	     "This is free software,\nand you are welcome to modify and "
+	     "redistribute it under the GPL license.\n");
+
+	puts("Measure throughput of XtraBackup datasink pipelines.\n");
+
+	puts("Usage: ");
+	printf("  %s [OPTIONS...]	# push pages through the datasinks "
+	       "specified with --pipeline and report per-stage statistics.\n",
+	       my_progname);
+	puts("\nOptions:");
+	my_print_help(my_long_options);
+}
@@ -20,6 +20,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 #include <my_base.h>
 #include <my_getopt.h>
+#include <my_dir.h>
 #include "common.h"
 #include "xbcrypt.h"
 #include <gcrypt.h>
@@ -48,6 +49,9 @@ static char 		*opt_encrypt_key_file = NULL;
 static void 		*opt_encrypt_key = NULL;
 static ulonglong	opt_encrypt_chunk_size = 0;
 static my_bool		opt_verbose = FALSE;
+static uint		opt_encrypt_threads = 1;
+static uint		opt_parallel = 1;
+static my_bool		opt_remove_original = FALSE;
 
 static uint 		encrypt_algos[] = { GCRY_CIPHER_NONE,
 					    GCRY_CIPHER_AES128,
@@ -60,6 +64,40 @@ static const unsigned char v1_encrypt_iv[] =
 			    "Percona Xtrabackup is Awesome!!!";
 static size_t 		encrypt_iv_len = 0;
 
+#define XBCRYPT_EXT	".xbcrypt"
+
+/* Chunk encryption/decryption worker thread context */
+typedef struct {
+	pthread_t		id;
+	uint			num;
+	pthread_mutex_t 	ctrl_mutex;
+	pthread_cond_t		ctrl_cond;
+	pthread_mutex_t		data_mutex;
+	pthread_cond_t  	data_cond;
+	my_bool			started;
+	my_bool			data_avail;
+	my_bool			cancelled;
+	my_bool			failed;
+	run_mode_t		mode;
+	char			*from;
+	size_t			from_size;
+	size_t			from_len;
+	char			*to;
+	size_t			to_size;
+	size_t			to_len;
+	char			*iv;
+	size_t			iv_len;
+	gcry_cipher_hd_t	cipher_handle;
+} crypt_thread_ctxt_t;
+
+/* Files to decrypt in the directory mode, shared by the file threads */
+typedef struct {
+	DYNAMIC_ARRAY		files;
+	uint			next;
+	my_bool			failed;
+	pthread_mutex_t		mutex;
+} decrypt_dir_ctxt_t;
+
 static struct my_option my_long_options[] =
 {
 	{"help", '?', "Display this help and exit.",
@@ -70,7 +108,9 @@ static struct my_option my_long_options[] =
 	 GET_NO_ARG, NO_ARG, 0, 0, 0, 0, 0, 0},
 
 	{"input", 'i', "Optional input file. If not specified, input"
-	 " will be read from standard input.",
+	 " will be read from standard input. With --decrypt, this can be a"
+	 " directory in which case all " XBCRYPT_EXT " files found in it"
+	 " are decrypted in place.",
 	 &opt_input_file, &opt_input_file, 0,
 	 GET_STR_ALLOC, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
 
@@ -96,6 +136,21 @@ static struct my_option my_long_options[] =
 	 &opt_encrypt_chunk_size, &opt_encrypt_chunk_size, 0,
 	GET_ULL, REQUIRED_ARG, (1 << 16), 1024, ULONGLONG_MAX, 0, 0, 0},
 
+	{"encrypt-threads", 't', "Number of threads for parallel data"
+	 " encryption or decryption. The default value is 1.",
+	 &opt_encrypt_threads, &opt_encrypt_threads, 0,
+	 GET_UINT, REQUIRED_ARG, 1, 1, UINT_MAX, 0, 0, 0},
+
+	{"parallel", 'p', "Number of files to decrypt in parallel when the"
+	 " input is a directory. The default value is 1.",
+	 &opt_parallel, &opt_parallel, 0,
+	 GET_UINT, REQUIRED_ARG, 1, 1, UINT_MAX, 0, 0, 0},
+
+	{"remove-original", 'r', "Remove the " XBCRYPT_EXT " files after"
+	 " they have been decrypted when the input is a directory.",
+	 &opt_remove_original, &opt_remove_original,
+	 0, GET_BOOL, NO_ARG, 0, 0, 0, 0, 0, 0},
+
 	{"verbose", 'v', "Display verbose status output.",
 	 &opt_verbose, &opt_verbose,
 	  0, GET_BOOL, NO_ARG, 0, 0, 0, 0, 0, 0},
@@ -127,6 +182,10 @@ static
 int
 mode_encrypt(File filein, File fileout);
 
+static
+int
+mode_decrypt_dir(const char *dir);
+
 int
 main(int argc, char **argv)
 {
@@ -206,6 +265,29 @@ main(int argc, char **argv)
 		if (my_stat(opt_input_file, &mystat, MYF(MY_WME)) == NULL) {
 			goto err;
 		}
+		if (MY_S_ISDIR(mystat.st_mode)) {
+			if (opt_run_mode != RUN_MODE_DECRYPT) {
+				msg("%s: a directory can only be used as "
+				    "input with --decrypt, exiting.\n",
+				    my_progname);
+				goto err;
+			}
+			if (opt_output_file) {
+				msg("%s: --output cannot be used when the "
+				    "input is a directory, exiting.\n",
+				    my_progname);
+				goto err;
+			}
+			if (mode_decrypt_dir(opt_input_file)) {
+				goto err;
+			}
+
+			my_cleanup_options(my_long_options);
+
+			my_end(0);
+
+			return EXIT_SUCCESS;
+		}
 		if (!MY_S_ISREG(mystat.st_mode)) {
 			msg("%s: \"%s\" is not a regular file, exiting.\n",
 			    my_progname, opt_input_file);
@@ -286,141 +368,390 @@ my_xb_crypt_read_callback(void *userdata, void *buf, size_t len, int flags)
 	return my_read(*file, buf, len, flags);
 }
 
+/************************************************************************
+Grow a worker buffer so that it can hold at least len bytes. */
 static
-int
-mode_decrypt(File filein, File fileout)
+void
+crypt_buf_reserve(char **buf, size_t *size, size_t len)
+{
+	if (*size < len) {
+		*buf = (char *) my_realloc(*buf, len,
+					   MYF(MY_FAE | MY_ALLOW_ZERO_PTR));
+		*size = len;
+	}
+}
+
+/************************************************************************
+Encrypt or decrypt the chunk currently assigned to a worker thread.
+
+@return FALSE on success, TRUE on error. */
+static
+my_bool
+crypt_worker_process(crypt_thread_ctxt_t *thd)
 {
-	xb_rcrypt_t		*xbcrypt_file = NULL;
-	void			*chunkbuf = NULL;
-	size_t			chunksize;
-	size_t			originalsize;
-	void			*ivbuf = NULL;
-	size_t			ivsize;
-	void			*decryptbuf = NULL;
-	size_t			decryptbufsize = 0;
-	ulonglong		ttlchunksread = 0;
-	ulonglong		ttlbytesread = 0;
-	xb_rcrypt_result_t	result;
-	gcry_cipher_hd_t	cipher_handle;
 	gcry_error_t		gcry_error;
+	const char		*op;
 
-	if (encrypt_algo != GCRY_CIPHER_NONE) {
-		gcry_error = gcry_cipher_open(&cipher_handle,
-					      encrypt_algo,
-					      encrypt_mode, 0);
-		if (gcry_error) {
-			msg("%s:decrypt: unable to open libgcrypt"
-			    " cipher - %s : %s\n", my_progname,
-			    gcry_strsource(gcry_error),
-			    gcry_strerror(gcry_error));
-			return 1;
-		}
+	if (encrypt_algo == GCRY_CIPHER_NONE) {
+		return FALSE;
+	}
 
-		gcry_error = gcry_cipher_setkey(cipher_handle,
-						opt_encrypt_key,
-						encrypt_key_len);
-		if (gcry_error) {
-			msg("%s:decrypt: unable to set libgcrypt cipher"
-			    "key - %s : %s\n", my_progname,
-			    gcry_strsource(gcry_error),
-			    gcry_strerror(gcry_error));
-			goto err;
+	op = (thd->mode == RUN_MODE_DECRYPT) ? "decrypt" : "encrypt";
+
+	gcry_error = gcry_cipher_reset(thd->cipher_handle);
+	if (gcry_error) {
+		msg("%s:%s: unable to reset libgcrypt cipher - %s : %s\n",
+		    my_progname, op, gcry_strsource(gcry_error),
+		    gcry_strerror(gcry_error));
+		return TRUE;
+	}
+
+	if (thd->mode == RUN_MODE_ENCRYPT) {
+		xb_crypt_create_iv(thd->iv, encrypt_iv_len);
+		thd->iv_len = encrypt_iv_len;
+		gcry_error = gcry_cipher_setiv(thd->cipher_handle,
+					       thd->iv, thd->iv_len);
+	} else if (thd->iv_len) {
+		gcry_error = gcry_cipher_setiv(thd->cipher_handle,
+					       thd->iv, thd->iv_len);
+	} else {
+		gcry_error = gcry_cipher_setiv(thd->cipher_handle,
+					       v1_encrypt_iv, encrypt_iv_len);
+	}
+	if (gcry_error) {
+		msg("%s:%s: unable to set cipher iv - %s : %s\n",
+		    my_progname, op, gcry_strsource(gcry_error),
+		    gcry_strerror(gcry_error));
+		return TRUE;
+	}
+
+	if (thd->mode == RUN_MODE_ENCRYPT) {
+		gcry_error = gcry_cipher_encrypt(thd->cipher_handle,
+						 thd->to, thd->to_len,
+						 thd->from, thd->from_len);
+	} else {
+		gcry_error = gcry_cipher_decrypt(thd->cipher_handle,
+						 thd->to, thd->to_len,
+						 thd->from, thd->from_len);
+	}
+	if (gcry_error) {
+		msg("%s:%s: unable to %s chunk - %s : %s\n",
+		    my_progname, op, op, gcry_strsource(gcry_error),
+		    gcry_strerror(gcry_error));
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+static
+void *
+crypt_worker_thread_func(void *arg)
+{
+	crypt_thread_ctxt_t *thd = (crypt_thread_ctxt_t *) arg;
+
+	pthread_mutex_lock(&thd->ctrl_mutex);
+
+	pthread_mutex_lock(&thd->data_mutex);
+
+	thd->started = TRUE;
+	pthread_cond_signal(&thd->ctrl_cond);
+
+	pthread_mutex_unlock(&thd->ctrl_mutex);
+
+	while (1) {
+		thd->data_avail = FALSE;
+		pthread_cond_signal(&thd->data_cond);
+
+		while (!thd->data_avail && !thd->cancelled) {
+			pthread_cond_wait(&thd->data_cond, &thd->data_mutex);
 		}
+
+		if (thd->cancelled)
+			break;
+
+		thd->failed = crypt_worker_process(thd);
 	}
 
-	/* Initialize the xb_crypt format reader */
-	xbcrypt_file = xb_crypt_read_open(&filein, my_xb_crypt_read_callback);
-	if (xbcrypt_file == NULL) {
-		msg("%s:decrypt: xb_crypt_read_open() failed.\n", my_progname);
-		goto err;
+	pthread_mutex_unlock(&thd->data_mutex);
+
+	return NULL;
+}
+
+static
+void
+destroy_worker_threads(crypt_thread_ctxt_t *threads, uint n)
+{
+	uint i;
+
+	for (i = 0; i < n; i++) {
+		crypt_thread_ctxt_t *thd = threads + i;
+
+		pthread_mutex_lock(&thd->data_mutex);
+		thd->cancelled = TRUE;
+		pthread_cond_signal(&thd->data_cond);
+		pthread_mutex_unlock(&thd->data_mutex);
+
+		pthread_join(thd->id, NULL);
+
+		pthread_cond_destroy(&thd->data_cond);
+		pthread_mutex_destroy(&thd->data_mutex);
+		pthread_cond_destroy(&thd->ctrl_cond);
+		pthread_mutex_destroy(&thd->ctrl_mutex);
+
+		if (encrypt_algo != GCRY_CIPHER_NONE)
+			gcry_cipher_close(thd->cipher_handle);
+
+		my_free(thd->from);
+		my_free(thd->to);
+		my_free(thd->iv);
 	}
 
-	/* Walk the encrypted chunks, decrypting them and writing out */
-	while ((result = xb_crypt_read_chunk(xbcrypt_file, &chunkbuf,
-					     &originalsize, &chunksize,
-					     &ivbuf, &ivsize))
-		== XB_CRYPT_READ_CHUNK) {
+	my_free(threads);
+}
+
+/************************************************************************
+Start n worker threads, each with its own cipher handle and buffers.
+
+@return array of thread contexts, or NULL on error. */
+static
+crypt_thread_ctxt_t *
+create_worker_threads(uint n, run_mode_t mode)
+{
+	crypt_thread_ctxt_t	*threads;
+	const char		*op;
+	uint			i;
+
+	op = (mode == RUN_MODE_DECRYPT) ? "decrypt" : "encrypt";
+
+	threads = (crypt_thread_ctxt_t *)
+		my_malloc(sizeof(crypt_thread_ctxt_t) * n,
+			  MYF(MY_FAE | MY_ZEROFILL));
+
+	for (i = 0; i < n; i++) {
+		crypt_thread_ctxt_t	*thd = threads + i;
+		gcry_error_t		gcry_error;
+
+		thd->num = i + 1;
+		thd->mode = mode;
+		thd->iv = (char *) my_malloc(encrypt_iv_len + 1,
+					     MYF(MY_FAE | MY_ZEROFILL));
 
 		if (encrypt_algo != GCRY_CIPHER_NONE) {
-			gcry_error = gcry_cipher_reset(cipher_handle);
+			gcry_error = gcry_cipher_open(&thd->cipher_handle,
+						      encrypt_algo,
+						      encrypt_mode, 0);
 			if (gcry_error) {
-				msg("%s:decrypt: unable to reset libgcrypt"
-				    " cipher - %s : %s\n", my_progname,
+				msg("%s:%s: unable to open libgcrypt"
+				    " cipher - %s : %s\n", my_progname, op,
 				    gcry_strsource(gcry_error),
 				    gcry_strerror(gcry_error));
 				goto err;
 			}
 
-			if (ivsize) {
-				gcry_error = gcry_cipher_setiv(cipher_handle,
-							       ivbuf,
-							       ivsize);
-			} else {
-				gcry_error = gcry_cipher_setiv(cipher_handle,
-							       v1_encrypt_iv,
-							       encrypt_iv_len);
-			}
+			gcry_error = gcry_cipher_setkey(thd->cipher_handle,
+							opt_encrypt_key,
+							encrypt_key_len);
 			if (gcry_error) {
-				msg("%s:decrypt: unable to set cipher iv - "
-				    "%s : %s\n", my_progname,
+				msg("%s:%s: unable to set libgcrypt cipher"
+				    " key - %s : %s\n", my_progname, op,
 				    gcry_strsource(gcry_error),
 				    gcry_strerror(gcry_error));
-				continue;
+				gcry_cipher_close(thd->cipher_handle);
+				goto err;
 			}
+		}
+
+		pthread_mutex_init(&thd->ctrl_mutex, NULL);
+		pthread_cond_init(&thd->ctrl_cond, NULL);
+		pthread_mutex_init(&thd->data_mutex, NULL);
+		pthread_cond_init(&thd->data_cond, NULL);
+
+		pthread_mutex_lock(&thd->ctrl_mutex);
+
+		if (pthread_create(&thd->id, NULL, crypt_worker_thread_func,
+				   thd)) {
+			msg("%s:%s: pthread_create() failed: errno = %d\n",
+			    my_progname, op, errno);
+			pthread_mutex_unlock(&thd->ctrl_mutex);
+
+			/* The thread was not started, release what has
+			been set up for it */
+			pthread_cond_destroy(&thd->data_cond);
+			pthread_mutex_destroy(&thd->data_mutex);
+			pthread_cond_destroy(&thd->ctrl_cond);
+			pthread_mutex_destroy(&thd->ctrl_mutex);
+			if (encrypt_algo != GCRY_CIPHER_NONE)
+				gcry_cipher_close(thd->cipher_handle);
+			goto err;
+		}
+	}
+
+	/* Wait for the threads to start */
+	for (i = 0; i < n; i++) {
+		crypt_thread_ctxt_t *thd = threads + i;
+
+		while (thd->started == FALSE)
+			pthread_cond_wait(&thd->ctrl_cond, &thd->ctrl_mutex);
+		pthread_mutex_unlock(&thd->ctrl_mutex);
+	}
+
+	return threads;
+
+err:
+	/* Only the threads before the failed one have been created. Wait for
+	them to start and shut them down. */
+	n = i;
+	for (i = 0; i < n; i++) {
+		crypt_thread_ctxt_t *thd = threads + i;
+
+		while (thd->started == FALSE)
+			pthread_cond_wait(&thd->ctrl_cond, &thd->ctrl_mutex);
+		pthread_mutex_unlock(&thd->ctrl_mutex);
+	}
+	my_free(threads[n].iv);
+	destroy_worker_threads(threads, n);
+
+	return NULL;
+}
+
+/************************************************************************
+Wait for a worker thread to finish its chunk. Returns with the thread data
+mutex locked. */
+static
+void
+crypt_worker_wait(crypt_thread_ctxt_t *thd)
+{
+	pthread_mutex_lock(&thd->data_mutex);
+	while (thd->data_avail == TRUE) {
+		pthread_cond_wait(&thd->data_cond, &thd->data_mutex);
+	}
+}
+
+/************************************************************************
+Hand the chunk in the worker buffers over to the worker thread. The caller
+must hold the thread control mutex. */
+static
+void
+crypt_worker_dispatch(crypt_thread_ctxt_t *thd)
+{
+	pthread_mutex_lock(&thd->data_mutex);
+	thd->failed = FALSE;
+	thd->data_avail = TRUE;
+	pthread_cond_signal(&thd->data_cond);
+	pthread_mutex_unlock(&thd->data_mutex);
+}
+
+static
+int
+mode_decrypt(File filein, File fileout)
+{
+	xb_rcrypt_t		*xbcrypt_file = NULL;
+	crypt_thread_ctxt_t	*threads = NULL;
+	void			*chunkbuf = NULL;
+	size_t			chunksize;
+	size_t			originalsize;
+	void			*ivbuf = NULL;
+	size_t			ivsize;
+	ulonglong		ttlchunksread = 0;
+	ulonglong		ttlbytesread = 0;
+	xb_rcrypt_result_t	result = XB_CRYPT_READ_CHUNK;
+	my_bool			failed = FALSE;
+	uint			nthreads = opt_encrypt_threads;
+	uint			n;
+	uint			i;
+
+	threads = create_worker_threads(nthreads, RUN_MODE_DECRYPT);
+	if (threads == NULL) {
+		return 1;
+	}
+
+	/* Initialize the xb_crypt format reader */
+	xbcrypt_file = xb_crypt_read_open(&filein, my_xb_crypt_read_callback);
+	if (xbcrypt_file == NULL) {
+		msg("%s:decrypt: xb_crypt_read_open() failed.\n", my_progname);
+		goto err;
+	}
 
-			if (decryptbufsize < originalsize) {
-				if (decryptbufsize) {
-					decryptbuf = my_realloc(decryptbuf,
-								originalsize,
-								MYF(MY_WME));
-					decryptbufsize = originalsize;
-				} else {
-					decryptbuf = my_malloc(originalsize,
-							       MYF(MY_WME));
-					decryptbufsize = originalsize;
-				}
+	/* Walk the encrypted chunks, decrypting them in the worker threads
+	and writing them out in the original order */
+	while (result == XB_CRYPT_READ_CHUNK && !failed) {
+
+		/* The reader reuses its buffers, so each chunk is copied to
+		the worker buffers before the next one is read */
+		for (n = 0; n < nthreads; n++) {
+			crypt_thread_ctxt_t *thd = threads + n;
+
+			result = xb_crypt_read_chunk(xbcrypt_file, &chunkbuf,
+						     &originalsize,
+						     &chunksize,
+						     &ivbuf, &ivsize);
+			if (result != XB_CRYPT_READ_CHUNK) {
+				break;
 			}
 
-			/* Try to decrypt it */
-			gcry_error = gcry_cipher_decrypt(cipher_handle,
-							 decryptbuf,
-							 originalsize,
-							 chunkbuf,
-							 chunksize);
-			if (gcry_error) {
-				msg("%s:decrypt: unable to decrypt chunk - "
-				    "%s : %s\n", my_progname,
-				    gcry_strsource(gcry_error),
-				    gcry_strerror(gcry_error));
-				gcry_cipher_close(cipher_handle);
-					goto err;
+			if (ivsize > encrypt_iv_len) {
+				msg("%s:decrypt: invalid iv size %lu in "
+				    "chunk %llu.\n", my_progname,
+				    (ulong) ivsize, ttlchunksread + n);
+				failed = TRUE;
+				break;
 			}
 
-		} else {
-			decryptbuf = chunkbuf;
+			pthread_mutex_lock(&thd->ctrl_mutex);
+
+			crypt_buf_reserve(&thd->from, &thd->from_size,
+					  chunksize);
+			memcpy(thd->from, chunkbuf, chunksize);
+			thd->from_len = chunksize;
+			memcpy(thd->iv, ivbuf, ivsize);
+			thd->iv_len = ivsize;
+			crypt_buf_reserve(&thd->to, &thd->to_size,
+					  originalsize);
+			thd->to_len = originalsize;
+
+			crypt_worker_dispatch(thd);
 		}
 
-		/* Write it out */
-		if (my_write(fileout, decryptbuf, originalsize,
-			     MYF(MY_WME | MY_NABP))) {
-			msg("%s:decrypt: unable to write output chunk.\n",
-			    my_progname);
-			goto err;
+		/* Reap and write out the decrypted data */
+		for (i = 0; i < n; i++) {
+			crypt_thread_ctxt_t	*thd = threads + i;
+			const char		*out;
+
+			crypt_worker_wait(thd);
+
+			out = (encrypt_algo == GCRY_CIPHER_NONE) ?
+				thd->from : thd->to;
+
+			if (failed || thd->failed) {
+				failed = TRUE;
+			} else if (my_write(fileout, (uchar *) out,
+					    thd->to_len,
+					    MYF(MY_WME | MY_NABP))) {
+				msg("%s:decrypt: unable to write output "
+				    "chunk.\n", my_progname);
+				failed = TRUE;
+			} else {
+				ttlchunksread++;
+				ttlbytesread += thd->from_len;
+			}
+
+			pthread_mutex_unlock(&thd->data_mutex);
+			pthread_mutex_unlock(&thd->ctrl_mutex);
 		}
-		ttlchunksread++;
-		ttlbytesread += chunksize;
-		if (opt_verbose)
+
+		if (opt_verbose && !failed)
 			msg("%s:decrypt: %llu chunks read, %llu bytes read\n.",
-		    	    my_progname, ttlchunksread, ttlbytesread);
+			    my_progname, ttlchunksread, ttlbytesread);
 	}
 
-	xb_crypt_read_close(xbcrypt_file);
+	if (failed || result == XB_CRYPT_READ_ERROR) {
+		goto err;
+	}
 
-	if (encrypt_algo != GCRY_CIPHER_NONE)
-		gcry_cipher_close(cipher_handle);
+	xb_crypt_read_close(xbcrypt_file);
 
-	if (decryptbuf && decryptbufsize)
-		my_free(decryptbuf);
+	destroy_worker_threads(threads, nthreads);
 
 	if (opt_verbose)
 		msg("\n%s:decrypt: done\n", my_progname);
@@ -430,11 +761,7 @@ err:
 	if (xbcrypt_file)
 		xb_crypt_read_close(xbcrypt_file);
 
-	if (encrypt_algo != GCRY_CIPHER_NONE)
-		gcry_cipher_close(cipher_handle);
-
-	if (decryptbuf && decryptbufsize)
-		my_free(decryptbuf);
+	destroy_worker_threads(threads, nthreads);
 
 	return 1;
 }
@@ -454,41 +781,21 @@ static
 int
 mode_encrypt(File filein, File fileout)
 {
-	size_t			bytesread;
+	size_t			bytesread = 0;
 	size_t			chunkbuflen;
-	void			*chunkbuf = NULL;
-	void			*ivbuf = NULL;
-	size_t			encryptbuflen = 0;
-	size_t			encryptedlen = 0;
-	void			*encryptbuf = NULL;
 	ulonglong		ttlchunkswritten = 0;
 	ulonglong		ttlbyteswritten = 0;
 	xb_wcrypt_t		*xbcrypt_file = NULL;
-	gcry_cipher_hd_t	cipher_handle;
-	gcry_error_t		gcry_error;
-
-	if (encrypt_algo != GCRY_CIPHER_NONE) {
-		gcry_error = gcry_cipher_open(&cipher_handle,
-					      encrypt_algo,
-					      encrypt_mode, 0);
-		if (gcry_error) {
-			msg("%s:encrypt: unable to open libgcrypt cipher - "
-			    "%s : %s\n", my_progname,
-			    gcry_strsource(gcry_error),
-			    gcry_strerror(gcry_error));
-			return 1;
-		}
-
-		gcry_error = gcry_cipher_setkey(cipher_handle,
-						opt_encrypt_key,
-						encrypt_key_len);
-		if (gcry_error) {
-			msg("%s:encrypt: unable to set libgcrypt cipher key - "
-			    "%s : %s\n", my_progname,
-			    gcry_strsource(gcry_error),
-			    gcry_strerror(gcry_error));
-			goto err;
-		}
+	crypt_thread_ctxt_t	*threads = NULL;
+	my_bool			failed = FALSE;
+	my_bool			eof = FALSE;
+	uint			nthreads = opt_encrypt_threads;
+	uint			n;
+	uint			i;
+
+	threads = create_worker_threads(nthreads, RUN_MODE_ENCRYPT);
+	if (threads == NULL) {
+		return 1;
 	}
 
 	posix_fadvise(filein, 0, 0, POSIX_FADV_SEQUENTIAL);
@@ -501,119 +808,295 @@ mode_encrypt(File filein, File fileout)
 		goto err;
 	}
 
-	ivbuf = my_malloc(encrypt_iv_len, MYF(MY_FAE));
-
-	/* now read in data in chunk size, encrypt and write out */
+	/* now read in data in chunk size, encrypt in the worker threads and
+	write out in the original order */
 	chunkbuflen = opt_encrypt_chunk_size;
-	chunkbuf = my_malloc(chunkbuflen, MYF(MY_FAE));
-	while ((bytesread = my_read(filein, chunkbuf, chunkbuflen,
-				    MYF(MY_WME))) > 0) {
-
-		if (encrypt_algo != GCRY_CIPHER_NONE) {
-			gcry_error = gcry_cipher_reset(cipher_handle);
-
-			if (gcry_error) {
-				msg("%s:encrypt: unable to reset cipher - "
-				    "%s : %s\n", my_progname,
-				    gcry_strsource(gcry_error),
-				    gcry_strerror(gcry_error));
-				goto err;
-			}
-
-			xb_crypt_create_iv(ivbuf, encrypt_iv_len);
-			gcry_error = gcry_cipher_setiv(cipher_handle,
-							ivbuf,
-							encrypt_iv_len);
-
-			if (gcry_error) {
-				msg("%s:encrypt: unable to set cipher iv - "
-				    "%s : %s\n", my_progname,
-				    gcry_strsource(gcry_error),
-				    gcry_strerror(gcry_error));
-				continue;
+	while (!eof && !failed) {
+
+		for (n = 0; n < nthreads; n++) {
+			crypt_thread_ctxt_t *thd = threads + n;
+
+			pthread_mutex_lock(&thd->ctrl_mutex);
+
+			crypt_buf_reserve(&thd->from, &thd->from_size,
+					  chunkbuflen);
+			bytesread = my_read(filein, (uchar *) thd->from,
+					    chunkbuflen, MYF(MY_WME));
+			if (bytesread == 0 || bytesread == (size_t) -1) {
+				pthread_mutex_unlock(&thd->ctrl_mutex);
+				failed = (bytesread != 0);
+				eof = TRUE;
+				break;
 			}
 
-			if (encryptbuflen < bytesread) {
-				if (encryptbuflen) {
-					encryptbuf = my_realloc(encryptbuf,
-								bytesread,
-								MYF(MY_WME));
-					encryptbuflen = bytesread;
-				} else {
-					encryptbuf = my_malloc(bytesread,
-							       MYF(MY_WME));
-					encryptbuflen = bytesread;
-				}
-			}
+			thd->from_len = bytesread;
+			crypt_buf_reserve(&thd->to, &thd->to_size, bytesread);
+			thd->to_len = bytesread;
 
-			gcry_error = gcry_cipher_encrypt(cipher_handle,
-							 encryptbuf,
-							 encryptbuflen,
-							 chunkbuf,
-							 bytesread);
-
-			encryptedlen = bytesread;
+			crypt_worker_dispatch(thd);
+		}
 
-			if (gcry_error) {
-				msg("%s:encrypt: unable to encrypt chunk - "
-				    "%s : %s\n", my_progname,
-				    gcry_strsource(gcry_error),
-				    gcry_strerror(gcry_error));
-				gcry_cipher_close(cipher_handle);
-				goto err;
+		/* Reap and write out the encrypted data */
+		for (i = 0; i < n; i++) {
+			crypt_thread_ctxt_t	*thd = threads + i;
+			const char		*out;
+
+			crypt_worker_wait(thd);
+
+			out = (encrypt_algo == GCRY_CIPHER_NONE) ?
+				thd->from : thd->to;
+
+			if (failed || thd->failed) {
+				failed = TRUE;
+			} else if (xb_crypt_write_chunk(xbcrypt_file, out,
+							thd->from_len,
+							thd->to_len,
+							thd->iv,
+							encrypt_iv_len)) {
+				msg("%s:encrypt: abcrypt_write_chunk() "
+				    "failed.\n", my_progname);
+				failed = TRUE;
+			} else {
+				ttlchunkswritten++;
+				ttlbyteswritten += thd->to_len;
 			}
-		} else {
-			encryptedlen = bytesread;
-			encryptbuf = chunkbuf;
-		}
 
-		if (xb_crypt_write_chunk(xbcrypt_file, encryptbuf, bytesread,
-					 encryptedlen, ivbuf, encrypt_iv_len)) {
-			msg("%s:encrypt: abcrypt_write_chunk() failed.\n",
-			    my_progname);
-			goto err;
+			pthread_mutex_unlock(&thd->data_mutex);
+			pthread_mutex_unlock(&thd->ctrl_mutex);
 		}
 
-		ttlchunkswritten++;
-		ttlbyteswritten += encryptedlen;
-
-		if (opt_verbose)
+		if (opt_verbose && !failed && n > 0)
 			msg("%s:encrypt: %llu chunks written, %llu bytes "
 			    "written\n.", my_progname, ttlchunkswritten,
 			    ttlbyteswritten);
 	}
 
-	my_free(ivbuf);
-	my_free(chunkbuf);
-
-	if (encryptbuf && encryptbuflen)
-		my_free(encryptbuf);
+	if (failed) {
+		goto err;
+	}
 
 	xb_crypt_write_close(xbcrypt_file);
 
-	if (encrypt_algo != GCRY_CIPHER_NONE)
-		gcry_cipher_close(cipher_handle);
+	destroy_worker_threads(threads, nthreads);
 
 	if (opt_verbose)
 		msg("\n%s:encrypt: done\n", my_progname);
 
 	return 0;
 err:
-	if (chunkbuf)
-		my_free(chunkbuf);
-
-	if (encryptbuf && encryptbuflen)
-		my_free(encryptbuf);
-
 	if (xbcrypt_file)
 		xb_crypt_write_close(xbcrypt_file);
 
-	if (encrypt_algo != GCRY_CIPHER_NONE)
-		gcry_cipher_close(cipher_handle);
+	destroy_worker_threads(threads, nthreads);
 
 	return 1;
 }
 
+/************************************************************************
+Decrypt a single file found by the directory mode into a file with the
+same name without the .xbcrypt extension.
+
+@return 0 on success, 1 on error. */
+static
+int
+decrypt_file(const char *path)
+{
+	char	dst_path[FN_REFLEN];
+	File	filein;
+	File	fileout;
+	size_t	len;
+	int	ret;
+
+	len = strlen(path) - (sizeof(XBCRYPT_EXT) - 1);
+	if (len >= sizeof(dst_path)) {
+		msg("%s: file name \"%s\" is too long.\n", my_progname, path);
+		return 1;
+	}
+	memcpy(dst_path, path, len);
+	dst_path[len] = 0;
+
+	if (opt_verbose)
+		msg("%s: decrypting \"%s\".\n", my_progname, path);
+
+	if ((filein = my_open(path, O_RDONLY, MYF(MY_WME))) < 0) {
+		msg("%s: failed to open \"%s\".\n", my_progname, path);
+		return 1;
+	}
+
+	if ((fileout = my_create(dst_path, 0,
+				 O_WRONLY|O_BINARY|O_EXCL|O_NOFOLLOW,
+				 MYF(MY_WME))) < 0) {
+		msg("%s: failed to create output file \"%s\".\n",
+		    my_progname, dst_path);
+		my_close(filein, MYF(MY_WME));
+		return 1;
+	}
+
+	ret = mode_decrypt(filein, fileout);
+
+	my_close(filein, MYF(MY_WME));
+	if (my_close(fileout, MYF(MY_WME))) {
+		ret = 1;
+	}
+
+	if (ret) {
+		my_delete(dst_path, MYF(MY_WME));
+	} else if (opt_remove_original && my_delete(path, MYF(MY_WME))) {
+		ret = 1;
+	}
+
+	return ret;
+}
+
+/************************************************************************
+Recursively collect the names of all .xbcrypt files under dir.
+
+@return FALSE on success, TRUE on error. */
+static
+my_bool
+decrypt_dir_scan(const char *dir, DYNAMIC_ARRAY *files)
+{
+	MY_DIR	*dir_info;
+	uint	i;
+	my_bool	ret = FALSE;
+
+	if (!(dir_info = my_dir(dir, MYF(MY_WANT_STAT | MY_WME)))) {
+		msg("%s: cannot read directory \"%s\".\n", my_progname, dir);
+		return TRUE;
+	}
+
+	for (i = 0; i < dir_info->number_off_files && !ret; i++) {
+		const FILEINFO	*entry = dir_info->dir_entry + i;
+		char		path[FN_REFLEN];
+		size_t		len;
+
+		if (!strcmp(entry->name, ".") || !strcmp(entry->name, "..")) {
+			continue;
+		}
+
+		if (my_snprintf(path, sizeof(path), "%s/%s", dir, entry->name)
+		    >= sizeof(path) - 1) {
+			msg("%s: path \"%s/%s\" is too long.\n", my_progname,
+			    dir, entry->name);
+			ret = TRUE;
+			break;
+		}
+
+		if (MY_S_ISDIR(entry->mystat->st_mode)) {
+			ret = decrypt_dir_scan(path, files);
+			continue;
+		}
+
+		len = strlen(entry->name);
+		if (MY_S_ISREG(entry->mystat->st_mode)
+		    && len > sizeof(XBCRYPT_EXT) - 1
+		    && !strcmp(entry->name + len - (sizeof(XBCRYPT_EXT) - 1),
+			       XBCRYPT_EXT)) {
+			char *name = my_strdup(path, MYF(MY_FAE));
+
+			if (insert_dynamic(files, &name)) {
+				my_free(name);
+				ret = TRUE;
+			}
+		}
+	}
+
+	my_dirend(dir_info);
+
+	return ret;
+}
+
+static
+void *
+decrypt_dir_thread_func(void *arg)
+{
+	decrypt_dir_ctxt_t	*ctxt = (decrypt_dir_ctxt_t *) arg;
+
+	my_thread_init();
+
+	while (1) {
+		char	*path;
+
+		pthread_mutex_lock(&ctxt->mutex);
+		if (ctxt->failed || ctxt->next >= ctxt->files.elements) {
+			pthread_mutex_unlock(&ctxt->mutex);
+			break;
+		}
+		path = *dynamic_element(&ctxt->files, ctxt->next, char **);
+		ctxt->next++;
+		pthread_mutex_unlock(&ctxt->mutex);
+
+		if (decrypt_file(path)) {
+			pthread_mutex_lock(&ctxt->mutex);
+			ctxt->failed = TRUE;
+			pthread_mutex_unlock(&ctxt->mutex);
+		}
+	}
+
+	my_thread_end();
+
+	return NULL;
+}
+
+/************************************************************************
+Decrypt all .xbcrypt files under dir in place, using --parallel threads
+to process several files at once. */
+static
+int
+mode_decrypt_dir(const char *dir)
+{
+	decrypt_dir_ctxt_t	ctxt;
+	pthread_t		*tids;
+	uint			nthreads;
+	uint			i;
+
+	if (my_init_dynamic_array(&ctxt.files, sizeof(char *), 64, 64)) {
+		return 1;
+	}
+	ctxt.next = 0;
+	ctxt.failed = decrypt_dir_scan(dir, &ctxt.files);
+	pthread_mutex_init(&ctxt.mutex, NULL);
+
+	nthreads = opt_parallel;
+	if (nthreads > ctxt.files.elements) {
+		nthreads = ctxt.files.elements;
+	}
+
+	if (opt_verbose && !ctxt.failed)
+		msg("%s: decrypting %u files in \"%s\" using %u threads.\n",
+		    my_progname, ctxt.files.elements, dir, nthreads);
+
+	tids = (pthread_t *) my_malloc(sizeof(pthread_t) * (nthreads + 1),
+				       MYF(MY_FAE));
+
+	for (i = 0; i < nthreads && !ctxt.failed; i++) {
+		if (pthread_create(tids + i, NULL, decrypt_dir_thread_func,
+				   &ctxt)) {
+			msg("%s: pthread_create() failed: errno = %d\n",
+			    my_progname, errno);
+			pthread_mutex_lock(&ctxt.mutex);
+			ctxt.failed = TRUE;
+			pthread_mutex_unlock(&ctxt.mutex);
+			break;
+		}
+	}
+
+	nthreads = i;
+	for (i = 0; i < nthreads; i++) {
+		pthread_join(tids[i], NULL);
+	}
+
+	my_free(tids);
+	pthread_mutex_destroy(&ctxt.mutex);
+
+	for (i = 0; i < ctxt.files.elements; i++) {
+		my_free(*dynamic_element(&ctxt.files, i, char **));
+	}
+	delete_dynamic(&ctxt.files);
+
+	return ctxt.failed ? 1 : 0;
+}
+
 static
 int
 get_options(int *argc, char ***argv)
@@ -670,6 +1153,9 @@ usage(void)
  	       " # read data from specified input, encrypting or decrypting "
 	       " and writing the result to the specified output.\n",
 	       my_progname);
+	printf("  %s --decrypt --input=DIR [OPTIONS...]"
+	       " # decrypt all " XBCRYPT_EXT " files in DIR in place.\n",
+	       my_progname);
 	puts("\nOptions:");
 	my_print_help(my_long_options);
 }
@@ -38,6 +38,12 @@ typedef enum {
 	RUN_MODE_EXTRACT
 } run_mode_t;
 
+enum {
+	OPT_LOCAL_WRITE_MODE = 256,
+	OPT_LOCAL_WRITE_THREADS,
+	OPT_LOCAL_WRITE_QUEUE_SIZE
+};
+
 /* Need the following definitions to avoid linking with ds_*.o and their link
 dependencies */
 datasink_t datasink_archive;
@@ -46,10 +52,20 @@ datasink_t datasink_compress;
 datasink_t datasink_tmpfile;
 datasink_t datasink_encrypt;
 datasink_t datasink_buffer;
+datasink_t datasink_spool;
 
 static run_mode_t 	opt_mode;
 static char *		opt_directory = NULL;
 static my_bool		opt_verbose = 0;
+static ulong		opt_local_write_mode = DS_LOCAL_FSYNC;
+static uint		opt_local_write_threads = 1;
+static ulonglong	opt_local_write_queue_size;
+
+static const char *local_write_mode_names[] =
+{"fsync", "write-behind", "direct", NullS};
+static TYPELIB local_write_mode_typelib =
+{array_elements(local_write_mode_names) - 1, "", local_write_mode_names,
+ NULL};
 
 static struct my_option my_long_options[] =
 {
@@ -65,6 +81,20 @@ static struct my_option my_long_options[] =
 	 GET_STR_ALLOC, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
 	{"verbose", 'v', "Print verbose output.", &opt_verbose, &opt_verbose,
 	 0, GET_BOOL, NO_ARG, 0, 0, 0, 0, 0, 0},
+	{"local-write-mode", OPT_LOCAL_WRITE_MODE, "How extracted files are "
+	 "written: 'fsync' (the default), 'write-behind' or 'direct'.",
+	 &opt_local_write_mode, &opt_local_write_mode,
+	 &local_write_mode_typelib, GET_ENUM, REQUIRED_ARG, DS_LOCAL_FSYNC,
+	 0, 0, 0, 0, 0},
+	{"local-write-threads", OPT_LOCAL_WRITE_THREADS, "Number of writer "
+	 "threads for the write-behind and direct modes.",
+	 &opt_local_write_threads, &opt_local_write_threads, 0, GET_UINT,
+	 REQUIRED_ARG, 1, 1, UINT_MAX, 0, 0, 0},
+	{"local-write-queue-size", OPT_LOCAL_WRITE_QUEUE_SIZE, "Maximum "
+	 "amount of data in bytes queued for the writer threads.",
+	 &opt_local_write_queue_size, &opt_local_write_queue_size, 0, GET_ULL,
+	 REQUIRED_ARG, 64 * 1024 * 1024L, 1024 * 1024L, ULONGLONG_MAX, 0, 1024,
+	 0},
 
 	{0, 0, 0, 0, 0, 0, GET_NO_ARG, NO_ARG, 0, 0, 0, 0, 0, 0}
 };
@@ -249,6 +279,11 @@ mode_create(int argc, char **argv)
 		return 1;
 	}
 
+	/* innobackupex runs xbstream while xtrabackup may be streaming to the
+	same output. Write whole chunks under a lock, if the output supports
+	it. */
+	xb_stream_write_set_lock(stream, fileno(stdout));
+
 	for (i = 0; i < argc; i++) {
 		char			*filepath = argv[i];
 		File			src_file;
@@ -374,6 +409,15 @@ mode_extract(int argc __attribute__((unused)),
 
 	/* If --directory is specified, it is already set as CWD by now. */
 	ds_ctxt = ds_create(".", DS_TYPE_LOCAL);
+	if (ds_local_set_mode(ds_ctxt, (ds_local_mode_t) opt_local_write_mode,
+			      opt_local_write_threads,
+			      (size_t) opt_local_write_queue_size)) {
+		msg("%s: failed to start local writer threads.\n",
+		    my_progname);
+		ds_destroy(ds_ctxt);
+		xb_stream_read_done(stream);
+		return 1;
+	}
 
 	if (my_hash_init(&filehash, &my_charset_bin, START_FILE_HASH_SIZE,
 			  0, 0, (my_hash_get_key) get_file_entry_key,
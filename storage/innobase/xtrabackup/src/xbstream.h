@@ -59,6 +59,11 @@ int xb_stream_write_close(xb_wstream_file_t *file);
 
 int xb_stream_write_done(xb_wstream_t *stream);
 
+/* Serialize chunk writes with other processes writing to the same output by
+holding an exclusive fcntl() lock on 'fd' while each chunk is written. Returns
+non-zero if 'fd' cannot be locked. */
+int xb_stream_write_set_lock(xb_wstream_t *stream, int fd);
+
 /************************************************************************
 Read interface. */
 
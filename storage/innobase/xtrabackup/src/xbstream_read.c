@@ -71,11 +71,33 @@ validate_chunk_type(uchar code)
 	}
 }
 
+/* Read exactly 'len' bytes. my_read() with MY_FULL_IO would retry forever on
+a truncated stream, so handle short reads here. Returns non-zero on a read
+error or end of file. */
+static
+int
+read_full(File fd, uchar *buf, size_t len)
+{
+	size_t	bytes;
+
+	while (len > 0) {
+		bytes = my_read(fd, buf, len, MYF(MY_WME));
+		if (bytes == 0 || bytes == MY_FILE_ERROR) {
+			return 1;
+		}
+		buf += bytes;
+		len -= bytes;
+	}
+
+	return 0;
+}
+
 #define F_READ(buf,len)                                       	\
 	do {                                                      	\
-		if (my_read(fd, buf, len, MYF(MY_WME|MY_FULL_IO)) ==	\
-		    MY_FILE_ERROR) {					\
-			msg("xb_stream_read_chunk(): my_read() failed.\n"); \
+		if (read_full(fd, (uchar *) (buf), len)) {		\
+			msg("xb_stream_read_chunk(): unexpected end of " \
+			    "stream or read error at offset 0x%llx.\n", \
+			    stream->offset);				\
 			goto err;                                 	\
 		}							\
 	} while (0)
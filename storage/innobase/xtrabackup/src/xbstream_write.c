@@ -29,6 +29,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 struct xb_wstream_struct {
 	pthread_mutex_t	mutex;
+	int		lock_fd;	/* fd locked around chunk writes, or
+					-1 */
 };
 
 struct xb_wstream_file_struct {
@@ -47,6 +49,7 @@ static int xb_stream_flush(xb_wstream_file_t *file);
 static int xb_stream_write_chunk(xb_wstream_file_t *file,
 				 const void *buf, size_t len);
 static int xb_stream_write_eof(xb_wstream_file_t *file);
+static int xb_stream_lock_output(xb_wstream_t *stream, my_bool lock);
 
 static
 ssize_t
@@ -66,10 +69,26 @@ xb_stream_write_new(void)
 
 	stream = (xb_wstream_t *) my_malloc(sizeof(xb_wstream_t), MYF(MY_FAE));
 	pthread_mutex_init(&stream->mutex, NULL);
+	stream->lock_fd = -1;
 
 	return stream;;
 }
 
+int
+xb_stream_write_set_lock(xb_wstream_t *stream, int fd)
+{
+	stream->lock_fd = fd;
+
+	/* Check that the output can be locked at all */
+	if (xb_stream_lock_output(stream, TRUE) ||
+	    xb_stream_lock_output(stream, FALSE)) {
+		stream->lock_fd = -1;
+		return 1;
+	}
+
+	return 0;
+}
+
 xb_wstream_file_t *
 xb_stream_write_open(xb_wstream_t *stream, const char *path,
 		     MY_STAT *mystat __attribute__((unused)),
@@ -205,6 +224,9 @@ xb_stream_write_chunk(xb_wstream_file_t *file, const void *buf, size_t len)
 
 	pthread_mutex_lock(&stream->mutex);
 
+	if (xb_stream_lock_output(stream, TRUE))
+		goto err_unlock;
+
 	int8store(ptr, file->offset);            /* Payload offset */
 	ptr += 8;
 
@@ -223,12 +245,19 @@ xb_stream_write_chunk(xb_wstream_file_t *file, const void *buf, size_t len)
 
 	file->offset+= len;
 
+	if (xb_stream_lock_output(stream, FALSE))
+		goto err_unlock;
+
 	pthread_mutex_unlock(&stream->mutex);
 
 	return 0;
 
 err:
 
+	xb_stream_lock_output(stream, FALSE);
+
+err_unlock:
+
 	pthread_mutex_unlock(&stream->mutex);
 
 	return 1;
@@ -246,6 +275,9 @@ xb_stream_write_eof(xb_wstream_file_t *file)
 
 	pthread_mutex_lock(&stream->mutex);
 
+	if (xb_stream_lock_output(stream, TRUE))
+		goto err_unlock;
+
 	/* Write xbstream header */
 	ptr = tmpbuf;
 
@@ -269,12 +301,54 @@ xb_stream_write_eof(xb_wstream_file_t *file)
 			(ulonglong) (ptr - tmpbuf)) == -1)
 		goto err;
 
+	if (xb_stream_lock_output(stream, FALSE))
+		goto err_unlock;
+
 	pthread_mutex_unlock(&stream->mutex);
 
 	return 0;
 err:
 
+	xb_stream_lock_output(stream, FALSE);
+
+err_unlock:
+
 	pthread_mutex_unlock(&stream->mutex);
 
 	return 1;
 }
+
+/************************************************************************
+Acquire or release the lock on the stream output, if any. The whole output
+is locked, so that a chunk is never interleaved with chunks written by other
+processes. Must be called with the stream mutex held.
+@return 0 on success, 1 on error. */
+static
+int
+xb_stream_lock_output(xb_wstream_t *stream, my_bool lock)
+{
+#ifdef F_SETLKW
+	struct flock	fl;
+
+	if (stream->lock_fd < 0) {
+		return 0;
+	}
+
+	memset(&fl, 0, sizeof(fl));
+	fl.l_type = lock ? F_WRLCK : F_UNLCK;
+	fl.l_whence = SEEK_SET;
+
+	while (fcntl(stream->lock_fd, F_SETLKW, &fl)) {
+		if (errno != EINTR) {
+			msg("xb_stream: fcntl() failed to %s the output: "
+			    "errno = %d\n",
+			    lock ? "lock" : "unlock", errno);
+			return 1;
+		}
+	}
+
+	return 0;
+#else
+	return stream->lock_fd < 0 ? 0 : 1;
+#endif
+}
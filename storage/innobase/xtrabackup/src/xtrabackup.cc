@@ -55,6 +55,7 @@ Place, Suite 330, Boston, MA 02111-1307 USA
 #endif
 
 #include <btr0sea.h>
+#include <dict0boot.h>
 #include <dict0priv.h>
 #include <dict0stats.h>
 #include <lock0lock.h>
@@ -74,10 +75,18 @@ Place, Suite 330, Boston, MA 02111-1307 USA
 #include "write_filt.h"
 #include "xtrabackup.h"
 #include "ds_buffer.h"
+#include "ds_spool.h"
 #include "ds_tmpfile.h"
+#include "ds_local.h"
+#include "ds_xbstream.h"
+#include "buf_arena.h"
 #include "xbstream.h"
+#include "stream_receive.h"
 #include "changed_page_bitmap.h"
 #include "read_filt.h"
+#include "lsn_summary.h"
+#include "log_filt.h"
+#include "progress.h"
 
 /* TODO: replace with appropriate macros used in InnoDB 5.6 */
 #define PAGE_ZIP_MIN_SIZE_SHIFT	10
@@ -99,6 +108,8 @@ my_bool xtrabackup_version = FALSE;
 my_bool xtrabackup_backup = FALSE;
 my_bool xtrabackup_stats = FALSE;
 my_bool xtrabackup_prepare = FALSE;
+my_bool xtrabackup_verify = FALSE;
+my_bool xtrabackup_stats_offline = FALSE;
 my_bool xtrabackup_print_param = FALSE;
 
 my_bool xtrabackup_export = FALSE;
@@ -177,15 +188,43 @@ char *xtrabackup_encrypt_key_file = NULL;
 uint xtrabackup_encrypt_threads;
 ulonglong xtrabackup_encrypt_chunk_size = 0;
 
+const char *xtrabackup_local_write_mode_names[] =
+{ "fsync", "write-behind", "direct", NullS};
+TYPELIB xtrabackup_local_write_mode_typelib=
+{array_elements(xtrabackup_local_write_mode_names)-1,"",
+	xtrabackup_local_write_mode_names, NULL};
+
+ulong xtrabackup_local_write_mode = DS_LOCAL_FSYNC;
+uint xtrabackup_local_write_threads;
+ulonglong xtrabackup_local_write_queue_size;
+
+/* size of the memory spool per file for parallel 'tar' streaming */
+ulonglong xtrabackup_stream_spool_size;
+
+/* memory limit for the recycled I/O buffers (--buffer-memory-limit) and
+whether to back them with explicitly reserved huge pages */
+ulonglong xtrabackup_buffer_memory_limit = 0;
+my_bool xtrabackup_buffer_large_pages = FALSE;
+
 ulint xtrabackup_rebuild_threads = 1;
 
 /* sleep interval beetween log copy iterations in log copying thread
 in milliseconds (default is 1 second) */
 int xtrabackup_log_copy_interval = 1000;
 
+/* replace the log records of the tables excluded from a partial backup with
+dummy records (--log-filter) */
+static my_bool xtrabackup_log_filter = FALSE;
+
+/* machine-readable status file (--status-file) and its update interval in
+milliseconds */
+char *xtrabackup_status_file = NULL;
+ulong xtrabackup_status_interval = 1000;
+
 /* === metadata of backup === */
 #define XTRABACKUP_METADATA_FILENAME "xtrabackup_checkpoints"
-char metadata_type[30] = ""; /*[full-backuped|full-prepared|incremental]*/
+char metadata_type[30] = ""; /*[full-backuped|full-prepared|export-prepared|
+				 incremental]*/
 lsn_t metadata_from_lsn = 0;
 lsn_t metadata_to_lsn = 0;
 lsn_t metadata_last_lsn = 0;
@@ -298,6 +337,7 @@ xtrabackup_add_datasink(ds_ctxt_t *ds)
 {
 	xb_ad(actual_datasinks < XTRABACKUP_MAX_DATASINKS);
 	datasinks[actual_datasinks] = ds; actual_datasinks++;
+	xb_progress_add_datasink(ds);
 }
 
 /* ======== Datafiles iterator ======== */
@@ -380,6 +420,8 @@ enum options_xtrabackup
   OPT_XTRA_BACKUP,
   OPT_XTRA_STATS,
   OPT_XTRA_PREPARE,
+  OPT_XTRA_VERIFY,
+  OPT_XTRA_STATS_OFFLINE,
   OPT_XTRA_EXPORT,
   OPT_XTRA_APPLY_LOG_ONLY,
   OPT_XTRA_PRINT_PARAM,
@@ -388,6 +430,7 @@ enum options_xtrabackup
   OPT_XTRA_USE_MEMORY,
   OPT_XTRA_THROTTLE,
   OPT_XTRA_LOG_COPY_INTERVAL,
+  OPT_XTRA_LOG_FILTER,
   OPT_XTRA_INCREMENTAL,
   OPT_XTRA_INCREMENTAL_BASEDIR,
   OPT_XTRA_EXTRA_LSNDIR,
@@ -398,6 +441,7 @@ enum options_xtrabackup
   OPT_XTRA_CREATE_IB_LOGFILE,
   OPT_XTRA_PARALLEL,
   OPT_XTRA_STREAM,
+  OPT_XTRA_STREAM_SPOOL_SIZE,
   OPT_XTRA_COMPRESS,
   OPT_XTRA_COMPRESS_THREADS,
   OPT_XTRA_COMPRESS_CHUNK_SIZE,
@@ -406,6 +450,11 @@ enum options_xtrabackup
   OPT_XTRA_ENCRYPT_KEY_FILE,
   OPT_XTRA_ENCRYPT_THREADS,
   OPT_XTRA_ENCRYPT_CHUNK_SIZE,
+  OPT_XTRA_LOCAL_WRITE_MODE,
+  OPT_XTRA_LOCAL_WRITE_THREADS,
+  OPT_XTRA_LOCAL_WRITE_QUEUE_SIZE,
+  OPT_XTRA_BUFFER_MEMORY_LIMIT,
+  OPT_XTRA_BUFFER_LARGE_PAGES,
   OPT_INNODB,
   OPT_INNODB_CHECKSUMS,
   OPT_INNODB_DATA_FILE_PATH,
@@ -439,6 +488,7 @@ enum options_xtrabackup
   OPT_INNODB_FAST_CHECKSUM,
   OPT_INNODB_EXTRA_UNDOSLOTS,
   OPT_INNODB_DOUBLEWRITE_FILE,
+  OPT_INNODB_PARALLEL_DOUBLEWRITE_PATH,
   OPT_INNODB_BUFFER_POOL_FILENAME,
   OPT_INNODB_FORCE_RECOVERY,
   OPT_INNODB_LOCK_WAIT_TIMEOUT,
@@ -459,6 +509,8 @@ enum options_xtrabackup
   OPT_UNDO_TABLESPACES,
   OPT_INNODB_LOG_CHECKSUM_ALGORITHM,
   OPT_XTRA_INCREMENTAL_FORCE_SCAN,
+  OPT_XTRA_STATUS_FILE,
+  OPT_XTRA_STATUS_INTERVAL,
   OPT_DEFAULTS_GROUP
 };
 
@@ -475,9 +527,20 @@ static struct my_option xb_long_options[] =
   {"stats", OPT_XTRA_STATS, "calc statistic of datadir (offline mysqld is recommended)",
    (G_PTR*) &xtrabackup_stats, (G_PTR*) &xtrabackup_stats,
    0, GET_BOOL, NO_ARG, 0, 0, 0, 0, 0, 0},
+  {"stats-offline", OPT_XTRA_STATS_OFFLINE, "with --stats, read the data "
+   "files directly without starting InnoDB, using --parallel threads, and "
+   "print the statistics of all indexes as a JSON document. Can be used on "
+   "a backup that has not been prepared.",
+   (G_PTR*) &xtrabackup_stats_offline, (G_PTR*) &xtrabackup_stats_offline,
+   0, GET_BOOL, NO_ARG, 0, 0, 0, 0, 0, 0},
   {"prepare", OPT_XTRA_PREPARE, "prepare a backup for starting mysql server on the backup.",
    (G_PTR*) &xtrabackup_prepare, (G_PTR*) &xtrabackup_prepare,
    0, GET_BOOL, NO_ARG, 0, 0, 0, 0, 0, 0},
+  {"verify", OPT_XTRA_VERIFY, "check page checksums of all data files and "
+   "deltas in target-dir, and the consistency of xtrabackup_logfile, "
+   "using --parallel threads.",
+   (G_PTR*) &xtrabackup_verify, (G_PTR*) &xtrabackup_verify,
+   0, GET_BOOL, NO_ARG, 0, 0, 0, 0, 0, 0},
   {"export", OPT_XTRA_EXPORT, "create files to import to another database when prepare.",
    (G_PTR*) &xtrabackup_export, (G_PTR*) &xtrabackup_export,
    0, GET_BOOL, NO_ARG, 0, 0, 0, 0, 0, 0},
@@ -513,6 +576,12 @@ static struct my_option xb_long_options[] =
   {"log-copy-interval", OPT_XTRA_LOG_COPY_INTERVAL, "time interval between checks done by log copying thread in milliseconds (default is 1 second).",
    (G_PTR*) &xtrabackup_log_copy_interval, (G_PTR*) &xtrabackup_log_copy_interval,
    0, GET_LONG, REQUIRED_ARG, 1000, 0, LONG_MAX, 0, 1, 0},
+  {"log-filter", OPT_XTRA_LOG_FILTER, "(for --backup with --tables or "
+   "--tables_file): replace the log records of the tables excluded from the "
+   "backup with dummy records in xtrabackup_logfile. This makes the log "
+   "compress better and speeds up --prepare.",
+   (G_PTR*) &xtrabackup_log_filter, (G_PTR*) &xtrabackup_log_filter,
+   0, GET_BOOL, NO_ARG, 0, 0, 0, 0, 0, 0},
   {"extra-lsndir", OPT_XTRA_EXTRA_LSNDIR, "(for --backup): save an extra copy of the xtrabackup_checkpoints file in this directory.",
    (G_PTR*) &xtrabackup_extra_lsndir, (G_PTR*) &xtrabackup_extra_lsndir,
    0, GET_STR, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
@@ -552,16 +621,29 @@ static struct my_option xb_long_options[] =
    (G_PTR*) &opt_mysql_tmpdir,
    (G_PTR*) &opt_mysql_tmpdir, 0, GET_STR, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
   {"parallel", OPT_XTRA_PARALLEL,
-   "Number of threads to use for parallel datafiles transfer. Does not have "
-   "any effect in the stream mode. The default value is 1.",
+   "Number of threads to use for parallel datafiles transfer. When streaming "
+   "in the 'tar' format, files are spooled and written to the stream one at "
+   "a time, see --stream-spool-size. The default value is 1.",
    (G_PTR*) &xtrabackup_parallel, (G_PTR*) &xtrabackup_parallel, 0, GET_INT,
    REQUIRED_ARG, 1, 1, INT_MAX, 0, 0, 0},
 
   {"stream", OPT_XTRA_STREAM, "Stream all backup files to the standard output "
-   "in the specified format. Currently the only supported format is 'tar'.",
+   "in the specified format. Supported formats are 'tar' and 'xbstream'. "
+   "With --prepare, receive a backup in the 'xbstream' format from the "
+   "standard input into the target directory and prepare it.",
    (G_PTR*) &xtrabackup_stream_str, (G_PTR*) &xtrabackup_stream_str, 0, GET_STR,
    REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
 
+  {"stream-spool-size", OPT_XTRA_STREAM_SPOOL_SIZE,
+   "Size of the memory buffer each file is spooled to when streaming in the "
+   "'tar' format with --parallel. A file that outgrows it is written "
+   "directly to the stream if no other file is being written, and spilled "
+   "to a temporary file in --tmpdir otherwise. The default value is 16M.",
+   (G_PTR*) &xtrabackup_stream_spool_size,
+   (G_PTR*) &xtrabackup_stream_spool_size,
+   0, GET_ULL, REQUIRED_ARG, 16 * 1024 * 1024L, 64 * 1024L, ULONGLONG_MAX,
+   0, 1024, 0},
+
   {"compress", OPT_XTRA_COMPRESS, "Compress individual backup files using the "
    "specified compression algorithm. Currently the only supported algorithm "
    "is 'quicklz'. It is also the default algorithm, i.e. the one used when "
@@ -602,6 +684,48 @@ static struct my_option xb_long_options[] =
    (G_PTR*) &xtrabackup_encrypt_chunk_size, (G_PTR*) &xtrabackup_encrypt_chunk_size,
    0, GET_ULL, REQUIRED_ARG, (1 << 16), 1024, ULONGLONG_MAX, 0, 0, 0},
 
+  {"local-write-mode", OPT_XTRA_LOCAL_WRITE_MODE,
+   "How files are written to the target directory when not streaming. "
+   "'fsync' (the default) writes and syncs each file in the copying thread, "
+   "'write-behind' hands writes to background writer threads and syncs the "
+   "target filesystem once at the end, 'direct' additionally bypasses the "
+   "OS page cache with O_DIRECT.",
+   &xtrabackup_local_write_mode, &xtrabackup_local_write_mode,
+   &xtrabackup_local_write_mode_typelib, GET_ENUM, REQUIRED_ARG,
+   DS_LOCAL_FSYNC, 0, 0, 0, 0, 0},
+
+  {"local-write-threads", OPT_XTRA_LOCAL_WRITE_THREADS,
+   "Number of writer threads for --local-write-mode=write-behind or direct. "
+   "The default value is 1.",
+   (G_PTR*) &xtrabackup_local_write_threads,
+   (G_PTR*) &xtrabackup_local_write_threads,
+   0, GET_UINT, REQUIRED_ARG, 1, 1, UINT_MAX, 0, 0, 0},
+
+  {"local-write-queue-size", OPT_XTRA_LOCAL_WRITE_QUEUE_SIZE,
+   "Maximum amount of data in bytes queued for the writer threads before "
+   "copying threads block. The default value is 64M.",
+   (G_PTR*) &xtrabackup_local_write_queue_size,
+   (G_PTR*) &xtrabackup_local_write_queue_size,
+   0, GET_ULL, REQUIRED_ARG, 64 * 1024 * 1024L, 1024 * 1024L, ULONGLONG_MAX,
+   0, 1024, 0},
+
+  {"buffer-memory-limit", OPT_XTRA_BUFFER_MEMORY_LIMIT,
+   "Maximum amount of memory in bytes used by the read, delta, compression, "
+   "encryption and write buffers. Threads needing a new buffer wait for "
+   "other threads to release theirs when the limit is reached. The default "
+   "value is 0 (no limit).",
+   (G_PTR*) &xtrabackup_buffer_memory_limit,
+   (G_PTR*) &xtrabackup_buffer_memory_limit,
+   0, GET_ULL, REQUIRED_ARG, 0, 0, ULONGLONG_MAX, 0, 1024 * 1024L, 0},
+
+  {"buffer-large-pages", OPT_XTRA_BUFFER_LARGE_PAGES,
+   "Allocate buffers of 2M or more from the reserved huge pages "
+   "(vm.nr_hugepages) when possible. Without this option, such buffers "
+   "are still advised to use transparent huge pages.",
+   (G_PTR*) &xtrabackup_buffer_large_pages,
+   (G_PTR*) &xtrabackup_buffer_large_pages,
+   0, GET_BOOL, NO_ARG, 0, 0, 0, 0, 0, 0},
+
    {"innodb", OPT_INNODB, "Ignored option for MySQL option compatibility",
    (G_PTR*) &innobase_ignored_opt, (G_PTR*) &innobase_ignored_opt, 0,
    GET_STR, OPT_ARG, 0, 0, 0, 0, 0, 0},
@@ -752,6 +876,13 @@ Disable with --skip-innodb-doublewrite.", (G_PTR*) &innobase_use_doublewrite,
    "Path to special datafile for doublewrite buffer. (default is "": not used)",
    (G_PTR*) &innobase_doublewrite_file, (G_PTR*) &innobase_doublewrite_file,
    0, GET_STR, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
+  {"innodb_parallel_doublewrite_path", OPT_INNODB_PARALLEL_DOUBLEWRITE_PATH,
+   "Name prefix of the files the batch flushes of each buffer pool instance "
+   "are doublewritten to on --prepare, relative to the target directory. "
+   "(default is "": not used)",
+   (G_PTR*) &srv_parallel_doublewrite_path,
+   (G_PTR*) &srv_parallel_doublewrite_path,
+   0, GET_STR, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
   {"innodb_buffer_pool_filename", OPT_INNODB_BUFFER_POOL_FILENAME,
    "Filename to/from which to dump/load the InnoDB buffer pool",
    (G_PTR*) &innobase_buffer_pool_filename,
@@ -779,6 +910,8 @@ Disable with --skip-innodb-doublewrite.", (G_PTR*) &innobase_use_doublewrite,
 
   {"rebuild_threads", OPT_XTRA_REBUILD_INDEXES,
    "Use this number of threads to rebuild indexes in a compact backup. "
+   "Threads that have no tables left to process help building the "
+   "secondary indexes of the remaining tables in parallel. "
    "Only has effect with --prepare and --rebuild-indexes.",
    (G_PTR*) &xtrabackup_rebuild_threads, (G_PTR*) &xtrabackup_rebuild_threads,
    0, GET_UINT, REQUIRED_ARG, 1, 1, UINT_MAX, 0, 0, 0},
@@ -810,6 +943,18 @@ Disable with --skip-innodb-doublewrite.", (G_PTR*) &innobase_use_doublewrite,
    (G_PTR*)&xtrabackup_incremental_force_scan, 0, GET_BOOL, NO_ARG,
    0, 0, 0, 0, 0, 0},
 
+  {"status-file", OPT_XTRA_STATUS_FILE,
+   "Periodically write the backup or prepare progress as a JSON document "
+   "to this file.",
+   (G_PTR*) &xtrabackup_status_file, (G_PTR*) &xtrabackup_status_file,
+   0, GET_STR, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
+
+  {"status-interval", OPT_XTRA_STATUS_INTERVAL,
+   "Time interval between updates of the status file in milliseconds "
+   "(default is 1 second).",
+   (G_PTR*) &xtrabackup_status_interval, (G_PTR*) &xtrabackup_status_interval,
+   0, GET_ULONG, REQUIRED_ARG, 1000, 10, ULONG_MAX, 0, 1, 0},
+
   {"defaults_group", OPT_DEFAULTS_GROUP, "defaults group in config file (default \"mysqld\").",
    (G_PTR*) &defaults_group, (G_PTR*) &defaults_group,
    0, GET_STR, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
@@ -1114,7 +1259,7 @@ mem_free_and_error:
                 goto error;
 	}
 
-	if (xtrabackup_prepare) {
+	if (xtrabackup_prepare || xtrabackup_verify) {
 		/* "--prepare" needs filenames only */
 		ulint i;
 
@@ -1586,8 +1731,12 @@ void
 xtrabackup_io_throttling(void)
 {
 	if (xtrabackup_throttle && (io_ticket--) < 0) {
+		ullint	start = ut_time_us(NULL);
+
 		os_event_reset(wait_throttle);
 		os_event_wait(wait_throttle);
+
+		xb_progress_throttle_wait(ut_time_us(NULL) - start);
 	}
 }
 
@@ -1760,11 +1909,16 @@ xtrabackup_copy_datafile(fil_node_t* node, uint thread_n)
 		return(FALSE);
 	}
 
-	if (!changed_page_bitmap) {
-		read_filter = &rf_pass_through;
-	}
-	else {
+	if (changed_page_bitmap) {
 		read_filter = &rf_bitmap;
+	} else if (xtrabackup_incremental
+		   && xb_lsn_summary_is_unchanged(node,
+			xb_get_relative_path(node_path, is_system))) {
+		msg("[%02u] %s has not changed since the base backup, "
+		    "skipping its pages\n", thread_n, node_path);
+		read_filter = &rf_skip;
+	} else {
+		read_filter = &rf_pass_through;
 	}
 	res = xb_fil_cur_open(&cursor, read_filter, node, thread_n);
 	if (res == XB_FIL_CUR_SKIP) {
@@ -1833,6 +1987,8 @@ xtrabackup_copy_datafile(fil_node_t* node, uint thread_n)
 
 	/* The main copy loop */
 	while ((res = xb_fil_cur_read(&cursor)) == XB_FIL_CUR_SUCCESS) {
+		xb_progress_data_read(thread_n, cursor.buf_npages,
+				      cursor.buf_read);
 		if (!write_filter->process(&write_filt_ctxt, dstfile)) {
 			goto error;
 		}
@@ -1849,6 +2005,8 @@ xtrabackup_copy_datafile(fil_node_t* node, uint thread_n)
 
 	/* close */
 	msg("[%02u]        ...done\n", thread_n);
+	xb_progress_data_file_done(thread_n);
+	xb_lsn_summary_add(&cursor, read_filter == &rf_skip);
 	xb_fil_cur_close(&cursor);
 	ds_close(dstfile);
 	if (write_filter && write_filter->deinit) {
@@ -1881,6 +2039,7 @@ skip:
 	    "and ignore the file.\n", thread_n);
 	msg("[%02u] xtrabackup: Warning: skipping tablespace %s.\n",
 	    thread_n, node_name);
+	xb_progress_data_file_done(thread_n);
 	return(FALSE);
 }
 
@@ -2057,7 +2216,10 @@ xtrabackup_copy_logfile(lsn_t from_lsn, my_bool is_last)
 		}
 
 
-		if (ds_write(dst_log_file, log_sys->buf, write_size)) {
+		if (xtrabackup_log_filter
+		    ? xb_log_filt_write(dst_log_file, log_sys->buf,
+					write_size, is_last && finished)
+		    : ds_write(dst_log_file, log_sys->buf, write_size)) {
 			msg("xtrabackup: Error: write to logfile failed\n");
 			goto error;
 		}
@@ -2099,6 +2261,38 @@ error:
 	return(TRUE);
 }
 
+/************************************************************************
+Read the latest checkpoint LSN from the log files.
+
+@return TRUE on success, FALSE on error. */
+static
+my_bool
+xtrabackup_read_latest_checkpoint(
+/*==============================*/
+	lsn_t*	lsn)	/*!< out: latest checkpoint LSN */
+{
+	log_group_t*	max_cp_group;
+	ulint		max_cp_field;
+	ulint		err;
+
+	mutex_enter(&log_sys->mutex);
+
+	err = recv_find_max_checkpoint(&max_cp_group, &max_cp_field);
+
+	if (err != DB_SUCCESS) {
+		mutex_exit(&log_sys->mutex);
+		return(FALSE);
+	}
+
+	log_group_read_checkpoint_info(max_cp_group, max_cp_field);
+
+	*lsn = mach_read_from_8(log_sys->checkpoint_buf + LOG_CHECKPOINT_LSN);
+
+	mutex_exit(&log_sys->mutex);
+
+	return(TRUE);
+}
+
 static
 #ifndef __WIN__
 void*
@@ -2108,6 +2302,8 @@ ulint
 log_copying_thread(
 	void*	arg __attribute__((unused)))
 {
+	lsn_t	latest_cp;
+
 	/*
 	  Initialize mysys thread-specific memory so we can
 	  use mysys functions in this thread.
@@ -2129,6 +2325,13 @@ log_copying_thread(
 
 				exit(EXIT_FAILURE);
 			}
+
+			/* Track how far the server is ahead of us for the
+			status file */
+			if (xtrabackup_status_file
+			    && xtrabackup_read_latest_checkpoint(&latest_cp)) {
+				xb_progress_set_log_state(latest_cp, 0);
+			}
 		}
 	}
 
@@ -2260,20 +2463,13 @@ Initialize the appropriate datasink(s). Both local backups and streaming in the
 'xbstream' format allow parallel writes so we can write directly.
 
 Otherwise (i.e. when streaming in the 'tar' format) we need 2 separate datasinks
-for the data stream (and don't allow parallel data copying) and for metainfo
-files (including xtrabackup_logfile). The second datasink writes to temporary
-files first, and then streams them in a serialized way when closed. */
+for the data stream and for metainfo files (including xtrabackup_logfile). With
+--parallel, data files are spooled so that each of them is written to the
+archive in one piece. The second datasink writes to temporary files first, and
+then streams them in a serialized way when closed. */
 static void
 xtrabackup_init_datasinks(void)
 {
-	if (xtrabackup_parallel > 1 && xtrabackup_stream &&
-	    xtrabackup_stream_fmt == XB_STREAM_FMT_TAR) {
-		msg("xtrabackup: warning: the --parallel option does not have "
-		    "any effect when streaming in the 'tar' format. "
-		    "You can use the 'xbstream' format instead.\n");
-		xtrabackup_parallel = 1;
-	}
-
 	/* Start building out the pipelines from the terminus back */
 	if (xtrabackup_stream) {
 		/* All streaming goes to stdout */
@@ -2283,6 +2479,15 @@ xtrabackup_init_datasinks(void)
 		/* Local filesystem */
 		ds_data = ds_meta = ds_create(xtrabackup_target_dir,
 					      DS_TYPE_LOCAL);
+		if (ds_local_set_mode(ds_data,
+				      (ds_local_mode_t)
+				      xtrabackup_local_write_mode,
+				      xtrabackup_local_write_threads,
+				      (size_t) xtrabackup_local_write_queue_size)) {
+			msg("xtrabackup: error: failed to start local "
+			    "writer threads.\n");
+			exit(EXIT_FAILURE);
+		}
 	}
 
 	/* Track it for destruction */
@@ -2316,15 +2521,35 @@ xtrabackup_init_datasinks(void)
 		ds_set_pipe(ds, ds_data);
 		ds_data = ds;
 
+		if (xtrabackup_stream_fmt == XB_STREAM_FMT_TAR &&
+		    xtrabackup_parallel > 1) {
+			ds_ctxt_t	*ds_spool;
+
+			ds_spool = ds_create(xtrabackup_target_dir,
+					     DS_TYPE_SPOOL);
+			ds_spool_set_size(ds_spool,
+					  (size_t)
+					  xtrabackup_stream_spool_size);
+			xtrabackup_add_datasink(ds_spool);
+			ds_set_pipe(ds_spool, ds);
+			ds_data = ds_spool;
+		}
+
 		if (xtrabackup_stream_fmt != XB_STREAM_FMT_XBSTREAM ||
-		    xtrabackup_suspend_at_end ||
-		    xtrabackup_suspend_at_start) {
-
-			/* 'xbstream' allow parallel streams, but we
-			still can't stream directly to stdout when
-			xtrabackup is invoked from innobackupex
-			(i.e. with --suspend_at_and), because
-			innobackupex and xtrabackup streams would
+		    ((xtrabackup_suspend_at_end ||
+		      xtrabackup_suspend_at_start) &&
+		     (xtrabackup_encrypt ||
+		      ds_xbstream_set_lock(ds, fileno(stdout))))) {
+
+			/* 'xbstream' allow parallel streams, but when
+			xtrabackup is invoked from innobackupex (i.e.
+			with --suspend_at_end), innobackupex streams
+			its own files to the same stdout. Chunks
+			written by both are serialized with a lock on
+			stdout, so xtrabackup_logfile is streamed as
+			it is copied. That is not possible when the
+			output cannot be locked, or when the stream is
+			encrypted, because the encrypted streams would
 			interfere. Use temporary files instead. */
 			ds_meta = ds_create(xtrabackup_target_dir, DS_TYPE_TMPFILE);
 			xtrabackup_add_datasink(ds_meta);
@@ -2359,6 +2584,8 @@ Destruction is done in the specific order to not violate their order in the
 pipeline so that each datasink is able to flush data down the pipeline. */
 static void xtrabackup_destroy_datasinks(void)
 {
+	xb_progress_forget_datasinks();
+
 	for (uint i = actual_datasinks; i > 0; i--) {
 		ds_destroy(datasinks[i-1]);
 		datasinks[i-1] = NULL;
@@ -2385,6 +2612,56 @@ xb_check_if_open_tablespace(
 	return !check_if_skip_table(buf);
 }
 
+/************************************************************************
+Checks if a tablespace should be recovered on --prepare --export with
+--tables or --tables-file. Tablespaces in the 'mysql' database are always
+recovered, as InnoDB uses the persistent statistics tables in it.
+@return TRUE if the tablespace should be recovered. */
+static
+ibool
+xb_check_if_recover_tablespace(
+	const char*	db,
+	const char*	table)
+{
+	if (!strcmp(db, "mysql")) {
+		return(TRUE);
+	}
+
+	return(xb_check_if_open_tablespace(db, table));
+}
+
+/************************************************************************
+Pass the ids of the single-table tablespaces being backed up to the redo log
+filter. */
+static
+void
+xb_log_filter_set_tablespaces(void)
+/*===============================*/
+{
+	fil_space_t*	space;
+	ulint*		space_ids;
+	ulint		n_space_ids = 0;
+
+	mutex_enter(&fil_system->mutex);
+
+	space_ids = static_cast<ulint*>(
+		ut_malloc((UT_LIST_GET_LEN(fil_system->space_list) + 1)
+			  * sizeof(ulint)));
+
+	for (space = UT_LIST_GET_FIRST(fil_system->space_list);
+	     space != NULL;
+	     space = UT_LIST_GET_NEXT(space_list, space)) {
+
+		if (fil_is_user_tablespace_id(space->id)) {
+			space_ids[n_space_ids++] = space->id;
+		}
+	}
+
+	mutex_exit(&fil_system->mutex);
+
+	xb_log_filt_set_included(space_ids, n_space_ids);
+}
+
 /************************************************************************
 Initializes the I/O and tablespace cache subsystems. */
 static
@@ -2873,6 +3150,46 @@ xb_normalize_init_values(void)
 	srv_lock_table_size = 5 * (srv_buf_pool_size / UNIV_PAGE_SIZE);
 }
 
+/************************************************************************
+Compute the number and total size of data files to be copied and pass them to
+the status file reporting to estimate the completion time. */
+static
+void
+xtrabackup_set_progress_totals(
+/*===========================*/
+	fil_system_t*	f_system)	/*!< in: tablespace memory cache */
+{
+	datafiles_iter_t	*it;
+	fil_node_t		*node;
+	MY_STAT			 stat_info;
+	ulint			 files = 0;
+	ib_uint64_t		 bytes = 0;
+
+	it = datafiles_iter_new(f_system);
+	if (it == NULL) {
+		return;
+	}
+
+	while ((node = datafiles_iter_next(it)) != NULL) {
+
+		if (fil_is_user_tablespace_id(node->space->id)
+		    && check_if_skip_table(node->space->name)) {
+			continue;
+		}
+
+		if (my_stat(node->name, &stat_info, MYF(0)) == NULL) {
+			continue;
+		}
+
+		files++;
+		bytes += stat_info.st_size;
+	}
+
+	datafiles_iter_free(it);
+
+	xb_progress_set_totals(files, bytes);
+}
+
 static void
 xtrabackup_backup_func(void)
 {
@@ -3111,6 +3428,11 @@ reread_log_header:
 
 	mutex_exit(&log_sys->mutex);
 
+	xb_progress_set_log_state(checkpoint_lsn_start,
+				  log_group_get_capacity(
+					  UT_LIST_GET_FIRST(
+						  log_sys->log_groups)));
+
 	xtrabackup_init_datasinks();
 
 	/* open the log file */
@@ -3152,6 +3474,17 @@ reread_log_header:
 	}
 
 
+	if (xtrabackup_log_filter) {
+		if (xtrabackup_tables == NULL
+		    && xtrabackup_tables_file == NULL) {
+			msg("xtrabackup: --log-filter has no effect without "
+			    "--tables or --tables_file.\n");
+			xtrabackup_log_filter = FALSE;
+		} else {
+			xb_log_filt_init(checkpoint_lsn_start);
+		}
+	}
+
 	/* copy log file by current position */
 	if(xtrabackup_copy_logfile(checkpoint_lsn_start, FALSE))
 		exit(EXIT_FAILURE);
@@ -3168,8 +3501,13 @@ reread_log_header:
 		exit(EXIT_FAILURE);
 	}
 
+	if (xtrabackup_log_filter) {
+		xb_log_filter_set_tablespaces();
+	}
+
 	/* Suspend at start, for the FLUSH CHANGED_PAGE_BITMAPS call */
 	if (xtrabackup_suspend_at_start) {
+		xb_progress_set_phase("suspended_at_start");
 		xtrabackup_suspend(XB_FN_SUSPENDED_AT_START);
 	}
 
@@ -3194,6 +3532,14 @@ reread_log_header:
 		    "files transfer\n", xtrabackup_parallel);
 	}
 
+	if (xtrabackup_status_file) {
+		xtrabackup_set_progress_totals(f_system);
+	}
+	xb_progress_set_phase("copying_data");
+
+	xb_lsn_summary_init(xtrabackup_incremental ?
+			    xtrabackup_incremental_basedir : NULL);
+
 	it = datafiles_iter_new(f_system);
 	if (it == NULL) {
 		msg("xtrabackup: Error: datafiles_iter_new() failed.\n");
@@ -3237,38 +3583,22 @@ reread_log_header:
 
 	/* suspend-at-end */
 	if (xtrabackup_suspend_at_end) {
+		xb_progress_set_phase("suspended_at_end");
 		xtrabackup_suspend(XB_FN_SUSPENDED_AT_END);
 	}
 
 	/* read the latest checkpoint lsn */
 	latest_cp = 0;
-	{
-		log_group_t*	max_cp_group;
-		ulint	max_cp_field;
-		ulint	err;
-
-		mutex_enter(&log_sys->mutex);
-
-		err = recv_find_max_checkpoint(&max_cp_group, &max_cp_field);
-
-		if (err != DB_SUCCESS) {
-			msg("xtrabackup: Error: recv_find_max_checkpoint() failed.\n");
-			mutex_exit(&log_sys->mutex);
-			goto skip_last_cp;
-		}
-
-		log_group_read_checkpoint_info(max_cp_group, max_cp_field);
-
-		latest_cp = mach_read_from_8(log_sys->checkpoint_buf +
-					     LOG_CHECKPOINT_LSN);
-
-		mutex_exit(&log_sys->mutex);
-
+	if (!xtrabackup_read_latest_checkpoint(&latest_cp)) {
+		msg("xtrabackup: Error: recv_find_max_checkpoint() failed.\n");
+	} else {
 		msg("xtrabackup: The latest check point (for incremental): "
 		    "'" LSN_PF "'\n", latest_cp);
+		xb_progress_set_log_state(latest_cp, 0);
 	}
-skip_last_cp:
+
 	/* stop log_copying_thread */
+	xb_progress_set_phase("stopping_log_copy");
 	log_copying = FALSE;
 	os_event_set(log_copying_stop);
 	msg("xtrabackup: Stopping log copying thread.\n");
@@ -3280,6 +3610,10 @@ skip_last_cp:
 
 	os_event_free(log_copying_stop);
 
+	if (xtrabackup_log_filter) {
+		xb_log_filt_deinit();
+	}
+
 	/* Signal innobackupex that log copying has stopped and it may now
 	unlock tables, so we can possibly stream xtrabackup_logfile later
 	without holding the lock. */
@@ -3291,6 +3625,8 @@ skip_last_cp:
 		}
 	}
 
+	xb_progress_set_phase("writing_metadata");
+
 	if(!xtrabackup_incremental) {
 		strcpy(metadata_type, "full-backuped");
 		metadata_from_lsn = 0;
@@ -3316,11 +3652,32 @@ skip_last_cp:
 
 	}
 
+	/* Later incremental backups skip files by the summary, a backup
+	without a complete one must not be reported as successful */
+	if (!xb_lsn_summary_write(ds_meta, xtrabackup_extra_lsndir)) {
+		msg("xtrabackup: error: "
+		    "xb_lsn_summary_write() failed.\n");
+		exit(EXIT_FAILURE);
+	}
+	xb_lsn_summary_free();
+
 	xtrabackup_destroy_datasinks();
 
 	if (wait_throttle)
 		os_event_free(wait_throttle);
 
+	{
+		xb_arena_stats_t	arena_stats;
+
+		xb_arena_get_stats(&arena_stats);
+		msg("xtrabackup: Buffer memory: %llu bytes peak, "
+		    "%llu of %llu buffer allocations reused, %llu waited for "
+		    "the memory limit.\n", arena_stats.peak,
+		    arena_stats.n_reused, arena_stats.n_allocs,
+		    arena_stats.n_waits);
+		xb_arena_release();
+	}
+
 	msg("xtrabackup: Transaction log of lsn (" LSN_PF ") to (" LSN_PF
 	    ") was copied.\n", checkpoint_lsn_start, log_copy_scanned_lsn);
 	xb_filters_free();
@@ -5182,6 +5539,53 @@ xtrabackup_arch_search_files(
 	return xtrabackup_arch_first_file_lsn != 0;
 }
 
+/***********************************************************************
+Receive a backup streamed with --stream=xbstream on the standard input into
+the directory to be prepared, i.e. --incremental-dir if specified and the
+target directory otherwise. Compressed files are decompressed as they arrive,
+so the backup can be prepared as soon as the stream ends without a separate
+'xbstream -x' and decompression pass.
+
+Redo is not applied while the stream is being received. Although the log
+chunks are interleaved with the data files, recovery opens the tablespaces
+it finds in the target directory and scans the log from the checkpoint up to
+its end, which is only known when the last log chunk arrives. A page can also
+be streamed after the log records that change it. */
+static void
+xtrabackup_receive_stream(void)
+{
+	const char*	dir;
+	ds_ctxt_t*	ds;
+
+	if (xtrabackup_stream_fmt != XB_STREAM_FMT_XBSTREAM) {
+		msg("xtrabackup: error: --prepare can only receive backups "
+		    "in the 'xbstream' format.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	dir = xtrabackup_incremental_dir ? xtrabackup_incremental_dir
+		: xtrabackup_real_target_dir;
+
+	msg("xtrabackup: receiving the backup stream into %s\n", dir);
+
+	ds = ds_create(dir, DS_TYPE_LOCAL);
+	if (ds_local_set_mode(ds, (ds_local_mode_t) xtrabackup_local_write_mode,
+			      xtrabackup_local_write_threads,
+			      (size_t) xtrabackup_local_write_queue_size)) {
+		msg("xtrabackup: error: failed to start local "
+		    "writer threads.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (xb_stream_receive(ds, TRUE)) {
+		msg("xtrabackup: error: failed to receive the backup "
+		    "stream.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	ds_destroy(ds);
+}
+
 static void
 xtrabackup_prepare_func(void)
 {
@@ -5224,6 +5628,21 @@ xtrabackup_prepare_func(void)
 			msg("xtrabackup: This target seems to be already "
 			    "prepared.\n");
 			goto skip_check;
+		} else if (!strcmp(metadata_type, "export-prepared")) {
+			if (!xtrabackup_export
+			    || !(xtrabackup_tables || xtrabackup_tables_file)
+			    || xtrabackup_incremental
+			    || xtrabackup_apply_log_only) {
+				msg("xtrabackup: error: This target has been "
+				    "prepared with --export and --tables or "
+				    "--tables-file, only the exported "
+				    "tablespaces have been recovered. It can "
+				    "only be prepared again the same way.\n");
+				exit(EXIT_FAILURE);
+			}
+			msg("xtrabackup: This target seems to be already "
+			    "prepared for export.\n");
+			goto skip_check;
 		} else {
 			msg("xtrabackup: This target seems not to have correct "
 			    "metadata...\n");
@@ -5270,6 +5689,8 @@ skip_check:
 	if (xtrabackup_compact) {
 		srv_compact_backup = TRUE;
 
+		xb_progress_set_phase("expanding_datafiles");
+
 		if (!xb_expand_datafiles()) {
 			goto error;
 		}
@@ -5297,6 +5718,8 @@ skip_check:
 	if (xtrabackup_incremental) {
 		inc_dir_tables_hash = hash_create(1000);
 
+		xb_progress_set_phase("applying_deltas");
+
 		if(!xtrabackup_apply_deltas()) {
 			xb_data_files_close();
 			xb_tables_hash_free(inc_dir_tables_hash);
@@ -5330,6 +5753,25 @@ skip_check:
 	srv_apply_log_only = (ibool) xtrabackup_apply_log_only;
 	srv_rebuild_indexes = (ibool) xtrabackup_rebuild_indexes;
 
+	/* With --export and table filters, recover only the tablespaces being
+	exported: others are neither loaded nor opened from the dictionary, so
+	their redo log records are discarded when the log is parsed. */
+	if (xtrabackup_export
+	    && (xtrabackup_tables || xtrabackup_tables_file)) {
+		if (xtrabackup_incremental || xtrabackup_apply_log_only
+		    || innobase_log_arch_dir) {
+			msg("xtrabackup: warning: --tables and --tables-file "
+			    "are only used to limit recovery with a full "
+			    "prepare, recovering all tablespaces.\n");
+		} else {
+			xb_filters_init();
+			fil_tablespace_filter = xb_check_if_recover_tablespace;
+			msg("xtrabackup: recovering only the tablespaces of "
+			    "the tables matching --tables or "
+			    "--tables-file.\n");
+		}
+	}
+
 	/* increase IO threads */
 	if(srv_n_file_io_threads < 10) {
 		srv_n_read_io_threads = 4;
@@ -5387,6 +5829,11 @@ skip_check:
 	    "xtrabackup: Using %lld bytes for buffer pool "
 	    "(set by --use-memory parameter)\n", xtrabackup_use_memory);
 
+	xb_progress_set_phase("recovery");
+	xb_progress_set_recovery_target(xtrabackup_incremental
+					? incremental_last_lsn
+					: metadata_last_lsn);
+
 	if(innodb_init())
 		goto error;
 
@@ -5434,6 +5881,7 @@ skip_check:
 
 	if (xtrabackup_export) {
 		msg("xtrabackup: export option is specified.\n");
+		xb_progress_set_phase("exporting");
 		os_file_t	info_file = XB_FILE_UNDEFINED;
 		char		info_file_path[FN_REFLEN];
 		ibool		success;
@@ -5627,9 +6075,13 @@ next_node:
 		}
 	}
 
+	xb_progress_set_phase("shutdown");
+
 	if(innodb_end())
 		goto error;
 
+	xb_progress_set_phase("writing_metadata");
+
 	sync_initialized = FALSE;
 	os_sync_mutex = NULL;
 
@@ -5646,7 +6098,17 @@ next_node:
 	{
 		char	filename[FN_REFLEN];
 
-		strcpy(metadata_type, "full-prepared");
+		if (fil_tablespace_filter != NULL) {
+			/* The tablespaces excluded from recovery are left
+			untouched without the redo log applied, mark the
+			backup so it is neither prepared nor restored as a
+			whole */
+			strcpy(metadata_type, "export-prepared");
+			fil_tablespace_filter = NULL;
+			xb_filters_free();
+		} else {
+			strcpy(metadata_type, "full-prepared");
+		}
 
 		if(xtrabackup_incremental
 		   && metadata_to_lsn < incremental_to_lsn)
@@ -5686,43 +6148,1984 @@ error:
 	exit(EXIT_FAILURE);
 }
 
-/* ================= main =================== */
+/* ================= offline scan ================= */
 
-int main(int argc, char **argv)
+/* Number of pages read at once when scanning data files offline */
+#define XB_SCAN_BUF_PAGES	64
+
+/* Kind of a file scanned offline */
+enum xb_scan_file_type_t {
+	XB_SCAN_DATAFILE,	/* tablespace file */
+	XB_SCAN_DELTA		/* incremental .delta file */
+};
+
+/* File scanned offline by --verify or --stats-offline */
+typedef struct {
+	char			path[FN_REFLEN];
+	xb_scan_file_type_t	type;
+	ibool			is_system;	/* TRUE for system tablespace
+						data files */
+} xb_scan_file_t;
+
+/* List of files to scan */
+typedef struct {
+	xb_scan_file_t*		files;
+	ulint			n_files;
+	ulint			n_alloc;
+} xb_scan_list_t;
+
+/* Function processing a single file in a scan thread */
+typedef void (*xb_scan_func_t)(
+	const xb_scan_file_t*	sfile,		/*!< in: file to process */
+	uint			thread_n,	/*!< in: thread number */
+	void*			arg);		/*!< in: argument given to
+						xb_scan_start() */
+
+struct xb_scan_pool_struct;
+
+/* Scan thread context */
+typedef struct {
+	struct xb_scan_pool_struct*	pool;
+	uint				num;
+	os_thread_id_t			id;
+} xb_scan_thread_ctxt_t;
+
+/* Threads processing the files of a list in parallel */
+typedef struct xb_scan_pool_struct {
+	const xb_scan_list_t*	list;
+	xb_scan_func_t		func;
+	void*			arg;
+	xb_scan_thread_ctxt_t*	threads;
+	ulint			next;		/* next file to process */
+	uint			count;		/* number of running threads */
+	os_ib_mutex_t		mutex;		/* protects next and count */
+} xb_scan_pool_t;
+
+/************************************************************************
+Add a file to a scan list. */
+static
+void
+xb_scan_add_file(
+/*=============*/
+	xb_scan_list_t*		list,		/*!< in/out: file list */
+	const char*		path,		/*!< in: file path */
+	xb_scan_file_type_t	type,		/*!< in: file type */
+	ibool			is_system)	/*!< in: TRUE for system
+						tablespace data files */
 {
-	int ho_error;
+	xb_scan_file_t*	file;
 
-#ifdef __linux__
-	/* Ensure xtrabackup process is killed when the parent one
-	(innobackupex) is terminated with an unhandled signal */
+	if (list->n_files == list->n_alloc) {
+		list->n_alloc = list->n_alloc ? list->n_alloc * 2 : 64;
+		list->files = static_cast<xb_scan_file_t *>
+			(ut_realloc(list->files,
+				    list->n_alloc * sizeof(xb_scan_file_t)));
+	}
 
-	if (prctl(PR_SET_PDEATHSIG, SIGINT)) {
-		msg("prctl() failed with errno = %d\n", errno);
-		exit(EXIT_FAILURE);
+	file = list->files + list->n_files++;
+
+	ut_strlcpy(file->path, path, sizeof(file->path));
+	srv_normalize_path_for_win(file->path);
+	file->type = type;
+	file->is_system = is_system;
+}
+
+/************************************************************************
+xb_process_datadir() callback adding .ibd and .delta files to a scan list.
+@return TRUE */
+static
+ibool
+xb_scan_add_datadir_entry(
+/*======================*/
+	const char*	data_home_dir,		/*!<in: path to datadir */
+	const char*	db_name,		/*!<in: database name */
+	const char*	file_name,		/*!<in: file name with suffix */
+	void*		arg)			/*!<in: scan list */
+{
+	xb_scan_list_t*	list = (xb_scan_list_t *) arg;
+	char		path[FN_REFLEN];
+	size_t		len = strlen(file_name);
+
+	if (db_name) {
+		snprintf(path, sizeof(path), "%s/%s/%s",
+			 data_home_dir, db_name, file_name);
+	} else {
+		snprintf(path, sizeof(path), "%s/%s",
+			 data_home_dir, file_name);
 	}
-#endif
-	MY_INIT(argv[0]);
-	xb_regex_init();
 
-	system_charset_info= &my_charset_utf8_general_ci;
-	key_map_full.set_all();
+	if (len > 6 && !strcmp(file_name + len - 6, ".delta")) {
+		xb_scan_add_file(list, path, XB_SCAN_DELTA, FALSE);
+	} else {
+		xb_scan_add_file(list, path, XB_SCAN_DATAFILE, FALSE);
+	}
 
-	/* scan options for group to load defaults from */
-	{
-		int	i;
-		char*	optend;
-		for (i=1; i < argc; i++) {
-			optend = strcend(argv[i], '=');
-			if (strncmp(argv[i], "--defaults-group", optend - argv[i]) == 0) {
-				xb_load_default_groups[2] = defaults_group = optend + 1;
-			}
+	return(TRUE);
+}
+
+/************************************************************************
+Add the existing system tablespace and separate undo tablespace files to a
+scan list. */
+static
+void
+xb_scan_add_system_files(
+/*=====================*/
+	xb_scan_list_t*	list)		/*!< in/out: file list */
+{
+	char		path[FN_REFLEN];
+	ibool		exists;
+	os_file_type_t	type;
+	size_t		len;
+	ulint		i;
+
+	len = strlen(srv_data_home);
+
+	for (i = 0; i < srv_n_data_files; i++) {
+		snprintf(path, sizeof(path), "%s%s%s", srv_data_home,
+			 (len && srv_data_home[len - 1] != SRV_PATH_SEPARATOR)
+			 ? "/" : "", srv_data_file_names[i]);
+		srv_normalize_path_for_win(path);
+
+		if (os_file_status(path, &exists, &type) && exists
+		    && type == OS_FILE_TYPE_FILE) {
+			xb_scan_add_file(list, path, XB_SCAN_DATAFILE, TRUE);
 		}
 	}
-	load_defaults("my", xb_load_default_groups, &argc, &argv);
 
-	/* ignore unsupported options */
-	{
-	int i,j,argc_new,find;
+	for (i = 1; i <= srv_undo_tablespaces; i++) {
+		snprintf(path, sizeof(path), "%s%cundo%03lu",
+			 srv_undo_dir, SRV_PATH_SEPARATOR, i);
+		srv_normalize_path_for_win(path);
+
+		if (os_file_status(path, &exists, &type) && exists
+		    && type == OS_FILE_TYPE_FILE) {
+			xb_scan_add_file(list, path, XB_SCAN_DATAFILE, FALSE);
+		}
+	}
+}
+
+/************************************************************************
+Check whether a page of the system tablespace belongs to the doublewrite
+buffer. Such pages are skipped by xb_fil_cur_read() as well. */
+static inline
+ibool
+xb_scan_is_doublewrite_page(
+/*========================*/
+	ulint	page_no)	/*!< in: page number */
+{
+	return(page_no >= FSP_EXTENT_SIZE && page_no < FSP_EXTENT_SIZE * 3);
+}
+
+/************************************************************************
+Open a tablespace file for a sequential scan and determine its page size
+from the space header. System tablespace files other than the first one
+have no header and are assumed to have the default page size.
+@return TRUE on success */
+static
+ibool
+xb_scan_open_datafile(
+/*==================*/
+	const xb_scan_file_t*	sfile,		/*!< in: file to open */
+	const char*		what,		/*!< in: operation name for
+						messages */
+	uint			thread_n,	/*!< in: thread number */
+	byte*			buf,		/*!< in: aligned buffer of at
+						least UNIV_ZIP_SIZE_MIN
+						bytes */
+	os_file_t*		file,		/*!< out: open file handle */
+	ib_int64_t*		file_size,	/*!< out: file size */
+	ulint*			page_size,	/*!< out: physical page size */
+	ulint*			zip_size)	/*!< out: compressed page size
+						or 0 */
+{
+	ibool	success;
+
+	*file = os_file_create_simple_no_error_handling(0, sfile->path,
+							OS_FILE_OPEN,
+							OS_FILE_READ_ONLY,
+							&success);
+	if (!success) {
+		os_file_get_last_error(TRUE);
+		msg("[%02u] xtrabackup: %s: cannot open %s.\n",
+		    thread_n, what, sfile->path);
+		return(FALSE);
+	}
+
+	posix_fadvise(*file, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	*file_size = os_file_get_size(*file);
+
+	if (sfile->is_system) {
+		/* Only the first system tablespace file has the space
+		header */
+		*page_size = UNIV_PAGE_SIZE;
+		*zip_size = 0;
+	} else {
+		ulint	flags;
+
+		if (*file_size < UNIV_ZIP_SIZE_MIN
+		    || !os_file_read(*file, buf, 0, UNIV_ZIP_SIZE_MIN)) {
+			msg("[%02u] xtrabackup: %s: cannot read the space "
+			    "header of %s.\n", thread_n, what, sfile->path);
+			goto error;
+		}
+
+		flags = fsp_header_get_flags(buf);
+		if (!fsp_flags_is_valid(flags)) {
+			msg("[%02u] xtrabackup: %s: invalid space flags 0x%lx "
+			    "in %s.\n", thread_n, what, flags, sfile->path);
+			goto error;
+		}
+
+		*zip_size = fsp_flags_get_zip_size(flags);
+		*page_size = *zip_size ? *zip_size
+			: fsp_flags_get_page_size(flags);
+	}
+
+	if (!*zip_size && *page_size != UNIV_PAGE_SIZE) {
+		msg("[%02u] xtrabackup: %s: page size %lu of %s does not "
+		    "match innodb_page_size = %lu.\n", thread_n, what,
+		    *page_size, sfile->path, UNIV_PAGE_SIZE);
+		goto error;
+	}
+
+	if (*file_size % *page_size) {
+		msg("[%02u] xtrabackup: %s: size of %s (" INT64PF
+		    " bytes) is not a multiple of the page size %lu.\n",
+		    thread_n, what, sfile->path, *file_size, *page_size);
+		goto error;
+	}
+
+	return(TRUE);
+
+error:
+	os_file_close(*file);
+
+	return(FALSE);
+}
+
+/************************************************************************
+Scan thread. Processes files from the shared list until it is empty. */
+static
+os_thread_ret_t
+xb_scan_thread_func(
+/*================*/
+	void*	arg)	/* thread context */
+{
+	xb_scan_thread_ctxt_t*	ctxt = (xb_scan_thread_ctxt_t *) arg;
+	xb_scan_pool_t*		pool = ctxt->pool;
+
+	my_thread_init();
+
+	while (1) {
+		const xb_scan_file_t*	sfile;
+
+		os_mutex_enter(pool->mutex);
+		if (pool->next == pool->list->n_files) {
+			os_mutex_exit(pool->mutex);
+			break;
+		}
+		sfile = pool->list->files + pool->next++;
+		os_mutex_exit(pool->mutex);
+
+		pool->func(sfile, ctxt->num, pool->arg);
+	}
+
+	os_mutex_enter(pool->mutex);
+	pool->count--;
+	os_mutex_exit(pool->mutex);
+
+	my_thread_end();
+	os_thread_exit(NULL);
+	OS_THREAD_DUMMY_RETURN;
+}
+
+/************************************************************************
+Start threads processing all files of a list with the given function.
+Use xb_scan_wait() to wait for them to finish.
+@return number of started threads */
+static
+uint
+xb_scan_start(
+/*==========*/
+	xb_scan_pool_t*		pool,		/*!< out: thread pool */
+	const xb_scan_list_t*	list,		/*!< in: files to process */
+	uint			n_threads,	/*!< in: maximum number of
+						threads */
+	xb_scan_func_t		func,		/*!< in: processing function */
+	void*			arg)		/*!< in: argument to func */
+{
+	uint	i;
+
+	ut_ad(list->n_files > 0);
+
+	if (n_threads == 0) {
+		n_threads = 1;
+	}
+	if (n_threads > list->n_files) {
+		n_threads = (uint) list->n_files;
+	}
+
+	pool->list = list;
+	pool->func = func;
+	pool->arg = arg;
+	pool->next = 0;
+	pool->count = n_threads;
+	pool->mutex = os_mutex_create();
+	pool->threads = static_cast<xb_scan_thread_ctxt_t *>
+		(ut_malloc(sizeof(xb_scan_thread_ctxt_t) * n_threads));
+
+	for (i = 0; i < n_threads; i++) {
+		pool->threads[i].pool = pool;
+		pool->threads[i].num = i + 1;
+		os_thread_create(xb_scan_thread_func, pool->threads + i,
+				 &pool->threads[i].id);
+	}
+
+	return(n_threads);
+}
+
+/************************************************************************
+Wait for the threads started by xb_scan_start() to finish and free the
+pool. */
+static
+void
+xb_scan_wait(
+/*=========*/
+	xb_scan_pool_t*	pool)	/*!< in/out: thread pool */
+{
+	while (1) {
+		os_mutex_enter(pool->mutex);
+		if (pool->count == 0) {
+			os_mutex_exit(pool->mutex);
+			break;
+		}
+		os_mutex_exit(pool->mutex);
+		os_thread_sleep(100000);
+	}
+
+	os_mutex_free(pool->mutex);
+	ut_free(pool->threads);
+}
+
+/************************************************************************
+Initialize the InnoDB subsystems required to read data files without
+starting InnoDB. */
+static
+void
+xb_scan_init(void)
+/*==============*/
+{
+	srv_max_n_threads = 1000;
+	os_sync_mutex = NULL;
+	ut_mem_init();
+	os_sync_init();
+	sync_init();
+	os_io_init_simple();
+	mem_init(srv_mem_pool_size);
+	ut_crc32_init();
+
+	if (innodb_init_param()) {
+		exit(EXIT_FAILURE);
+	}
+}
+
+/* ================= verify ================= */
+
+/* Maximum number of corrupted pages reported for a single file */
+#define XB_VERIFY_MAX_REPORTED	10
+
+/* Results of --verify accumulated by all threads */
+typedef struct {
+	os_ib_mutex_t		mutex;		/* protects the counters */
+	ulint			n_failed;	/* number of files with
+						errors */
+	ib_uint64_t		n_pages;	/* pages checked */
+	ib_uint64_t		n_corrupted;	/* corrupted pages */
+	ib_uint64_t		n_bytes;	/* bytes read */
+} xb_verify_ctxt_t;
+
+/* Per-file results of --verify */
+typedef struct {
+	ib_uint64_t		n_pages;
+	ib_uint64_t		n_corrupted;
+	ib_uint64_t		n_bytes;
+} xb_verify_stats_t;
+
+/************************************************************************
+Check a single page with the same logic as xb_fil_cur_read().
+@return TRUE if the page is corrupted */
+static
+ibool
+xb_verify_page(
+/*===========*/
+	const byte*	page,		/*!< in: page */
+	ulint		zip_size,	/*!< in: compressed page size or 0 */
+	ulint		page_no,	/*!< in: page number */
+	const char*	path,		/*!< in: file name for messages */
+	uint		thread_n,	/*!< in: thread number */
+	ib_uint64_t*	n_corrupted)	/*!< in/out: corrupted pages */
+{
+	lsn_t	page_lsn;
+
+	if (buf_page_is_corrupted(TRUE, page, zip_size)) {
+		if (++*n_corrupted <= XB_VERIFY_MAX_REPORTED) {
+			msg("[%02u] xtrabackup: verify: page %lu of %s is "
+			    "corrupted.\n", thread_n, page_no, path);
+		}
+		return(TRUE);
+	}
+
+	/* Pages of a non-prepared backup cannot be newer than the copied
+	log */
+	page_lsn = mach_read_from_8(page + FIL_PAGE_LSN);
+	if (metadata_last_lsn > 0 && page_lsn > metadata_last_lsn
+	    && (!strcmp(metadata_type, "full-backuped")
+		|| !strcmp(metadata_type, "incremental"))) {
+		if (++*n_corrupted <= XB_VERIFY_MAX_REPORTED) {
+			msg("[%02u] xtrabackup: verify: page %lu of %s has "
+			    "LSN " LSN_PF " which is beyond the end of the "
+			    "copied log (" LSN_PF ").\n", thread_n, page_no,
+			    path, page_lsn, metadata_last_lsn);
+		}
+		return(TRUE);
+	}
+
+	return(FALSE);
+}
+
+/************************************************************************
+Check all pages of a tablespace file.
+@return TRUE if the file is OK */
+static
+ibool
+xb_verify_datafile(
+/*===============*/
+	const xb_scan_file_t*	vfile,		/*!< in: file to check */
+	uint			thread_n,	/*!< in: thread number */
+	xb_verify_stats_t*	stats)		/*!< out: results */
+{
+	os_file_t	file;
+	byte*		buf_base;
+	byte*		buf;
+	ulint		page_size;
+	ulint		zip_size;
+	ib_int64_t	file_size;
+	ib_int64_t	offset;
+	ibool		ret		= FALSE;
+
+	buf_base = static_cast<byte *>
+		(ut_malloc((XB_SCAN_BUF_PAGES + 1) * UNIV_PAGE_SIZE_MAX));
+	buf = static_cast<byte *>(ut_align(buf_base, UNIV_PAGE_SIZE_MAX));
+
+	if (!xb_scan_open_datafile(vfile, "verify", thread_n, buf, &file,
+				   &file_size, &page_size, &zip_size)) {
+		ut_free(buf_base);
+		return(FALSE);
+	}
+
+	for (offset = 0; offset < file_size;) {
+		ulint	to_read;
+		ulint	npages;
+		ulint	i;
+
+		to_read = (ulint) ut_min(file_size - offset,
+					 (ib_int64_t) XB_SCAN_BUF_PAGES
+					 * page_size);
+		npages = to_read / page_size;
+
+		if (!os_file_read(file, buf, offset, to_read)) {
+			msg("[%02u] xtrabackup: verify: cannot read %s at "
+			    "offset " INT64PF ".\n", thread_n, vfile->path,
+			    offset);
+			goto end;
+		}
+
+		for (i = 0; i < npages; i++) {
+			ulint	page_no = (ulint) (offset / page_size) + i;
+
+			if (vfile->is_system
+			    && xb_scan_is_doublewrite_page(page_no)) {
+				continue;
+			}
+
+			xb_verify_page(buf + i * page_size, zip_size, page_no,
+				       vfile->path, thread_n,
+				       &stats->n_corrupted);
+		}
+
+		stats->n_pages += npages;
+		stats->n_bytes += to_read;
+		offset += to_read;
+
+		posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED);
+	}
+
+	ret = (stats->n_corrupted == 0);
+
+end:
+	ut_free(buf_base);
+	os_file_close(file);
+
+	return(ret);
+}
+
+/************************************************************************
+Check the .meta file, the cluster headers and all pages of an incremental
+.delta file. The format is the one xtrabackup_apply_delta() expects.
+@return TRUE if the file is OK */
+static
+ibool
+xb_verify_delta(
+/*============*/
+	const xb_scan_file_t*	vfile,		/*!< in: file to check */
+	uint			thread_n,	/*!< in: thread number */
+	xb_verify_stats_t*	stats)		/*!< out: results */
+{
+	os_file_t	file		= XB_FILE_UNDEFINED;
+	char		meta_path[FN_REFLEN];
+	xb_delta_info_t	info;
+	ibool		success;
+	byte*		buf_base	= NULL;
+	byte*		buf;
+	ulint		page_size;
+	ulint		page_size_shift;
+	ulint		zip_size;
+	ulint		cluster_size;
+	ib_int64_t	file_size;
+	ib_int64_t	offset;
+	ibool		last_cluster	= FALSE;
+	ibool		ret		= FALSE;
+
+	if (!get_meta_path(vfile->path, meta_path)) {
+		goto end;
+	}
+
+	if (!xb_read_delta_metadata(meta_path, &info)) {
+		msg("[%02u] xtrabackup: verify: invalid metadata file %s.\n",
+		    thread_n, meta_path);
+		goto end;
+	}
+
+	/* xb_read_delta_metadata() succeeds for a missing .meta file, but
+	the delta cannot be applied without it */
+	if (info.page_size == ULINT_UNDEFINED) {
+		msg("[%02u] xtrabackup: verify: cannot read %s.\n",
+		    thread_n, meta_path);
+		goto end;
+	}
+
+	page_size = info.page_size;
+	page_size_shift = get_bit_shift(page_size);
+	if (page_size_shift < 10
+	    || page_size_shift > UNIV_PAGE_SIZE_SHIFT_MAX
+	    || (1UL << page_size_shift) != page_size) {
+		msg("[%02u] xtrabackup: verify: invalid page_size %lu in "
+		    "%s.\n", thread_n, page_size, meta_path);
+		goto end;
+	}
+
+	if (info.zip_size == ULINT_UNDEFINED) {
+		zip_size = (page_size == UNIV_PAGE_SIZE) ? 0 : page_size;
+	} else if (info.zip_size == 0 ? page_size != UNIV_PAGE_SIZE
+		   : info.zip_size != page_size) {
+		msg("[%02u] xtrabackup: verify: zip_size %lu does not match "
+		    "page_size %lu in %s.\n", thread_n, info.zip_size,
+		    page_size, meta_path);
+		goto end;
+	} else {
+		zip_size = info.zip_size;
+	}
+
+	file = os_file_create_simple_no_error_handling(0, vfile->path,
+						       OS_FILE_OPEN,
+						       OS_FILE_READ_ONLY,
+						       &success);
+	if (!success) {
+		os_file_get_last_error(TRUE);
+		msg("[%02u] xtrabackup: verify: cannot open %s.\n",
+		    thread_n, vfile->path);
+		goto end;
+	}
+
+	posix_fadvise(file, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	file_size = os_file_get_size(file);
+
+	/* Each cluster is a header page with the magic and the page offsets
+	followed by up to page_size / 4 - 1 pages */
+	cluster_size = page_size / 4;
+
+	buf_base = static_cast<byte *>
+		(ut_malloc((UNIV_PAGE_SIZE_MAX / 4 + 1) * UNIV_PAGE_SIZE_MAX));
+	buf = static_cast<byte *>(ut_align(buf_base, UNIV_PAGE_SIZE_MAX));
+
+	for (offset = 0; !last_cluster;
+	     offset += (ib_int64_t) cluster_size << page_size_shift) {
+		ulint	npages;
+		ulint	i;
+
+		if (offset + (ib_int64_t) page_size > file_size) {
+			msg("[%02u] xtrabackup: verify: %s is truncated at "
+			    "offset " INT64PF ".\n", thread_n, vfile->path,
+			    offset);
+			goto end;
+		}
+
+		if (!os_file_read(file, buf, offset, page_size)) {
+			goto read_error;
+		}
+
+		switch (mach_read_from_4(buf)) {
+		case 0x78747261UL: /*"xtra"*/
+			break;
+		case 0x58545241UL: /*"XTRA"*/
+			last_cluster = TRUE;
+			break;
+		default:
+			msg("[%02u] xtrabackup: verify: invalid cluster "
+			    "header at offset " INT64PF " of %s.\n",
+			    thread_n, offset, vfile->path);
+			goto end;
+		}
+
+		for (npages = 1; npages < cluster_size; npages++) {
+			if (mach_read_from_4(buf + npages * 4)
+			    == 0xFFFFFFFFUL) {
+				break;
+			}
+		}
+
+		if (!last_cluster && npages != cluster_size) {
+			msg("[%02u] xtrabackup: verify: incomplete cluster "
+			    "at offset " INT64PF " of %s.\n", thread_n,
+			    offset, vfile->path);
+			goto end;
+		}
+
+		if (offset + ((ib_int64_t) npages << page_size_shift)
+		    > file_size) {
+			msg("[%02u] xtrabackup: verify: %s is truncated at "
+			    "offset " INT64PF ".\n", thread_n, vfile->path,
+			    offset);
+			goto end;
+		}
+
+		if (npages > 1
+		    && !os_file_read(file, buf + page_size,
+				     offset + page_size,
+				     (npages - 1) * page_size)) {
+			goto read_error;
+		}
+
+		for (i = 1; i < npages; i++) {
+			const byte*	page = buf + i * page_size;
+			ulint		page_no;
+			ulint		page_offset;
+			ulint		page_space_id;
+
+			page_no = mach_read_from_4(buf + i * 4);
+
+			if (info.space_id == 0
+			    && xb_scan_is_doublewrite_page(page_no)) {
+				continue;
+			}
+
+			if (xb_verify_page(page, zip_size, page_no,
+					   vfile->path, thread_n,
+					   &stats->n_corrupted)) {
+				continue;
+			}
+
+			/* The page must be applied to the right place */
+			page_offset = mach_read_from_4(page + FIL_PAGE_OFFSET);
+			page_space_id = mach_read_from_4(
+				page + FIL_PAGE_ARCH_LOG_NO_OR_SPACE_ID);
+
+			if (page_offset != page_no
+			    || (info.space_id != ULINT_UNDEFINED
+				&& page_space_id != info.space_id)) {
+				if (++stats->n_corrupted
+				    <= XB_VERIFY_MAX_REPORTED) {
+					msg("[%02u] xtrabackup: verify: page "
+					    "%lu of %s has page number %lu "
+					    "and space id %lu, expected "
+					    "space id %lu.\n", thread_n,
+					    page_no, vfile->path,
+					    page_offset, page_space_id,
+					    info.space_id);
+				}
+			}
+		}
+
+		stats->n_pages += npages - 1;
+		stats->n_bytes += npages * page_size;
+
+		posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED);
+	}
+
+	ret = (stats->n_corrupted == 0);
+	goto end;
+
+read_error:
+	msg("[%02u] xtrabackup: verify: cannot read %s at offset " INT64PF
+	    ".\n", thread_n, vfile->path, offset);
+end:
+	if (buf_base) {
+		ut_free(buf_base);
+	}
+	if (file != XB_FILE_UNDEFINED) {
+		os_file_close(file);
+	}
+
+	return(ret);
+}
+
+/************************************************************************
+xb_scan_start() callback checking a single file for --verify. */
+static
+void
+xb_verify_file(
+/*===========*/
+	const xb_scan_file_t*	vfile,		/*!< in: file to check */
+	uint			thread_n,	/*!< in: thread number */
+	void*			arg)		/*!< in: verify context */
+{
+	xb_verify_ctxt_t*	verify = (xb_verify_ctxt_t *) arg;
+	xb_verify_stats_t	stats;
+	ibool			ok;
+
+	memset(&stats, 0, sizeof(stats));
+
+	if (vfile->type == XB_SCAN_DELTA) {
+		ok = xb_verify_delta(vfile, thread_n, &stats);
+	} else {
+		ok = xb_verify_datafile(vfile, thread_n, &stats);
+	}
+
+	if (!ok) {
+		msg("[%02u] xtrabackup: verify: %s: FAILED, "
+		    UINT64PF " of " UINT64PF " pages corrupted.\n",
+		    thread_n, vfile->path, stats.n_corrupted,
+		    stats.n_pages);
+	}
+
+	os_mutex_enter(verify->mutex);
+	verify->n_pages += stats.n_pages;
+	verify->n_corrupted += stats.n_corrupted;
+	verify->n_bytes += stats.n_bytes;
+	if (!ok) {
+		verify->n_failed++;
+	}
+	os_mutex_exit(verify->mutex);
+}
+
+/************************************************************************
+Check the checksums and the continuity of the log blocks in
+xtrabackup_logfile, and that the log covers the range of LSNs recorded in
+xtrabackup_checkpoints.
+@return TRUE if the log is OK */
+static
+ibool
+xb_verify_log(void)
+/*===============*/
+{
+	os_file_t	file;
+	char		path[FN_REFLEN];
+	ibool		success;
+	byte*		buf_base;
+	byte*		buf;
+	ulint		buf_size;
+	ib_int64_t	file_size;
+	ib_int64_t	offset;
+	ulint		field;
+	lsn_t		max_no		= 0;
+	lsn_t		checkpoint_lsn	= 0;
+	lsn_t		scanned_lsn;
+	lsn_t		required_lsn;
+	ulint		n_blocks	= 0;
+	ibool		finished	= FALSE;
+	ibool		ret		= FALSE;
+
+	snprintf(path, sizeof(path), "%s/%s", xtrabackup_target_dir,
+		 XB_LOG_FILENAME);
+	srv_normalize_path_for_win(path);
+
+	file = os_file_create_simple_no_error_handling(0, path, OS_FILE_OPEN,
+						       OS_FILE_READ_ONLY,
+						       &success);
+	if (!success) {
+		os_file_get_last_error(TRUE);
+		msg("xtrabackup: verify: cannot open %s. Compressed or "
+		    "encrypted backups must be decompressed and decrypted "
+		    "before --verify.\n", path);
+		return(FALSE);
+	}
+
+	posix_fadvise(file, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	file_size = os_file_get_size(file);
+
+	buf_size = XB_SCAN_BUF_PAGES * UNIV_PAGE_SIZE_MAX;
+	buf_base = static_cast<byte *>
+		(ut_malloc(buf_size + UNIV_PAGE_SIZE_MAX));
+	buf = static_cast<byte *>(ut_align(buf_base, UNIV_PAGE_SIZE_MAX));
+
+	if (file_size < (ib_int64_t) LOG_FILE_HDR_SIZE
+	    || !os_file_read(file, buf, 0, LOG_FILE_HDR_SIZE)) {
+		msg("xtrabackup: verify: cannot read the header of %s.\n",
+		    path);
+		goto end;
+	}
+
+	if (ut_memcmp(buf + LOG_FILE_WAS_CREATED_BY_HOT_BACKUP,
+		      (byte*)"xtrabkup", (sizeof "xtrabkup") - 1) != 0) {
+		msg("xtrabackup: verify: %s was already used to --prepare, "
+		    "skipping log checks.\n", path);
+		ret = TRUE;
+		goto end;
+	}
+
+	/* Find the checkpoint the log copy has started from, the same way
+	xtrabackup_init_temp_log() does */
+	for (field = LOG_CHECKPOINT_1; field <= LOG_CHECKPOINT_2;
+	     field += LOG_CHECKPOINT_2 - LOG_CHECKPOINT_1) {
+		lsn_t	checkpoint_no;
+
+		if (!recv_check_cp_is_consistent(buf + field)) {
+			continue;
+		}
+
+		checkpoint_no = mach_read_from_8(buf + field
+						 + LOG_CHECKPOINT_NO);
+		if (checkpoint_no >= max_no) {
+			max_no = checkpoint_no;
+			checkpoint_lsn = mach_read_from_8(buf + field
+							  + LOG_CHECKPOINT_LSN);
+		}
+	}
+
+	if (checkpoint_lsn == 0) {
+		msg("xtrabackup: verify: no valid checkpoint found in %s.\n",
+		    path);
+		goto end;
+	}
+
+	/* The log blocks start right after the header, from the block
+	containing the checkpoint */
+	scanned_lsn = ut_uint64_align_down(checkpoint_lsn,
+					   OS_FILE_LOG_BLOCK_SIZE);
+
+	for (offset = LOG_FILE_HDR_SIZE; offset < file_size && !finished;) {
+		ulint	to_read;
+		byte*	log_block;
+
+		to_read = (ulint) ut_min(file_size - offset,
+					 (ib_int64_t) buf_size);
+		to_read = ut_calc_align_down(to_read, OS_FILE_LOG_BLOCK_SIZE);
+		if (to_read == 0) {
+			break;
+		}
+
+		if (!os_file_read(file, buf, offset, to_read)) {
+			msg("xtrabackup: verify: cannot read %s at offset "
+			    INT64PF ".\n", path, offset);
+			goto end;
+		}
+
+		for (log_block = buf; log_block < buf + to_read;
+		     log_block += OS_FILE_LOG_BLOCK_SIZE) {
+			ulint	no = log_block_get_hdr_no(log_block);
+			ulint	scanned_no;
+			ulint	data_len;
+
+			scanned_no = log_block_convert_lsn_to_no(scanned_lsn);
+
+			if (!log_block_checksum_is_ok_or_old_format(
+				    log_block)) {
+				msg("xtrabackup: verify: log block checksum "
+				    "mismatch (block no %lu at lsn " LSN_PF
+				    "): expected %lu, calculated checksum "
+				    "%lu.\n", (ulong) no, scanned_lsn,
+				    (ulong) log_block_get_checksum(log_block),
+				    (ulong) log_block_calc_checksum(
+					    log_block));
+				goto end;
+			}
+
+			if (no != scanned_no) {
+				msg("xtrabackup: verify: log block numbers "
+				    "mismatch: expected log block no. %lu at "
+				    "lsn " LSN_PF ", but got no. %lu.\n",
+				    (ulong) scanned_no, scanned_lsn,
+				    (ulong) no);
+				goto end;
+			}
+
+			n_blocks++;
+
+			data_len = log_block_get_data_len(log_block);
+			if (data_len < OS_FILE_LOG_BLOCK_SIZE) {
+				/* The copied log ends here */
+				scanned_lsn += data_len;
+				finished = TRUE;
+				break;
+			}
+
+			scanned_lsn += OS_FILE_LOG_BLOCK_SIZE;
+		}
+
+		offset += to_read;
+	}
+
+	msg("xtrabackup: verify: log: checkpoint lsn " LSN_PF ", "
+	    "end lsn " LSN_PF ", %lu blocks checked.\n",
+	    checkpoint_lsn, scanned_lsn, n_blocks);
+
+	/* The log must cover everything from the checkpoint up to the end
+	of the backup */
+	required_lsn = ut_max(metadata_to_lsn, metadata_last_lsn);
+
+	if (checkpoint_lsn > metadata_to_lsn) {
+		msg("xtrabackup: verify: log starts at " LSN_PF ", "
+		    "after to_lsn " LSN_PF ".\n",
+		    checkpoint_lsn, metadata_to_lsn);
+		goto end;
+	}
+
+	if (scanned_lsn < required_lsn) {
+		msg("xtrabackup: verify: log ends at " LSN_PF ", "
+		    "expected at least " LSN_PF ".\n",
+		    scanned_lsn, required_lsn);
+		goto end;
+	}
+
+	ret = TRUE;
+
+end:
+	ut_free(buf_base);
+	os_file_close(file);
+
+	return(ret);
+}
+
+/************************************************************************
+Implementation of --verify. Checks all data files and deltas of the backup
+in target_dir in parallel, along with xtrabackup_logfile, and reports the
+result. Exits with an error if the backup is found to be damaged. */
+static void
+xtrabackup_verify_func(void)
+{
+	xb_verify_ctxt_t	verify;
+	xb_scan_list_t		list;
+	xb_scan_pool_t		pool;
+	char			metadata_path[FN_REFLEN];
+	uint			n_threads;
+	ibool			log_ok;
+	ib_time_t		start_time;
+	ulint			elapsed;
+
+	if (my_setwd(xtrabackup_real_target_dir,MYF(MY_WME)))
+	{
+		msg("xtrabackup: cannot my_setwd %s\n",
+		    xtrabackup_real_target_dir);
+		exit(EXIT_FAILURE);
+	}
+	msg("xtrabackup: cd to %s\n", xtrabackup_real_target_dir);
+
+	xtrabackup_target_dir= mysql_data_home_buff;
+	xtrabackup_target_dir[0]=FN_CURLIB;		// all paths are relative from here
+	xtrabackup_target_dir[1]=0;
+
+	sprintf(metadata_path, "%s/%s", xtrabackup_target_dir,
+		XTRABACKUP_METADATA_FILENAME);
+
+	if (!xtrabackup_read_metadata(metadata_path)) {
+		msg("xtrabackup: verify: cannot read %s\n", metadata_path);
+		exit(EXIT_FAILURE);
+	}
+
+	msg("xtrabackup: verify: backup_type = %s, from_lsn = " LSN_PF
+	    ", to_lsn = " LSN_PF ", last_lsn = " LSN_PF "\n",
+	    metadata_type, metadata_from_lsn, metadata_to_lsn,
+	    metadata_last_lsn);
+
+	xb_scan_init();
+
+	memset(&verify, 0, sizeof(verify));
+	verify.mutex = os_mutex_create();
+
+	memset(&list, 0, sizeof(list));
+	xb_scan_add_system_files(&list);
+	xb_process_datadir(xtrabackup_target_dir, ".ibd",
+			   xb_scan_add_datadir_entry, &list);
+	xb_process_datadir(xtrabackup_target_dir, ".delta",
+			   xb_scan_add_datadir_entry, &list);
+
+	if (list.n_files == 0) {
+		msg("xtrabackup: verify: no data files found in %s. "
+		    "Compressed or encrypted backups must be decompressed "
+		    "and decrypted before --verify.\n",
+		    xtrabackup_real_target_dir);
+		exit(EXIT_FAILURE);
+	}
+
+	start_time = ut_time();
+
+	n_threads = xb_scan_start(&pool, &list, xtrabackup_parallel,
+				  xb_verify_file, &verify);
+
+	msg("xtrabackup: verify: checking %lu files using %u threads\n",
+	    list.n_files, n_threads);
+
+	/* Check the log while the data files are being read */
+	log_ok = xb_verify_log();
+
+	xb_scan_wait(&pool);
+
+	elapsed = (ulint) ut_difftime(ut_time(), start_time);
+
+	msg("xtrabackup: verify: %lu files, " UINT64PF " pages, "
+	    UINT64PF " MB checked in %lu seconds\n", list.n_files,
+	    verify.n_pages, verify.n_bytes >> 20, elapsed);
+	msg("xtrabackup: verify: %lu files failed, " UINT64PF
+	    " corrupted pages, log %s\n", verify.n_failed,
+	    verify.n_corrupted, log_ok ? "OK" : "FAILED");
+
+	os_mutex_free(verify.mutex);
+	ut_free(list.files);
+
+	if (verify.n_failed > 0 || !log_ok) {
+		msg("xtrabackup: verify: backup is NOT usable.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	msg("xtrabackup: verify: backup is OK.\n");
+}
+
+/* ================= offline stats ================= */
+
+/* B-tree levels accounted separately by --stats-offline. Pages of higher
+levels are accounted to the last one. */
+#define XB_STATS_MAX_LEVELS	16
+
+/* Statistics of a single B-tree level */
+typedef struct {
+	ib_uint64_t	n_pages;
+	ib_uint64_t	n_recs;		/* records, including delete-marked */
+	ib_uint64_t	data_size;	/* bytes occupied by records */
+	ib_uint64_t	garbage;	/* bytes in the page free lists */
+	ib_uint64_t	n_out_of_order;	/* pages whose right sibling is not
+					the physically next page */
+} xb_stats_level_t;
+
+/* Statistics of a single index gathered from its pages */
+typedef struct xb_stats_index_struct	xb_stats_index_t;
+struct xb_stats_index_struct {
+	index_id_t		id;
+	ulint			space_id;
+	ulint			root_page_no;	/* FIL_NULL if not found */
+	ulint			n_levels;
+	xb_stats_level_t	levels[XB_STATS_MAX_LEVELS];
+	hash_node_t		hash;
+};
+
+/* Table or index name read from the data dictionary */
+typedef struct xb_stats_name_struct	xb_stats_name_t;
+struct xb_stats_name_struct {
+	ib_uint64_t		id;		/* table or index id */
+	table_id_t		table_id;	/* table id of an index */
+	char*			name;
+	hash_node_t		hash;
+};
+
+/* Page type counters of a single data file */
+typedef struct {
+	ibool		ok;		/* FALSE if the file could not be
+					read */
+	ulint		space_id;
+	ulint		page_size;
+	ulint		zip_size;
+	ib_uint64_t	n_pages;
+	ib_uint64_t	n_index;	/* B-tree pages */
+	ib_uint64_t	n_blob;		/* externally stored columns */
+	ib_uint64_t	blob_bytes;	/* data on uncompressed BLOB pages */
+	ib_uint64_t	n_undo;		/* undo log pages */
+	ib_uint64_t	n_free;		/* free and never used pages */
+	ib_uint64_t	n_other;	/* file management, system and
+					doublewrite pages */
+	ib_uint64_t	n_corrupted;
+} xb_stats_file_t;
+
+/* State of --stats-offline shared by the scan threads */
+typedef struct {
+	const xb_scan_list_t*	list;
+	xb_stats_file_t*	files;		/* results in the order of
+						list->files */
+	hash_table_t*		indexes;	/* xb_stats_index_t */
+	hash_table_t*		tables;		/* xb_stats_name_t of tables
+						from SYS_TABLES */
+	hash_table_t*		index_names;	/* xb_stats_name_t of indexes
+						from SYS_INDEXES */
+	os_ib_mutex_t		mutex;		/* protects the hash tables */
+} xb_stats_ctxt_t;
+
+/************************************************************************
+Check whether a page is marked free in its extent descriptor.
+@return TRUE if the page is free */
+static
+ibool
+xb_stats_page_is_free(
+/*==================*/
+	const byte*	descr_page,	/*!< in: descriptor page or NULL */
+	ulint		descr_page_no,	/*!< in: descr_page offset */
+	ulint		zip_size,	/*!< in: compressed page size or 0 */
+	ulint		page_no)	/*!< in: page offset */
+{
+	const xdes_t*	descr;
+	ulint		state;
+
+	if (descr_page == NULL
+	    || xdes_calc_descriptor_page(zip_size, page_no)
+	    != descr_page_no) {
+		/* The descriptor has not been read, assume the page is
+		used */
+		return(FALSE);
+	}
+
+	descr = descr_page + XDES_ARR_OFFSET
+		+ XDES_SIZE * xdes_calc_descriptor_index(zip_size, page_no);
+
+	/* Descriptors of the extents above the free limit are not
+	initialized */
+	state = mach_read_from_4(descr + XDES_STATE);
+	if (state != XDES_FREE_FRAG && state != XDES_FULL_FRAG
+	    && state != XDES_FSEG) {
+		return(TRUE);
+	}
+
+	return(xdes_get_bit(descr, XDES_FREE_BIT, page_no % FSP_EXTENT_SIZE));
+}
+
+/************************************************************************
+Add a name to a dictionary hash unless it is already there. */
+static
+void
+xb_stats_add_name(
+/*==============*/
+	hash_table_t*	hash,		/*!< in/out: name hash */
+	ib_uint64_t	id,		/*!< in: table or index id */
+	table_id_t	table_id,	/*!< in: table id of an index */
+	const byte*	name,		/*!< in: name, not NUL-terminated */
+	ulint		len)		/*!< in: length of name */
+{
+	xb_stats_name_t*	entry;
+
+	HASH_SEARCH(hash, hash, ut_fold_ull(id), xb_stats_name_t*, entry,
+		    (void) 0, entry->id == id);
+	if (entry != NULL) {
+		return;
+	}
+
+	entry = static_cast<xb_stats_name_t *>
+		(ut_malloc(sizeof(xb_stats_name_t) + len + 1));
+	entry->id = id;
+	entry->table_id = table_id;
+	entry->name = (char *) (entry + 1);
+	memcpy(entry->name, name, len);
+	entry->name[len] = '\0';
+
+	HASH_INSERT(xb_stats_name_t, hash, hash, ut_fold_ull(id), entry);
+}
+
+/************************************************************************
+Read the table or index names from a leaf page of the clustered index of
+SYS_TABLES or SYS_INDEXES. The records are in the redundant format. */
+static
+void
+xb_stats_read_dict_page(
+/*====================*/
+	const byte*		page,		/*!< in: leaf page */
+	index_id_t		index_id,	/*!< in: DICT_TABLES_ID or
+						DICT_INDEXES_ID */
+	xb_stats_ctxt_t*	stats)		/*!< in/out: stats context */
+{
+	ulint	offs = PAGE_OLD_INFIMUM;
+	ulint	n_fields;
+	ulint	n;
+
+	if (page_is_comp(page)) {
+		return;
+	}
+
+	n_fields = (index_id == DICT_TABLES_ID)
+		? (ulint) DICT_NUM_FIELDS__SYS_TABLES
+		: (ulint) DICT_NUM_FIELDS__SYS_INDEXES;
+
+	os_mutex_enter(stats->mutex);
+
+	/* Follow the record list with bounds checks, the page may be
+	inconsistent without having a wrong checksum */
+	for (n = 0; n < UNIV_PAGE_SIZE / REC_N_OLD_EXTRA_BYTES; n++) {
+		const rec_t*	rec;
+		const byte*	field;
+		ulint		len;
+		const byte*	id_field;
+		ulint		id_len;
+
+		/* Stop at the supremum or at an invalid pointer */
+		offs = mach_read_from_2(page + offs - REC_NEXT);
+		if (offs <= PAGE_OLD_SUPREMUM
+		    || offs >= UNIV_PAGE_SIZE - FIL_PAGE_DATA_END) {
+			break;
+		}
+
+		rec = page + offs;
+
+		if (rec_get_n_fields_old(rec) != n_fields
+		    || rec_get_deleted_flag(rec, FALSE)) {
+			continue;
+		}
+
+		if (index_id == DICT_TABLES_ID) {
+			field = rec_get_nth_field_old(
+				rec, DICT_FLD__SYS_TABLES__NAME, &len);
+			id_field = rec_get_nth_field_old(
+				rec, DICT_FLD__SYS_TABLES__ID, &id_len);
+		} else {
+			field = rec_get_nth_field_old(
+				rec, DICT_FLD__SYS_INDEXES__NAME, &len);
+			id_field = rec_get_nth_field_old(
+				rec, DICT_FLD__SYS_INDEXES__ID, &id_len);
+		}
+
+		if (len == UNIV_SQL_NULL || id_len != 8
+		    || field + len > page + UNIV_PAGE_SIZE) {
+			continue;
+		}
+
+		if (index_id == DICT_TABLES_ID) {
+			xb_stats_add_name(stats->tables,
+					  mach_read_from_8(id_field), 0,
+					  field, len);
+		} else {
+			const byte*	table_id_field;
+			ulint		table_id_len;
+
+			table_id_field = rec_get_nth_field_old(
+				rec, DICT_FLD__SYS_INDEXES__TABLE_ID,
+				&table_id_len);
+			if (table_id_len != 8) {
+				continue;
+			}
+
+			xb_stats_add_name(stats->index_names,
+					  mach_read_from_8(id_field),
+					  mach_read_from_8(table_id_field),
+					  field, len);
+		}
+	}
+
+	os_mutex_exit(stats->mutex);
+}
+
+/************************************************************************
+Account a B-tree page to its index and level. */
+static
+void
+xb_stats_index_page(
+/*================*/
+	const byte*		page,		/*!< in: index page */
+	ulint			page_no,	/*!< in: page offset */
+	hash_table_t*		hash,		/*!< in/out: index stats */
+	xb_stats_ctxt_t*	stats)		/*!< in/out: stats context */
+{
+	xb_stats_index_t*	index;
+	xb_stats_level_t*	level;
+	index_id_t		id;
+	ulint			level_no;
+	ulint			prev;
+	ulint			next;
+	ulint			space_id;
+
+	id = mach_read_from_8(page + PAGE_HEADER + PAGE_INDEX_ID);
+	level_no = mach_read_from_2(page + PAGE_HEADER + PAGE_LEVEL);
+	prev = mach_read_from_4(page + FIL_PAGE_PREV);
+	next = mach_read_from_4(page + FIL_PAGE_NEXT);
+	space_id = mach_read_from_4(page + FIL_PAGE_ARCH_LOG_NO_OR_SPACE_ID);
+
+	HASH_SEARCH(hash, hash, ut_fold_ull(id), xb_stats_index_t*, index,
+		    (void) 0, index->id == id);
+	if (index == NULL) {
+		index = static_cast<xb_stats_index_t *>
+			(ut_malloc(sizeof(xb_stats_index_t)));
+		memset(index, 0, sizeof(xb_stats_index_t));
+		index->id = id;
+		index->space_id = space_id;
+		index->root_page_no = FIL_NULL;
+		HASH_INSERT(xb_stats_index_t, hash, hash, ut_fold_ull(id),
+			    index);
+	}
+
+	if (level_no + 1 > index->n_levels) {
+		index->n_levels = level_no + 1;
+	}
+
+	/* The root is the only page of the top level */
+	if (prev == FIL_NULL && next == FIL_NULL
+	    && level_no + 1 == index->n_levels) {
+		index->root_page_no = page_no;
+	}
+
+	level = index->levels + ut_min(level_no, XB_STATS_MAX_LEVELS - 1);
+
+	level->n_pages++;
+	level->n_recs += page_get_n_recs(page);
+	level->data_size += page_get_data_size(page);
+	level->garbage += page_header_get_field(page, PAGE_GARBAGE);
+	if (next != FIL_NULL && next != page_no + 1) {
+		level->n_out_of_order++;
+	}
+
+	if (space_id == 0 && level_no == 0
+	    && (id == DICT_TABLES_ID || id == DICT_INDEXES_ID)) {
+		xb_stats_read_dict_page(page, id, stats);
+	}
+}
+
+/************************************************************************
+Move the index statistics of a single file to the shared hash, adding them
+to the statistics gathered from other files of the same tablespace. Frees
+the file hash. */
+static
+void
+xb_stats_merge(
+/*===========*/
+	hash_table_t*		hash,		/*!< in, own: file stats */
+	xb_stats_ctxt_t*	stats)		/*!< in/out: stats context */
+{
+	ulint	i;
+
+	os_mutex_enter(stats->mutex);
+
+	for (i = 0; i < hash_get_n_cells(hash); i++) {
+		xb_stats_index_t*	index;
+
+		index = static_cast<xb_stats_index_t *>
+			(HASH_GET_FIRST(hash, i));
+
+		while (index) {
+			xb_stats_index_t*	next;
+			xb_stats_index_t*	found;
+			ulint			l;
+
+			next = static_cast<xb_stats_index_t *>
+				(HASH_GET_NEXT(hash, index));
+
+			HASH_DELETE(xb_stats_index_t, hash, hash,
+				    ut_fold_ull(index->id), index);
+
+			HASH_SEARCH(hash, stats->indexes,
+				    ut_fold_ull(index->id),
+				    xb_stats_index_t*, found, (void) 0,
+				    found->id == index->id);
+
+			if (found == NULL) {
+				HASH_INSERT(xb_stats_index_t, hash,
+					    stats->indexes,
+					    ut_fold_ull(index->id), index);
+				index = next;
+				continue;
+			}
+
+			for (l = 0; l < XB_STATS_MAX_LEVELS; l++) {
+				xb_stats_level_t*	to = found->levels + l;
+				xb_stats_level_t*	from = index->levels + l;
+
+				to->n_pages += from->n_pages;
+				to->n_recs += from->n_recs;
+				to->data_size += from->data_size;
+				to->garbage += from->garbage;
+				to->n_out_of_order += from->n_out_of_order;
+			}
+
+			if (index->n_levels > found->n_levels) {
+				found->n_levels = index->n_levels;
+				found->root_page_no = index->root_page_no;
+			} else if (index->n_levels == found->n_levels
+				   && found->root_page_no == FIL_NULL) {
+				found->root_page_no = index->root_page_no;
+			}
+
+			ut_free(index);
+			index = next;
+		}
+	}
+
+	os_mutex_exit(stats->mutex);
+
+	hash_table_free(hash);
+}
+
+/************************************************************************
+xb_scan_start() callback gathering the statistics of a single file for
+--stats-offline. */
+static
+void
+xb_stats_file(
+/*==========*/
+	const xb_scan_file_t*	sfile,		/*!< in: file to scan */
+	uint			thread_n,	/*!< in: thread number */
+	void*			arg)		/*!< in: stats context */
+{
+	xb_stats_ctxt_t*	stats = (xb_stats_ctxt_t *) arg;
+	xb_stats_file_t*	fstats;
+	hash_table_t*		hash;
+	os_file_t		file;
+	byte*			buf_base;
+	byte*			buf;
+	byte*			descr_page_base;
+	byte*			descr_page;
+	ulint			descr_page_no	= ULINT_UNDEFINED;
+	ibool			have_descr	= FALSE;
+	ulint			page_size;
+	ulint			zip_size;
+	ib_int64_t		file_size;
+	ib_int64_t		offset;
+
+	fstats = stats->files + (sfile - stats->list->files);
+
+	buf_base = static_cast<byte *>
+		(ut_malloc((XB_SCAN_BUF_PAGES + 1) * UNIV_PAGE_SIZE_MAX));
+	buf = static_cast<byte *>(ut_align(buf_base, UNIV_PAGE_SIZE_MAX));
+
+	if (!xb_scan_open_datafile(sfile, "stats", thread_n, buf, &file,
+				   &file_size, &page_size, &zip_size)) {
+		ut_free(buf_base);
+		return;
+	}
+
+	descr_page_base = static_cast<byte *>
+		(ut_malloc(2 * UNIV_PAGE_SIZE_MAX));
+	descr_page = static_cast<byte *>
+		(ut_align(descr_page_base, UNIV_PAGE_SIZE_MAX));
+
+	fstats->page_size = page_size;
+	fstats->zip_size = zip_size;
+	fstats->space_id = ULINT_UNDEFINED;
+
+	hash = hash_create(sfile->is_system ? 10000 : 100);
+
+	for (offset = 0; offset < file_size;) {
+		ulint	to_read;
+		ulint	npages;
+		ulint	i;
+
+		to_read = (ulint) ut_min(file_size - offset,
+					 (ib_int64_t) XB_SCAN_BUF_PAGES
+					 * page_size);
+		npages = to_read / page_size;
+
+		if (!os_file_read(file, buf, offset, to_read)) {
+			msg("[%02u] xtrabackup: stats: cannot read %s at "
+			    "offset " INT64PF ".\n", thread_n, sfile->path,
+			    offset);
+			goto end;
+		}
+
+		for (i = 0; i < npages; i++) {
+			const byte*	page = buf + i * page_size;
+			ulint		page_no;
+
+			fstats->n_pages++;
+
+			if (sfile->is_system
+			    && xb_scan_is_doublewrite_page(
+				    (ulint) (offset / page_size) + i)) {
+				fstats->n_other++;
+				continue;
+			}
+
+			if (buf_page_is_corrupted(TRUE, page, zip_size)) {
+				fstats->n_corrupted++;
+				continue;
+			}
+
+			/* Use the page number stored in the page, as only the
+			first system tablespace file starts with page 0 */
+			page_no = mach_read_from_4(page + FIL_PAGE_OFFSET);
+
+			if (fstats->space_id == ULINT_UNDEFINED) {
+				fstats->space_id = mach_read_from_4(
+					page + FIL_PAGE_ARCH_LOG_NO_OR_SPACE_ID);
+			}
+
+			if (page_no == xdes_calc_descriptor_page(zip_size,
+								 page_no)) {
+				memcpy(descr_page, page, page_size);
+				descr_page_no = page_no;
+				have_descr = TRUE;
+			}
+
+			if (xb_stats_page_is_free(have_descr ? descr_page
+						  : NULL, descr_page_no,
+						  zip_size, page_no)) {
+				fstats->n_free++;
+				continue;
+			}
+
+			switch (fil_page_get_type(page)) {
+			case FIL_PAGE_INDEX:
+				fstats->n_index++;
+				xb_stats_index_page(page, page_no, hash, stats);
+				break;
+			case FIL_PAGE_TYPE_BLOB:
+				fstats->n_blob++;
+				/* BTR_BLOB_HDR_PART_LEN */
+				fstats->blob_bytes += mach_read_from_4(
+					page + FIL_PAGE_DATA);
+				break;
+			case FIL_PAGE_TYPE_ZBLOB:
+			case FIL_PAGE_TYPE_ZBLOB2:
+				fstats->n_blob++;
+				break;
+			case FIL_PAGE_UNDO_LOG:
+				fstats->n_undo++;
+				break;
+			case FIL_PAGE_TYPE_ALLOCATED:
+				fstats->n_free++;
+				break;
+			default:
+				fstats->n_other++;
+			}
+		}
+
+		offset += to_read;
+
+		posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED);
+	}
+
+	fstats->ok = TRUE;
+
+end:
+	xb_stats_merge(hash, stats);
+
+	ut_free(descr_page_base);
+	ut_free(buf_base);
+	os_file_close(file);
+}
+
+/************************************************************************
+xb_process_datadir() callback adding .ibd files of the tables matching the
+--tables and --tables-file filters to a scan list.
+@return TRUE */
+static
+ibool
+xb_stats_add_datadir_entry(
+/*=======================*/
+	const char*	data_home_dir,		/*!<in: path to datadir */
+	const char*	db_name,		/*!<in: database name */
+	const char*	file_name,		/*!<in: file name with suffix */
+	void*		arg)			/*!<in: scan list */
+{
+	char	name[FN_REFLEN];
+
+	if (db_name) {
+		snprintf(name, sizeof(name), "%s/%s", db_name, file_name);
+		if (check_if_skip_table(name)) {
+			return(TRUE);
+		}
+	}
+
+	return(xb_scan_add_datadir_entry(data_home_dir, db_name, file_name,
+					 arg));
+}
+
+/************************************************************************
+Print a string as a JSON string literal. */
+static
+void
+xb_stats_print_json_string(
+/*=======================*/
+	FILE*		f,	/*!< in: output stream */
+	const char*	s)	/*!< in: string or NULL */
+{
+	if (s == NULL) {
+		fputs("null", f);
+		return;
+	}
+
+	putc('"', f);
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\') {
+			putc('\\', f);
+			putc(*s, f);
+		} else if ((unsigned char) *s < 0x20) {
+			fprintf(f, "\\u%04x", (unsigned) *s);
+		} else {
+			putc(*s, f);
+		}
+	}
+	putc('"', f);
+}
+
+/************************************************************************
+qsort() comparison function ordering indexes by space id and index id. */
+static
+int
+xb_stats_index_cmp(
+/*===============*/
+	const void*	a,
+	const void*	b)
+{
+	const xb_stats_index_t*	ia = *(const xb_stats_index_t**) a;
+	const xb_stats_index_t*	ib = *(const xb_stats_index_t**) b;
+
+	if (ia->space_id != ib->space_id) {
+		return(ia->space_id < ib->space_id ? -1 : 1);
+	}
+	if (ia->id != ib->id) {
+		return(ia->id < ib->id ? -1 : 1);
+	}
+	return(0);
+}
+
+/************************************************************************
+Print the statistics of a single index as a JSON object. */
+static
+void
+xb_stats_print_index(
+/*=================*/
+	FILE*			f,	/*!< in: output stream */
+	const xb_stats_index_t*	index,	/*!< in: index stats */
+	xb_stats_ctxt_t*	stats)	/*!< in: stats context */
+{
+	const xb_stats_name_t*	index_name;
+	const xb_stats_name_t*	table_name = NULL;
+	ib_uint64_t		n_pages = 0;
+	ib_uint64_t		data_size = 0;
+	const xb_stats_level_t*	leaf = index->levels;
+	ulint			n_levels;
+	ulint			l;
+
+	HASH_SEARCH(hash, stats->index_names, ut_fold_ull(index->id),
+		    const xb_stats_name_t*, index_name, (void) 0,
+		    index_name->id == index->id);
+	if (index_name != NULL) {
+		HASH_SEARCH(hash, stats->tables,
+			    ut_fold_ull(index_name->table_id),
+			    const xb_stats_name_t*, table_name, (void) 0,
+			    table_name->id == index_name->table_id);
+	}
+
+	n_levels = ut_min(index->n_levels, XB_STATS_MAX_LEVELS);
+
+	for (l = 0; l < n_levels; l++) {
+		n_pages += index->levels[l].n_pages;
+		data_size += index->levels[l].data_size;
+	}
+
+	fprintf(f, "    {\"index_id\": " UINT64PF ", \"space_id\": %lu, "
+		"\"table\": ", (ib_uint64_t) index->id, index->space_id);
+	xb_stats_print_json_string(f, table_name ? table_name->name : NULL);
+	fputs(", \"index\": ", f);
+	xb_stats_print_json_string(f, index_name ? index_name->name : NULL);
+	fprintf(f, ",\n     \"root_page\": ");
+	if (index->root_page_no != FIL_NULL) {
+		fprintf(f, "%lu", index->root_page_no);
+	} else {
+		fputs("null", f);
+	}
+	fprintf(f, ", \"height\": %lu, \"pages\": " UINT64PF
+		", \"leaf_pages\": " UINT64PF ", \"records\": " UINT64PF
+		",\n     \"fill_factor\": %.4f, \"leaf_fragmentation\": %.4f"
+		",\n     \"levels\": [",
+		index->n_levels, n_pages, leaf->n_pages, leaf->n_recs,
+		n_pages ? (double) data_size / n_pages / UNIV_PAGE_SIZE : 0.0,
+		leaf->n_pages
+		? (double) leaf->n_out_of_order / leaf->n_pages : 0.0);
+
+	for (l = 0; l < n_levels; l++) {
+		const xb_stats_level_t*	level = index->levels + l;
+
+		fprintf(f, "%s\n       {\"level\": %lu, \"pages\": " UINT64PF
+			", \"records\": " UINT64PF ", \"data_bytes\": "
+			UINT64PF ", \"garbage_bytes\": " UINT64PF
+			", \"out_of_order_pages\": " UINT64PF
+			", \"fill_factor\": %.4f}",
+			l ? "," : "", l, level->n_pages, level->n_recs,
+			level->data_size, level->garbage,
+			level->n_out_of_order,
+			level->n_pages ? (double) level->data_size
+			/ level->n_pages / UNIV_PAGE_SIZE : 0.0);
+	}
+
+	fprintf(f, "\n     ]}");
+}
+
+/************************************************************************
+Print the --stats-offline report as a JSON document. */
+static
+void
+xb_stats_print(
+/*===========*/
+	FILE*			f,	/*!< in: output stream */
+	xb_stats_ctxt_t*	stats)	/*!< in: stats context */
+{
+	xb_stats_index_t**	indexes;
+	ulint			n_indexes = 0;
+	ulint			n_alloc = 256;
+	ulint			i;
+
+	fprintf(f, "{\n  \"page_size\": %lu,\n  \"files\": [", UNIV_PAGE_SIZE);
+
+	for (i = 0; i < stats->list->n_files; i++) {
+		const xb_stats_file_t*	fstats = stats->files + i;
+
+		fprintf(f, "%s\n    {\"path\": ", i ? "," : "");
+		xb_stats_print_json_string(f, stats->list->files[i].path);
+		fprintf(f, ", \"status\": \"%s\"", fstats->ok ? "ok" : "error");
+		if (fstats->space_id != ULINT_UNDEFINED) {
+			fprintf(f, ", \"space_id\": %lu", fstats->space_id);
+		}
+		fprintf(f, ", \"page_size\": %lu, \"zip_size\": %lu,\n"
+			"     \"pages\": " UINT64PF ", \"index_pages\": "
+			UINT64PF ", \"blob_pages\": " UINT64PF
+			", \"blob_bytes\": " UINT64PF ", \"undo_pages\": "
+			UINT64PF ", \"free_pages\": " UINT64PF
+			", \"other_pages\": " UINT64PF
+			", \"corrupted_pages\": " UINT64PF "}",
+			fstats->page_size, fstats->zip_size, fstats->n_pages,
+			fstats->n_index, fstats->n_blob, fstats->blob_bytes,
+			fstats->n_undo, fstats->n_free, fstats->n_other,
+			fstats->n_corrupted);
+	}
+
+	fprintf(f, "\n  ],\n  \"indexes\": [\n");
+
+	indexes = static_cast<xb_stats_index_t **>
+		(ut_malloc(n_alloc * sizeof(xb_stats_index_t *)));
+
+	for (i = 0; i < hash_get_n_cells(stats->indexes); i++) {
+		xb_stats_index_t*	index;
+
+		for (index = static_cast<xb_stats_index_t *>
+			     (HASH_GET_FIRST(stats->indexes, i));
+		     index != NULL;
+		     index = static_cast<xb_stats_index_t *>
+			     (HASH_GET_NEXT(hash, index))) {
+
+			if (n_indexes == n_alloc) {
+				n_alloc *= 2;
+				indexes = static_cast<xb_stats_index_t **>
+					(ut_realloc(indexes, n_alloc
+						    * sizeof(xb_stats_index_t *)));
+			}
+			indexes[n_indexes++] = index;
+		}
+	}
+
+	qsort(indexes, n_indexes, sizeof(xb_stats_index_t *),
+	      xb_stats_index_cmp);
+
+	for (i = 0; i < n_indexes; i++) {
+		xb_stats_print_index(f, indexes[i], stats);
+		fputs(i + 1 < n_indexes ? ",\n" : "\n", f);
+	}
+
+	fprintf(f, "  ]\n}\n");
+
+	ut_free(indexes);
+}
+
+/************************************************************************
+Free a hash table of xb_stats_index_t objects. */
+static
+void
+xb_stats_free_indexes(
+/*==================*/
+	hash_table_t*	hash)	/*!< in, own: hash table */
+{
+	ulint	i;
+
+	for (i = 0; i < hash_get_n_cells(hash); i++) {
+		xb_stats_index_t*	index;
+
+		index = static_cast<xb_stats_index_t *>
+			(HASH_GET_FIRST(hash, i));
+
+		while (index) {
+			xb_stats_index_t*	next;
+
+			next = static_cast<xb_stats_index_t *>
+				(HASH_GET_NEXT(hash, index));
+			ut_free(index);
+			index = next;
+		}
+	}
+
+	hash_table_free(hash);
+}
+
+/************************************************************************
+Free a hash table of xb_stats_name_t objects. */
+static
+void
+xb_stats_free_names(
+/*================*/
+	hash_table_t*	hash)	/*!< in, own: hash table */
+{
+	ulint	i;
+
+	for (i = 0; i < hash_get_n_cells(hash); i++) {
+		xb_stats_name_t*	name;
+
+		name = static_cast<xb_stats_name_t *>
+			(HASH_GET_FIRST(hash, i));
+
+		while (name) {
+			xb_stats_name_t*	next;
+
+			next = static_cast<xb_stats_name_t *>
+				(HASH_GET_NEXT(hash, name));
+			ut_free(name);
+			name = next;
+		}
+	}
+
+	hash_table_free(hash);
+}
+
+/************************************************************************
+Implementation of --stats --stats-offline. Reads all data files of datadir
+in parallel without starting InnoDB and prints the page statistics of every
+index found in the files as a JSON document. Suitable for backups that have
+not been prepared, as the pages are read as they are on disk. */
+static void
+xtrabackup_stats_offline_func(void)
+{
+	xb_stats_ctxt_t		stats;
+	xb_scan_list_t		list;
+	xb_scan_pool_t		pool;
+	uint			n_threads;
+	ulint			n_failed = 0;
+	ulint			i;
+	ib_time_t		start_time;
+
+	if (my_setwd(mysql_real_data_home,MYF(MY_WME)))
+	{
+		msg("xtrabackup: cannot my_setwd %s\n", mysql_real_data_home);
+		exit(EXIT_FAILURE);
+	}
+	msg("xtrabackup: cd to %s\n", mysql_real_data_home);
+
+	mysql_data_home= mysql_data_home_buff;
+	mysql_data_home[0]=FN_CURLIB;		// all paths are relative from here
+	mysql_data_home[1]=0;
+
+	xb_scan_init();
+
+	xb_filters_init();
+
+	memset(&list, 0, sizeof(list));
+	xb_scan_add_system_files(&list);
+	xb_process_datadir(mysql_data_home, ".ibd",
+			   xb_stats_add_datadir_entry, &list);
+
+	if (list.n_files == 0) {
+		msg("xtrabackup: stats: no data files found in %s.\n",
+		    mysql_real_data_home);
+		exit(EXIT_FAILURE);
+	}
+
+	memset(&stats, 0, sizeof(stats));
+	stats.list = &list;
+	stats.files = static_cast<xb_stats_file_t *>
+		(ut_malloc(list.n_files * sizeof(xb_stats_file_t)));
+	memset(stats.files, 0, list.n_files * sizeof(xb_stats_file_t));
+	for (i = 0; i < list.n_files; i++) {
+		stats.files[i].space_id = ULINT_UNDEFINED;
+	}
+	stats.indexes = hash_create(10000);
+	stats.tables = hash_create(1000);
+	stats.index_names = hash_create(1000);
+	stats.mutex = os_mutex_create();
+
+	start_time = ut_time();
+
+	n_threads = xb_scan_start(&pool, &list, xtrabackup_parallel,
+				  xb_stats_file, &stats);
+
+	msg("xtrabackup: stats: scanning %lu files using %u threads\n",
+	    list.n_files, n_threads);
+
+	xb_scan_wait(&pool);
+
+	msg("xtrabackup: stats: %lu files scanned in %lu seconds\n",
+	    list.n_files, (ulint) ut_difftime(ut_time(), start_time));
+
+	xb_stats_print(stdout, &stats);
+	fflush(stdout);
+
+	for (i = 0; i < list.n_files; i++) {
+		if (!stats.files[i].ok) {
+			n_failed++;
+		}
+	}
+
+	xb_stats_free_indexes(stats.indexes);
+	xb_stats_free_names(stats.tables);
+	xb_stats_free_names(stats.index_names);
+	os_mutex_free(stats.mutex);
+	ut_free(stats.files);
+	ut_free(list.files);
+
+	xb_filters_free();
+
+	if (n_failed > 0) {
+		msg("xtrabackup: stats: %lu files could not be read.\n",
+		    n_failed);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/* ================= main =================== */
+
+int main(int argc, char **argv)
+{
+	int ho_error;
+
+#ifdef __linux__
+	/* Ensure xtrabackup process is killed when the parent one
+	(innobackupex) is terminated with an unhandled signal */
+
+	if (prctl(PR_SET_PDEATHSIG, SIGINT)) {
+		msg("prctl() failed with errno = %d\n", errno);
+		exit(EXIT_FAILURE);
+	}
+#endif
+	MY_INIT(argv[0]);
+	xb_regex_init();
+
+	system_charset_info= &my_charset_utf8_general_ci;
+	key_map_full.set_all();
+
+	/* scan options for group to load defaults from */
+	{
+		int	i;
+		char*	optend;
+		for (i=1; i < argc; i++) {
+			optend = strcend(argv[i], '=');
+			if (strncmp(argv[i], "--defaults-group", optend - argv[i]) == 0) {
+				xb_load_default_groups[2] = defaults_group = optend + 1;
+			}
+		}
+	}
+	load_defaults("my", xb_load_default_groups, &argc, &argv);
+
+	/* ignore unsupported options */
+	{
+	int i,j,argc_new,find;
 	char *optend, *prev_found = NULL;
 	argc_new = argc;
 
@@ -5771,7 +8174,8 @@ next_opt:
 	if ((ho_error=handle_options(&argc, &argv, xb_long_options, get_one_option)))
 		exit(ho_error);
 
-	if ((!xtrabackup_print_param) && (!xtrabackup_prepare) && (strcmp(mysql_data_home, "./") == 0)) {
+	if ((!xtrabackup_print_param) && (!xtrabackup_prepare)
+	    && (!xtrabackup_verify) && (strcmp(mysql_data_home, "./") == 0)) {
 		if (!xtrabackup_print_param)
 			usage();
 		msg("\nxtrabackup: Error: Please set parameter 'datadir'\n");
@@ -5782,6 +8186,12 @@ next_opt:
 	my_load_path(xtrabackup_real_target_dir, xtrabackup_target_dir, NULL);
 	xtrabackup_target_dir= xtrabackup_real_target_dir;
 
+	/* --prepare --stream: the backup arrives on stdin. Receive it before
+	the metadata of an incremental backup is read below. */
+	if (xtrabackup_prepare && xtrabackup_stream && !xtrabackup_backup) {
+		xtrabackup_receive_stream();
+	}
+
 	/* temporary setting of enough size */
 	srv_page_size_shift = UNIV_PAGE_SIZE_SHIFT_MAX;
 	srv_page_size = UNIV_PAGE_SIZE_MAX;
@@ -5930,6 +8340,7 @@ next_opt:
 		if (xtrabackup_backup) num++;
 		if (xtrabackup_stats) num++;
 		if (xtrabackup_prepare) num++;
+		if (xtrabackup_verify) num++;
 		if (num != 1) { /* !XOR (for now) */
 			usage();
 			exit(EXIT_FAILURE);
@@ -5942,18 +8353,46 @@ next_opt:
 	}
 #endif
 
+	xb_arena_set_limit(xtrabackup_buffer_memory_limit);
+	xb_arena_set_large_pages(xtrabackup_buffer_large_pages);
+
+	if (xtrabackup_status_file && (xtrabackup_backup || xtrabackup_prepare)) {
+		char	status_file[FN_REFLEN];
+
+		/* Both --backup and --prepare change the working directory */
+		my_load_path(status_file, xtrabackup_status_file, NULL);
+
+		if (!xb_progress_start(status_file, xtrabackup_status_interval,
+				       xtrabackup_backup ? "backup" : "prepare",
+				       xtrabackup_parallel > 0
+				       ? xtrabackup_parallel : 1)) {
+			exit(EXIT_FAILURE);
+		}
+	}
+
 	/* --backup */
 	if (xtrabackup_backup)
 		xtrabackup_backup_func();
 
 	/* --stats */
-	if (xtrabackup_stats)
-		xtrabackup_stats_func();
+	if (xtrabackup_stats) {
+		if (xtrabackup_stats_offline) {
+			xtrabackup_stats_offline_func();
+		} else {
+			xtrabackup_stats_func();
+		}
+	}
 
 	/* --prepare */
 	if (xtrabackup_prepare)
 		xtrabackup_prepare_func();
 
+	/* --verify */
+	if (xtrabackup_verify)
+		xtrabackup_verify_func();
+
+	xb_progress_stop();
+
 	xb_regex_end();
 
 	exit(EXIT_SUCCESS);
@@ -55,6 +55,9 @@ extern ds_ctxt_t	*ds_data;
 /* The last checkpoint LSN at the backup startup time */
 extern lsn_t checkpoint_lsn_start;
 
+/* The LSN the log copying thread has scanned up to */
+extern lsn_t log_copy_scanned_lsn;
+
 extern xb_page_bitmap *changed_page_bitmap;
 
 extern ulint	xtrabackup_rebuild_threads;
@@ -61,3 +61,75 @@ innobackupex --copy-back $backup_dir
 start_server
 
 verify_db_state sakila
+
+##########################################################################
+# Test --rebuild-threads with a single table having several secondary
+# indexes, which are then built in parallel
+##########################################################################
+
+stop_server
+start_server --innodb_file_per_table
+
+run_cmd $MYSQL $MYSQL_ARGS test <<EOF2
+CREATE TABLE t(a INT PRIMARY KEY, b INT, c INT, d VARCHAR(32),
+  KEY(b), KEY(c), UNIQUE KEY(d), KEY(c, b)) ENGINE=InnoDB;
+EOF2
+
+multi_row_insert test.t \({1..5000},NULL,NULL,NULL\)
+
+# Distinct values in an order different from the primary key, so that every
+# index needs sorting and merging
+run_cmd $MYSQL $MYSQL_ARGS -e "UPDATE t SET b = a * 7919 % 5003, \
+  c = a * 104729 % 997, d = MD5(a)" test
+
+# Scan every secondary index
+index_state_query="SELECT 'b', COUNT(*), SUM(b), MIN(b), MAX(b) \
+  FROM t FORCE INDEX (b) WHERE b >= 0 UNION ALL \
+  SELECT 'c', COUNT(*), SUM(c), MIN(c), MAX(c) \
+  FROM t FORCE INDEX (c) WHERE c >= 0 UNION ALL \
+  SELECT 'd', COUNT(*), COUNT(DISTINCT d), MIN(d), MAX(d) \
+  FROM t FORCE INDEX (d) WHERE d >= '' UNION ALL \
+  SELECT 'cb', COUNT(*), SUM(c * 5003 + b), MIN(c), MAX(b) \
+  FROM t FORCE INDEX (c_2) WHERE c >= 0"
+
+index_state_a=`$MYSQL $MYSQL_ARGS -Ns -e "$index_state_query" test`
+
+# Leave test.t as the only large table so other threads run out of tables
+run_cmd $MYSQL $MYSQL_ARGS -e "DROP DATABASE sakila"
+
+rm -rf $backup_dir
+
+innobackupex --no-timestamp --compact $backup_dir
+vlog "Backup created in directory $backup_dir"
+
+record_db_state test
+
+stop_server
+
+rm -r $mysql_datadir
+
+innobackupex --apply-log --rebuild-indexes --rebuild-threads=4 $backup_dir
+
+grep -q "Building 4 indexes of table test/t in [2-4] threads" $OUTFILE
+
+vlog "Restoring MySQL datadir"
+mkdir -p $mysql_datadir
+innobackupex --copy-back $backup_dir
+
+start_server
+
+verify_db_state test
+
+run_cmd $MYSQL $MYSQL_ARGS -e "CHECK TABLE t" test | grep -q "status.*OK" || \
+    die "CHECK TABLE test.t failed"
+
+index_state_b=`$MYSQL $MYSQL_ARGS -Ns -e "$index_state_query" test`
+
+vlog "Index state before the backup: $index_state_a"
+vlog "Index state after the restore: $index_state_b"
+
+if [ "$index_state_a" != "$index_state_b" ]
+then
+    vlog "The rebuilt secondary indexes of test.t do not match"
+    exit 1
+fi
@@ -0,0 +1,71 @@
+########################################################################
+# Test that innobackupex --dump-innodb-buffer-pool backs up a fresh dump
+# of the buffer pool, and that a server restored from the backup loads it
+########################################################################
+
+. inc/common.sh
+
+require_server_version_higher_than 5.6.0
+
+start_server --innodb_file_per_table
+
+run_cmd $MYSQL $MYSQL_ARGS test <<EOF
+CREATE TABLE t1(a INT PRIMARY KEY, b INT) ENGINE=InnoDB;
+EOF
+
+multi_row_insert test.t1 \({1..1000},1\)
+
+checksum_a=`checksum_table test t1`
+
+space_id=`$MYSQL $MYSQL_ARGS -Ns -e "SELECT space \
+FROM INFORMATION_SCHEMA.INNODB_SYS_TABLES WHERE name = 'test/t1'"`
+
+rm -f $mysql_datadir/ib_buffer_pool
+
+backup_dir=$topdir/backup
+
+innobackupex --no-timestamp --dump-innodb-buffer-pool $backup_dir
+
+if ! grep -q "^$space_id," $backup_dir/ib_buffer_pool
+then
+    vlog "The buffer pool dump has no pages of test.t1"
+    exit 1
+fi
+
+innobackupex --apply-log $backup_dir
+
+stop_server
+
+rm -rf $mysql_datadir/*
+
+innobackupex --copy-back $backup_dir
+
+start_server --innodb_file_per_table --innodb_buffer_pool_load_at_startup=ON
+
+for i in {1..30}
+do
+    status=`$MYSQL $MYSQL_ARGS -Ns -e \
+        "SHOW STATUS LIKE 'innodb_buffer_pool_load_status'" | cut -f 2`
+    vlog "Load status: $status"
+    if [[ "$status" == "Buffer pool(s) load completed"* ]]
+    then
+        break
+    fi
+    sleep 1
+done
+
+if [[ "$status" != "Buffer pool(s) load completed"* ]]
+then
+    vlog "The buffer pool has not been loaded"
+    exit 1
+fi
+
+checksum_b=`checksum_table test t1`
+
+vlog "Checksums: $checksum_a $checksum_b"
+
+if [ "$checksum_a" != "$checksum_b" ]
+then
+    vlog "Checksums do not match"
+    exit 1
+fi
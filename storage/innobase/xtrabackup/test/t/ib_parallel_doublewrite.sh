@@ -0,0 +1,56 @@
+########################################################################
+# Test that --apply-log doublewrites its batch flushes to the parallel
+# doublewrite files and that --copy-back does not restore them
+########################################################################
+
+. inc/common.sh
+
+start_server --innodb_file_per_table
+
+run_cmd $MYSQL $MYSQL_ARGS test <<EOF
+CREATE TABLE t1(a INT PRIMARY KEY, b INT) ENGINE=InnoDB;
+EOF
+
+multi_row_insert test.t1 \({1..1000},1\)
+
+checksum_a=`checksum_table test t1`
+
+backup_dir=$topdir/backup
+
+innobackupex --no-timestamp $backup_dir
+
+echo "innodb_parallel_doublewrite_path=xb_doublewrite" >> \
+    $backup_dir/backup-my.cnf
+
+innobackupex --apply-log $backup_dir
+
+if ! ls $backup_dir/xb_doublewrite_0 >/dev/null 2>&1
+then
+    vlog "The parallel doublewrite files have not been created"
+    exit 1
+fi
+
+stop_server
+
+rm -rf $mysql_datadir/*
+
+innobackupex --copy-back $backup_dir
+
+if ls $mysql_datadir/xb_doublewrite_* \
+    $mysql_datadir/ib_parallel_doublewrite >/dev/null 2>&1
+then
+    vlog "The parallel doublewrite files have been copied back"
+    exit 1
+fi
+
+start_server --innodb_file_per_table
+
+checksum_b=`checksum_table test t1`
+
+vlog "Checksums: $checksum_a $checksum_b"
+
+if [ "$checksum_a" != "$checksum_b" ]
+then
+    vlog "Checksums do not match"
+    exit 1
+fi
@@ -0,0 +1,118 @@
+########################################################################
+# Test that crash recovery restores torn pages from the parallel
+# doublewrite files:
+#  1 - from the newest copy when the files have several copies of a page
+#  2 - after innodb_parallel_doublewrite_path has been cleared
+########################################################################
+
+. inc/common.sh
+
+require_server_version_higher_than 5.6.0
+
+mysqld_args="--innodb_file_per_table --innodb_buffer_pool_instances=1"
+
+########################################################################
+# Flush all dirty pages and wait until the checkpoint has caught up with
+# the log, so that recovery does not redo the changes made so far
+########################################################################
+function wait_for_checkpoint()
+{
+    local status
+    local lsn
+    local checkpoint
+    local dirty
+
+    run_cmd $MYSQL $MYSQL_ARGS -e \
+        "SET GLOBAL innodb_max_dirty_pages_pct = 0"
+
+    for i in {1..120}
+    do
+        status=`$MYSQL $MYSQL_ARGS -Ns -e "SHOW ENGINE INNODB STATUS\G"`
+        lsn=`echo "$status" | sed -n 's/^Log sequence number *//p'`
+        checkpoint=`echo "$status" | sed -n 's/^Last checkpoint at *//p'`
+        dirty=`$MYSQL $MYSQL_ARGS -Ns -e \
+            "SHOW STATUS LIKE 'Innodb_buffer_pool_pages_dirty'" | cut -f 2`
+        vlog "LSN: $lsn, checkpoint: $checkpoint, dirty pages: $dirty"
+        if [ "$lsn" = "$checkpoint" -a "$dirty" = "0" ]
+        then
+            run_cmd $MYSQL $MYSQL_ARGS -e \
+                "SET GLOBAL innodb_max_dirty_pages_pct = 75"
+            return
+        fi
+        sleep 1
+    done
+
+    vlog "The checkpoint has not caught up with the log"
+    exit 1
+}
+
+start_server $mysqld_args --innodb_parallel_doublewrite_path=xb_doublewrite
+
+run_cmd $MYSQL $MYSQL_ARGS test <<EOF
+CREATE TABLE t1(a INT PRIMARY KEY, b INT) ENGINE=InnoDB;
+CREATE TABLE t2(a INT PRIMARY KEY) ENGINE=InnoDB;
+EOF
+
+# All the rows fit in the root page of t1, page 3
+multi_row_insert test.t1 \({1..100},1\)
+
+wait_for_checkpoint
+
+# Keep the doublewrite copy of the first version of the page
+cp $mysql_datadir/xb_doublewrite_0 $topdir/xb_doublewrite_old
+
+run_cmd $MYSQL $MYSQL_ARGS -e "UPDATE t1 SET b = 2" test
+
+wait_for_checkpoint
+
+checksum_a=`checksum_table test t1`
+
+# Leave the log ahead of the checkpoint, so that the server has to be
+# recovered
+run_cmd $MYSQL $MYSQL_ARGS -e "INSERT INTO t2 VALUES (1)" test
+
+stop_server
+
+vlog "Tearing page 3 of t1.ibd"
+
+dd if=/dev/urandom of=$mysql_datadir/test/t1.ibd bs=4096 seek=13 count=1 \
+    conv=notrunc
+
+# Make the copy of the first version the one found first, so that only
+# comparing the LSNs of the copies restores the latest version
+mv $mysql_datadir/xb_doublewrite_0 $mysql_datadir/xb_doublewrite_1
+cp $topdir/xb_doublewrite_old $mysql_datadir/xb_doublewrite_0
+echo "2 xb_doublewrite" > $mysql_datadir/ib_parallel_doublewrite
+
+# The files have to be found without innodb_parallel_doublewrite_path
+start_server $mysqld_args
+
+if ! grep -q "Recovered the page from the doublewrite buffer" \
+    $MYSQLD_ERRFILE
+then
+    vlog "The torn page has not been restored"
+    exit 1
+fi
+
+checksum_b=`checksum_table test t1`
+
+vlog "Checksums: $checksum_a $checksum_b"
+
+if [ "$checksum_a" != "$checksum_b" ]
+then
+    vlog "Checksums do not match"
+    exit 1
+fi
+
+if ! $MYSQL $MYSQL_ARGS -Ns -e "CHECK TABLE t1" test | grep -q "status.OK"
+then
+    vlog "CHECK TABLE t1 has failed"
+    exit 1
+fi
+
+if ls $mysql_datadir/xb_doublewrite_* \
+    $mysql_datadir/ib_parallel_doublewrite >/dev/null 2>&1
+then
+    vlog "The parallel doublewrite files have not been removed"
+    exit 1
+fi
@@ -0,0 +1,102 @@
+############################################################################
+# Test that xbstream chunks written to the same output by several processes
+# are not interleaved, as with innobackupex --stream=xbstream, where
+# xtrabackup streams xtrabackup_logfile while innobackupex streams non-InnoDB
+# files:
+#  1 - concurrent 'xbstream -c' processes produce a valid stream
+#  2 - a streamed backup taken under write load can be extracted and prepared
+#  3 - xtrabackup_logfile is streamed while the data files are copied rather
+#      than after them
+############################################################################
+
+. inc/common.sh
+
+src_dir=$topdir/xbstream_src
+dst_dir=$topdir/xbstream_dst
+
+mkdir -p $src_dir $dst_dir
+
+for i in 1 2 3 4
+do
+    dd if=/dev/urandom of=$src_dir/file_$i bs=1M count=8 2>/dev/null
+done
+
+vlog "Streaming 4 files concurrently to the same pipe"
+( cd $src_dir
+  for i in 1 2 3 4
+  do
+      xbstream -c file_$i &
+  done
+  wait ) | cat > $topdir/concurrent.xbs
+
+run_cmd bash -c "xbstream -x -C $dst_dir < $topdir/concurrent.xbs"
+
+for i in 1 2 3 4
+do
+    run_cmd cmp $src_dir/file_$i $dst_dir/file_$i
+done
+
+rm -rf $src_dir $dst_dir $topdir/concurrent.xbs
+
+start_server --innodb_file_per_table
+
+load_dbase_schema sakila
+load_dbase_data sakila
+
+# Generate redo while the backup is taken
+( for i in `seq 1 20`
+  do
+      $MYSQL $MYSQL_ARGS -Ns -e \
+          "CREATE TABLE tmp$i ENGINE=InnoDB SELECT * FROM payment" sakila
+  done ) &
+load_pid=$!
+
+mkdir -p $topdir/backup
+innobackupex --stream=xbstream $topdir/backup > $topdir/backup/out
+
+run_cmd wait $load_pid
+
+checksum_a=`checksum_table sakila payment`
+
+stop_server
+
+cd $topdir/backup
+run_cmd bash -c "xbstream -xv < out 2> $topdir/xbstream.log"
+rm -f out
+cd - >/dev/null
+
+cat $topdir/xbstream.log >&2
+
+# 'xbstream -xv' prints a file name when the first chunk of the file is
+# found in the stream. xtrabackup_logfile must appear before the last data
+# file, i.e. its chunks must be interleaved with the data file chunks.
+logfile_line=`grep -n 'xtrabackup_logfile$' $topdir/xbstream.log | \
+    head -1 | cut -d: -f1`
+last_ibd_line=`grep -n '\.ibd$' $topdir/xbstream.log | tail -1 | cut -d: -f1`
+
+vlog "xtrabackup_logfile at line $logfile_line, last .ibd at line $last_ibd_line"
+
+if [ -z "$logfile_line" -o -z "$last_ibd_line" ] || \
+    [ "$logfile_line" -gt "$last_ibd_line" ]
+then
+    vlog "xtrabackup_logfile is not interleaved with the data files"
+    exit 1
+fi
+
+innobackupex --apply-log $topdir/backup
+
+rm -rf $mysql_datadir
+mkdir -p $mysql_datadir
+innobackupex --copy-back $topdir/backup
+
+start_server
+
+checksum_b=`checksum_table sakila payment`
+
+vlog "Checksums: $checksum_a $checksum_b"
+
+if [ "$checksum_a" != "$checksum_b" ]
+then
+    vlog "Checksums do not match"
+    exit 1
+fi
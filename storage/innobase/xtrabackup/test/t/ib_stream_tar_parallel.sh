@@ -0,0 +1,67 @@
+############################################################################
+# Test parallel streaming in the TAR format
+#
+# A small --stream-spool-size makes the data files outgrow their memory
+# spools, so that both the files spilled to temporary files and the files
+# written directly to the stream are exercised.
+############################################################################
+
+. inc/common.sh
+
+start_server --innodb_file_per_table
+
+load_dbase_schema sakila
+load_dbase_data sakila
+
+tables="actor address category city country customer film film_actor \
+film_category film_text inventory language payment rental staff store"
+
+for t in $tables
+do
+    eval "checksum_$t=`checksum_table sakila $t`"
+done
+
+cat >> $MYSQLD_VARDIR/my.cnf <<EOF
+
+[xtrabackup]
+stream-spool-size=64K
+EOF
+
+# Take backup
+mkdir -p $topdir/backup
+innobackupex --stream=tar --parallel=16 $topdir/backup \
+    > $topdir/backup/out 2> $topdir/backup.log
+
+cat $topdir/backup.log >&2
+
+run_cmd grep -q "files were spilled to temporary files" $topdir/backup.log
+run_cmd grep -q "files were written directly to the stream" $topdir/backup.log
+
+stop_server
+
+rm -r $mysql_datadir
+
+backup_dir=$topdir/backup
+cd $backup_dir
+run_cmd $TAR -ixvf out
+cd - >/dev/null 2>&1
+
+innobackupex --apply-log $backup_dir
+mkdir -p $mysql_datadir
+innobackupex --copy-back $backup_dir
+
+start_server
+
+for t in $tables
+do
+    checksum_a=`eval echo \\$checksum_$t`
+    checksum_b=`checksum_table sakila $t`
+
+    vlog "Table sakila.$t: old checksum $checksum_a, new checksum $checksum_b"
+
+    if [ "$checksum_a" != "$checksum_b" ]
+    then
+        vlog "Checksums of sakila.$t do not match"
+        exit 1
+    fi
+done
@@ -0,0 +1,70 @@
+############################################################################
+# Test xtrabackup --prepare --export with --tables:
+#  1 - only the matching tablespaces are recovered and exported
+#  2 - tablespaces excluded from recovery are left in the backup, which
+#      can then be neither prepared in full nor copied back
+#  3 - the exported table can be imported
+############################################################################
+
+. inc/common.sh
+
+if ! is_server_version_higher_than 5.6.0
+then
+    skip_test "Requires MySQL 5.6+"
+fi
+
+mysql_extra_args="--innodb_file_per_table"
+
+start_server $mysql_extra_args
+
+run_cmd $MYSQL $MYSQL_ARGS test <<EOF
+CREATE TABLE t1(a INT PRIMARY KEY, b INT) ENGINE=InnoDB;
+CREATE TABLE t2(a INT PRIMARY KEY, b INT) ENGINE=InnoDB;
+EOF
+
+multi_row_insert test.t1 \({1..1000},1\)
+multi_row_insert test.t2 \({1..1000},2\)
+
+checksum_a=`checksum_table test t1`
+
+backup_dir=$topdir/backup
+
+xtrabackup --datadir=$mysql_datadir --backup --target-dir=$backup_dir
+
+xtrabackup --datadir=$mysql_datadir --prepare --export \
+    --tables='^test[.]t1$' --target-dir=$backup_dir
+
+run_cmd test -f $backup_dir/test/t1.cfg
+run_cmd test -f $backup_dir/test/t1.exp
+run_cmd test -f $backup_dir/test/t2.ibd
+run_cmd_expect_failure test -f $backup_dir/test/t2.cfg
+
+run_cmd grep -q "^backup_type = export-prepared" \
+    $backup_dir/xtrabackup_checkpoints
+
+vlog "Checking that the backup cannot be prepared in full or restored"
+
+run_cmd_expect_failure $XB_BIN $XB_ARGS --datadir=$mysql_datadir --prepare \
+    --target-dir=$backup_dir
+run_cmd_expect_failure $IB_BIN $IB_ARGS --copy-back $backup_dir
+
+vlog "Importing test.t1"
+
+run_cmd $MYSQL $MYSQL_ARGS -e "DROP TABLE t1" test
+run_cmd $MYSQL $MYSQL_ARGS -e \
+    "CREATE TABLE t1(a INT PRIMARY KEY, b INT) ENGINE=InnoDB" test
+run_cmd $MYSQL $MYSQL_ARGS -e "ALTER TABLE t1 DISCARD TABLESPACE" test
+
+run_cmd cp $backup_dir/test/t1.ibd $backup_dir/test/t1.cfg \
+    $mysql_datadir/test/
+run_cmd $MYSQL $MYSQL_ARGS -e "ALTER TABLE t1 IMPORT TABLESPACE" test
+
+checksum_b=`checksum_table test t1`
+
+vlog "Checksums: $checksum_a $checksum_b"
+
+if [ "$checksum_a" != "$checksum_b" ]
+then
+    vlog "Checksums do not match"
+    exit 1
+fi
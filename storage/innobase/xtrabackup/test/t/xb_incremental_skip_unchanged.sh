@@ -0,0 +1,77 @@
+############################################################################
+# Test that a full-scan incremental backup does not read the data files that
+# have not been written to since the base backup, as recorded in the
+# xtrabackup_lsn_summary file of the base backup.
+############################################################################
+
+. inc/common.sh
+
+start_server --innodb_file_per_table
+
+run_cmd $MYSQL $MYSQL_ARGS test <<EOF
+CREATE TABLE t1(a INT PRIMARY KEY, b INT) ENGINE=InnoDB;
+CREATE TABLE t2(a INT PRIMARY KEY, b INT) ENGINE=InnoDB;
+EOF
+
+multi_row_insert test.t1 \({1..1000},1\)
+multi_row_insert test.t2 \({1..1000},2\)
+
+# Restart the server so that all pages are flushed, and let the clock move on
+# so that the modification time of t2.ibd is well before the base backup
+stop_server
+start_server --innodb_file_per_table
+sleep 2
+
+xtrabackup --datadir=$mysql_datadir --backup --target-dir=$topdir/full
+
+run_cmd test -f $topdir/full/xtrabackup_lsn_summary
+
+multi_row_insert test.t1 \({1001..2000},1\)
+
+checksum_t1_a=`checksum_table test t1`
+checksum_t2_a=`checksum_table test t2`
+
+xtrabackup --datadir=$mysql_datadir --backup --target-dir=$topdir/inc \
+    --incremental-basedir=$topdir/full 2>$topdir/inc.log
+
+if ! grep -q "t2.ibd has not changed since the base backup" $topdir/inc.log
+then
+    vlog "t2.ibd was read by the incremental backup"
+    exit 1
+fi
+
+if grep -q "t1.ibd has not changed since the base backup" $topdir/inc.log
+then
+    vlog "t1.ibd was skipped by the incremental backup"
+    exit 1
+fi
+
+# The skipped file must be carried over to the summary of the new backup
+run_cmd grep -q "test/t2.ibd" $topdir/inc/xtrabackup_lsn_summary
+
+xtrabackup --datadir=$mysql_datadir --prepare --apply-log-only \
+    --target-dir=$topdir/full
+xtrabackup --datadir=$mysql_datadir --prepare --apply-log-only \
+    --target-dir=$topdir/full --incremental-dir=$topdir/inc
+xtrabackup --datadir=$mysql_datadir --prepare --target-dir=$topdir/full
+
+stop_server
+
+run_cmd cp $topdir/full/ibdata1 $mysql_datadir/
+run_cmd cp $topdir/full/test/t1.ibd $topdir/full/test/t2.ibd \
+    $mysql_datadir/test/
+rm -f $mysql_datadir/ib_logfile*
+
+start_server --innodb_file_per_table
+
+checksum_t1_b=`checksum_table test t1`
+checksum_t2_b=`checksum_table test t2`
+
+vlog "Checksums: t1 $checksum_t1_a $checksum_t1_b, t2 $checksum_t2_a $checksum_t2_b"
+
+if [ "$checksum_t1_a" != "$checksum_t1_b" -o \
+     "$checksum_t2_a" != "$checksum_t2_b" ]
+then
+    vlog "Checksums do not match"
+    exit 1
+fi
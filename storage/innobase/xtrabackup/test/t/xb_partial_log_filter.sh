@@ -0,0 +1,77 @@
+############################################################################
+# Test xtrabackup --log-filter with --tables:
+#  1 - the log records of the excluded table are replaced with dummy records
+#  2 - the partial backup is prepared and the backed up table is correct
+############################################################################
+
+. inc/common.sh
+
+if ! is_server_version_higher_than 5.6.0
+then
+    skip_test "Requires MySQL 5.6+"
+fi
+
+start_server --innodb_file_per_table
+
+run_cmd $MYSQL $MYSQL_ARGS test <<EOF
+CREATE TABLE t1(a INT PRIMARY KEY, b INT) ENGINE=InnoDB;
+CREATE TABLE t2(a INT PRIMARY KEY, b INT) ENGINE=InnoDB;
+EOF
+
+multi_row_insert test.t1 \({1..1000},1\)
+multi_row_insert test.t2 \({1..1000},2\)
+
+backup_dir=$topdir/backup
+mkdir -p $backup_dir
+
+xtrabackup --datadir=$mysql_datadir --backup --target-dir=$backup_dir \
+    --tables='^test[.]t1$' --log-filter --suspend-at-end \
+    2>$topdir/backup.log &
+
+job_pid=$!
+
+wait_for_xb_to_suspend $backup_dir/xtrabackup_suspended_2
+
+# Generate log records for both tables while the log is being copied
+multi_row_insert test.t1 \({1001..2000},1\)
+multi_row_insert test.t2 \({1001..5000},2\)
+
+checksum_a=`checksum_table test t1`
+
+# Let the log copying thread catch up
+sleep 2
+
+resume_suspended_xb $backup_dir/xtrabackup_suspended_2
+
+run_cmd wait $job_pid
+
+if ! egrep -q "Redo log filter: [1-9][0-9]* of [0-9]+ log records" \
+    $topdir/backup.log
+then
+    vlog "No log records have been filtered out"
+    exit 1
+fi
+
+xtrabackup --datadir=$mysql_datadir --prepare --export \
+    --tables='^test[.]t1$' --target-dir=$backup_dir
+
+vlog "Importing test.t1"
+
+run_cmd $MYSQL $MYSQL_ARGS -e "DROP TABLE t1" test
+run_cmd $MYSQL $MYSQL_ARGS -e \
+    "CREATE TABLE t1(a INT PRIMARY KEY, b INT) ENGINE=InnoDB" test
+run_cmd $MYSQL $MYSQL_ARGS -e "ALTER TABLE t1 DISCARD TABLESPACE" test
+
+run_cmd cp $backup_dir/test/t1.ibd $backup_dir/test/t1.cfg \
+    $mysql_datadir/test/
+run_cmd $MYSQL $MYSQL_ARGS -e "ALTER TABLE t1 IMPORT TABLESPACE" test
+
+checksum_b=`checksum_table test t1`
+
+vlog "Checksums: $checksum_a $checksum_b"
+
+if [ "$checksum_a" != "$checksum_b" ]
+then
+    vlog "Checksums do not match"
+    exit 1
+fi
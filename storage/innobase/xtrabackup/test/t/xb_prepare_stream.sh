@@ -0,0 +1,55 @@
+############################################################################
+# Test xtrabackup --prepare --stream=xbstream. The backup is prepared while
+# the server is still running to use its InnoDB configuration.
+#  1 - a compressed xbstream backup is received from stdin, decompressed on the
+#      fly and prepared in one step
+#  2 - a truncated stream is rejected
+############################################################################
+
+. inc/common.sh
+
+start_server --innodb_file_per_table
+
+load_dbase_schema sakila
+load_dbase_data sakila
+
+checksum_a=`checksum_table sakila payment`
+
+mkdir -p $topdir/backup
+innobackupex --stream=xbstream --compress --compress-threads=4 \
+    $topdir/backup > $topdir/stream.xbs
+
+vlog "Preparing a truncated stream"
+size=`stat -c %s $topdir/stream.xbs`
+head -c $((size / 2)) $topdir/stream.xbs > $topdir/truncated.xbs
+run_cmd_expect_failure $XB_BIN $XB_ARGS --prepare --stream=xbstream \
+    --target-dir=$topdir/truncated < $topdir/truncated.xbs
+rm -rf $topdir/truncated $topdir/truncated.xbs
+
+vlog "Preparing the backup from the stream"
+xtrabackup --prepare --stream=xbstream --target-dir=$topdir/full \
+    < $topdir/stream.xbs
+
+if ls $topdir/full/*.qp $topdir/full/*/*.qp >/dev/null 2>&1
+then
+    vlog "Compressed files left in the target directory"
+    exit 1
+fi
+
+stop_server
+
+rm -rf $mysql_datadir
+mkdir -p $mysql_datadir
+innobackupex --copy-back $topdir/full
+
+start_server
+
+checksum_b=`checksum_table sakila payment`
+
+vlog "Checksums: $checksum_a $checksum_b"
+
+if [ "$checksum_a" != "$checksum_b" ]
+then
+    vlog "Checksums do not match"
+    exit 1
+fi
@@ -0,0 +1,53 @@
+############################################################################
+# Test xtrabackup --stats --stats-offline:
+#  1 - statistics can be gathered from a backup that has not been prepared
+#  2 - table and index names are resolved from the data dictionary
+#  3 - --tables limits the set of scanned tablespaces
+#  4 - record counts match the table contents on a cleanly shut down server
+############################################################################
+
+. inc/common.sh
+
+start_server --innodb_file_per_table
+
+run_cmd $MYSQL $MYSQL_ARGS test <<EOF
+CREATE TABLE t1(a INT PRIMARY KEY, b INT, KEY k(b)) ENGINE=InnoDB;
+CREATE TABLE t2(a INT) ENGINE=InnoDB;
+EOF
+
+multi_row_insert test.t1 \({1..1000},1\)
+multi_row_insert test.t2 \({1..10}\)
+
+xtrabackup --datadir=$mysql_datadir --backup --target-dir=$topdir/backup
+
+stats_file=$topdir/stats.json
+
+vlog "Gathering statistics from the backup"
+xtrabackup --stats --stats-offline --datadir=$topdir/backup --parallel=4 \
+    > $stats_file
+cat $stats_file >&2
+
+run_cmd grep -q '"table": "test/t1", "index": "PRIMARY"' $stats_file
+run_cmd grep -q '"table": "test/t1", "index": "k"' $stats_file
+run_cmd grep -q '"table": "test/t2", "index": "GEN_CLUST_INDEX"' $stats_file
+
+vlog "Gathering statistics for test.t2 only"
+xtrabackup --stats --stats-offline --datadir=$topdir/backup \
+    --tables='^test[.]t2$' > $stats_file
+
+run_cmd grep -q 't2.ibd' $stats_file
+run_cmd_expect_failure grep -q 't1.ibd' $stats_file
+
+shutdown_server
+
+vlog "Gathering statistics from the server datadir"
+xtrabackup --stats --stats-offline --datadir=$mysql_datadir > $stats_file
+
+records=`grep -A1 '"table": "test/t1", "index": "PRIMARY"' $stats_file | \
+    sed -n 's/.*"records": \([0-9]*\).*/\1/p'`
+
+if [ "$records" != "1000" ]
+then
+    vlog "Expected 1000 records in test/t1, found '$records'"
+    exit 1
+fi
@@ -0,0 +1,78 @@
+############################################################################
+# Test the --status-file option:
+#  1 - the status file is written for --backup and reports all data copied
+#  2 - the status file is written for --prepare and reports recovery progress
+#  3 - a failure is recorded in the status file
+############################################################################
+
+. inc/common.sh
+
+require_qpress
+
+start_server --innodb_file_per_table
+
+load_sakila
+
+status_file=${topdir}/xtrabackup_status.json
+
+xtrabackup --datadir=$mysql_datadir --backup --target-dir=$topdir/backup \
+    --parallel=2 --compress --compress-threads=2 \
+    --status-file=$status_file --status-interval=100
+
+vlog "Backup status:"
+cat $status_file >&2
+
+run_cmd grep -q '"mode": "backup"' $status_file
+run_cmd grep -q '"phase": "completed"' $status_file
+run_cmd grep -q '"name": "compress"' $status_file
+
+# All data files have been copied
+files_total=`sed -n 's/.*"files_total": \([0-9]*\).*/\1/p' $status_file`
+files_done=`sed -n 's/.*"files_done": \([0-9]*\).*/\1/p' $status_file`
+
+if [ -z "$files_total" -o "$files_total" = "0" -o \
+    "$files_total" != "$files_done" ]
+then
+    vlog "files_done = '$files_done', files_total = '$files_total'"
+    exit 1
+fi
+
+# Temporary file must not be left behind
+if [ -f ${status_file}.tmp ]
+then
+    vlog "${status_file}.tmp exists"
+    exit 1
+fi
+
+rm -f $status_file
+
+cd $topdir/backup
+for i in `find . -name '*.qp'`
+do
+    qpress -d $i `dirname $i` && rm -f $i
+done
+cd - >/dev/null
+
+xtrabackup --prepare --target-dir=$topdir/backup \
+    --status-file=$status_file --status-interval=100
+
+vlog "Prepare status:"
+cat $status_file >&2
+
+run_cmd grep -q '"mode": "prepare"' $status_file
+run_cmd grep -q '"phase": "completed"' $status_file
+run_cmd grep -q '"recovery"' $status_file
+
+rm -f $status_file
+
+# --prepare fails on a directory that does not contain a backup
+mkdir -p $topdir/empty
+
+run_cmd_expect_failure $XB_BIN $XB_ARGS --prepare --target-dir=$topdir/empty \
+    --status-file=$status_file --status-interval=100
+
+vlog "Failed prepare status:"
+cat $status_file >&2
+
+run_cmd grep -q '"phase": "failed"' $status_file
+run_cmd grep -q '"failed_phase"' $status_file
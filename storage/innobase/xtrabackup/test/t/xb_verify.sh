@@ -0,0 +1,67 @@
+############################################################################
+# Test xtrabackup --verify:
+#  1 - full and incremental backups pass verification
+#  2 - a corrupted page in a data file is detected
+#  3 - a corrupted page in a .delta file is detected
+#  4 - a truncated xtrabackup_logfile is detected
+############################################################################
+
+. inc/common.sh
+
+start_server --innodb_file_per_table
+
+load_dbase_schema incremental_sample
+
+multi_row_insert incremental_sample.test \({1..1000},1000\)
+
+full_dir=$topdir/full
+inc_dir=$topdir/inc
+
+xtrabackup --datadir=$mysql_datadir --backup --target-dir=$full_dir
+
+multi_row_insert incremental_sample.test \({1001..2000},2000\)
+
+xtrabackup --datadir=$mysql_datadir --backup --target-dir=$inc_dir \
+    --incremental-basedir=$full_dir
+
+stop_server
+
+vlog "Verifying the full backup"
+xtrabackup --verify --target-dir=$full_dir --parallel=4
+
+vlog "Verifying the incremental backup"
+xtrabackup --verify --target-dir=$inc_dir --parallel=4
+
+# Overwrite a part of page 3 of the table with garbage
+function corrupt_page()
+{
+    dd if=/dev/urandom of=$1 bs=1024 seek=$((16 * 3 + 8)) count=1 \
+        conv=notrunc 2>/dev/null
+}
+
+vlog "Corrupting a data file"
+cp -a $full_dir $topdir/full_copy
+corrupt_page $topdir/full_copy/incremental_sample/test.ibd
+run_cmd_expect_failure $XB_BIN $XB_ARGS --verify \
+    --target-dir=$topdir/full_copy
+rm -rf $topdir/full_copy
+
+vlog "Corrupting a delta file"
+cp -a $inc_dir $topdir/inc_copy
+dd if=/dev/urandom of=$topdir/inc_copy/incremental_sample/test.ibd.delta \
+    bs=1024 seek=$((16 + 8)) count=1 conv=notrunc 2>/dev/null
+run_cmd_expect_failure $XB_BIN $XB_ARGS --verify \
+    --target-dir=$topdir/inc_copy
+rm -rf $topdir/inc_copy
+
+vlog "Truncating xtrabackup_logfile"
+cp -a $full_dir $topdir/full_copy
+truncate -s 2048 $topdir/full_copy/xtrabackup_logfile
+run_cmd_expect_failure $XB_BIN $XB_ARGS --verify \
+    --target-dir=$topdir/full_copy
+rm -rf $topdir/full_copy
+
+# The backup can still be prepared after verification
+xtrabackup --prepare --apply-log-only --target-dir=$full_dir
+xtrabackup --prepare --apply-log-only --target-dir=$full_dir \
+    --incremental-dir=$inc_dir
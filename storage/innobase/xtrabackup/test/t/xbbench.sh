@@ -0,0 +1,54 @@
+############################################################################
+# Test the xbbench datasink pipeline benchmark:
+#  1 - every stage of the pipeline is reported
+#  2 - data written through the 'local' sink has the expected size in all
+#      --local-write-mode modes
+#  3 - datasink buffers are recycled and the memory limit is honored
+#  4 - invalid pipelines are rejected
+############################################################################
+
+bench_log=${topdir}/xbbench.log
+
+run_cmd xbbench --pipeline=compress,buffer,encrypt,xbstream,null \
+    --files=4 --file-size=4M --parallel=2 --compress-threads=2 \
+    --encrypt-threads=2 2> $bench_log
+
+for stage in compress buffer encrypt xbstream null
+do
+    run_cmd grep -q "^$stage " $bench_log
+done
+
+run_cmd xbbench --pipeline=archive,memory --files=2 --file-size=1M \
+    --input=inc/decrypt_v1_test_file.txt 2> $bench_log
+run_cmd grep -q "^archive " $bench_log
+
+for mode in fsync write-behind direct
+do
+    mkdir -p ${topdir}/xbbench_local
+    run_cmd xbbench --pipeline=local --files=2 --file-size=1M \
+        --write-size=100000 --local-write-mode=$mode \
+        --local-write-threads=2 --target-dir=${topdir}/xbbench_local \
+        2> $bench_log
+
+    for i in 0 1
+    do
+        size=`stat -c %s ${topdir}/xbbench_local/xbbench/file_$i.ibd`
+        if [ "$size" != "1048576" ]
+        then
+            vlog "$mode: file_$i.ibd has size $size, expected 1048576"
+            exit 1
+        fi
+    done
+
+    rm -rf ${topdir}/xbbench_local
+done
+
+run_cmd xbbench --pipeline=compress,buffer,xbstream,null --files=8 \
+    --file-size=1M --parallel=2 --compress-threads=2 \
+    --buffer-memory-limit=1M 2> $bench_log
+run_cmd grep -q "buffer memory .* allocations reused" $bench_log
+
+run_cmd_expect_failure xbbench --pipeline=null,compress
+run_cmd_expect_failure xbbench --pipeline=compress
+run_cmd_expect_failure xbbench --pipeline=archive,null --parallel=2
+run_cmd_expect_failure xbbench --pipeline=local
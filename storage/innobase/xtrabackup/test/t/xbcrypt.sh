@@ -5,6 +5,8 @@
 #  2 - Test that files encrypted with prior versions of xbcrypt can be 
 #      correctly decrypted. Introduced when fixing bug 1185343 - Fixed IV 
 #      used in Xtrabackup encryption
+#  3 - Test parallel encryption and decryption with --encrypt-threads
+#  4 - Test decryption of a directory tree in place with --parallel
 ############################################################################
 
 encrypt_algo="AES256"
@@ -22,3 +24,35 @@ rm ${topdir}/decrypt_v1_test_file.txt
 run_cmd xbcrypt -d -i inc/decrypt_v1_test_file.xbcrypt -o ${topdir}/decrypt_v1_test_file.txt -a ${encrypt_algo} -k ${encrypt_key}
 run_cmd cmp inc/decrypt_v1_test_file.txt ${topdir}/decrypt_v1_test_file.txt
 rm ${topdir}/decrypt_v1_test_file.txt
+
+
+# test that parallel encryption/decryption preserves the chunk order
+run_cmd xbcrypt -i inc/decrypt_v1_test_file.txt -o ${topdir}/decrypt_v1_test_file.xbcrypt -a ${encrypt_algo} -k ${encrypt_key} --encrypt-threads=4 --encrypt-chunk-size=1024
+run_cmd xbcrypt -d -i ${topdir}/decrypt_v1_test_file.xbcrypt -o ${topdir}/decrypt_v1_test_file.txt -a ${encrypt_algo} -k ${encrypt_key} --encrypt-threads=3
+run_cmd cmp inc/decrypt_v1_test_file.txt ${topdir}/decrypt_v1_test_file.txt
+rm ${topdir}/decrypt_v1_test_file.xbcrypt
+rm ${topdir}/decrypt_v1_test_file.txt
+
+
+# test in place decryption of a directory tree
+mkdir -p ${topdir}/xbcrypt_dir/db1 ${topdir}/xbcrypt_dir/db2
+for f in file1 db1/file2 db1/file3 db2/file4
+do
+    run_cmd xbcrypt -i inc/decrypt_v1_test_file.txt -o ${topdir}/xbcrypt_dir/$f.xbcrypt -a ${encrypt_algo} -k ${encrypt_key} --encrypt-chunk-size=1024
+done
+
+run_cmd xbcrypt -d -i ${topdir}/xbcrypt_dir -a ${encrypt_algo} -k ${encrypt_key} --parallel=2 --encrypt-threads=2 --remove-original
+
+for f in file1 db1/file2 db1/file3 db2/file4
+do
+    run_cmd cmp inc/decrypt_v1_test_file.txt ${topdir}/xbcrypt_dir/$f
+    if [ -f ${topdir}/xbcrypt_dir/$f.xbcrypt ]
+    then
+        vlog "$f.xbcrypt has not been removed"
+        exit 1
+    fi
+done
+rm -rf ${topdir}/xbcrypt_dir
+
+# a directory can only be decrypted
+run_cmd_expect_failure xbcrypt -i inc -a ${encrypt_algo} -k ${encrypt_key}